@@ -0,0 +1,124 @@
+// ACEOAuth2RACChunkedUploader.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ReactiveObjC.h"
+
+#import "ACEOAuth2RACRequest.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Block in charge of sending a single call of the upload.
+ The returned signal must send a `RACTuple` with the response object and the URL response.
+ */
+typedef RACSignal * _Nonnull (^ACEOAuth2RACChunkedUploaderSendBlock)(ACEOAuth2RACRequest *request);
+
+/**
+ `ACEOAuth2RACChunkedUploader` uploads large files in chunks, following the tus offset protocol.
+
+ The upload is created with a `POST` carrying the `Upload-Length` header, and the server replies with
+ the upload URL in the `Location` header. Each chunk is then sent with a `PATCH` to the upload URL,
+ carrying its position in the `Upload-Offset` header.
+
+ The core protocol accepts the chunks only in order. With `usesConcatenation` each chunk is sent instead
+ as a partial upload of the tus Concatenation extension, so the chunks can run in parallel, and a final
+ `POST` with the `Upload-Concat` header joins them into the upload.
+
+ The completed byte ranges are saved to a small journal after every chunk, so an upload interrupted
+ by a network failure or by the termination of the process continues from where it stopped when it
+ is started again with the same identifier. A single upload resumes from the `Upload-Offset` that the
+ server returns to a `HEAD`, which wins over the journal. The size of the chunks follows the measured throughput.
+ */
+@interface ACEOAuth2RACChunkedUploader : NSObject
+
+/**
+ YES to send the chunks as partial uploads joined at the end, the server must implement the tus Concatenation extension.
+ Default is NO, which sends the chunks one after the other to a single upload.
+ */
+@property (nonatomic, assign) BOOL usesConcatenation;
+
+/**
+ The maximum number of chunks sent at the same time when `usesConcatenation` is YES. Default is 1.
+ Without the Concatenation extension the chunks are always sent one at a time.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrentChunks;
+
+/**
+ The size of the first chunk, in bytes. Default is 1 MB.
+ */
+@property (nonatomic, assign) NSUInteger initialChunkSize;
+
+/**
+ The smallest chunk size, in bytes. Default is 256 KB.
+ */
+@property (nonatomic, assign) NSUInteger minimumChunkSize;
+
+/**
+ The largest chunk size, in bytes. Default is 16 MB.
+ */
+@property (nonatomic, assign) NSUInteger maximumChunkSize;
+
+/**
+ The time a chunk should take to be sent, the chunk size is adjusted to meet it. Default is 5 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval targetChunkDuration;
+
+/**
+ The desired number of retries of each chunk before giving up. Default is 3.
+ */
+@property (nonatomic, assign) NSInteger chunkRetries;
+
+/**
+ The directory of the journals. Default is `ACEOAuth2RACUploads` in the caches directory.
+ */
+@property (nonatomic, strong) NSURL *journalDirectoryURL;
+
+- (instancetype)initWithSendBlock:(ACEOAuth2RACChunkedUploaderSendBlock)sendBlock;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Return a signal uploading a file.
+
+ @param fileURL The file to upload.
+ @param path The URL path of the endpoint creating the uploads, relative to the apiURLString.
+ @param identifier The identifier of the upload, used to resume it. The journal is discarded if the file changed.
+ @param progressSubscriber The optional subscriber receiving the `NSProgress` of the upload. It completes when the upload does.
+
+ @return The signal sending the upload URL when every chunk has been received by the server.
+ */
+- (RACSignal *)rac_uploadFileURL:(NSURL *)fileURL
+                          toPath:(NSString *)path
+                      identifier:(NSString *)identifier
+                        progress:(nullable id<RACSubscriber>)progressSubscriber;
+
+/**
+ Forget the progress of an upload, so the next one with the same identifier starts from the beginning.
+
+ @param identifier The identifier of the upload.
+ */
+- (void)discardUploadWithIdentifier:(NSString *)identifier;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,599 @@
+// ACEOAuth2RACChunkedUploader.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACChunkedUploader.h"
+#import "ACEOAuth2RACManager.h"
+#import "ACEOAuth2RACManagerPrivate.h"
+
+#import "AFURLResponseSerialization.h"
+
+static NSString * const ACEOAuth2RACTusVersion = @"1.0.0";
+
+@interface ACEOAuth2RACChunkedUpload : NSObject
+@property (nonatomic, strong) NSURL *fileURL;
+@property (nonatomic, strong) NSString *path;
+@property (nonatomic, strong) NSURL *journalURL;
+@property (nonatomic, strong) id<RACSubscriber> subscriber;
+@property (nonatomic, strong) id<RACSubscriber> progressSubscriber;
+@property (nonatomic, strong) RACCompoundDisposable *disposable;
+@property (nonatomic, strong) NSFileHandle *fileHandle;
+@property (nonatomic, strong) NSProgress *progress;
+
+// saved in the journal
+@property (nonatomic, assign) unsigned long long fileSize;
+@property (nonatomic, assign) NSTimeInterval modificationDate;
+@property (nonatomic, strong) NSURL *uploadURL;
+@property (nonatomic, assign) NSUInteger chunkSize;
+@property (nonatomic, strong) NSMutableIndexSet *completedRanges;
+
+// the partial uploads of the completed chunks by location, as [length, URL], with the Concatenation extension
+@property (nonatomic, assign) BOOL concatenates;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSArray *> *partialUploads;
+
+// chunks being sent, and the ones sent or being sent
+@property (nonatomic, assign) NSUInteger runningChunks;
+@property (nonatomic, strong) NSMutableIndexSet *takenRanges;
+@property (nonatomic, assign) BOOL finished;
+@end
+
+@implementation ACEOAuth2RACChunkedUpload
+@end
+
+#pragma mark -
+
+@interface ACEOAuth2RACChunkedUploader ()
+@property (nonatomic, copy) ACEOAuth2RACChunkedUploaderSendBlock sendBlock;
+
+// the state of the uploads is accessed only on the queue
+@property (nonatomic, strong) dispatch_queue_t queue;
+@end
+
+@implementation ACEOAuth2RACChunkedUploader
+
+- (instancetype)initWithSendBlock:(ACEOAuth2RACChunkedUploaderSendBlock)sendBlock
+{
+    self = [super init];
+    if (self) {
+        self.sendBlock              = sendBlock;
+        self.queue                  = dispatch_queue_create("com.onemob.network.uploads", DISPATCH_QUEUE_SERIAL);
+        
+        self.maxConcurrentChunks    = 1;
+        self.initialChunkSize       = 1024 * 1024;
+        self.minimumChunkSize       = 256 * 1024;
+        self.maximumChunkSize       = 16 * 1024 * 1024;
+        self.targetChunkDuration    = 5.0;
+        self.chunkRetries           = 3;
+        
+        NSURL *cachesURL = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask] firstObject];
+        self.journalDirectoryURL    = [cachesURL URLByAppendingPathComponent:@"ACEOAuth2RACUploads" isDirectory:YES];
+    }
+    return self;
+}
+
+
+#pragma mark - Signals
+
+- (RACSignal *)rac_uploadFileURL:(NSURL *)fileURL
+                          toPath:(NSString *)path
+                      identifier:(NSString *)identifier
+                        progress:(id<RACSubscriber>)progressSubscriber
+{
+    @weakify(self)
+    return [[RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+        
+        @strongify(self)
+        ACEOAuth2RACChunkedUpload *upload = [ACEOAuth2RACChunkedUpload new];
+        upload.fileURL              = fileURL;
+        upload.path                 = path;
+        upload.journalURL           = [self journalURLForIdentifier:identifier];
+        upload.subscriber           = subscriber;
+        upload.progressSubscriber   = progressSubscriber;
+        upload.disposable           = [RACCompoundDisposable compoundDisposable];
+        
+        dispatch_async(self.queue, ^{
+            [self startUpload:upload];
+        });
+        
+        return [RACDisposable disposableWithBlock:^{
+            @strongify(self)
+            dispatch_async(self.queue, ^{
+                // the journal is kept, the upload can be resumed later
+                upload.finished = YES;
+                [upload.disposable dispose];
+                [upload.fileHandle closeFile];
+            });
+        }];
+        
+    }] setNameWithFormat:@"[%@] -rac_uploadFileURL: %@ toPath: %@ identifier: %@", self.class, fileURL, path, identifier];
+}
+
+- (void)discardUploadWithIdentifier:(NSString *)identifier
+{
+    NSURL *journalURL = [self journalURLForIdentifier:identifier];
+    dispatch_async(self.queue, ^{
+        [[NSFileManager defaultManager] removeItemAtURL:journalURL error:nil];
+    });
+}
+
+
+#pragma mark - Upload
+
+- (void)startUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    NSError *error;
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:upload.fileURL.path error:&error];
+    upload.fileHandle = [NSFileHandle fileHandleForReadingFromURL:upload.fileURL error:&error];
+    
+    if (attributes == nil || upload.fileHandle == nil) {
+        [self finishUpload:upload withError:error];
+        return;
+    }
+    
+    upload.fileSize         = [attributes fileSize];
+    upload.modificationDate = [[attributes fileModificationDate] timeIntervalSince1970];
+    upload.chunkSize        = self.initialChunkSize;
+    upload.completedRanges  = [NSMutableIndexSet indexSet];
+    upload.partialUploads   = [NSMutableDictionary dictionary];
+    
+    // an empty file has nothing to concatenate
+    upload.concatenates     = self.usesConcatenation && upload.fileSize > 0;
+    
+    [self loadJournalOfUpload:upload];
+    
+    upload.takenRanges = [upload.completedRanges mutableCopy];
+    
+    upload.progress = [NSProgress progressWithTotalUnitCount:(int64_t)upload.fileSize];
+    upload.progress.completedUnitCount = (int64_t)upload.completedRanges.count;
+    [upload.progressSubscriber sendNext:upload.progress];
+    
+    if (upload.concatenates) {
+        // each chunk creates its own partial upload
+        [self sendChunksOfUpload:upload];
+        
+    } else if (upload.uploadURL != nil) {
+        [self fetchOffsetOfUpload:upload];
+        
+    } else {
+        [self createUpload:upload];
+    }
+}
+
+- (void)fetchOffsetOfUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    ACEOAuth2RACRequest *request = [ACEOAuth2RACRequest requestWithMethod:@"HEAD" path:upload.uploadURL.absoluteString parameters:nil];
+    request.retries     = self.chunkRetries;
+    request.HTTPHeaders = @{
+                            @"Tus-Resumable":   ACEOAuth2RACTusVersion
+                            };
+    
+    [upload.disposable addDisposable:[self.sendBlock(request)
+                                      subscribeNext:^(RACTuple *response) {
+                                          dispatch_async(self.queue, ^{
+                                              [self didFetchOffsetOfUpload:upload withResponse:[response second]];
+                                          });
+                                          
+                                      } error:^(NSError *error) {
+                                          dispatch_async(self.queue, ^{
+                                              NSHTTPURLResponse *response = error.userInfo[AFNetworkingOperationFailingURLResponseErrorKey];
+                                              NSInteger statusCode = [response isKindOfClass:[NSHTTPURLResponse class]] ? response.statusCode : 0;
+                                              
+                                              if (statusCode == 403 || statusCode == 404 || statusCode == 410) {
+                                                  // the server doesn't know the upload anymore, start again
+                                                  [self restartUpload:upload];
+                                                  
+                                              } else {
+                                                  [self finishUpload:upload withError:error];
+                                              }
+                                          });
+                                      }]];
+}
+
+- (void)didFetchOffsetOfUpload:(ACEOAuth2RACChunkedUpload *)upload withResponse:(NSHTTPURLResponse *)response
+{
+    if (upload.finished) {
+        return;
+    }
+    
+    NSString *offsetValue = [response isKindOfClass:[NSHTTPURLResponse class]] ? response.allHeaderFields[@"Upload-Offset"] : nil;
+    unsigned long long offset = (unsigned long long)[offsetValue longLongValue];
+    
+    if (offsetValue == nil || [offsetValue longLongValue] < 0 || offset > upload.fileSize) {
+        [self finishUpload:upload withError:[NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                                                                code:ACEOAuth2RACErrorBadUploadResponse
+                                                            userInfo:@{
+                                                                       NSLocalizedDescriptionKey: @"Missing upload offset in the response"
+                                                                       }]];
+        return;
+    }
+    
+    // the server knows better than the journal
+    ACE_LOG_DEBUG(@"Resuming upload of %@ at %llu of %llu bytes", upload.fileURL.lastPathComponent, offset, upload.fileSize);
+    
+    [upload.completedRanges removeAllIndexes];
+    [upload.completedRanges addIndexesInRange:NSMakeRange(0, (NSUInteger)offset)];
+    upload.takenRanges = [upload.completedRanges mutableCopy];
+    
+    upload.progress.completedUnitCount = (int64_t)offset;
+    [upload.progressSubscriber sendNext:upload.progress];
+    
+    [self saveJournalOfUpload:upload];
+    [self sendChunksOfUpload:upload];
+}
+
+- (void)restartUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    if (upload.finished) {
+        return;
+    }
+    
+    [[NSFileManager defaultManager] removeItemAtURL:upload.journalURL error:nil];
+    
+    upload.uploadURL = nil;
+    [upload.completedRanges removeAllIndexes];
+    [upload.takenRanges removeAllIndexes];
+    
+    upload.progress.completedUnitCount = 0;
+    [upload.progressSubscriber sendNext:upload.progress];
+    
+    [self createUpload:upload];
+}
+
+- (void)createUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    ACEOAuth2RACRequest *request = [ACEOAuth2RACRequest requestWithMethod:@"POST" path:upload.path parameters:nil];
+    request.retries     = self.chunkRetries;
+    request.HTTPHeaders = @{
+                            @"Tus-Resumable":   ACEOAuth2RACTusVersion,
+                            @"Upload-Length":   [NSString stringWithFormat:@"%llu", upload.fileSize]
+                            };
+    
+    [upload.disposable addDisposable:[self.sendBlock(request)
+                                      subscribeNext:^(RACTuple *response) {
+                                          dispatch_async(self.queue, ^{
+                                              [self didCreateUpload:upload withResponse:[response second]];
+                                          });
+                                          
+                                      } error:^(NSError *error) {
+                                          dispatch_async(self.queue, ^{
+                                              [self finishUpload:upload withError:error];
+                                          });
+                                      }]];
+}
+
+- (void)didCreateUpload:(ACEOAuth2RACChunkedUpload *)upload withResponse:(NSHTTPURLResponse *)response
+{
+    if (upload.finished) {
+        return;
+    }
+    
+    upload.uploadURL = [self uploadURLFromResponse:response];
+    
+    if (upload.uploadURL == nil) {
+        [self finishUpload:upload withError:[self missingUploadURLError]];
+        return;
+    }
+    
+    [self saveJournalOfUpload:upload];
+    [self sendChunksOfUpload:upload];
+}
+
+- (void)sendChunksOfUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    if (upload.finished) {
+        return;
+    }
+    
+    if (upload.completedRanges.count >= upload.fileSize) {
+        if (upload.uploadURL == nil) {
+            [self concatenateUpload:upload];
+            return;
+        }
+        
+        [[NSFileManager defaultManager] removeItemAtURL:upload.journalURL error:nil];
+        
+        upload.finished = YES;
+        [upload.fileHandle closeFile];
+        [upload.subscriber sendNext:upload.uploadURL];
+        [upload.subscriber sendCompleted];
+        [upload.progressSubscriber sendCompleted];
+        return;
+    }
+    
+    // the core protocol accepts a single chunk at a time, at the current offset
+    NSUInteger maxConcurrentChunks = upload.concatenates ? MAX(self.maxConcurrentChunks, 1) : 1;
+    
+    // a chunk failing to read finishes the upload without taking its range
+    while (!upload.finished && upload.runningChunks < maxConcurrentChunks) {
+        NSRange range = [self nextRangeOfUpload:upload];
+        if (range.location == NSNotFound) {
+            break;
+        }
+        [self sendChunkWithRange:range ofUpload:upload];
+    }
+}
+
+- (NSRange)nextRangeOfUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    // the first byte not sent yet, ranges are enumerated in order
+    __block NSUInteger location = 0;
+    [upload.takenRanges enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        if (range.location > location) {
+            *stop = YES;
+            
+        } else {
+            location = MAX(location, NSMaxRange(range));
+        }
+    }];
+    
+    if (location >= upload.fileSize) {
+        return NSMakeRange(NSNotFound, 0);
+    }
+    
+    // up to the chunk size, without overlapping a range already sent
+    NSUInteger end = (NSUInteger)MIN(upload.fileSize, (unsigned long long)location + upload.chunkSize);
+    NSUInteger nextTaken = [upload.takenRanges indexGreaterThanIndex:location];
+    if (nextTaken != NSNotFound) {
+        end = MIN(end, nextTaken);
+    }
+    return NSMakeRange(location, end - location);
+}
+
+- (void)sendChunkWithRange:(NSRange)range ofUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    [upload.fileHandle seekToFileOffset:range.location];
+    NSData *chunk = [upload.fileHandle readDataOfLength:range.length];
+    
+    if (chunk.length != range.length) {
+        [self finishUpload:upload withError:[NSError errorWithDomain:NSCocoaErrorDomain
+                                                                code:NSFileReadUnknownError
+                                                            userInfo:@{ NSURLErrorKey: upload.fileURL }]];
+        return;
+    }
+    
+    [upload.takenRanges addIndexesInRange:range];
+    upload.runningChunks++;
+    
+    RACSignal *chunkSignal;
+    if (upload.concatenates) {
+        chunkSignal = [self rac_sendPartialUploadWithChunk:chunk ofUpload:upload];
+        
+    } else {
+        chunkSignal = [[self.sendBlock([self requestWithChunk:chunk offset:range.location URL:upload.uploadURL]) ignoreValues] concat:[RACSignal return:nil]];
+    }
+    
+    NSDate *startDate = [NSDate date];
+    [upload.disposable addDisposable:[chunkSignal
+                                      subscribeNext:^(NSURL *partialURL) {
+                                          NSTimeInterval duration = -[startDate timeIntervalSinceNow];
+                                          dispatch_async(self.queue, ^{
+                                              [self didSendChunkWithRange:range partialURL:partialURL duration:duration ofUpload:upload];
+                                          });
+                                          
+                                      } error:^(NSError *error) {
+                                          dispatch_async(self.queue, ^{
+                                              [self finishUpload:upload withError:error];
+                                          });
+                                      }]];
+}
+
+- (ACEOAuth2RACRequest *)requestWithChunk:(NSData *)chunk offset:(NSUInteger)offset URL:(NSURL *)URL
+{
+    ACEOAuth2RACRequest *request = [ACEOAuth2RACRequest requestWithMethod:@"PATCH" path:URL.absoluteString parameters:nil];
+    request.retries     = self.chunkRetries;
+    request.HTTPBody    = chunk;
+    request.HTTPHeaders = @{
+                            @"Tus-Resumable":   ACEOAuth2RACTusVersion,
+                            @"Upload-Offset":   [NSString stringWithFormat:@"%lu", (unsigned long)offset],
+                            @"Content-Type":    @"application/offset+octet-stream"
+                            };
+    return request;
+}
+
+- (RACSignal *)rac_sendPartialUploadWithChunk:(NSData *)chunk ofUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    ACEOAuth2RACRequest *request = [ACEOAuth2RACRequest requestWithMethod:@"POST" path:upload.path parameters:nil];
+    request.retries     = self.chunkRetries;
+    request.HTTPHeaders = @{
+                            @"Tus-Resumable":   ACEOAuth2RACTusVersion,
+                            @"Upload-Concat":   @"partial",
+                            @"Upload-Length":   [NSString stringWithFormat:@"%lu", (unsigned long)chunk.length]
+                            };
+    
+    // the partial upload takes the whole chunk from its start
+    return [self.sendBlock(request) flattenMap:^__kindof RACSignal *(RACTuple *response) {
+        NSURL *partialURL = [self uploadURLFromResponse:[response second]];
+        if (partialURL == nil) {
+            return [RACSignal error:[self missingUploadURLError]];
+        }
+        
+        return [[[self.sendBlock([self requestWithChunk:chunk offset:0 URL:partialURL]) ignoreValues] concat:[RACSignal return:partialURL]] take:1];
+    }];
+}
+
+- (void)concatenateUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    // the partial uploads in the order of the file
+    NSMutableArray<NSString *> *partialURLs = [NSMutableArray arrayWithCapacity:upload.partialUploads.count];
+    for (NSNumber *location in [upload.partialUploads.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        [partialURLs addObject:upload.partialUploads[location][1]];
+    }
+    
+    ACEOAuth2RACRequest *request = [ACEOAuth2RACRequest requestWithMethod:@"POST" path:upload.path parameters:nil];
+    request.retries     = self.chunkRetries;
+    request.HTTPHeaders = @{
+                            @"Tus-Resumable":   ACEOAuth2RACTusVersion,
+                            @"Upload-Concat":   [@"final;" stringByAppendingString:[partialURLs componentsJoinedByString:@" "]]
+                            };
+    
+    [upload.disposable addDisposable:[self.sendBlock(request)
+                                      subscribeNext:^(RACTuple *response) {
+                                          dispatch_async(self.queue, ^{
+                                              [self didCreateUpload:upload withResponse:[response second]];
+                                          });
+                                          
+                                      } error:^(NSError *error) {
+                                          dispatch_async(self.queue, ^{
+                                              [self finishUpload:upload withError:error];
+                                          });
+                                      }]];
+}
+
+- (NSURL *)uploadURLFromResponse:(NSHTTPURLResponse *)response
+{
+    NSString *location = [response isKindOfClass:[NSHTTPURLResponse class]] ? response.allHeaderFields[@"Location"] : nil;
+    return location ? [[NSURL URLWithString:location relativeToURL:response.URL] absoluteURL] : nil;
+}
+
+- (NSError *)missingUploadURLError
+{
+    return [NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                               code:ACEOAuth2RACErrorBadUploadResponse
+                           userInfo:@{
+                                      NSLocalizedDescriptionKey: @"Missing upload URL in the response"
+                                      }];
+}
+
+- (void)didSendChunkWithRange:(NSRange)range partialURL:(NSURL *)partialURL duration:(NSTimeInterval)duration ofUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    if (upload.finished) {
+        return;
+    }
+    
+    upload.runningChunks--;
+    [upload.completedRanges addIndexesInRange:range];
+    
+    if (partialURL != nil) {
+        upload.partialUploads[@(range.location)] = @[ @(range.length), partialURL.absoluteString ];
+    }
+    
+    [self adaptChunkSizeOfUpload:upload withRange:range duration:duration];
+    [self saveJournalOfUpload:upload];
+    
+    upload.progress.completedUnitCount = (int64_t)upload.completedRanges.count;
+    [upload.progressSubscriber sendNext:upload.progress];
+    
+    [self sendChunksOfUpload:upload];
+}
+
+- (void)adaptChunkSizeOfUpload:(ACEOAuth2RACChunkedUpload *)upload withRange:(NSRange)range duration:(NSTimeInterval)duration
+{
+    if (duration <= 0.0) {
+        return;
+    }
+    
+    // aim for chunks lasting the target duration, smoothing the measures of the single chunks
+    double throughput   = range.length / duration;
+    double targetSize   = (upload.chunkSize + throughput * self.targetChunkDuration) / 2.0;
+    
+    NSUInteger granularity  = 64 * 1024;
+    NSUInteger chunkSize    = (NSUInteger)(targetSize / granularity) * granularity;
+    
+    upload.chunkSize = MIN(MAX(chunkSize, self.minimumChunkSize), MAX(self.maximumChunkSize, self.minimumChunkSize));
+}
+
+- (void)finishUpload:(ACEOAuth2RACChunkedUpload *)upload withError:(NSError *)error
+{
+    if (upload.finished) {
+        return;
+    }
+    
+    ACE_LOG_DEBUG(@"Upload of %@ failed: %@", upload.fileURL.lastPathComponent, error);
+    
+    // stop the other chunks, the journal keeps the ones completed
+    upload.finished = YES;
+    [upload.disposable dispose];
+    [upload.fileHandle closeFile];
+    [upload.subscriber sendError:error];
+    [upload.progressSubscriber sendCompleted];
+}
+
+
+#pragma mark - Journal
+
+- (NSURL *)journalURLForIdentifier:(NSString *)identifier
+{
+    NSString *fileName = [identifier stringByAddingPercentEncodingWithAllowedCharacters:[NSCharacterSet alphanumericCharacterSet]];
+    return [self.journalDirectoryURL URLByAppendingPathComponent:[fileName stringByAppendingPathExtension:@"json"]];
+}
+
+- (void)loadJournalOfUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    NSData *data = [NSData dataWithContentsOfURL:upload.journalURL];
+    NSDictionary *journal = data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:nil] : nil;
+    if (![journal isKindOfClass:[NSDictionary class]]) {
+        return;
+    }
+    
+    // a different file can't continue the previous upload
+    if ([journal[@"fileSize"] unsignedLongLongValue] != upload.fileSize ||
+        [journal[@"modificationDate"] doubleValue] != upload.modificationDate ||
+        ![journal[@"path"] isEqual:upload.path] ||
+        [journal[@"concatenation"] boolValue] != upload.concatenates) {
+        
+        [[NSFileManager defaultManager] removeItemAtURL:upload.journalURL error:nil];
+        return;
+    }
+    
+    upload.uploadURL = journal[@"uploadURL"] ? [NSURL URLWithString:journal[@"uploadURL"]] : nil;
+    upload.chunkSize = [journal[@"chunkSize"] unsignedIntegerValue] ?: upload.chunkSize;
+    
+    for (NSArray<NSNumber *> *range in journal[@"completedRanges"]) {
+        [upload.completedRanges addIndexesInRange:NSMakeRange([range[0] unsignedIntegerValue], [range[1] unsignedIntegerValue])];
+    }
+    
+    for (NSArray *partialUpload in journal[@"partialUploads"]) {
+        upload.partialUploads[partialUpload[0]] = @[ partialUpload[1], partialUpload[2] ];
+    }
+}
+
+- (void)saveJournalOfUpload:(ACEOAuth2RACChunkedUpload *)upload
+{
+    NSMutableArray *completedRanges = [NSMutableArray array];
+    [upload.completedRanges enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        [completedRanges addObject:@[ @(range.location), @(range.length) ]];
+    }];
+    
+    NSMutableArray *partialUploads = [NSMutableArray arrayWithCapacity:upload.partialUploads.count];
+    [upload.partialUploads enumerateKeysAndObjectsUsingBlock:^(NSNumber *location, NSArray *partialUpload, BOOL *stop) {
+        [partialUploads addObject:@[ location, partialUpload[0], partialUpload[1] ]];
+    }];
+    
+    NSMutableDictionary *journal = [@{
+                                      @"path":              upload.path,
+                                      @"fileSize":          @(upload.fileSize),
+                                      @"modificationDate":  @(upload.modificationDate),
+                                      @"chunkSize":         @(upload.chunkSize),
+                                      @"completedRanges":   completedRanges,
+                                      @"concatenation":     @(upload.concatenates),
+                                      @"partialUploads":    partialUploads
+                                      } mutableCopy];
+    
+    // the final upload of a concatenation is created at the end
+    journal[@"uploadURL"] = upload.uploadURL.absoluteString;
+    
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.journalDirectoryURL withIntermediateDirectories:YES attributes:nil error:nil];
+    [[NSJSONSerialization dataWithJSONObject:journal options:0 error:nil] writeToURL:upload.journalURL atomically:YES];
+}
+
+@end
@@ -0,0 +1,48 @@
+// ACEOAuth2RACCompression.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Compress `data` in the gzip format.
+
+ @param data The data to compress.
+
+ @return The compressed data, nil if the compression failed.
+ */
+extern NSData * _Nullable ACEOAuth2RACGzipCompressData(NSData *data);
+
+/**
+ Tell if a body of the given content type is worth compressing: the text formats written by the request
+ serializers, never the binary or compressed ones like `application/offset+octet-stream`.
+
+ @param contentType The value of the `Content-Type` header, parameters included.
+
+ @return YES if the body can be compressed.
+ */
+extern BOOL ACEOAuth2RACIsCompressibleContentType(NSString * _Nullable contentType);
+
+NS_ASSUME_NONNULL_END
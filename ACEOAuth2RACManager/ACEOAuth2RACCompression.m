@@ -0,0 +1,77 @@
+// ACEOAuth2RACCompression.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACCompression.h"
+
+#import <zlib.h>
+
+NSData *ACEOAuth2RACGzipCompressData(NSData *data)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    
+    // 15 window bits, plus 16 to write the gzip header and trailer
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nil;
+    }
+    
+    NSMutableData *compressedData = [NSMutableData dataWithLength:deflateBound(&stream, (uLong)data.length)];
+    
+    stream.next_in      = (Bytef *)data.bytes;
+    stream.avail_in     = (uInt)data.length;
+    stream.next_out     = compressedData.mutableBytes;
+    stream.avail_out    = (uInt)compressedData.length;
+    
+    // the output buffer is large enough for a single pass
+    int status = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    
+    if (status != Z_STREAM_END) {
+        return nil;
+    }
+    
+    compressedData.length = stream.total_out;
+    return compressedData;
+}
+
+BOOL ACEOAuth2RACIsCompressibleContentType(NSString *contentType)
+{
+    NSString *mediaType = [[[contentType componentsSeparatedByString:@";"] firstObject] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+    mediaType = mediaType.lowercaseString;
+    if (mediaType.length == 0) {
+        return NO;
+    }
+    
+    // the formats of the JSON, form and property list serializers, and their relatives
+    static NSSet<NSString *> *mediaTypes;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mediaTypes = [NSSet setWithObjects:@"application/json", @"application/x-www-form-urlencoded", @"application/x-plist", @"application/xml", nil];
+    });
+    
+    return [mediaTypes containsObject:mediaType] ||
+        [mediaType hasPrefix:@"text/"] ||
+        [mediaType hasSuffix:@"+json"] ||
+        [mediaType hasSuffix:@"+xml"];
+}
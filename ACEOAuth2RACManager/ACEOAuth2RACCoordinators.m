@@ -23,8 +23,7 @@
 
 #import "ACEOAuth2RACCoordinators.h"
 #import "ACEOAuth2RACManager.h"
-
-#import "NSURL+QueryDictionary.h"
+#import "ACEOAuth2RACQueryScanner.h"
 
 #if !OAUTH_APP_EXTENSION
 
@@ -122,8 +121,7 @@
 
 - (BOOL)webView:(UIWebView *)webView shouldStartLoadWithRequest:(NSURLRequest *)request navigationType:(UIWebViewNavigationType)navigationType
 {
-    NSDictionary *queryDict = [request.URL uq_queryDictionary];
-    if (queryDict.count == 1 && queryDict[@"code"] != nil && [self.authManager handleRedirectURL:request.URL]) {
+    if (ACEOAuth2RACQueryParameterCount(request.URL) == 1 && ACEOAuth2RACQueryValueForKey(request.URL, @"code") != nil && [self.authManager handleRedirectURL:request.URL]) {
         // dismiss the login controller
         [self.presentingController dismissViewControllerAnimated:YES completion:nil];
         
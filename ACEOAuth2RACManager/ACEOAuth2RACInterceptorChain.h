@@ -0,0 +1,75 @@
+// ACEOAuth2RACInterceptorChain.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACProtocols.h"
+#import "ReactiveObjC.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `ACEOAuth2RACInterceptorChain` is the immutable form of a list of interceptors, built once when the list changes.
+ The methods implemented by each interceptor are found in advance, so running the chain is a loop over a flat array.
+ */
+@interface ACEOAuth2RACInterceptorChain : NSObject
+
+/**
+ The interceptors, in order.
+ */
+@property (nonatomic, copy, readonly) NSArray<id<ACEOAuth2RACInterceptor>> *interceptors;
+
+- (instancetype)initWithInterceptors:(NSArray<id<ACEOAuth2RACInterceptor>> *)interceptors;
+
+/**
+ Wrap the signal sending a request with the interceptors.
+
+ @param URLRequest The request built by the manager.
+ @param block The block returning the signal that sends the request, and the tuple with the response.
+
+ @return The signal sending the intercepted response.
+ */
+- (RACSignal *)rac_interceptRequest:(NSURLRequest *)URLRequest withBlock:(RACSignal *(^)(NSURLRequest *URLRequest))block;
+
+/**
+ Wrap the signal streaming the body of a request, to the caller or between a file and the server, with the interceptors.
+ The body never makes a response object the interceptors could read or cache, so only the requests and the errors go through the interceptors.
+
+ @param URLRequest The request built by the manager.
+ @param block The block returning the signal that streams the body.
+
+ @return The signal streaming the body, with the intercepted error.
+ */
+- (RACSignal *)rac_interceptStreamRequest:(NSURLRequest *)URLRequest withBlock:(RACSignal *(^)(NSURLRequest *URLRequest))block;
+
+/**
+ Return a request modified by the interceptors, for the requests built again by a retry.
+
+ @param URLRequest The request built by the manager.
+
+ @return The request to send.
+ */
+- (NSURLRequest *)requestByInterceptingRequest:(NSURLRequest *)URLRequest;
+
+@end
+
+NS_ASSUME_NONNULL_END
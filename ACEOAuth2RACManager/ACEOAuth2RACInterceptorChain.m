@@ -0,0 +1,183 @@
+// ACEOAuth2RACInterceptorChain.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACInterceptorChain.h"
+
+typedef NS_OPTIONS(uint8_t, ACEOAuth2RACInterceptorMethods) {
+    ACEOAuth2RACInterceptorMethodRequest    = 1 << 0,
+    ACEOAuth2RACInterceptorMethodCache      = 1 << 1,
+    ACEOAuth2RACInterceptorMethodResponse   = 1 << 2,
+    ACEOAuth2RACInterceptorMethodError      = 1 << 3,
+};
+
+typedef struct {
+    // retained by the interceptors array
+    __unsafe_unretained id<ACEOAuth2RACInterceptor> interceptor;
+    ACEOAuth2RACInterceptorMethods methods;
+} ACEOAuth2RACInterceptorEntry;
+
+@interface ACEOAuth2RACInterceptorChain ()
+@property (nonatomic, copy, readwrite) NSArray<id<ACEOAuth2RACInterceptor>> *interceptors;
+@end
+
+@implementation ACEOAuth2RACInterceptorChain {
+    ACEOAuth2RACInterceptorEntry *_entries;
+    NSUInteger _count;
+    ACEOAuth2RACInterceptorMethods _methods;
+}
+
+- (instancetype)initWithInterceptors:(NSArray<id<ACEOAuth2RACInterceptor>> *)interceptors
+{
+    self = [super init];
+    if (self) {
+        self.interceptors = interceptors;
+        
+        _count      = interceptors.count;
+        _entries    = calloc(MAX(_count, 1), sizeof(ACEOAuth2RACInterceptorEntry));
+        
+        for (NSUInteger idx = 0; idx < _count; idx++) {
+            id<ACEOAuth2RACInterceptor> interceptor = self.interceptors[idx];
+            
+            ACEOAuth2RACInterceptorMethods methods = 0;
+            if ([interceptor respondsToSelector:@selector(interceptRequest:)]) {
+                methods |= ACEOAuth2RACInterceptorMethodRequest;
+            }
+            if ([interceptor respondsToSelector:@selector(cachedResponseForRequest:)]) {
+                methods |= ACEOAuth2RACInterceptorMethodCache;
+            }
+            if ([interceptor respondsToSelector:@selector(interceptResponse:forRequest:)]) {
+                methods |= ACEOAuth2RACInterceptorMethodResponse;
+            }
+            if ([interceptor respondsToSelector:@selector(interceptError:forRequest:)]) {
+                methods |= ACEOAuth2RACInterceptorMethodError;
+            }
+            
+            _entries[idx].interceptor   = interceptor;
+            _entries[idx].methods       = methods;
+            _methods |= methods;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_entries);
+}
+
+
+#pragma mark - Signals
+
+- (RACSignal *)rac_interceptRequest:(NSURLRequest *)URLRequest withBlock:(RACSignal *(^)(NSURLRequest *URLRequest))block
+{
+    if (_methods == 0) {
+        return block(URLRequest);
+    }
+    
+    return [RACSignal defer:^RACSignal *{
+        NSURLRequest *request = URLRequest;
+        RACTuple *cachedResponse = nil;
+        
+        // the interceptors after the one answering from its cache are skipped
+        NSUInteger end = self->_count;
+        for (NSUInteger i = 0; i < self->_count; i++) {
+            ACEOAuth2RACInterceptorEntry entry = self->_entries[i];
+            
+            if (entry.methods & ACEOAuth2RACInterceptorMethodRequest) {
+                request = [entry.interceptor interceptRequest:request];
+            }
+            if (entry.methods & ACEOAuth2RACInterceptorMethodCache) {
+                cachedResponse = [entry.interceptor cachedResponseForRequest:request];
+                if (cachedResponse != nil) {
+                    end = i;
+                    break;
+                }
+            }
+        }
+        
+        RACSignal *signal = cachedResponse ? [RACSignal return:cachedResponse] : block(request);
+        if ((self->_methods & (ACEOAuth2RACInterceptorMethodResponse | ACEOAuth2RACInterceptorMethodError)) == 0) {
+            return signal;
+        }
+        
+        return [[signal
+                 map:^id(RACTuple *response) {
+                     for (NSUInteger i = end; i > 0; i--) {
+                         ACEOAuth2RACInterceptorEntry entry = self->_entries[i - 1];
+                         if (entry.methods & ACEOAuth2RACInterceptorMethodResponse) {
+                             response = [entry.interceptor interceptResponse:response forRequest:request];
+                         }
+                     }
+                     return response;
+                 }]
+                catch:^RACSignal *(NSError *error) {
+                    for (NSUInteger i = end; i > 0; i--) {
+                        ACEOAuth2RACInterceptorEntry entry = self->_entries[i - 1];
+                        if (entry.methods & ACEOAuth2RACInterceptorMethodError) {
+                            error = [entry.interceptor interceptError:error forRequest:request];
+                        }
+                    }
+                    return [RACSignal error:error];
+                }];
+    }];
+}
+
+- (RACSignal *)rac_interceptStreamRequest:(NSURLRequest *)URLRequest withBlock:(RACSignal *(^)(NSURLRequest *URLRequest))block
+{
+    if ((_methods & (ACEOAuth2RACInterceptorMethodRequest | ACEOAuth2RACInterceptorMethodError)) == 0) {
+        return block(URLRequest);
+    }
+    
+    return [RACSignal defer:^RACSignal *{
+        NSURLRequest *request = [self requestByInterceptingRequest:URLRequest];
+        
+        return [block(request) catch:^RACSignal *(NSError *error) {
+            for (NSUInteger i = self->_count; i > 0; i--) {
+                ACEOAuth2RACInterceptorEntry entry = self->_entries[i - 1];
+                if (entry.methods & ACEOAuth2RACInterceptorMethodError) {
+                    error = [entry.interceptor interceptError:error forRequest:request];
+                }
+            }
+            return [RACSignal error:error];
+        }];
+    }];
+}
+
+- (NSURLRequest *)requestByInterceptingRequest:(NSURLRequest *)URLRequest
+{
+    if ((_methods & ACEOAuth2RACInterceptorMethodRequest) == 0) {
+        return URLRequest;
+    }
+    
+    NSURLRequest *request = URLRequest;
+    for (NSUInteger i = 0; i < _count; i++) {
+        ACEOAuth2RACInterceptorEntry entry = _entries[i];
+        if (entry.methods & ACEOAuth2RACInterceptorMethodRequest) {
+            request = [entry.interceptor interceptRequest:request];
+        }
+    }
+    return request;
+}
+
+@end
@@ -0,0 +1,69 @@
+// ACEOAuth2RACJSONResponseSerializer.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "AFURLResponseSerialization.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Decode a UTF-8 JSON document, leaving out the keys with a null value.
+
+ The result is the same of `NSJSONSerialization` followed by the null removal of `AFJSONResponseSerializer`:
+ the keys with a null value are removed from the dictionaries, while the null elements of the arrays are kept as `NSNull`.
+ A repeated key keeps its last value, which removes the key when that value is null.
+ Every container is built once, without the mutable copy of the whole tree made by the second pass.
+
+ @param data The JSON document, encoded in UTF-8.
+ @param options The `NSJSONReadingMutableContainers`, `NSJSONReadingMutableLeaves` and `NSJSONReadingAllowFragments` options.
+ @param error The error if the document is not valid, in the same domain and code of `NSJSONSerialization`.
+
+ @return The decoded object, nil if the document is not valid.
+ */
+extern id _Nullable ACEOAuth2RACJSONObjectRemovingNullValues(NSData *data, NSJSONReadingOptions options, NSError * _Nullable __autoreleasing * _Nullable error);
+
+/**
+ `ACEOAuth2RACJSONResponseSerializer` is a JSON response serializer that removes the keys with a null value
+ while parsing, when `removesKeysWithNullValues` is YES. Otherwise it behaves like `AFJSONResponseSerializer`.
+
+ The large documents are parsed in two stages: a vectorized pass finds the positions of all the structural characters,
+ then the objects are built walking those positions, without looking at the bytes between them again.
+ */
+@interface ACEOAuth2RACJSONResponseSerializer : AFJSONResponseSerializer
+
+/**
+ The size in bytes above which the documents are parsed with the structural index. Default is 1 MB.
+ Set it to `NSUIntegerMax` to always use `NSJSONSerialization`.
+ */
+@property (nonatomic, assign) NSUInteger structuralIndexThreshold;
+
+/**
+ YES to return dictionary and array proxies decoding their values only when first read,
+ so the screens reading a few fields of large objects don't pay for the whole document.
+ The proxies are immutable, the option is ignored with `NSJSONReadingMutableContainers`. Default is NO.
+ */
+@property (nonatomic, assign) BOOL decodesLazily;
+
+@end
+
+NS_ASSUME_NONNULL_END
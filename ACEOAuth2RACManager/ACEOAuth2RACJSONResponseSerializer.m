@@ -0,0 +1,949 @@
+// ACEOAuth2RACJSONResponseSerializer.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACJSONResponseSerializer.h"
+#import "ACEOAuth2RACJSONStructuralIndex.h"
+#import "ACEOAuth2RACLazyJSON.h"
+
+// nesting deeper than this is rejected, instead of running out of stack
+static NSUInteger const ACEOAuth2RACJSONMaxDepth = 512;
+
+typedef struct {
+    const uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger position;
+    NSUInteger depth;
+    NSJSONReadingOptions options;
+    
+    // the values of the open containers, owned by the caller
+    __unsafe_unretained NSMutableArray *stack;
+    
+    // the bytes of the strings with escapes
+    uint8_t *buffer;
+    NSUInteger bufferCapacity;
+    
+    // the structural characters, when walking an index
+    const uint32_t *structurals;
+    NSUInteger structuralCount;
+    NSUInteger structural;
+    BOOL removesNullValues;
+    
+    const char *failure;
+} ACEOAuth2RACJSONParser;
+
+static id ACEOAuth2RACJSONParseValue(ACEOAuth2RACJSONParser *parser);
+
+#pragma mark - Helpers
+
+static inline id ACEOAuth2RACJSONFail(ACEOAuth2RACJSONParser *parser, const char *failure)
+{
+    if (parser->failure == NULL) {
+        parser->failure = failure;
+    }
+    return nil;
+}
+
+static inline void ACEOAuth2RACJSONSkipWhitespace(ACEOAuth2RACJSONParser *parser)
+{
+    while (parser->position < parser->length) {
+        uint8_t c = parser->bytes[parser->position];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            break;
+        }
+        parser->position++;
+    }
+}
+
+static inline BOOL ACEOAuth2RACJSONConsumeLiteral(ACEOAuth2RACJSONParser *parser, const char *literal, NSUInteger length)
+{
+    if (parser->length - parser->position < length || memcmp(parser->bytes + parser->position, literal, length) != 0) {
+        return NO;
+    }
+    parser->position += length;
+    return YES;
+}
+
+static BOOL ACEOAuth2RACJSONReserveBuffer(ACEOAuth2RACJSONParser *parser, NSUInteger length)
+{
+    if (length <= parser->bufferCapacity) {
+        return YES;
+    }
+    
+    NSUInteger capacity = MAX(length, parser->bufferCapacity * 2);
+    uint8_t *buffer = realloc(parser->buffer, capacity);
+    if (buffer == NULL) {
+        return NO;
+    }
+    
+    parser->buffer          = buffer;
+    parser->bufferCapacity  = capacity;
+    return YES;
+}
+
+static inline int ACEOAuth2RACJSONHexValue(uint8_t c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static BOOL ACEOAuth2RACJSONReadHex4(ACEOAuth2RACJSONParser *parser, uint32_t *value)
+{
+    if (parser->length - parser->position < 4) {
+        return NO;
+    }
+    
+    uint32_t result = 0;
+    for (NSUInteger i = 0; i < 4; i++) {
+        int digit = ACEOAuth2RACJSONHexValue(parser->bytes[parser->position + i]);
+        if (digit < 0) {
+            return NO;
+        }
+        result = (result << 4) | (uint32_t)digit;
+    }
+    
+    parser->position += 4;
+    *value = result;
+    return YES;
+}
+
+static NSUInteger ACEOAuth2RACJSONEncodeUTF8(uint32_t codePoint, uint8_t *output)
+{
+    if (codePoint < 0x80) {
+        output[0] = (uint8_t)codePoint;
+        return 1;
+        
+    } else if (codePoint < 0x800) {
+        output[0] = (uint8_t)(0xc0 | (codePoint >> 6));
+        output[1] = (uint8_t)(0x80 | (codePoint & 0x3f));
+        return 2;
+        
+    } else if (codePoint < 0x10000) {
+        output[0] = (uint8_t)(0xe0 | (codePoint >> 12));
+        output[1] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3f));
+        output[2] = (uint8_t)(0x80 | (codePoint & 0x3f));
+        return 3;
+        
+    } else {
+        output[0] = (uint8_t)(0xf0 | (codePoint >> 18));
+        output[1] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3f));
+        output[2] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3f));
+        output[3] = (uint8_t)(0x80 | (codePoint & 0x3f));
+        return 4;
+    }
+}
+
+
+#pragma mark - Strings
+
+static NSString *ACEOAuth2RACJSONMakeString(ACEOAuth2RACJSONParser *parser, const uint8_t *bytes, NSUInteger length, BOOL isKey)
+{
+    Class stringClass = (!isKey && (parser->options & NSJSONReadingMutableLeaves)) ? [NSMutableString class] : [NSString class];
+    NSString *string = [[stringClass alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    return string ?: ACEOAuth2RACJSONFail(parser, "Invalid UTF-8 string");
+}
+
+// decode the bytes between the quotes, from `start` to the closing quote at `end`
+static NSString *ACEOAuth2RACJSONDecodeEscapedString(ACEOAuth2RACJSONParser *parser, NSUInteger start, NSUInteger end, BOOL isKey)
+{
+    // the escapes never make the string longer than in the document
+    if (!ACEOAuth2RACJSONReserveBuffer(parser, end - start)) {
+        return ACEOAuth2RACJSONFail(parser, "Out of memory");
+    }
+    
+    NSUInteger length = 0;
+    parser->position = start;
+    
+    while (parser->position < end) {
+        uint8_t c = parser->bytes[parser->position++];
+        if (c != '\\') {
+            parser->buffer[length++] = c;
+            continue;
+        }
+        
+        uint8_t escape = parser->bytes[parser->position++];
+        switch (escape) {
+            case '"':   parser->buffer[length++] = '"';     break;
+            case '\\':  parser->buffer[length++] = '\\';    break;
+            case '/':   parser->buffer[length++] = '/';     break;
+            case 'b':   parser->buffer[length++] = '\b';    break;
+            case 'f':   parser->buffer[length++] = '\f';    break;
+            case 'n':   parser->buffer[length++] = '\n';    break;
+            case 'r':   parser->buffer[length++] = '\r';    break;
+            case 't':   parser->buffer[length++] = '\t';    break;
+                
+            case 'u': {
+                uint32_t codePoint;
+                if (end - parser->position < 4 || !ACEOAuth2RACJSONReadHex4(parser, &codePoint)) {
+                    return ACEOAuth2RACJSONFail(parser, "Invalid unicode escape");
+                }
+                
+                if (codePoint >= 0xd800 && codePoint <= 0xdbff) {
+                    // a surrogate pair, in two escapes
+                    uint32_t lowSurrogate;
+                    if (end - parser->position < 6 ||
+                        !ACEOAuth2RACJSONConsumeLiteral(parser, "\\u", 2) ||
+                        !ACEOAuth2RACJSONReadHex4(parser, &lowSurrogate) ||
+                        lowSurrogate < 0xdc00 || lowSurrogate > 0xdfff) {
+                        return ACEOAuth2RACJSONFail(parser, "Invalid surrogate pair");
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (lowSurrogate - 0xdc00);
+                    
+                } else if (codePoint >= 0xdc00 && codePoint <= 0xdfff) {
+                    return ACEOAuth2RACJSONFail(parser, "Invalid surrogate pair");
+                }
+                
+                // at most 4 bytes for the 6 or 12 of the escape
+                length += ACEOAuth2RACJSONEncodeUTF8(codePoint, parser->buffer + length);
+                break;
+            }
+                
+            default:
+                return ACEOAuth2RACJSONFail(parser, "Invalid escape");
+        }
+    }
+    
+    // skip the closing quote
+    parser->position = end + 1;
+    return ACEOAuth2RACJSONMakeString(parser, parser->buffer, length, isKey);
+}
+
+static NSString *ACEOAuth2RACJSONParseString(ACEOAuth2RACJSONParser *parser, BOOL isKey)
+{
+    // skip the opening quote
+    NSUInteger start = ++parser->position;
+    BOOL hasEscapes = NO;
+    
+    while (parser->position < parser->length) {
+        uint8_t c = parser->bytes[parser->position];
+        if (c == '"') {
+            break;
+            
+        } else if (c == '\\') {
+            // the escaped character is skipped, it's validated while decoding
+            hasEscapes = YES;
+            parser->position++;
+            
+        } else if (c < 0x20) {
+            return ACEOAuth2RACJSONFail(parser, "Unescaped control character in string");
+        }
+        parser->position++;
+    }
+    
+    if (parser->position >= parser->length) {
+        return ACEOAuth2RACJSONFail(parser, "Unterminated string");
+    }
+    
+    if (hasEscapes) {
+        return ACEOAuth2RACJSONDecodeEscapedString(parser, start, parser->position, isKey);
+    }
+    
+    // most strings have no escapes, they are created straight from the document
+    NSString *string = ACEOAuth2RACJSONMakeString(parser, parser->bytes + start, parser->position - start, isKey);
+    parser->position++;
+    return string;
+}
+
+
+#pragma mark - Numbers
+
+static NSNumber *ACEOAuth2RACJSONParseNumber(ACEOAuth2RACJSONParser *parser)
+{
+    const uint8_t *bytes = parser->bytes;
+    NSUInteger start = parser->position;
+    
+    BOOL negative = (bytes[parser->position] == '-');
+    if (negative) {
+        parser->position++;
+    }
+    
+    if (parser->position >= parser->length || bytes[parser->position] < '0' || bytes[parser->position] > '9') {
+        return ACEOAuth2RACJSONFail(parser, "Invalid number");
+    }
+    
+    // the integer part, no leading zeros
+    uint64_t value = 0;
+    BOOL overflow = NO;
+    if (bytes[parser->position] == '0') {
+        parser->position++;
+        
+    } else {
+        while (parser->position < parser->length && bytes[parser->position] >= '0' && bytes[parser->position] <= '9') {
+            uint64_t digit = bytes[parser->position] - '0';
+            if (value > (UINT64_MAX - digit) / 10) {
+                overflow = YES;
+            }
+            value = value * 10 + digit;
+            parser->position++;
+        }
+    }
+    
+    BOOL isFloat = NO;
+    if (parser->position < parser->length && bytes[parser->position] == '.') {
+        isFloat = YES;
+        parser->position++;
+        
+        NSUInteger digits = parser->position;
+        while (parser->position < parser->length && bytes[parser->position] >= '0' && bytes[parser->position] <= '9') {
+            parser->position++;
+        }
+        if (parser->position == digits) {
+            return ACEOAuth2RACJSONFail(parser, "Invalid number");
+        }
+    }
+    
+    if (parser->position < parser->length && (bytes[parser->position] == 'e' || bytes[parser->position] == 'E')) {
+        isFloat = YES;
+        parser->position++;
+        
+        if (parser->position < parser->length && (bytes[parser->position] == '+' || bytes[parser->position] == '-')) {
+            parser->position++;
+        }
+        
+        NSUInteger digits = parser->position;
+        while (parser->position < parser->length && bytes[parser->position] >= '0' && bytes[parser->position] <= '9') {
+            parser->position++;
+        }
+        if (parser->position == digits) {
+            return ACEOAuth2RACJSONFail(parser, "Invalid number");
+        }
+    }
+    
+    if (!isFloat && !overflow) {
+        if (!negative) {
+            return (value <= INT64_MAX) ? @((int64_t)value) : @(value);
+            
+        } else if (value <= (uint64_t)INT64_MAX + 1) {
+            return @((int64_t)(0 - value));
+        }
+    }
+    
+    // strtod needs a terminated string
+    NSUInteger length = parser->position - start;
+    char stackBuffer[64];
+    char *buffer = (length < sizeof(stackBuffer)) ? stackBuffer : malloc(length + 1);
+    if (buffer == NULL) {
+        return ACEOAuth2RACJSONFail(parser, "Out of memory");
+    }
+    
+    memcpy(buffer, bytes + start, length);
+    buffer[length] = '\0';
+    double number = strtod(buffer, NULL);
+    
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+    
+    if (isinf(number)) {
+        return ACEOAuth2RACJSONFail(parser, "Number out of range");
+    }
+    return @(number);
+}
+
+
+#pragma mark - Containers
+
+// build the dictionary once, straight from the keys and the values collected on the stack after `base`
+static NSDictionary *ACEOAuth2RACJSONCollectDictionary(ACEOAuth2RACJSONParser *parser, NSUInteger base)
+{
+    NSMutableArray *stack = parser->stack;
+    NSUInteger count = (stack.count - base) / 2;
+    
+    __unsafe_unretained id *keys    = (__unsafe_unretained id *)malloc(MAX(count, 1) * sizeof(id));
+    __unsafe_unretained id *values  = (__unsafe_unretained id *)malloc(MAX(count, 1) * sizeof(id));
+    if (keys == NULL || values == NULL) {
+        free(keys);
+        free(values);
+        return ACEOAuth2RACJSONFail(parser, "Out of memory");
+    }
+    
+    NSNull *null = [NSNull null];
+    BOOL hasNullValues = NO;
+    for (NSUInteger i = 0; i < count; i++) {
+        keys[i]         = stack[base + 2 * i];
+        values[i]       = stack[base + 2 * i + 1];
+        hasNullValues   = hasNullValues || (values[i] == null);
+    }
+    
+    Class dictionaryClass = (parser->options & NSJSONReadingMutableContainers) ? [NSMutableDictionary class] : [NSDictionary class];
+    NSDictionary *dictionary = nil;
+    if (!hasNullValues || !parser->removesNullValues) {
+        dictionary = [dictionaryClass dictionaryWithObjects:values forKeys:keys count:count];
+    }
+    
+    if (dictionary.count < count) {
+        // a key repeated or a null value to remove: the last value of a key wins, like NSJSONSerialization,
+        // and only then its key is removed if the value is null, like AFNetworking
+        NSMutableDictionary *mutableDictionary = [NSMutableDictionary dictionaryWithCapacity:count];
+        for (NSUInteger i = 0; i < count; i++) {
+            mutableDictionary[keys[i]] = values[i];
+        }
+        
+        if (parser->removesNullValues) {
+            [mutableDictionary removeObjectsForKeys:[mutableDictionary allKeysForObject:null]];
+        }
+        dictionary = (dictionaryClass == [NSMutableDictionary class]) ? mutableDictionary : [mutableDictionary copy];
+    }
+    
+    free(keys);
+    free(values);
+    [stack removeObjectsInRange:NSMakeRange(base, stack.count - base)];
+    return dictionary;
+}
+
+// build the array once, straight from the values collected on the stack after `base`
+static NSArray *ACEOAuth2RACJSONCollectArray(ACEOAuth2RACJSONParser *parser, NSUInteger base)
+{
+    NSMutableArray *stack = parser->stack;
+    NSUInteger count = stack.count - base;
+    
+    __unsafe_unretained id *values = (__unsafe_unretained id *)malloc(MAX(count, 1) * sizeof(id));
+    if (values == NULL) {
+        return ACEOAuth2RACJSONFail(parser, "Out of memory");
+    }
+    
+    [stack getObjects:values range:NSMakeRange(base, count)];
+    
+    Class arrayClass = (parser->options & NSJSONReadingMutableContainers) ? [NSMutableArray class] : [NSArray class];
+    NSArray *array = [arrayClass arrayWithObjects:values count:count];
+    
+    free(values);
+    [stack removeObjectsInRange:NSMakeRange(base, count)];
+    return array;
+}
+
+static id ACEOAuth2RACJSONParseObject(ACEOAuth2RACJSONParser *parser)
+{
+    NSMutableArray *stack = parser->stack;
+    NSUInteger base = stack.count;
+    
+    // skip the opening brace
+    parser->position++;
+    ACEOAuth2RACJSONSkipWhitespace(parser);
+    
+    if (parser->position < parser->length && parser->bytes[parser->position] == '}') {
+        parser->position++;
+        
+    } else {
+        while (YES) {
+            ACEOAuth2RACJSONSkipWhitespace(parser);
+            if (parser->position >= parser->length || parser->bytes[parser->position] != '"') {
+                return ACEOAuth2RACJSONFail(parser, "Expected a key");
+            }
+            
+            NSString *key = ACEOAuth2RACJSONParseString(parser, YES);
+            if (key == nil) {
+                return nil;
+            }
+            
+            ACEOAuth2RACJSONSkipWhitespace(parser);
+            if (parser->position >= parser->length || parser->bytes[parser->position] != ':') {
+                return ACEOAuth2RACJSONFail(parser, "Expected a colon");
+            }
+            parser->position++;
+            ACEOAuth2RACJSONSkipWhitespace(parser);
+            
+            // the keys with a null value are removed when the dictionary is built
+            id value = ACEOAuth2RACJSONParseValue(parser);
+            if (value == nil) {
+                return nil;
+            }
+            [stack addObject:key];
+            [stack addObject:value];
+            
+            ACEOAuth2RACJSONSkipWhitespace(parser);
+            if (parser->position < parser->length && parser->bytes[parser->position] == ',') {
+                parser->position++;
+                
+            } else if (parser->position < parser->length && parser->bytes[parser->position] == '}') {
+                parser->position++;
+                break;
+                
+            } else {
+                return ACEOAuth2RACJSONFail(parser, "Expected a comma or a closing brace");
+            }
+        }
+    }
+    
+    return ACEOAuth2RACJSONCollectDictionary(parser, base);
+}
+
+static id ACEOAuth2RACJSONParseArray(ACEOAuth2RACJSONParser *parser)
+{
+    NSMutableArray *stack = parser->stack;
+    NSUInteger base = stack.count;
+    
+    // skip the opening bracket
+    parser->position++;
+    ACEOAuth2RACJSONSkipWhitespace(parser);
+    
+    if (parser->position < parser->length && parser->bytes[parser->position] == ']') {
+        parser->position++;
+        
+    } else {
+        while (YES) {
+            ACEOAuth2RACJSONSkipWhitespace(parser);
+            
+            // the null elements are kept, like AFNetworking does
+            id value = ACEOAuth2RACJSONParseValue(parser);
+            if (value == nil) {
+                return nil;
+            }
+            [stack addObject:value];
+            
+            ACEOAuth2RACJSONSkipWhitespace(parser);
+            if (parser->position < parser->length && parser->bytes[parser->position] == ',') {
+                parser->position++;
+                
+            } else if (parser->position < parser->length && parser->bytes[parser->position] == ']') {
+                parser->position++;
+                break;
+                
+            } else {
+                return ACEOAuth2RACJSONFail(parser, "Expected a comma or a closing bracket");
+            }
+        }
+    }
+    
+    return ACEOAuth2RACJSONCollectArray(parser, base);
+}
+
+
+#pragma mark - Values
+
+static id ACEOAuth2RACJSONParseValue(ACEOAuth2RACJSONParser *parser)
+{
+    if (parser->position >= parser->length) {
+        return ACEOAuth2RACJSONFail(parser, "Unexpected end of data");
+    }
+    
+    switch (parser->bytes[parser->position]) {
+        case '{':
+        case '[': {
+            if (++parser->depth > ACEOAuth2RACJSONMaxDepth) {
+                return ACEOAuth2RACJSONFail(parser, "Too many nested containers");
+            }
+            
+            id container = (parser->bytes[parser->position] == '{') ? ACEOAuth2RACJSONParseObject(parser) : ACEOAuth2RACJSONParseArray(parser);
+            parser->depth--;
+            return container;
+        }
+            
+        case '"':
+            return ACEOAuth2RACJSONParseString(parser, NO);
+            
+        case 't':
+            return ACEOAuth2RACJSONConsumeLiteral(parser, "true", 4) ? @YES : ACEOAuth2RACJSONFail(parser, "Invalid literal");
+            
+        case 'f':
+            return ACEOAuth2RACJSONConsumeLiteral(parser, "false", 5) ? @NO : ACEOAuth2RACJSONFail(parser, "Invalid literal");
+            
+        case 'n':
+            return ACEOAuth2RACJSONConsumeLiteral(parser, "null", 4) ? [NSNull null] : ACEOAuth2RACJSONFail(parser, "Invalid literal");
+            
+        default:
+            return ACEOAuth2RACJSONParseNumber(parser);
+    }
+}
+
+id ACEOAuth2RACJSONObjectRemovingNullValues(NSData *data, NSJSONReadingOptions options, NSError *__autoreleasing *error)
+{
+    NSMutableArray *stack = [NSMutableArray array];
+    
+    ACEOAuth2RACJSONParser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.bytes                = data.bytes;
+    parser.length               = data.length;
+    parser.options              = options;
+    parser.stack                = stack;
+    parser.removesNullValues    = YES;
+    
+    // the byte order mark of UTF-8
+    if (parser.length >= 3 && memcmp(parser.bytes, "\xef\xbb\xbf", 3) == 0) {
+        parser.position = 3;
+    }
+    
+    ACEOAuth2RACJSONSkipWhitespace(&parser);
+    
+    id object = nil;
+    if (parser.position < parser.length && parser.bytes[parser.position] != '{' && parser.bytes[parser.position] != '[' && !(options & NSJSONReadingAllowFragments)) {
+        ACEOAuth2RACJSONFail(&parser, "The root is not an object or an array");
+        
+    } else {
+        object = ACEOAuth2RACJSONParseValue(&parser);
+        ACEOAuth2RACJSONSkipWhitespace(&parser);
+        
+        if (object != nil && parser.position < parser.length) {
+            object = ACEOAuth2RACJSONFail(&parser, "Garbage at end");
+        }
+    }
+    
+    free(parser.buffer);
+    
+    if (object == nil && error != NULL) {
+        *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                     code:NSPropertyListReadCorruptError
+                                 userInfo:@{
+                                            NSDebugDescriptionErrorKey: [NSString stringWithFormat:@"%s around character %lu.", parser.failure, (unsigned long)parser.position]
+                                            }];
+    }
+    return object;
+}
+
+
+#pragma mark - Structural Index
+
+static id ACEOAuth2RACJSONIndexedValue(ACEOAuth2RACJSONParser *parser);
+
+// the character of the current structural, 0 at the end of the index
+static inline uint8_t ACEOAuth2RACJSONIndexedPeek(ACEOAuth2RACJSONParser *parser)
+{
+    if (parser->structural >= parser->structuralCount) {
+        parser->position = parser->length;
+        return 0;
+    }
+    
+    parser->position = parser->structurals[parser->structural];
+    return parser->bytes[parser->position];
+}
+
+static NSString *ACEOAuth2RACJSONIndexedString(ACEOAuth2RACJSONParser *parser, BOOL isKey)
+{
+    // the index holds both quotes, the control characters were already rejected
+    NSUInteger start    = parser->structurals[parser->structural] + 1;
+    NSUInteger end      = parser->structurals[parser->structural + 1];
+    parser->structural += 2;
+    
+    if (memchr(parser->bytes + start, '\\', end - start) != NULL) {
+        return ACEOAuth2RACJSONDecodeEscapedString(parser, start, end, isKey);
+    }
+    return ACEOAuth2RACJSONMakeString(parser, parser->bytes + start, end - start, isKey);
+}
+
+static id ACEOAuth2RACJSONIndexedObject(ACEOAuth2RACJSONParser *parser)
+{
+    NSMutableArray *stack = parser->stack;
+    NSUInteger base = stack.count;
+    
+    // skip the opening brace
+    parser->structural++;
+    
+    if (ACEOAuth2RACJSONIndexedPeek(parser) == '}') {
+        parser->structural++;
+        
+    } else {
+        while (YES) {
+            if (ACEOAuth2RACJSONIndexedPeek(parser) != '"') {
+                return ACEOAuth2RACJSONFail(parser, "Expected a key");
+            }
+            
+            NSString *key = ACEOAuth2RACJSONIndexedString(parser, YES);
+            if (key == nil) {
+                return nil;
+            }
+            
+            if (ACEOAuth2RACJSONIndexedPeek(parser) != ':') {
+                return ACEOAuth2RACJSONFail(parser, "Expected a colon");
+            }
+            parser->structural++;
+            
+            id value = ACEOAuth2RACJSONIndexedValue(parser);
+            if (value == nil) {
+                return nil;
+            }
+            
+            [stack addObject:key];
+            [stack addObject:value];
+            
+            uint8_t c = ACEOAuth2RACJSONIndexedPeek(parser);
+            parser->structural++;
+            
+            if (c == '}') {
+                break;
+                
+            } else if (c != ',') {
+                return ACEOAuth2RACJSONFail(parser, "Expected a comma or a closing brace");
+            }
+        }
+    }
+    
+    return ACEOAuth2RACJSONCollectDictionary(parser, base);
+}
+
+static id ACEOAuth2RACJSONIndexedArray(ACEOAuth2RACJSONParser *parser)
+{
+    NSMutableArray *stack = parser->stack;
+    NSUInteger base = stack.count;
+    
+    // skip the opening bracket
+    parser->structural++;
+    
+    if (ACEOAuth2RACJSONIndexedPeek(parser) == ']') {
+        parser->structural++;
+        
+    } else {
+        while (YES) {
+            id value = ACEOAuth2RACJSONIndexedValue(parser);
+            if (value == nil) {
+                return nil;
+            }
+            [stack addObject:value];
+            
+            uint8_t c = ACEOAuth2RACJSONIndexedPeek(parser);
+            parser->structural++;
+            
+            if (c == ']') {
+                break;
+                
+            } else if (c != ',') {
+                return ACEOAuth2RACJSONFail(parser, "Expected a comma or a closing bracket");
+            }
+        }
+    }
+    
+    return ACEOAuth2RACJSONCollectArray(parser, base);
+}
+
+static id ACEOAuth2RACJSONIndexedValue(ACEOAuth2RACJSONParser *parser)
+{
+    switch (ACEOAuth2RACJSONIndexedPeek(parser)) {
+        case 0:
+            return ACEOAuth2RACJSONFail(parser, "Unexpected end of data");
+            
+        case '{':
+        case '[': {
+            if (++parser->depth > ACEOAuth2RACJSONMaxDepth) {
+                return ACEOAuth2RACJSONFail(parser, "Too many nested containers");
+            }
+            
+            id container = (parser->bytes[parser->position] == '{') ? ACEOAuth2RACJSONIndexedObject(parser) : ACEOAuth2RACJSONIndexedArray(parser);
+            parser->depth--;
+            return container;
+        }
+            
+        case '"':
+            return ACEOAuth2RACJSONIndexedString(parser, NO);
+            
+        case '}':
+        case ']':
+        case ':':
+        case ',':
+            return ACEOAuth2RACJSONFail(parser, "Expected a value");
+            
+        default: {
+            // a number or a literal, that must end right before the next structural character
+            id value = ACEOAuth2RACJSONParseValue(parser);
+            if (value == nil) {
+                return nil;
+            }
+            
+            parser->structural++;
+            NSUInteger end = (parser->structural < parser->structuralCount) ? parser->structurals[parser->structural] : parser->length;
+            
+            ACEOAuth2RACJSONSkipWhitespace(parser);
+            if (parser->position != end) {
+                return ACEOAuth2RACJSONFail(parser, "Invalid value");
+            }
+            return value;
+        }
+    }
+}
+
+static id ACEOAuth2RACJSONObjectWithStructuralIndex(NSData *data, NSJSONReadingOptions options, BOOL removesNullValues, NSError *__autoreleasing *error)
+{
+    NSMutableArray *stack = [NSMutableArray array];
+    
+    ACEOAuth2RACJSONParser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.bytes                = data.bytes;
+    parser.length               = data.length;
+    parser.options              = options;
+    parser.stack                = stack;
+    parser.removesNullValues    = removesNullValues;
+    
+    // the byte order mark of UTF-8, the positions of the index are relative to the document after it
+    if (parser.length >= 3 && memcmp(parser.bytes, "\xef\xbb\xbf", 3) == 0) {
+        parser.bytes    += 3;
+        parser.length   -= 3;
+    }
+    
+    id object = nil;
+    ACEOAuth2RACJSONStructuralIndex index = { 0 };
+    size_t errorPosition = 0;
+    
+    switch (ACEOAuth2RACJSONStructuralIndexBuild(parser.bytes, parser.length, &index, &errorPosition)) {
+        case ACEOAuth2RACJSONStructuralIndexSuccess: {
+            parser.structurals      = index.positions;
+            parser.structuralCount  = index.count;
+            
+            uint8_t c = ACEOAuth2RACJSONIndexedPeek(&parser);
+            if (c != 0 && c != '{' && c != '[' && !(options & NSJSONReadingAllowFragments)) {
+                ACEOAuth2RACJSONFail(&parser, "The root is not an object or an array");
+                
+            } else {
+                object = ACEOAuth2RACJSONIndexedValue(&parser);
+                
+                if (object != nil && ACEOAuth2RACJSONIndexedPeek(&parser) != 0) {
+                    object = ACEOAuth2RACJSONFail(&parser, "Garbage at end");
+                }
+            }
+            break;
+        }
+            
+        case ACEOAuth2RACJSONStructuralIndexUnterminatedString:
+            parser.position = errorPosition;
+            ACEOAuth2RACJSONFail(&parser, "Unterminated string");
+            break;
+            
+        case ACEOAuth2RACJSONStructuralIndexControlCharacter:
+            parser.position = errorPosition;
+            ACEOAuth2RACJSONFail(&parser, "Unescaped control character in string");
+            break;
+            
+        default:
+            ACEOAuth2RACJSONFail(&parser, "Out of memory");
+            break;
+    }
+    
+    ACEOAuth2RACJSONStructuralIndexFree(&index);
+    free(parser.buffer);
+    
+    if (object == nil && error != NULL) {
+        *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                     code:NSPropertyListReadCorruptError
+                                 userInfo:@{
+                                            NSDebugDescriptionErrorKey: [NSString stringWithFormat:@"%s around character %lu.", parser.failure, (unsigned long)parser.position]
+                                            }];
+    }
+    return object;
+}
+
+
+#pragma mark -
+
+// the content type error is the underlying error of the status code one, when both fail
+static BOOL ACEOAuth2RACErrorOrUnderlyingErrorHasCodeInDomain(NSError *error, NSInteger code, NSString *domain)
+{
+    for (; error != nil; error = error.userInfo[NSUnderlyingErrorKey]) {
+        if (error.code == code && [error.domain isEqualToString:domain]) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+@implementation ACEOAuth2RACJSONResponseSerializer
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self.structuralIndexThreshold = 1024 * 1024;
+    }
+    return self;
+}
+
+- (id)responseObjectForResponse:(NSURLResponse *)response data:(NSData *)data error:(NSError *__autoreleasing *)error
+{
+    // only UTF-8 is parsed here, the other encodings start with a zero byte
+    BOOL isUTF8 = data.length < 2 || (((const uint8_t *)data.bytes)[0] != 0 && ((const uint8_t *)data.bytes)[1] != 0);
+    BOOL usesStructuralIndex = (data.length >= self.structuralIndexThreshold);
+    BOOL decodesLazily = self.decodesLazily && !(self.readingOptions & NSJSONReadingMutableContainers);
+    
+    if (!isUTF8 || (!self.removesKeysWithNullValues && !usesStructuralIndex && !decodesLazily)) {
+        return [super responseObjectForResponse:response data:data error:error];
+    }
+    
+    // the same checks of the superclass, with a single parsing pass
+    NSError *validationError;
+    if (![self validateResponse:(NSHTTPURLResponse *)response data:data error:&validationError]) {
+        if (error != NULL) {
+            *error = validationError;
+        }
+        
+        if (error == NULL || ACEOAuth2RACErrorOrUnderlyingErrorHasCodeInDomain(validationError, NSURLErrorCannotDecodeContentData, AFURLResponseSerializationErrorDomain)) {
+            return nil;
+        }
+    }
+    
+    // a single space is returned by some servers for empty responses
+    BOOL isSpace = (data.length == 1 && ((const uint8_t *)data.bytes)[0] == ' ');
+    if (data.length == 0 || isSpace) {
+        return nil;
+    }
+    
+    NSError *serializationError;
+    id responseObject;
+    
+    if (decodesLazily) {
+        responseObject = ACEOAuth2RACLazyJSONObjectWithData(data, self.readingOptions, self.removesKeysWithNullValues, &serializationError);
+        
+    } else if (usesStructuralIndex) {
+        responseObject = ACEOAuth2RACJSONObjectWithStructuralIndex(data, self.readingOptions, self.removesKeysWithNullValues, &serializationError);
+        
+    } else {
+        responseObject = ACEOAuth2RACJSONObjectRemovingNullValues(data, self.readingOptions, &serializationError);
+    }
+    
+    if (validationError == nil && error != NULL) {
+        *error = serializationError;
+    }
+    return responseObject;
+}
+
+
+#pragma mark - NSSecureCoding
+
+- (instancetype)initWithCoder:(NSCoder *)decoder
+{
+    self = [super initWithCoder:decoder];
+    if (self) {
+        self.structuralIndexThreshold = [[decoder decodeObjectOfClass:[NSNumber class] forKey:NSStringFromSelector(@selector(structuralIndexThreshold))] unsignedIntegerValue];
+        self.decodesLazily = [[decoder decodeObjectOfClass:[NSNumber class] forKey:NSStringFromSelector(@selector(decodesLazily))] boolValue];
+    }
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)coder
+{
+    [super encodeWithCoder:coder];
+    
+    [coder encodeObject:@(self.structuralIndexThreshold) forKey:NSStringFromSelector(@selector(structuralIndexThreshold))];
+    [coder encodeObject:@(self.decodesLazily) forKey:NSStringFromSelector(@selector(decodesLazily))];
+}
+
+
+#pragma mark - NSCopying
+
+- (instancetype)copyWithZone:(NSZone *)zone
+{
+    ACEOAuth2RACJSONResponseSerializer *serializer = [super copyWithZone:zone];
+    serializer.structuralIndexThreshold = self.structuralIndexThreshold;
+    serializer.decodesLazily = self.decodesLazily;
+    
+    return serializer;
+}
+
+@end
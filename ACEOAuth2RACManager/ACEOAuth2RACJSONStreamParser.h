@@ -0,0 +1,70 @@
+// ACEOAuth2RACJSONStreamParser.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `ACEOAuth2RACJSONStreamParser` decodes the elements of a JSON array while the bytes arrive.
+
+ The array can be the root of the document, or the value of a key of the root object.
+ Only the bytes of the element being received are kept in memory, each element
+ is decoded as soon as it is complete.
+ */
+@interface ACEOAuth2RACJSONStreamParser : NSObject
+
+/**
+ Initializes a parser.
+
+ @param itemsKey The key of the root object containing the array, nil if the array is the root.
+
+ @return The newly-initialized parser.
+ */
+- (instancetype)initWithItemsKey:(nullable NSString *)itemsKey;
+
+/**
+ Feed the parser with the next chunk of the document.
+
+ @param data The bytes received.
+ @param elementHandler The block called with each element completed by this chunk.
+ @param error The error if the chunk is not valid.
+
+ @return NO if the parsing failed.
+ */
+- (BOOL)parseData:(NSData *)data
+   elementHandler:(void (^)(id element))elementHandler
+            error:(NSError * _Nullable __autoreleasing *)error;
+
+/**
+ Tell the parser the document is complete.
+
+ @param error The error if the document was truncated or didn't contain the array.
+
+ @return NO if the document is not valid.
+ */
+- (BOOL)finishWithError:(NSError * _Nullable __autoreleasing *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
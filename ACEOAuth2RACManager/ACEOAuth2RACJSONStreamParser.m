@@ -0,0 +1,298 @@
+// ACEOAuth2RACJSONStreamParser.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import "ACEOAuth2RACJSONStreamParser.h"
+#import "ACEOAuth2RACManager.h"
+
+@implementation ACEOAuth2RACJSONStreamParser {
+    NSString *_itemsKey;
+    NSData *_itemsKeyData;
+
+    // position in the document
+    NSUInteger _depth;
+    BOOL _inString;
+    BOOL _escaped;
+    BOOL _rootIsObject;
+
+    // keys of the root object, used to find the array
+    BOOL _expectingValue;
+    BOOL _capturingKey;
+    BOOL _keyMatches;
+    NSMutableData *_key;
+
+    // the streamed array, its depth is 0 until it is found
+    NSUInteger _arrayDepth;
+    BOOL _foundArray;
+    BOOL _finished;
+    BOOL _expectingElement;
+
+    // the bytes of the element split across chunks
+    BOOL _inElement;
+    NSMutableData *_element;
+}
+
+- (instancetype)initWithItemsKey:(NSString *)itemsKey
+{
+    self = [super init];
+    if (self) {
+        _itemsKey       = [itemsKey copy];
+        _itemsKeyData   = [itemsKey dataUsingEncoding:NSUTF8StringEncoding];
+        _key            = [NSMutableData data];
+        _element        = [NSMutableData data];
+    }
+    return self;
+}
+
+
+#pragma mark - Parsing
+
+- (BOOL)parseData:(NSData *)data
+   elementHandler:(void (^)(id element))elementHandler
+            error:(NSError *__autoreleasing *)error
+{
+    __block BOOL success = YES;
+    __block NSError *parseError;
+
+    // walk the regions of the data, without flattening it
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        NSError *rangeError;
+        if (![self parseBytes:bytes length:byteRange.length elementHandler:elementHandler error:&rangeError]) {
+            parseError  = rangeError;
+            success     = NO;
+            *stop       = YES;
+        }
+    }];
+
+    if (!success && error != NULL) {
+        *error = parseError;
+    }
+    return success;
+}
+
+- (BOOL)parseBytes:(const uint8_t *)bytes
+            length:(NSUInteger)length
+    elementHandler:(void (^)(id element))elementHandler
+             error:(NSError *__autoreleasing *)error
+{
+    // an element or a key can continue from the previous chunk
+    NSUInteger elementStart = _inElement ? 0 : NSNotFound;
+    NSUInteger keyStart     = _capturingKey ? 0 : NSNotFound;
+
+    for (NSUInteger i = 0; i < length && !_finished; i++) {
+        uint8_t c = bytes[i];
+
+        if (_inString) {
+            if (_escaped) {
+                _escaped = NO;
+
+            } else if (c == '\\') {
+                _escaped = YES;
+
+            } else if (c == '"') {
+                _inString = NO;
+
+                if (_capturingKey) {
+                    [_key appendBytes:bytes + keyStart length:i - keyStart];
+                    _keyMatches     = [self capturedKeyMatches];
+                    _capturingKey   = NO;
+                    keyStart        = NSNotFound;
+                }
+            }
+            continue;
+        }
+
+        BOOL atArrayLevel = (_arrayDepth > 0 && _depth == _arrayDepth);
+
+        switch (c) {
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                break;
+
+            case '"':
+                if (atArrayLevel && !_inElement) {
+                    _inElement      = YES;
+                    elementStart    = i;
+
+                } else if (!_foundArray && _rootIsObject && _depth == 1 && !_expectingValue) {
+                    // a key of the root object
+                    _capturingKey   = YES;
+                    _key.length     = 0;
+                    keyStart        = i + 1;
+                }
+                _inString = YES;
+                break;
+
+            case '{':
+            case '[':
+                if (atArrayLevel && !_inElement) {
+                    _inElement      = YES;
+                    elementStart    = i;
+
+                } else if (!_foundArray && _depth == 0) {
+                    _rootIsObject = (c == '{');
+
+                    if (c == '[' && _itemsKeyData == nil) {
+                        _arrayDepth = 1;
+                        _foundArray = YES;
+                    }
+
+                } else if (!_foundArray && _depth == 1 && _rootIsObject && _expectingValue && _keyMatches && c == '[') {
+                    _arrayDepth = 2;
+                    _foundArray = YES;
+                }
+                _depth++;
+                break;
+
+            case '}':
+            case ']':
+                if (_depth == 0) {
+                    return [self failWithReason:@"Unbalanced brackets" error:error];
+                }
+
+                if (atArrayLevel) {
+                    if (!_inElement && _expectingElement) {
+                        return [self failWithReason:@"Missing array element" error:error];
+                    }
+
+                    // the end of the streamed array, ignore the rest of the document
+                    if (_inElement && ![self finishElementWithBytes:bytes start:elementStart end:i elementHandler:elementHandler error:error]) {
+                        return NO;
+                    }
+                    elementStart    = NSNotFound;
+                    _finished       = YES;
+                }
+                _depth--;
+                break;
+
+            case ',':
+                if (atArrayLevel) {
+                    if (!_inElement) {
+                        return [self failWithReason:@"Missing array element" error:error];
+                    }
+                    if (![self finishElementWithBytes:bytes start:elementStart end:i elementHandler:elementHandler error:error]) {
+                        return NO;
+                    }
+                    elementStart        = NSNotFound;
+                    _expectingElement   = YES;
+
+                } else if (_depth == 1) {
+                    _expectingValue = NO;
+                }
+                break;
+
+            case ':':
+                if (_depth == 1) {
+                    _expectingValue = YES;
+                }
+                break;
+
+            default:
+                // numbers, true, false and null
+                if (atArrayLevel && !_inElement) {
+                    _inElement      = YES;
+                    elementStart    = i;
+                }
+                break;
+        }
+    }
+
+    // keep the partial element and key for the next chunk
+    if (_inElement && elementStart != NSNotFound) {
+        [_element appendBytes:bytes + elementStart length:length - elementStart];
+    }
+    if (_capturingKey && keyStart != NSNotFound) {
+        [_key appendBytes:bytes + keyStart length:length - keyStart];
+    }
+    return YES;
+}
+
+- (BOOL)capturedKeyMatches
+{
+    if (memchr(_key.bytes, '\\', _key.length) == NULL) {
+        return [_key isEqualToData:_itemsKeyData];
+    }
+
+    // the escapes are decoded parsing the key as a string
+    NSMutableData *fragment = [NSMutableData dataWithBytes:"\"" length:1];
+    [fragment appendData:_key];
+    [fragment appendBytes:"\"" length:1];
+
+    NSString *key = [NSJSONSerialization JSONObjectWithData:fragment options:NSJSONReadingAllowFragments error:NULL];
+    return [key isKindOfClass:[NSString class]] && [key isEqualToString:_itemsKey];
+}
+
+- (BOOL)finishElementWithBytes:(const uint8_t *)bytes
+                         start:(NSUInteger)start
+                           end:(NSUInteger)end
+                elementHandler:(void (^)(id element))elementHandler
+                         error:(NSError *__autoreleasing *)error
+{
+    NSData *elementData;
+    if (_element.length > 0) {
+        // the element started in a previous chunk
+        [_element appendBytes:bytes + start length:end - start];
+        elementData = _element;
+
+    } else {
+        elementData = [NSData dataWithBytesNoCopy:(void *)(bytes + start) length:end - start freeWhenDone:NO];
+    }
+
+    id element = [NSJSONSerialization JSONObjectWithData:elementData options:NSJSONReadingAllowFragments error:error];
+
+    _element.length = 0;
+    _inElement      = NO;
+
+    if (element == nil) {
+        return NO;
+    }
+
+    elementHandler(element);
+    return YES;
+}
+
+- (BOOL)finishWithError:(NSError *__autoreleasing *)error
+{
+    if (!_foundArray) {
+        return [self failWithReason:@"The document doesn't contain the array" error:error];
+
+    } else if (!_finished) {
+        return [self failWithReason:@"The document is truncated" error:error];
+
+    } else {
+        return YES;
+    }
+}
+
+- (BOOL)failWithReason:(NSString *)reason error:(NSError *__autoreleasing *)error
+{
+    if (error != NULL) {
+        *error = [NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                                     code:ACEOAuth2RACErrorInvalidJSON
+                                 userInfo:@{ NSLocalizedDescriptionKey: reason }];
+    }
+    return NO;
+}
+
+@end
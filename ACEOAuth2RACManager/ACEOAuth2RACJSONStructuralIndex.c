@@ -0,0 +1,373 @@
+// ACEOAuth2RACJSONStructuralIndex.c
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#include "ACEOAuth2RACJSONStructuralIndex.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// the document is classified in blocks of 64 bytes, one bit per byte
+typedef struct {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t whitespace;
+    uint64_t operators;
+    uint64_t control;
+} ACEOAuth2RACJSONBlock;
+
+typedef void (*ACEOAuth2RACJSONClassifier)(const uint8_t *bytes, ACEOAuth2RACJSONBlock *block);
+
+
+#pragma mark - Scalar
+
+enum {
+    ACEOAuth2RACJSONClassQuote        = 1 << 0,
+    ACEOAuth2RACJSONClassBackslash    = 1 << 1,
+    ACEOAuth2RACJSONClassWhitespace   = 1 << 2,
+    ACEOAuth2RACJSONClassOperator     = 1 << 3,
+    ACEOAuth2RACJSONClassControl      = 1 << 4,
+};
+
+static uint8_t ACEOAuth2RACJSONClasses[256];
+
+static void ACEOAuth2RACJSONSetupClasses(void)
+{
+    for (int c = 0; c < 0x20; c++) {
+        ACEOAuth2RACJSONClasses[c] = ACEOAuth2RACJSONClassControl;
+    }
+    
+    ACEOAuth2RACJSONClasses['"']    = ACEOAuth2RACJSONClassQuote;
+    ACEOAuth2RACJSONClasses['\\']   = ACEOAuth2RACJSONClassBackslash;
+    ACEOAuth2RACJSONClasses[' ']    = ACEOAuth2RACJSONClassWhitespace;
+    ACEOAuth2RACJSONClasses['\t']  |= ACEOAuth2RACJSONClassWhitespace;
+    ACEOAuth2RACJSONClasses['\n']  |= ACEOAuth2RACJSONClassWhitespace;
+    ACEOAuth2RACJSONClasses['\r']  |= ACEOAuth2RACJSONClassWhitespace;
+    ACEOAuth2RACJSONClasses['{']    = ACEOAuth2RACJSONClassOperator;
+    ACEOAuth2RACJSONClasses['}']    = ACEOAuth2RACJSONClassOperator;
+    ACEOAuth2RACJSONClasses['[']    = ACEOAuth2RACJSONClassOperator;
+    ACEOAuth2RACJSONClasses[']']    = ACEOAuth2RACJSONClassOperator;
+    ACEOAuth2RACJSONClasses[':']    = ACEOAuth2RACJSONClassOperator;
+    ACEOAuth2RACJSONClasses[',']    = ACEOAuth2RACJSONClassOperator;
+}
+
+// the fallback of the architectures without a vector classifier, same condition as its dispatch
+#if !defined(__aarch64__) && !((defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__))
+
+static void ACEOAuth2RACJSONClassifyScalar(const uint8_t *bytes, ACEOAuth2RACJSONBlock *block)
+{
+    memset(block, 0, sizeof(*block));
+    
+    for (int i = 0; i < 64; i++) {
+        uint8_t classes = ACEOAuth2RACJSONClasses[bytes[i]];
+        uint64_t bit = 1ULL << i;
+        
+        if (classes & ACEOAuth2RACJSONClassQuote)       block->quote       |= bit;
+        if (classes & ACEOAuth2RACJSONClassBackslash)   block->backslash   |= bit;
+        if (classes & ACEOAuth2RACJSONClassWhitespace)  block->whitespace  |= bit;
+        if (classes & ACEOAuth2RACJSONClassOperator)    block->operators    |= bit;
+        if (classes & ACEOAuth2RACJSONClassControl)     block->control     |= bit;
+    }
+}
+
+#endif
+
+
+#pragma mark - x86
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+
+static void ACEOAuth2RACJSONClassifySSE2(const uint8_t *bytes, ACEOAuth2RACJSONBlock *block)
+{
+    memset(block, 0, sizeof(*block));
+    
+    for (int i = 0; i < 4; i++) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(bytes + 16 * i));
+        
+        __m128i quote       = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+        __m128i backslash   = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'));
+        __m128i whitespace  = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+                                           _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+        
+        // the brackets and the braces differ by 0x20 only
+        __m128i folded      = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+        __m128i operators    = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+                                           _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))));
+        
+        // unsigned x <= 0x1f
+        __m128i control     = _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(0x1f)), chunk);
+        
+        int shift = 16 * i;
+        block->quote        |= (uint64_t)(uint16_t)_mm_movemask_epi8(quote) << shift;
+        block->backslash    |= (uint64_t)(uint16_t)_mm_movemask_epi8(backslash) << shift;
+        block->whitespace   |= (uint64_t)(uint16_t)_mm_movemask_epi8(whitespace) << shift;
+        block->operators     |= (uint64_t)(uint16_t)_mm_movemask_epi8(operators) << shift;
+        block->control      |= (uint64_t)(uint16_t)_mm_movemask_epi8(control) << shift;
+    }
+}
+
+__attribute__((target("avx2")))
+static void ACEOAuth2RACJSONClassifyAVX2(const uint8_t *bytes, ACEOAuth2RACJSONBlock *block)
+{
+    memset(block, 0, sizeof(*block));
+    
+    for (int i = 0; i < 2; i++) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(bytes + 32 * i));
+        
+        __m256i quote       = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+        __m256i backslash   = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'));
+        __m256i whitespace  = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+                                              _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'))));
+        
+        __m256i folded      = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+        __m256i operators    = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+                                              _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(','))));
+        
+        __m256i control     = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, _mm256_set1_epi8(0x1f)), chunk);
+        
+        int shift = 32 * i;
+        block->quote        |= (uint64_t)(uint32_t)_mm256_movemask_epi8(quote) << shift;
+        block->backslash    |= (uint64_t)(uint32_t)_mm256_movemask_epi8(backslash) << shift;
+        block->whitespace   |= (uint64_t)(uint32_t)_mm256_movemask_epi8(whitespace) << shift;
+        block->operators     |= (uint64_t)(uint32_t)_mm256_movemask_epi8(operators) << shift;
+        block->control      |= (uint64_t)(uint32_t)_mm256_movemask_epi8(control) << shift;
+    }
+}
+
+#endif
+
+
+#pragma mark - ARM
+
+#if defined(__aarch64__)
+
+static inline uint64_t ACEOAuth2RACJSONMaskNEON(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3)
+{
+    // weight each lane by its bit, then fold the four vectors with pairwise additions
+    const uint8x16_t bits = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(m0, bits), vandq_u8(m1, bits));
+    uint8x16_t sum1 = vpaddq_u8(vandq_u8(m2, bits), vandq_u8(m3, bits));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+static void ACEOAuth2RACJSONClassifyNEON(const uint8_t *bytes, ACEOAuth2RACJSONBlock *block)
+{
+    uint8x16_t quote[4], backslash[4], whitespace[4], operators[4], control[4];
+    
+    for (int i = 0; i < 4; i++) {
+        uint8x16_t chunk = vld1q_u8(bytes + 16 * i);
+        
+        quote[i]        = vceqq_u8(chunk, vdupq_n_u8('"'));
+        backslash[i]    = vceqq_u8(chunk, vdupq_n_u8('\\'));
+        whitespace[i]   = vorrq_u8(vorrq_u8(vceqq_u8(chunk, vdupq_n_u8(' ')), vceqq_u8(chunk, vdupq_n_u8('\t'))),
+                                   vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('\n')), vceqq_u8(chunk, vdupq_n_u8('\r'))));
+        
+        uint8x16_t folded = vorrq_u8(chunk, vdupq_n_u8(0x20));
+        operators[i]     = vorrq_u8(vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}'))),
+                                   vorrq_u8(vceqq_u8(chunk, vdupq_n_u8(':')), vceqq_u8(chunk, vdupq_n_u8(','))));
+        
+        control[i]      = vcltq_u8(chunk, vdupq_n_u8(0x20));
+    }
+    
+    block->quote        = ACEOAuth2RACJSONMaskNEON(quote[0], quote[1], quote[2], quote[3]);
+    block->backslash    = ACEOAuth2RACJSONMaskNEON(backslash[0], backslash[1], backslash[2], backslash[3]);
+    block->whitespace   = ACEOAuth2RACJSONMaskNEON(whitespace[0], whitespace[1], whitespace[2], whitespace[3]);
+    block->operators     = ACEOAuth2RACJSONMaskNEON(operators[0], operators[1], operators[2], operators[3]);
+    block->control      = ACEOAuth2RACJSONMaskNEON(control[0], control[1], control[2], control[3]);
+}
+
+#endif
+
+
+#pragma mark - Dispatch
+
+static ACEOAuth2RACJSONClassifier ACEOAuth2RACJSONSelectClassifier(void)
+{
+#if defined(__aarch64__)
+    return ACEOAuth2RACJSONClassifyNEON;
+    
+#elif (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? ACEOAuth2RACJSONClassifyAVX2 : ACEOAuth2RACJSONClassifySSE2;
+    
+#else
+    return ACEOAuth2RACJSONClassifyScalar;
+#endif
+}
+
+static ACEOAuth2RACJSONClassifier ACEOAuth2RACJSONClassify;
+
+static void ACEOAuth2RACJSONSetup(void)
+{
+    ACEOAuth2RACJSONSetupClasses();
+    ACEOAuth2RACJSONClassify = ACEOAuth2RACJSONSelectClassifier();
+}
+
+
+#pragma mark - Index
+
+// the characters escaped by an odd number of backslashes, carrying the escape across the blocks
+static inline uint64_t ACEOAuth2RACJSONEscapedMask(uint64_t backslash, uint64_t *nextIsEscaped)
+{
+    const uint64_t oddBits = 0xaaaaaaaaaaaaaaaaULL;
+    
+    uint64_t potentialEscape            = backslash & ~*nextIsEscaped;
+    uint64_t maybeEscaped               = potentialEscape << 1;
+    uint64_t evenSeriesCodesAndOddBits  = (maybeEscaped | oddBits) - potentialEscape;
+    uint64_t escapeAndTerminalCode      = evenSeriesCodesAndOddBits ^ oddBits;
+    uint64_t escaped                    = escapeAndTerminalCode ^ (backslash | *nextIsEscaped);
+    uint64_t escape                     = escapeAndTerminalCode & backslash;
+    
+    *nextIsEscaped = escape >> 63;
+    return escaped;
+}
+
+// every bit set to the parity of the bits up to it, included
+static inline uint64_t ACEOAuth2RACJSONPrefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+static bool ACEOAuth2RACJSONReserve(ACEOAuth2RACJSONStructuralIndex *index, size_t count)
+{
+    if (index->count + count <= index->capacity) {
+        return true;
+    }
+    
+    size_t capacity = index->capacity * 2;
+    if (capacity < index->count + count) {
+        capacity = index->count + count;
+    }
+    
+    uint32_t *positions = realloc(index->positions, capacity * sizeof(uint32_t));
+    if (positions == NULL) {
+        return false;
+    }
+    
+    index->positions    = positions;
+    index->capacity     = capacity;
+    return true;
+}
+
+ACEOAuth2RACJSONStructuralIndexStatus ACEOAuth2RACJSONStructuralIndexBuild(const uint8_t *bytes, size_t length,
+                                                                          ACEOAuth2RACJSONStructuralIndex *index,
+                                                                          size_t *errorPosition)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, ACEOAuth2RACJSONSetup);
+    
+    index->count = 0;
+    if (length > UINT32_MAX) {
+        *errorPosition = 0;
+        return ACEOAuth2RACJSONStructuralIndexTooLarge;
+    }
+    
+    // about one structural character every 8 bytes in the usual documents
+    if (!ACEOAuth2RACJSONReserve(index, length / 8 + 64)) {
+        return ACEOAuth2RACJSONStructuralIndexOutOfMemory;
+    }
+    
+    uint64_t nextIsEscaped  = 0;
+    uint64_t inString       = 0;
+    uint64_t previousScalar = 0;
+    
+    for (size_t offset = 0; offset < length; offset += 64) {
+        ACEOAuth2RACJSONBlock block;
+        
+        if (length - offset >= 64) {
+            ACEOAuth2RACJSONClassify(bytes + offset, &block);
+            
+        } else {
+            // the last block is padded with spaces
+            uint8_t padded[64];
+            memset(padded, ' ', sizeof(padded));
+            memcpy(padded, bytes + offset, length - offset);
+            ACEOAuth2RACJSONClassify(padded, &block);
+        }
+        
+        uint64_t escaped    = ACEOAuth2RACJSONEscapedMask(block.backslash, &nextIsEscaped);
+        uint64_t quote      = block.quote & ~escaped;
+        
+        // from the opening quote, included, to the closing quote, excluded
+        uint64_t stringMask = ACEOAuth2RACJSONPrefixXor(quote) ^ inString;
+        inString = (uint64_t)((int64_t)stringMask >> 63);
+        
+        // the control characters, tabs and newlines included, must be escaped in the strings
+        uint64_t invalid = block.control & stringMask;
+        if (invalid != 0) {
+            *errorPosition = offset + __builtin_ctzll(invalid);
+            return ACEOAuth2RACJSONStructuralIndexControlCharacter;
+        }
+        
+        // the first character of each run of a number or a literal
+        uint64_t scalar         = ~(block.operators | block.whitespace | block.quote) & ~stringMask;
+        uint64_t scalarStarts   = scalar & ~((scalar << 1) | previousScalar);
+        previousScalar = scalar >> 63;
+        
+        uint64_t structurals = (block.operators & ~stringMask) | quote | scalarStarts;
+        
+        if (!ACEOAuth2RACJSONReserve(index, 64)) {
+            return ACEOAuth2RACJSONStructuralIndexOutOfMemory;
+        }
+        
+        uint32_t *positions = index->positions + index->count;
+        while (structurals != 0) {
+            *positions++ = (uint32_t)(offset + __builtin_ctzll(structurals));
+            structurals &= structurals - 1;
+        }
+        index->count = positions - index->positions;
+    }
+    
+    if (inString != 0) {
+        *errorPosition = length;
+        return ACEOAuth2RACJSONStructuralIndexUnterminatedString;
+    }
+    
+    return ACEOAuth2RACJSONStructuralIndexSuccess;
+}
+
+void ACEOAuth2RACJSONStructuralIndexFree(ACEOAuth2RACJSONStructuralIndex *index)
+{
+    free(index->positions);
+    
+    index->positions    = NULL;
+    index->count        = 0;
+    index->capacity     = 0;
+}
@@ -0,0 +1,78 @@
+// ACEOAuth2RACJSONStructuralIndex.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#ifndef ACEOAuth2RACJSONStructuralIndex_h
+#define ACEOAuth2RACJSONStructuralIndex_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ The positions of the structural characters of a JSON document, found with a single vectorized pass.
+
+ The index holds, in order, the braces, brackets, colons and commas outside the strings, the opening and
+ the closing quotes of every string, and the first character of every number and literal.
+ */
+typedef struct {
+    uint32_t *positions;
+    size_t count;
+    size_t capacity;
+} ACEOAuth2RACJSONStructuralIndex;
+
+typedef enum {
+    ACEOAuth2RACJSONStructuralIndexSuccess = 0,
+    ACEOAuth2RACJSONStructuralIndexOutOfMemory,
+    ACEOAuth2RACJSONStructuralIndexTooLarge,
+    ACEOAuth2RACJSONStructuralIndexUnterminatedString,
+    ACEOAuth2RACJSONStructuralIndexControlCharacter,
+} ACEOAuth2RACJSONStructuralIndexStatus;
+
+/**
+ Build the index of a document, using AVX2 or SSE2 on x86, NEON on ARM, or plain 64 bit words elsewhere.
+
+ @param bytes The document, encoded in UTF-8.
+ @param length The size of the document, up to 4 GB.
+ @param index The index to fill, zeroed or reused from a previous call.
+ @param errorPosition Set to the offset of the failure, when the status is not a success.
+
+ @return The status of the indexing.
+ */
+extern ACEOAuth2RACJSONStructuralIndexStatus ACEOAuth2RACJSONStructuralIndexBuild(const uint8_t *bytes, size_t length,
+                                                                                 ACEOAuth2RACJSONStructuralIndex *index,
+                                                                                 size_t *errorPosition);
+
+/**
+ Release the memory of the index.
+ */
+extern void ACEOAuth2RACJSONStructuralIndexFree(ACEOAuth2RACJSONStructuralIndex *index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ACEOAuth2RACJSONStructuralIndex_h */
@@ -0,0 +1,47 @@
+// ACEOAuth2RACLazyJSON.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Decode a UTF-8 JSON document into dictionary and array proxies, that decode their values only when first read.
+
+ The whole document is indexed and its structure validated upfront, without creating any object. Each proxy then
+ decodes its values on the first access and keeps them, so the cost follows the values read, not the size of the document.
+ The proxies are immutable and thread safe, they keep the data of the document alive until released.
+
+ The numbers and the literals are validated upfront, while an invalid string is reported as `NSNull` when read.
+
+ @param data The JSON document, encoded in UTF-8.
+ @param options The `NSJSONReadingAllowFragments` option, the mutable options are not supported.
+ @param removesNullValues YES to leave out the keys with a null value from the dictionaries.
+ @param error The error if the document is not valid, in the same domain and code of `NSJSONSerialization`.
+
+ @return The proxy of the root container, or the value of a fragment. Nil if the document is not valid.
+ */
+extern id _Nullable ACEOAuth2RACLazyJSONObjectWithData(NSData *data, NSJSONReadingOptions options, BOOL removesNullValues, NSError * _Nullable __autoreleasing * _Nullable error);
+
+NS_ASSUME_NONNULL_END
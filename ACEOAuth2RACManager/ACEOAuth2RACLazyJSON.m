@@ -0,0 +1,645 @@
+// ACEOAuth2RACLazyJSON.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACLazyJSON.h"
+#import "ACEOAuth2RACJSONResponseSerializer.h"
+#import "ACEOAuth2RACJSONStructuralIndex.h"
+
+// nesting deeper than this is rejected, like the eager parsers do
+static NSUInteger const ACEOAuth2RACLazyJSONMaxDepth = 512;
+
+@class ACEOAuth2RACLazyJSONDocument;
+
+@interface ACEOAuth2RACLazyJSONDictionary : NSDictionary
+- (instancetype)initWithDocument:(ACEOAuth2RACLazyJSONDocument *)document structural:(NSUInteger)structural;
+@end
+
+@interface ACEOAuth2RACLazyJSONArray : NSArray
+- (instancetype)initWithDocument:(ACEOAuth2RACLazyJSONDocument *)document structural:(NSUInteger)structural;
+@end
+
+
+#pragma mark - Validation
+
+// the length of the number or the literal at the start of `bytes`, 0 if it's not valid
+static NSUInteger ACEOAuth2RACLazyJSONScalarLength(const uint8_t *bytes, NSUInteger length)
+{
+    if (length >= 4 && (memcmp(bytes, "true", 4) == 0 || memcmp(bytes, "null", 4) == 0)) {
+        return 4;
+        
+    } else if (length >= 5 && memcmp(bytes, "false", 5) == 0) {
+        return 5;
+    }
+    
+    NSUInteger position = 0;
+    if (position < length && bytes[position] == '-') {
+        position++;
+    }
+    
+    // the integer part, no leading zeros
+    if (position < length && bytes[position] == '0') {
+        position++;
+        
+    } else if (position < length && bytes[position] >= '1' && bytes[position] <= '9') {
+        while (position < length && bytes[position] >= '0' && bytes[position] <= '9') {
+            position++;
+        }
+        
+    } else {
+        return 0;
+    }
+    
+    if (position < length && bytes[position] == '.') {
+        NSUInteger digits = ++position;
+        while (position < length && bytes[position] >= '0' && bytes[position] <= '9') {
+            position++;
+        }
+        if (position == digits) {
+            return 0;
+        }
+    }
+    
+    if (position < length && (bytes[position] == 'e' || bytes[position] == 'E')) {
+        position++;
+        if (position < length && (bytes[position] == '+' || bytes[position] == '-')) {
+            position++;
+        }
+        
+        NSUInteger digits = position;
+        while (position < length && bytes[position] >= '0' && bytes[position] <= '9') {
+            position++;
+        }
+        if (position == digits) {
+            return 0;
+        }
+    }
+    
+    return position;
+}
+
+/**
+ Check the grammar of the document walking only the structural characters, and match every opening brace and bracket
+ with its closing one in `ends`, so the containers can be skipped without looking inside them.
+ */
+static const char *ACEOAuth2RACLazyJSONValidate(const uint8_t *bytes, NSUInteger length, const uint32_t *positions, NSUInteger count,
+                                                NSJSONReadingOptions options, uint32_t *ends, NSUInteger *failurePosition)
+{
+    enum {
+        ExpectValue,
+        ExpectValueOrClose,
+        ExpectKey,
+        ExpectKeyOrClose,
+        ExpectColon,
+        ExpectCommaOrClose,
+        ExpectEnd,
+    } state = ExpectValue;
+    
+    uint32_t openers[ACEOAuth2RACLazyJSONMaxDepth];
+    NSUInteger depth = 0;
+    
+    if (count > 0 && bytes[positions[0]] != '{' && bytes[positions[0]] != '[' && !(options & NSJSONReadingAllowFragments)) {
+        *failurePosition = positions[0];
+        return "The root is not an object or an array";
+    }
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        uint8_t c = bytes[positions[i]];
+        *failurePosition = positions[i];
+        
+        BOOL isObject = (depth > 0 && bytes[positions[openers[depth - 1]]] == '{');
+        BOOL isValue = NO;
+        
+        switch (c) {
+            case '{':
+            case '[':
+                if (state != ExpectValue && state != ExpectValueOrClose) {
+                    return "Unexpected container";
+                    
+                } else if (depth == ACEOAuth2RACLazyJSONMaxDepth) {
+                    return "Too many nested containers";
+                }
+                
+                openers[depth++] = (uint32_t)i;
+                state = (c == '{') ? ExpectKeyOrClose : ExpectValueOrClose;
+                break;
+                
+            case '}':
+            case ']':
+                if (c == '}' && !(isObject && (state == ExpectKeyOrClose || state == ExpectCommaOrClose))) {
+                    return "Unexpected closing brace";
+                    
+                } else if (c == ']' && !(depth > 0 && !isObject && (state == ExpectValueOrClose || state == ExpectCommaOrClose))) {
+                    return "Unexpected closing bracket";
+                }
+                
+                ends[openers[--depth]] = (uint32_t)i;
+                isValue = YES;
+                break;
+                
+            case ':':
+                if (state != ExpectColon) {
+                    return "Unexpected colon";
+                }
+                state = ExpectValue;
+                break;
+                
+            case ',':
+                if (state != ExpectCommaOrClose) {
+                    return "Unexpected comma";
+                }
+                state = isObject ? ExpectKey : ExpectValue;
+                break;
+                
+            case '"':
+                // the index holds the closing quote right after the opening one
+                i++;
+                
+                if (state == ExpectKey || state == ExpectKeyOrClose) {
+                    state = ExpectColon;
+                    
+                } else if (state == ExpectValue || state == ExpectValueOrClose) {
+                    isValue = YES;
+                    
+                } else {
+                    return "Unexpected string";
+                }
+                break;
+                
+            default: {
+                if (state != ExpectValue && state != ExpectValueOrClose) {
+                    return "Unexpected value";
+                }
+                
+                // a number or a literal, followed only by whitespace up to the next structural character
+                NSUInteger end = (i + 1 < count) ? positions[i + 1] : length;
+                NSUInteger position = positions[i] + ACEOAuth2RACLazyJSONScalarLength(bytes + positions[i], end - positions[i]);
+                if (position == positions[i]) {
+                    return "Invalid value";
+                }
+                
+                while (position < end) {
+                    uint8_t whitespace = bytes[position++];
+                    if (whitespace != ' ' && whitespace != '\n' && whitespace != '\r' && whitespace != '\t') {
+                        return "Invalid value";
+                    }
+                }
+                
+                isValue = YES;
+                break;
+            }
+        }
+        
+        if (isValue) {
+            state = (depth > 0) ? ExpectCommaOrClose : ExpectEnd;
+            
+            // nothing can follow the root
+            if (state == ExpectEnd && i + 1 < count) {
+                *failurePosition = positions[i + 1];
+                return "Garbage at end";
+            }
+        }
+    }
+    
+    if (state != ExpectEnd) {
+        *failurePosition = length;
+        return "Unexpected end of data";
+    }
+    return NULL;
+}
+
+
+#pragma mark - Document
+
+@interface ACEOAuth2RACLazyJSONDocument : NSObject {
+    ACEOAuth2RACJSONStructuralIndex _index;
+    uint32_t *_ends;
+}
+
+@property (nonatomic, strong) NSData *data;
+@property (nonatomic, assign) const uint8_t *bytes;
+@property (nonatomic, assign) NSUInteger length;
+@property (nonatomic, assign) BOOL removesNullValues;
+
+@end
+
+@implementation ACEOAuth2RACLazyJSONDocument
+
+- (instancetype)initWithData:(NSData *)data options:(NSJSONReadingOptions)options removesNullValues:(BOOL)removesNullValues error:(NSError *__autoreleasing *)error
+{
+    self = [super init];
+    if (self) {
+        self.data               = [data copy];
+        self.bytes              = self.data.bytes;
+        self.length             = self.data.length;
+        self.removesNullValues  = removesNullValues;
+        
+        // the byte order mark of UTF-8, the positions of the index are relative to the document after it
+        if (self.length >= 3 && memcmp(self.bytes, "\xef\xbb\xbf", 3) == 0) {
+            self.bytes  += 3;
+            self.length -= 3;
+        }
+        
+        const char *failure = NULL;
+        size_t failurePosition = 0;
+        
+        switch (ACEOAuth2RACJSONStructuralIndexBuild(self.bytes, self.length, &_index, &failurePosition)) {
+            case ACEOAuth2RACJSONStructuralIndexSuccess: {
+                _ends = calloc(MAX(_index.count, 1), sizeof(uint32_t));
+                if (_ends == NULL) {
+                    failure = "Out of memory";
+                    break;
+                }
+                
+                NSUInteger position = 0;
+                failure = ACEOAuth2RACLazyJSONValidate(self.bytes, self.length, _index.positions, _index.count, options, _ends, &position);
+                failurePosition = position;
+                break;
+            }
+                
+            case ACEOAuth2RACJSONStructuralIndexUnterminatedString:
+                failure = "Unterminated string";
+                break;
+                
+            case ACEOAuth2RACJSONStructuralIndexControlCharacter:
+                failure = "Unescaped control character in string";
+                break;
+                
+            default:
+                failure = "Out of memory";
+                break;
+        }
+        
+        if (failure != NULL) {
+            if (error != NULL) {
+                *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                             code:NSPropertyListReadCorruptError
+                                         userInfo:@{
+                                                    NSDebugDescriptionErrorKey: [NSString stringWithFormat:@"%s around character %lu.", failure, (unsigned long)failurePosition]
+                                                    }];
+            }
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    ACEOAuth2RACJSONStructuralIndexFree(&_index);
+    free(_ends);
+}
+
+
+#pragma mark - Structure
+
+- (uint8_t)characterAtStructural:(NSUInteger)structural
+{
+    return self.bytes[_index.positions[structural]];
+}
+
+- (NSUInteger)endOfContainerAtStructural:(NSUInteger)structural
+{
+    return _ends[structural];
+}
+
+- (NSUInteger)structuralAfterValueAtStructural:(NSUInteger)structural
+{
+    switch ([self characterAtStructural:structural]) {
+        case '{':
+        case '[':
+            return _ends[structural] + 1;
+            
+        case '"':
+            return structural + 2;
+            
+        default:
+            return structural + 1;
+    }
+}
+
+
+#pragma mark - Values
+
+- (NSString *)stringAtStructural:(NSUInteger)structural
+{
+    NSUInteger start    = _index.positions[structural];
+    NSUInteger length   = _index.positions[structural + 1] + 1 - start;
+    
+    if (memchr(self.bytes + start, '\\', length) == NULL) {
+        return [[NSString alloc] initWithBytes:self.bytes + start + 1 length:length - 2 encoding:NSUTF8StringEncoding];
+    }
+    
+    // the strings with escapes go through the complete parser, as a fragment
+    NSData *fragment = [NSData dataWithBytesNoCopy:(void *)(self.bytes + start) length:length freeWhenDone:NO];
+    id string = ACEOAuth2RACJSONObjectRemovingNullValues(fragment, NSJSONReadingAllowFragments, NULL);
+    return [string isKindOfClass:[NSString class]] ? string : nil;
+}
+
+- (NSNumber *)numberAtStructural:(NSUInteger)structural
+{
+    NSUInteger start    = _index.positions[structural];
+    NSUInteger length   = ACEOAuth2RACLazyJSONScalarLength(self.bytes + start, self.length - start);
+    
+    // already validated, strtod and strtoll need a terminated string
+    char buffer[64];
+    if (length >= sizeof(buffer)) {
+        NSData *fragment = [NSData dataWithBytesNoCopy:(void *)(self.bytes + start) length:length freeWhenDone:NO];
+        return ACEOAuth2RACJSONObjectRemovingNullValues(fragment, NSJSONReadingAllowFragments, NULL);
+    }
+    
+    memcpy(buffer, self.bytes + start, length);
+    buffer[length] = '\0';
+    
+    if (strpbrk(buffer, ".eE") == NULL) {
+        errno = 0;
+        long long number = strtoll(buffer, NULL, 10);
+        if (errno == 0) {
+            return @(number);
+        }
+        
+        errno = 0;
+        unsigned long long unsignedNumber = strtoull(buffer, NULL, 10);
+        if (errno == 0 && buffer[0] != '-') {
+            return @(unsignedNumber);
+        }
+    }
+    return @(strtod(buffer, NULL));
+}
+
+- (id)valueAtStructural:(NSUInteger)structural
+{
+    switch ([self characterAtStructural:structural]) {
+        case '{':
+            return [[ACEOAuth2RACLazyJSONDictionary alloc] initWithDocument:self structural:structural];
+            
+        case '[':
+            return [[ACEOAuth2RACLazyJSONArray alloc] initWithDocument:self structural:structural];
+            
+        case '"':
+            // an invalid string can't be reported anymore
+            return [self stringAtStructural:structural] ?: [NSNull null];
+            
+        case 't':
+            return @YES;
+            
+        case 'f':
+            return @NO;
+            
+        case 'n':
+            return [NSNull null];
+            
+        default:
+            return [self numberAtStructural:structural];
+    }
+}
+
+@end
+
+
+#pragma mark - Dictionary
+
+@interface ACEOAuth2RACLazyJSONDictionary () {
+    uint32_t *_keyStructurals;
+    uint32_t *_valueStructurals;
+    NSUInteger _memberCount;
+}
+
+@property (nonatomic, strong) ACEOAuth2RACLazyJSONDocument *document;
+
+// the decoded values, NULL until first read
+@property (nonatomic, strong) NSPointerArray *values;
+
+// the member of each distinct key, built on first use
+@property (nonatomic, strong) NSDictionary<NSString *, NSNumber *> *keyIndexes;
+
+@end
+
+@implementation ACEOAuth2RACLazyJSONDictionary
+
+- (instancetype)initWithDocument:(ACEOAuth2RACLazyJSONDocument *)document structural:(NSUInteger)structural
+{
+    self = [super init];
+    if (self) {
+        self.document = document;
+        
+        // only the positions of the members, the containers inside are skipped
+        NSUInteger end      = [document endOfContainerAtStructural:structural];
+        NSUInteger capacity = (end - structural) / 4 + 1;
+        _keyStructurals     = malloc(capacity * sizeof(uint32_t));
+        _valueStructurals   = malloc(capacity * sizeof(uint32_t));
+        
+        for (NSUInteger key = structural + 1; key < end; ) {
+            NSUInteger value = key + 3;
+            
+            _keyStructurals[_memberCount]   = (uint32_t)key;
+            _valueStructurals[_memberCount] = (uint32_t)value;
+            _memberCount++;
+            
+            // skip the comma after the value
+            key = [document structuralAfterValueAtStructural:value] + 1;
+        }
+        
+        self.values = [NSPointerArray strongObjectsPointerArray];
+        self.values.count = _memberCount;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_keyStructurals);
+    free(_valueStructurals);
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)indexesOfKeys
+{
+    @synchronized (self) {
+        if (self.keyIndexes == nil) {
+            NSMutableDictionary *keyIndexes = [NSMutableDictionary dictionaryWithCapacity:_memberCount];
+            for (NSUInteger index = 0; index < _memberCount; index++) {
+                NSString *key = [self.document stringAtStructural:_keyStructurals[index]];
+                
+                // the last occurrence of a key wins, like NSJSONSerialization
+                if (key != nil) {
+                    keyIndexes[key] = @(index);
+                }
+            }
+            
+            // the keys with a null value are never listed, only the winning value counts
+            if (self.document.removesNullValues) {
+                NSSet *nullKeys = [keyIndexes keysOfEntriesPassingTest:^BOOL(NSString *key, NSNumber *index, BOOL *stop) {
+                    return [self.document characterAtStructural:self->_valueStructurals[index.unsignedIntegerValue]] == 'n';
+                }];
+                [keyIndexes removeObjectsForKeys:nullKeys.allObjects];
+            }
+            self.keyIndexes = keyIndexes;
+        }
+        return self.keyIndexes;
+    }
+}
+
+- (id)valueAtIndex:(NSUInteger)index
+{
+    @synchronized (self) {
+        id value = (__bridge id)[self.values pointerAtIndex:index];
+        if (value == nil) {
+            value = [self.document valueAtStructural:_valueStructurals[index]];
+            [self.values replacePointerAtIndex:index withPointer:(__bridge void *)value];
+        }
+        return value;
+    }
+}
+
+
+#pragma mark - NSDictionary
+
+- (NSUInteger)count
+{
+    return [self indexesOfKeys].count;
+}
+
+- (id)objectForKey:(id)key
+{
+    if (![key isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+    
+    NSNumber *index = [self indexesOfKeys][key];
+    return index ? [self valueAtIndex:index.unsignedIntegerValue] : nil;
+}
+
+- (NSEnumerator *)keyEnumerator
+{
+    return [[self indexesOfKeys] keyEnumerator];
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // immutable
+    return self;
+}
+
+- (Class)classForCoder
+{
+    return [NSDictionary class];
+}
+
+@end
+
+
+#pragma mark - Array
+
+@interface ACEOAuth2RACLazyJSONArray () {
+    uint32_t *_valueStructurals;
+    NSUInteger _count;
+}
+
+@property (nonatomic, strong) ACEOAuth2RACLazyJSONDocument *document;
+
+// the decoded values, NULL until first read
+@property (nonatomic, strong) NSPointerArray *values;
+
+@end
+
+@implementation ACEOAuth2RACLazyJSONArray
+
+- (instancetype)initWithDocument:(ACEOAuth2RACLazyJSONDocument *)document structural:(NSUInteger)structural
+{
+    self = [super init];
+    if (self) {
+        self.document = document;
+        
+        // only the positions of the elements, the containers inside are skipped
+        NSUInteger end      = [document endOfContainerAtStructural:structural];
+        NSUInteger capacity = (end - structural) / 2 + 1;
+        _valueStructurals   = malloc(capacity * sizeof(uint32_t));
+        
+        for (NSUInteger value = structural + 1; value < end; ) {
+            _valueStructurals[_count++] = (uint32_t)value;
+            
+            // skip the comma after the value
+            value = [document structuralAfterValueAtStructural:value] + 1;
+        }
+        
+        self.values = [NSPointerArray strongObjectsPointerArray];
+        self.values.count = _count;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_valueStructurals);
+}
+
+
+#pragma mark - NSArray
+
+- (NSUInteger)count
+{
+    return _count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    if (index >= _count) {
+        [NSException raise:NSRangeException format:@"index %lu beyond bounds [0 .. %ld]", (unsigned long)index, (long)_count - 1];
+    }
+    
+    @synchronized (self) {
+        id value = (__bridge id)[self.values pointerAtIndex:index];
+        if (value == nil) {
+            value = [self.document valueAtStructural:_valueStructurals[index]];
+            [self.values replacePointerAtIndex:index withPointer:(__bridge void *)value];
+        }
+        return value;
+    }
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // immutable
+    return self;
+}
+
+- (Class)classForCoder
+{
+    return [NSArray class];
+}
+
+@end
+
+
+#pragma mark -
+
+id ACEOAuth2RACLazyJSONObjectWithData(NSData *data, NSJSONReadingOptions options, BOOL removesNullValues, NSError *__autoreleasing *error)
+{
+    ACEOAuth2RACLazyJSONDocument *document = [[ACEOAuth2RACLazyJSONDocument alloc] initWithData:data
+                                                                                        options:options
+                                                                                removesNullValues:removesNullValues
+                                                                                          error:error];
+    
+    // the fragments are decoded right away
+    return [document valueAtStructural:0];
+}
@@ -23,11 +23,45 @@
 
 #import "ReactiveObjC.h"
 
+#import "ACEOAuth2RACChunkedUploader.h"
 #import "ACEOAuth2RACCoordinators.h"
+#import "ACEOAuth2RACModelMapper.h"
+#import "ACEOAuth2RACOfflineQueue.h"
+#import "ACEOAuth2RACQueryEncoder.h"
+#import "ACEOAuth2RACRequest.h"
+#import "ACEOAuth2RACRequestQueue.h"
+#import "ACEOAuth2RACResponseSerializer.h"
+#import "ACEOAuth2RACRoute.h"
+#import "ACEOAuth2RACTransportProfile.h"
 
 extern NSTimeInterval const ACEDefaultRetryTimeInterval;
 
+extern NSString * const _Nonnull ACEOAuth2RACErrorDomain;
+
+/**
+ The HTTP status code of a failed request, as `NSNumber`.
+ */
+extern NSString * const _Nonnull ACEOAuth2RACStatusCodeErrorKey;
+
+/**
+ The response object returned by the server for a failed request.
+ */
+extern NSString * const _Nonnull ACEOAuth2RACResponseObjectErrorKey;
+
+typedef NS_ENUM(NSInteger, ACEOAuth2RACError) {
+    ACEOAuth2RACErrorBadBatchResponse       = -1000,
+    ACEOAuth2RACErrorBatchRequestFailed     = -1001,
+    ACEOAuth2RACErrorDeadlineExceeded       = -1002,
+    ACEOAuth2RACErrorInvalidJSON            = -1003,
+    ACEOAuth2RACErrorBadUploadResponse      = -1004,
+    ACEOAuth2RACErrorInvalidMessagePack     = -1005,
+    ACEOAuth2RACErrorModelMapping           = -1006,
+    ACEOAuth2RACErrorMissingRouteValue      = -1007,
+    ACEOAuth2RACErrorInvalidOfflineRequest  = -1008,
+};
+
 @class AFHTTPSessionManager;
+@protocol AFMultipartFormData;
 
 /**
  `ACEOAuth2RACManager` is a class that helps to manage the network connection to a server using OAuth2 for authentication
@@ -63,6 +97,109 @@ extern NSTimeInterval const ACEDefaultRetryTimeInterval;
 
 @property (nonatomic, strong, readonly, nonnull) AFHTTPSessionManager *networkManager;
 
+/**
+ The queue controlling the admission of the requests to `networkManager`, use it to tune the concurrency limits.
+ */
+@property (nonatomic, strong, readonly, nonnull) ACEOAuth2RACRequestQueue *requestQueue;
+
+/**
+ The serializer of the responses, choosing the decoder from the content type of each response.
+ MessagePack is registered by default, and preferred to JSON in the `Accept` header.
+ */
+@property (nonatomic, strong, readonly, nonnull) ACEOAuth2RACResponseSerializer *responseSerializer;
+
+/**
+ The engine of the chunked uploads, to tune the chunk sizes and the parallelism.
+ */
+@property (nonatomic, strong, readonly, nonnull) ACEOAuth2RACChunkedUploader *chunkedUploader;
+
+/**
+ The journal of the requests sent when the network is available, to tune the replay and observe the rejected requests.
+ */
+@property (nonatomic, strong, readonly, nonnull) ACEOAuth2RACOfflineQueue *offlineQueue;
+
+/**
+ The encoder of the query strings and of the form bodies of `networkManager`, to set the key ordering
+ and to register the constant parameters.
+ */
+@property (nonatomic, strong, readonly, nonnull) ACEOAuth2RACQueryEncoder *queryEncoder;
+
+/**
+ YES to gzip the request bodies larger than `compressionThreshold`, setting the `Content-Encoding` header.
+ The server must accept compressed bodies. Only the text bodies written by the request serializer are
+ compressed, never a raw `HTTPBody` of the request. The compression runs on a background queue, and it's
+ skipped when it doesn't reduce the body by at least 10%. Default is NO.
+ */
+@property (nonatomic, assign) BOOL compressesRequestBodies;
+
+/**
+ The size in bytes above which the request bodies are compressed. Default is 16 KB.
+ */
+@property (nonatomic, assign) NSUInteger compressionThreshold;
+
+/**
+ YES to leave out the keys with a null value from the JSON dictionaries. The keys are dropped while parsing,
+ without copying the whole tree again after `NSJSONSerialization`. Default is NO.
+ */
+@property (nonatomic, assign) BOOL removesKeysWithNullValues;
+
+/**
+ YES to decode the JSON responses lazily: the dictionaries and the arrays are proxies over the raw bytes,
+ decoding each value the first time it's read. Default is NO.
+ */
+@property (nonatomic, assign) BOOL decodesJSONLazily;
+
+/**
+ YES to run the token calls over the session of `networkManager`, sharing its connections to the server,
+ so a refresh of the token doesn't pay a new TCP and TLS handshake. The two managers keep their own serializers,
+ and the token calls go back to their own session if the response serializer of `networkManager` is replaced. Default is YES.
+ */
+@property (nonatomic, assign) BOOL usesSharedSession;
+
+/**
+ The path, relative to the `apiURLString`, called with a `HEAD` to open the connections before the first request.
+ When it is set, the connections to the API and token hosts are opened right away, on every change of network,
+ and when the app returns to the foreground. Default is nil, which disables the pre-warm.
+ */
+@property (nonatomic, copy, nullable) NSString *prewarmURLString;
+
+/**
+ The minimum time between two pre-warms of the connections. Default is 30 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval prewarmInterval;
+
+/**
+ YES to deliver the responses and run the retries on a private concurrent queue, instead of the main queue.
+ The network calls don't wait for the main thread anymore, and a busy UI doesn't slow them down. Default is NO.
+ */
+@property (nonatomic, assign) BOOL completesOnPrivateQueue;
+
+/**
+ YES to send the values of the signals created afterwards on the main thread, after every other step of the pipeline.
+ The pages of `-rac_pagesForRequest:` are always sent on their own queue. Default is NO.
+ */
+@property (nonatomic, assign) BOOL deliversOnMainThread;
+
+/**
+ String to append to the `apiURLString` to compose the URL of the batch endpoint. Default is nil, which disables the batching.
+ 
+ The batchable requests arriving within `batchWindow` are sent with a single `POST` with a JSON body
+ `{"requests": [{"method": ..., "path": ..., "parameters": ...}, ...]}`.
+ The server must reply with the sub-responses in the same order, either as an array or in a `responses` key,
+ each one in the form `{"status": ..., "body": ...}`.
+ */
+@property (nonatomic, strong, nullable) NSString *batchURLString;
+
+/**
+ The time to wait for more batchable requests before calling the batch endpoint. Default is 50ms.
+ */
+@property (nonatomic, assign) NSTimeInterval batchWindow;
+
+/**
+ The maximum number of requests packed in a single call to the batch endpoint. Default is 20.
+ */
+@property (nonatomic, assign) NSUInteger batchSizeLimit;
+
 
 
 #pragma mark - Initialization
@@ -115,8 +252,128 @@ NS_ASSUME_NONNULL_BEGIN
                  oauthURLString:(nullable NSString *)oauthURLString
                    apiURLString:(nullable NSString *)apiURLString;
 
+/**
+ Initializes an `ACEOAuth2RACManager` object with the specified base URL and client information,
+ and the configurations of the sessions used for the API and OAuth calls.
+ The timeout, pipelining and cellular settings also apply to the requests built by each side. While `usesSharedSession`
+ is YES the token calls run on the API session, keeping only these request settings of the OAuth configuration.
+ 
+ @param baseURL The base URL for the HTTP client.
+ @param clientID The OAuth client identifier.
+ @param secret The OAuth secret string.
+ @param redirectURL The OAuth URL used for redirection.
+ @param oauthURLString The URL path to connect to the OAuth api.
+ @param apiURLString The URL path to connect to the server api.
+ @param configuration The configuration of the API session, nil for the default one.
+ @param oauthConfiguration The configuration of the OAuth session, nil for the default one.
+ 
+ @return The newly-initialized network manager.
+ */
+- (instancetype)initWithBaseURL:(nonnull NSURL *)baseURL
+                       clientID:(nonnull NSString *)clientID
+                         secret:(nonnull NSString *)secret
+                    redirectURL:(nullable NSURL *)redirectURL
+                 oauthURLString:(nullable NSString *)oauthURLString
+                   apiURLString:(nullable NSString *)apiURLString
+           sessionConfiguration:(nullable NSURLSessionConfiguration *)configuration
+      oauthSessionConfiguration:(nullable NSURLSessionConfiguration *)oauthConfiguration;
+
+/**
+ Initializes an `ACEOAuth2RACManager` object with the specified base URL and client information,
+ applying a transport profile to both the API and OAuth sessions.
+ 
+ @param baseURL The base URL for the HTTP client.
+ @param clientID The OAuth client identifier.
+ @param secret The OAuth secret string.
+ @param redirectURL The OAuth URL used for redirection.
+ @param oauthURLString The URL path to connect to the OAuth api.
+ @param apiURLString The URL path to connect to the server api.
+ @param transportProfile The settings of the sessions, like `+[ACEOAuth2RACTransportProfile lowLatencyProfile]`.
+ 
+ @return The newly-initialized network manager.
+ */
+- (instancetype)initWithBaseURL:(nonnull NSURL *)baseURL
+                       clientID:(nonnull NSString *)clientID
+                         secret:(nonnull NSString *)secret
+                    redirectURL:(nullable NSURL *)redirectURL
+                 oauthURLString:(nullable NSString *)oauthURLString
+                   apiURLString:(nullable NSString *)apiURLString
+               transportProfile:(nonnull ACEOAuth2RACTransportProfile *)transportProfile;
+
 NS_ASSUME_NONNULL_END
 
+#pragma mark - Serialization
+
+///--------------------
+/// @name Serialization
+///--------------------
+
+/**
+ Register the serializer of the responses of a content type, and advertise it in the `Accept` header of the requests.
+ The content types registered first are preferred.
+ 
+ @param serializer The serializer, nil to remove the registration.
+ @param contentType The MIME type of the responses, like `application/msgpack`.
+ */
+- (void)setResponseSerializer:(nullable AFHTTPResponseSerializer *)serializer forContentType:(nonnull NSString *)contentType;
+
+
+#pragma mark - Interceptors
+
+///-------------------
+/// @name Interceptors
+///-------------------
+
+/**
+ The interceptors of the requests, in order.
+ */
+@property (nonatomic, copy, readonly, nonnull) NSArray<id<ACEOAuth2RACInterceptor>> *interceptors;
+
+/**
+ Add an interceptor at the end of the chain. It takes part in the requests sent afterwards, after their retries
+ and with their final error. The chain is built again only here, the requests just run through it.
+ The batch calls go through the chain as a whole. The streams and the transfers only go through the request and error methods,
+ their body never makes a response object to read or to cache.
+ 
+ @param interceptor The interceptor.
+ */
+- (void)addInterceptor:(nonnull id<ACEOAuth2RACInterceptor>)interceptor;
+
+/**
+ Remove an interceptor from the chain.
+ 
+ @param interceptor The interceptor.
+ */
+- (void)removeInterceptor:(nonnull id<ACEOAuth2RACInterceptor>)interceptor;
+
+
+#pragma mark - Routes
+
+///-------------
+/// @name Routes
+///-------------
+
+/**
+ Compile a URL template against the URL of the api, and register it under a name.
+ The name identifies the requests of the route in the metrics and the caches, whatever the values.
+ 
+ @param name The name of the route, like `user.posts`.
+ @param URLTemplate The template, like `users/{id}/posts`, relative to the apiURLString.
+ 
+ @return The compiled route.
+ */
+- (nonnull ACEOAuth2RACRoute *)registerRouteWithName:(nonnull NSString *)name URLTemplate:(nonnull NSString *)URLTemplate;
+
+/**
+ Return a registered route.
+ 
+ @param name The name of the route.
+ 
+ @return The compiled route, nil if no route was registered with that name.
+ */
+- (nullable ACEOAuth2RACRoute *)routeNamed:(nonnull NSString *)name;
+
+
 #pragma mark - HTTP Signals
 
 ///-------------------
@@ -147,6 +404,19 @@ NS_ASSUME_NONNULL_END
  */
 - (nonnull RACSignal *)rac_GET:(nonnull NSString *)path parameters:(nullable id)parameters retries:(NSInteger)retries interval:(NSTimeInterval)interval;
 
+/**
+ Set a signal to execute an HTTP `GET` asynchronously, mapping the response to models.
+ The mapping runs on a concurrent background queue, so the response is delivered already mapped.
+ It also handle the authentication via OAuth2
+ 
+ @param path The URL path relative to the apiURLString.
+ @param parameters The optional parameters for this method.
+ @param modelClass The class of the models, adopting `ACEOAuth2RACModel`.
+ 
+ @return The signal sending the model, or an array of models if the response is an array.
+ */
+- (nonnull RACSignal *)rac_GET:(nonnull NSString *)path parameters:(nullable id)parameters modelClass:(nonnull Class)modelClass;
+
 /**
  Set a signal to execute an HTTP `HEAD` asynchronously.
  It also handle the authentication via OAuth2
@@ -268,6 +538,252 @@ NS_ASSUME_NONNULL_END
 - (nonnull RACSignal *)rac_DELETE:(nonnull NSString *)path parameters:(nullable id)parameters retries:(NSInteger)retries interval:(NSTimeInterval)interval;
 
 
+/**
+ Set a signal to execute the HTTP request described by `request` asynchronously.
+ It also handle the authentication via OAuth2
+ 
+ @param request The description of the request to execute.
+ 
+ @return The signal that will execute the HTTP request asynchronously.
+ */
+- (nonnull RACSignal *)rac_request:(nonnull ACEOAuth2RACRequest *)request;
+
+/**
+ Set a signal to execute the HTTP request to a registered route asynchronously.
+ It also handle the authentication via OAuth2
+ 
+ @param name The name of the route.
+ @param method The HTTP method.
+ @param values The values of the placeholders of the route.
+ @param parameters The parameters to be encoded according to the client request serializer.
+ 
+ @return The signal that will execute the HTTP request asynchronously.
+ It fails with `ACEOAuth2RACErrorMissingRouteValue` if a placeholder has no value.
+ */
+- (nonnull RACSignal *)rac_requestRoute:(nonnull NSString *)name
+                                 method:(nonnull NSString *)method
+                                 values:(nullable NSDictionary<NSString *, id> *)values
+                             parameters:(nullable id)parameters;
+
+
+#pragma mark - Batch Signals
+
+///--------------------
+/// @name Batch Signals
+///--------------------
+
+/**
+ Set a signal to execute a batch of HTTP requests asynchronously.
+ The authentication via OAuth2 is performed only once, before starting the first request.
+ 
+ Each result is sent as a `RACTuple` with the index of the request in `requests`, the response object and the error.
+ A failing request doesn't abort the batch: its tuple has a nil response object and the error that made it fail.
+ The signal completes when all the requests are finished. The deadline of each request starts when the batch starts it.
+ 
+ @param requests The requests to execute.
+ @param maxConcurrent The maximum number of requests running at the same time, 0 means no limit.
+ @param ordered YES to send the results in the same order of `requests`, NO to send them as they complete.
+ 
+ @return The signal that will execute the HTTP requests asynchronously.
+ */
+- (nonnull RACSignal *)rac_batchRequests:(nonnull NSArray<ACEOAuth2RACRequest *> *)requests
+                           maxConcurrent:(NSUInteger)maxConcurrent
+                                 ordered:(BOOL)ordered;
+
+
+#pragma mark - Streaming Signals
+
+///------------------------
+/// @name Streaming Signals
+///------------------------
+
+/**
+ Set a signal to execute an HTTP `GET` asynchronously, decoding a JSON array while it is downloaded.
+ It also handle the authentication via OAuth2
+ 
+ @param path The URL path relative to the apiURLString.
+ @param parameters The optional parameters for this method.
+ @param itemsKey The key of the root object containing the array, nil if the array is the root of the response.
+ 
+ @return The signal sending each element of the array as soon as it is received.
+ */
+- (nonnull RACSignal *)rac_streamGET:(nonnull NSString *)path parameters:(nullable id)parameters itemsKey:(nullable NSString *)itemsKey;
+
+/**
+ Set a signal to execute the HTTP request described by `request` asynchronously, decoding a JSON array while it is downloaded.
+ The body is never kept in memory as a whole, so the time to the first element and the memory used don't depend on its size.
+ Since the elements are sent while they arrive, the request is never retried. The server trust is evaluated with the
+ `securityPolicy` of the network manager, and the interceptors see the request and the error, never a cached response.
+ It also handle the authentication via OAuth2
+ 
+ @param request The description of the request to execute.
+ @param itemsKey The key of the root object containing the array, nil if the array is the root of the response.
+ 
+ @return The signal sending each element of the array as soon as it is received.
+ */
+- (nonnull RACSignal *)rac_streamRequest:(nonnull ACEOAuth2RACRequest *)request itemsKey:(nullable NSString *)itemsKey;
+
+
+#pragma mark - Transfer Signals
+
+///-----------------------
+/// @name Transfer Signals
+///-----------------------
+
+/**
+ Set a signal to download the response body of `request` straight to a file, without keeping it in memory.
+ 
+ When an attempt fails, the next retry continues from the bytes already received if the server supports it,
+ instead of starting from zero. If the download fails for good, the `userInfo` of the error contains
+ `NSURLSessionDownloadTaskResumeData`, which can be passed back to continue the download later.
+ It also handle the authentication via OAuth2
+ 
+ @param request The description of the request to execute.
+ @param fileURL The file URL the body is saved to, replaced if it exists.
+ @param resumeData The optional resume data of a previous download of the same request.
+ @param progressSubscriber The optional subscriber receiving the `NSProgress` of the download, usually a `RACSubject`. It completes when the download
+ does or when it's cancelled, and it fails with the same error.
+ 
+ @return The signal sending `fileURL` when the download completes.
+ */
+- (nonnull RACSignal *)rac_downloadRequest:(nonnull ACEOAuth2RACRequest *)request
+                                     toURL:(nonnull NSURL *)fileURL
+                                resumeData:(nullable NSData *)resumeData
+                                  progress:(nullable id<RACSubscriber>)progressSubscriber;
+
+/**
+ Set a signal to execute a multipart HTTP `POST` uploading files, without loading them in memory.
+ It also handle the authentication via OAuth2
+ 
+ @param path The URL path relative to the apiURLString.
+ @param parameters The optional parameters for this method.
+ @param fileURLs The files to upload, keyed by the name of their part.
+ @param progressSubscriber The optional subscriber receiving the `NSProgress` of the upload, usually a `RACSubject`. It completes when the upload
+ does or when it's cancelled, and it fails with the same error.
+ 
+ @return The signal sending the response object, or failing with the error of the first file that can't be read.
+ */
+- (nonnull RACSignal *)rac_POST:(nonnull NSString *)path
+                     parameters:(nullable id)parameters
+                       fileURLs:(nonnull NSDictionary<NSString *, NSURL *> *)fileURLs
+                       progress:(nullable id<RACSubscriber>)progressSubscriber;
+
+/**
+ Set a signal to execute the multipart request described by `request`, streaming the body.
+ 
+ The body is rebuilt for every attempt, so `block` is called once per attempt. Parts appended with
+ `-appendPartWithFileURL:name:error:` or an input stream are read while they are sent and never kept in memory.
+ It also handle the authentication via OAuth2
+ 
+ @param request The description of the request to execute.
+ @param block The block appending the parts to the body.
+ @param progressSubscriber The optional subscriber receiving the `NSProgress` of the upload, usually a `RACSubject`. It completes when the upload
+ does or when it's cancelled, and it fails with the same error.
+ 
+ @return The signal sending the response object.
+ */
+- (nonnull RACSignal *)rac_uploadRequest:(nonnull ACEOAuth2RACRequest *)request
+               constructingBodyWithBlock:(nonnull void (^)(id<AFMultipartFormData> _Nonnull formData))block
+                                progress:(nullable id<RACSubscriber>)progressSubscriber;
+
+/**
+ Set a signal uploading a large file in chunks, resuming from the last chunk received by the server after a failure
+ or a restart of the app. The chunks are sent in parallel as separate requests, each with its own retries.
+ It also handle the authentication via OAuth2
+ 
+ @param fileURL The file to upload.
+ @param path The URL path of the endpoint creating the uploads, relative to the apiURLString.
+ @param identifier The identifier of the upload, the same identifier resumes it.
+ @param progressSubscriber The optional subscriber receiving the `NSProgress` of the upload, usually a `RACSubject`. It completes when the upload does.
+ 
+ @return The signal sending the upload URL when the whole file has been received by the server.
+ 
+ @see `ACEOAuth2RACChunkedUploader`
+ */
+- (nonnull RACSignal *)rac_uploadFileURL:(nonnull NSURL *)fileURL
+                                  toPath:(nonnull NSString *)path
+                              identifier:(nonnull NSString *)identifier
+                                progress:(nullable id<RACSubscriber>)progressSubscriber;
+
+
+#pragma mark - Offline Signals
+
+///----------------------
+/// @name Offline Signals
+///----------------------
+
+/**
+ Set a signal adding a request to the offline journal. The requests of the journal are sent in order as soon as the network
+ is available, even after a restart of the app, and the pending `PUT` and `PATCH` of the same path are collapsed.
+ It's meant for the requests changing the data on the server, like `POST`, `PUT`, `PATCH` and `DELETE`.
+ It also handle the authentication via OAuth2
+ 
+ @param request The request to add, its parameters must be valid JSON objects.
+ 
+ @return The signal completing when the request is written to disk.
+ 
+ @see `ACEOAuth2RACOfflineQueue`
+ */
+- (nonnull RACSignal *)rac_enqueueOfflineRequest:(nonnull ACEOAuth2RACRequest *)request;
+
+
+#pragma mark - Pagination Signals
+
+///-------------------------
+/// @name Pagination Signals
+///-------------------------
+
+/**
+ Set a signal walking a paginated endpoint, following the `Link` header with `rel="next"`.
+ The next page is fetched while the current one is processed.
+ It also handle the authentication via OAuth2
+ 
+ @param request The request of the first page.
+ 
+ @return The signal sending the response object of each page.
+ */
+- (nonnull RACSignal *)rac_pagesForRequest:(nonnull ACEOAuth2RACRequest *)request;
+
+/**
+ Set a signal walking a paginated endpoint, following the `Link` header with `rel="next"` or a cursor returned in the response.
+ 
+ The pages are fetched one after the other, up to `prefetchDepth` pages ahead of the one being processed by the subscriber,
+ so only a bounded number of pages is kept in memory whatever the size of the collection. The pages are sent on a private
+ serial scheduler, and disposing the subscription stops the fetching. Each page is a separate request, with the retries,
+ priority and deadline of `request`.
+ It also handle the authentication via OAuth2
+ 
+ @param request The request of the first page.
+ @param cursorKeyPath The key path of the cursor in the response object, used when there is no `Link` header. The walk ends when it is missing or empty.
+ @param cursorParameter The name of the parameter sending the cursor back to the server.
+ @param prefetchDepth The maximum number of pages to fetch ahead of the one being processed, at least 1.
+ 
+ @return The signal sending the response object of each page.
+ */
+- (nonnull RACSignal *)rac_pagesForRequest:(nonnull ACEOAuth2RACRequest *)request
+                             cursorKeyPath:(nullable NSString *)cursorKeyPath
+                           cursorParameter:(nullable NSString *)cursorParameter
+                             prefetchDepth:(NSUInteger)prefetchDepth;
+
+
+#pragma mark - Pre-warm
+
+///--------------
+/// @name Pre-warm
+///--------------
+
+/**
+ Open the connections to the API and token hosts with a `HEAD` to `prewarmURLString`, paying the DNS, TCP
+ and TLS setup before the first request. Nothing happens within `prewarmInterval` from the previous pre-warm.
+ */
+- (void)prewarmConnections;
+
+/**
+ Cancel the running pre-warm calls.
+ */
+- (void)cancelPrewarming;
+
+
 #pragma mark - Other Signals
 
 ///--------------------
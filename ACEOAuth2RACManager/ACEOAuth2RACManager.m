@@ -23,17 +23,31 @@
 
 #import "ACEOAuth2RACManager.h"
 #import "ACEOAuth2RACManagerPrivate.h"
+#import "ACEOAuth2RACCompression.h"
 #import "ACEOAuth2RACCoordinators.h"
+#import "ACEOAuth2RACInterceptorChain.h"
+#import "ACEOAuth2RACRequest.h"
+#import "ACEOAuth2RACJSONResponseSerializer.h"
+#import "ACEOAuth2RACJSONStreamParser.h"
+#import "ACEOAuth2RACMessagePackSerializer.h"
+#import "ACEOAuth2RACModelMapper.h"
+#import "ACEOAuth2RACOAuthManager.h"
+#import "ACEOAuth2RACPaginator.h"
+#import "ACEOAuth2RACQueryScanner.h"
+#import "ACEOAuth2RACRequestCoalescer.h"
+#import "ACEOAuth2RACStreamingSession.h"
 
 #import "AFHTTPRequestSerializer+OAuth2.h"
 #import "AFHTTPSessionManager+RACRetrySupport.h"
 #import "AFNetworkActivityLogger.h"
 #import "AFOAuth2Manager.h"
 
-#import "NSURL+QueryDictionary.h"
-
 NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
 
+NSString * const ACEOAuth2RACErrorDomain                = @"com.onemob.network.error";
+NSString * const ACEOAuth2RACStatusCodeErrorKey         = @"ACEOAuth2RACStatusCodeErrorKey";
+NSString * const ACEOAuth2RACResponseObjectErrorKey     = @"ACEOAuth2RACResponseObjectErrorKey";
+
 #if __DDLOG_ENABLED__
     #if DEBUG
         const DDLogLevel ACELogLevel = DDLogLevelDebug;
@@ -42,13 +56,33 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
     #endif
 #endif
 
+// appends the parts of a multipart body, NO with an error when a part can't be added
+typedef BOOL (^ACEOAuth2RACMultipartBodyBlock)(id<AFMultipartFormData> formData, NSError **error);
+
 
 @interface ACEOAuth2RACManager ()
 // managers
 @property (nonatomic, strong) AFHTTPSessionManager *networkManager;
-@property (nonatomic, strong) AFOAuth2Manager *oauthManager;
+@property (nonatomic, strong) ACEOAuth2RACRequestQueue *requestQueue;
+@property (nonatomic, strong) ACEOAuth2RACResponseSerializer *responseSerializer;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, ACEOAuth2RACRoute *> *routes;
+@property (nonatomic, strong) ACEOAuth2RACOAuthManager *oauthManager;
 @property (nonatomic, strong) AFNetworkReachabilityManager *reachabilityManager;
 @property (nonatomic, strong) RACScheduler *scheduler;
+@property (nonatomic, strong) dispatch_queue_t decodeQueue;
+@property (nonatomic, strong) dispatch_queue_t completionQueue;
+@property (nonatomic, strong) ACEOAuth2RACRequestCoalescer *requestCoalescer;
+@property (nonatomic, strong) ACEOAuth2RACStreamingSession *streamingSession;
+@property (nonatomic, strong) ACEOAuth2RACChunkedUploader *chunkedUploader;
+@property (nonatomic, strong) ACEOAuth2RACOfflineQueue *offlineQueue;
+@property (nonatomic, strong) ACEOAuth2RACQueryEncoder *queryEncoder;
+
+// replaced as a whole, read once by each request
+@property (atomic, strong) ACEOAuth2RACInterceptorChain *interceptorChain;
+
+// pre-warm
+@property (nonatomic, strong) NSDate *prewarmDate;
+@property (nonatomic, strong) NSArray<NSURLSessionDataTask *> *prewarmTasks;
 
 // oauth
 @property (nonatomic, strong) AFOAuthCredential *oauthCredential;
@@ -84,20 +118,89 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
                     redirectURL:(NSURL *)redirectURL
                  oauthURLString:(NSString *)oauthURLString
                    apiURLString:(NSString *)apiURLString
+{
+    return [self initWithBaseURL:baseURL clientID:clientID secret:secret redirectURL:redirectURL oauthURLString:oauthURLString apiURLString:apiURLString
+            sessionConfiguration:nil oauthSessionConfiguration:nil];
+}
+
+- (instancetype)initWithBaseURL:(NSURL *)baseURL
+                       clientID:(NSString *)clientID
+                         secret:(NSString *)secret
+                    redirectURL:(NSURL *)redirectURL
+                 oauthURLString:(NSString *)oauthURLString
+                   apiURLString:(NSString *)apiURLString
+               transportProfile:(ACEOAuth2RACTransportProfile *)transportProfile
+{
+    return [self initWithBaseURL:baseURL clientID:clientID secret:secret redirectURL:redirectURL oauthURLString:oauthURLString apiURLString:apiURLString
+            sessionConfiguration:[transportProfile sessionConfigurationWithConfiguration:nil]
+       oauthSessionConfiguration:[transportProfile sessionConfigurationWithConfiguration:nil]];
+}
+
+- (instancetype)initWithBaseURL:(NSURL *)baseURL
+                       clientID:(NSString *)clientID
+                         secret:(NSString *)secret
+                    redirectURL:(NSURL *)redirectURL
+                 oauthURLString:(NSString *)oauthURLString
+                   apiURLString:(NSString *)apiURLString
+           sessionConfiguration:(NSURLSessionConfiguration *)configuration
+      oauthSessionConfiguration:(NSURLSessionConfiguration *)oauthConfiguration
 {
     self = [super init];
     if (self) {
         NSURL *oauthBaseURL     = oauthURLString ? [baseURL URLByAppendingPathComponent:oauthURLString] : baseURL;
         NSURL *apiBaseURL       = apiURLString ? [baseURL URLByAppendingPathComponent:apiURLString] : baseURL;
         
-        self.oauthManager       = [[AFOAuth2Manager alloc] initWithBaseURL:oauthBaseURL clientID:clientID secret:secret];
+        self.oauthManager       = [[ACEOAuth2RACOAuthManager alloc] initWithBaseURL:oauthBaseURL sessionConfiguration:oauthConfiguration clientID:clientID secret:secret];
         self.oauthManager.useHTTPBasicAuthentication = NO;
         
-        self.networkManager     = [[AFHTTPSessionManager alloc] initWithBaseURL:apiBaseURL];
+        self.networkManager     = [[AFHTTPSessionManager alloc] initWithBaseURL:apiBaseURL sessionConfiguration:configuration];
+        [self configureRequestSerializerOfSessionManager:self.networkManager];
+        [self configureRequestSerializerOfSessionManager:self.oauthManager];
+        self.responseSerializer = [[ACEOAuth2RACResponseSerializer alloc] initWithDefaultSerializer:[ACEOAuth2RACJSONResponseSerializer serializer]];
+        self.networkManager.responseSerializer = self.responseSerializer;
+        [self setResponseSerializer:[ACEOAuth2RACMessagePackResponseSerializer serializer] forContentType:@"application/msgpack"];
+        [self setResponseSerializer:[ACEOAuth2RACMessagePackResponseSerializer serializer] forContentType:@"application/x-msgpack"];
+        
+        // same format of AFNetworking, without an object for each pair
+        ACEOAuth2RACQueryEncoder *queryEncoder = [ACEOAuth2RACQueryEncoder new];
+        [self.networkManager.requestSerializer setQueryStringSerializationWithBlock:^NSString *(NSURLRequest *request, id parameters, NSError *__autoreleasing *error) {
+            return [queryEncoder queryStringFromParameters:parameters];
+        }];
+        self.queryEncoder       = queryEncoder;
+        
+        self.requestQueue       = [ACEOAuth2RACRequestQueue new];
+        self.interceptorChain   = [[ACEOAuth2RACInterceptorChain alloc] initWithInterceptors:@[]];
+        self.compressionThreshold = 16 * 1024;
+        self.usesSharedSession  = YES;
+        self.prewarmInterval    = 30.0;
         
         self.reachabilityManager= [AFNetworkReachabilityManager managerForDomain:baseURL.host];
         [self.reachabilityManager startMonitoring];
         
+        // open the connections again on every change of network
+        @weakify(self)
+        [[[RACObserve(self.reachabilityManager, networkReachabilityStatus) distinctUntilChanged]
+          filter:^BOOL(NSNumber *status) {
+              return status.integerValue > AFNetworkReachabilityStatusNotReachable;
+          }]
+         subscribeNext:^(id x) {
+             @strongify(self)
+             [self prewarmConnections];
+             
+             // a manager that never queued a request doesn't read the journal
+             [self->_offlineQueue replay];
+         }];
+        
+#if TARGET_OS_IPHONE && !OAUTH_APP_EXTENSION
+        // the idle connections are closed while the app is in background
+        [[[[NSNotificationCenter defaultCenter] rac_addObserverForName:UIApplicationWillEnterForegroundNotification object:nil]
+          takeUntil:self.rac_willDeallocSignal]
+         subscribeNext:^(id x) {
+             @strongify(self)
+             [self prewarmConnections];
+         }];
+#endif
+        
         self.oauthRedirectURI   = [redirectURL absoluteString];
         self.oauthTestBlock = ^BOOL(NSURLResponse *response, id responseObject, NSError *error) {
             // don't retry to call the API if user is not authorized
@@ -108,13 +211,34 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
     return self;
 }
 
+- (void)configureRequestSerializerOfSessionManager:(AFHTTPSessionManager *)sessionManager
+{
+    // the settings of the requests built by AFNetworking win over the ones of the session
+    NSURLSessionConfiguration *configuration = sessionManager.session.configuration;
+    sessionManager.requestSerializer.timeoutInterval            = configuration.timeoutIntervalForRequest;
+    sessionManager.requestSerializer.HTTPShouldUsePipelining    = configuration.HTTPShouldUsePipelining;
+    sessionManager.requestSerializer.allowsCellularAccess       = configuration.allowsCellularAccess;
+}
+
+- (void)dealloc
+{
+    // the session keeps a strong reference to its delegate
+    [_streamingSession invalidate];
+    
+    [self cancelPrewarming];
+}
+
 
 #pragma mark - Properties
 
 - (NSURL *)authenticateURL
 {
     NSURL *authenticateURL = [self.oauthManager.baseURL URLByAppendingPathComponent:self.authorizeURLString];
-    return [authenticateURL uq_URLByAppendingQueryDictionary:[self authParameters]];
+    NSString *query = [self.queryEncoder queryStringFromParameters:[self authParameters]];
+    
+    NSURLComponents *components = [NSURLComponents componentsWithURL:authenticateURL resolvingAgainstBaseURL:NO];
+    components.percentEncodedQuery = components.percentEncodedQuery.length > 0 ? [components.percentEncodedQuery stringByAppendingFormat:@"&%@", query] : query;
+    return components.URL;
 }
 
 - (NSDictionary *)authParameters
@@ -135,6 +259,199 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
     return _scheduler;
 }
 
+- (dispatch_queue_t)decodeQueue
+{
+    if (_decodeQueue == nil) {
+        _decodeQueue = dispatch_queue_create("com.onemob.network.decode", DISPATCH_QUEUE_CONCURRENT);
+    }
+    return _decodeQueue;
+}
+
+- (ACEOAuth2RACRequestCoalescer *)requestCoalescer
+{
+    if (_requestCoalescer == nil) {
+        @weakify(self)
+        _requestCoalescer = [[ACEOAuth2RACRequestCoalescer alloc] initWithFlushBlock:^RACSignal *(NSArray<ACEOAuth2RACRequest *> *requests, NSDate *deadline) {
+            @strongify(self)
+            return [self rac_sendBatchRequests:requests deadline:deadline];
+        }];
+    }
+    return _requestCoalescer;
+}
+
+- (ACEOAuth2RACStreamingSession *)streamingSession
+{
+    if (_streamingSession == nil) {
+        _streamingSession = [[ACEOAuth2RACStreamingSession alloc] initWithSessionConfiguration:self.networkManager.session.configuration];
+    }
+    return _streamingSession;
+}
+
+- (ACEOAuth2RACChunkedUploader *)chunkedUploader
+{
+    if (_chunkedUploader == nil) {
+        @weakify(self)
+        _chunkedUploader = [[ACEOAuth2RACChunkedUploader alloc] initWithSendBlock:^RACSignal *(ACEOAuth2RACRequest *request) {
+            @strongify(self)
+            return [self rac_responseForRequest:request];
+        }];
+    }
+    return _chunkedUploader;
+}
+
+- (ACEOAuth2RACOfflineQueue *)offlineQueue
+{
+    if (_offlineQueue == nil) {
+        // the journal belongs to the server, the requests are relative to its URL
+        NSString *identifier = self.networkManager.baseURL.absoluteString ?: @"";
+        
+        @weakify(self)
+        _offlineQueue = [[ACEOAuth2RACOfflineQueue alloc] initWithIdentifier:identifier sendBlock:^RACSignal *(ACEOAuth2RACRequest *request) {
+            @strongify(self)
+            
+            // the manager is gone, the request stays in the journal for the next one
+            return [self rac_responseForRequest:request] ?: [RACSignal never];
+        }];
+    }
+    return _offlineQueue;
+}
+
+- (NSTimeInterval)batchWindow
+{
+    return self.requestCoalescer.window;
+}
+
+- (void)setBatchWindow:(NSTimeInterval)batchWindow
+{
+    self.requestCoalescer.window = batchWindow;
+}
+
+- (NSUInteger)batchSizeLimit
+{
+    return self.requestCoalescer.sizeLimit;
+}
+
+- (void)setBatchSizeLimit:(NSUInteger)batchSizeLimit
+{
+    self.requestCoalescer.sizeLimit = batchSizeLimit;
+}
+
+
+#pragma mark - Serialization
+
+- (void)setResponseSerializer:(AFHTTPResponseSerializer *)serializer forContentType:(NSString *)contentType
+{
+    [self.responseSerializer setSerializer:serializer forContentType:contentType];
+    
+    // tell the server what we can decode, the preferred types first
+    [self.networkManager.requestSerializer setValue:self.responseSerializer.acceptHeaderValue forHTTPHeaderField:@"Accept"];
+}
+
+
+#pragma mark - Interceptors
+
+- (NSArray<id<ACEOAuth2RACInterceptor>> *)interceptors
+{
+    return self.interceptorChain.interceptors;
+}
+
+- (void)addInterceptor:(id<ACEOAuth2RACInterceptor>)interceptor
+{
+    @synchronized (self) {
+        NSArray *interceptors = [self.interceptorChain.interceptors arrayByAddingObject:interceptor];
+        self.interceptorChain = [[ACEOAuth2RACInterceptorChain alloc] initWithInterceptors:interceptors];
+    }
+}
+
+- (void)removeInterceptor:(id<ACEOAuth2RACInterceptor>)interceptor
+{
+    @synchronized (self) {
+        NSMutableArray *interceptors = [self.interceptorChain.interceptors mutableCopy];
+        [interceptors removeObjectIdenticalTo:interceptor];
+        self.interceptorChain = [[ACEOAuth2RACInterceptorChain alloc] initWithInterceptors:interceptors];
+    }
+}
+
+
+#pragma mark - Routes
+
+- (NSMutableDictionary<NSString *, ACEOAuth2RACRoute *> *)routes
+{
+    if (_routes == nil) {
+        _routes = [NSMutableDictionary dictionary];
+    }
+    return _routes;
+}
+
+- (ACEOAuth2RACRoute *)registerRouteWithName:(NSString *)name URLTemplate:(NSString *)URLTemplate
+{
+    // compiled once, every request only fills the placeholders
+    ACEOAuth2RACRoute *route = [[ACEOAuth2RACRoute alloc] initWithURLTemplate:URLTemplate
+                                                                   identifier:name
+                                                                      baseURL:self.networkManager.baseURL];
+    
+    @synchronized (self.routes) {
+        self.routes[name] = route;
+    }
+    return route;
+}
+
+- (ACEOAuth2RACRoute *)routeNamed:(NSString *)name
+{
+    @synchronized (self.routes) {
+        return self.routes[name];
+    }
+}
+
+
+#pragma mark - Completion
+
+- (BOOL)removesKeysWithNullValues
+{
+    return [(AFJSONResponseSerializer *)self.responseSerializer.defaultSerializer removesKeysWithNullValues];
+}
+
+- (void)setRemovesKeysWithNullValues:(BOOL)removesKeysWithNullValues
+{
+    [(AFJSONResponseSerializer *)self.responseSerializer.defaultSerializer setRemovesKeysWithNullValues:removesKeysWithNullValues];
+}
+
+- (BOOL)decodesJSONLazily
+{
+    return [(ACEOAuth2RACJSONResponseSerializer *)self.responseSerializer.defaultSerializer decodesLazily];
+}
+
+- (void)setDecodesJSONLazily:(BOOL)decodesJSONLazily
+{
+    [(ACEOAuth2RACJSONResponseSerializer *)self.responseSerializer.defaultSerializer setDecodesLazily:decodesJSONLazily];
+}
+
+- (BOOL)usesSharedSession
+{
+    return self.oauthManager.sharedSessionManager != nil;
+}
+
+- (void)setUsesSharedSession:(BOOL)usesSharedSession
+{
+    self.oauthManager.sharedSessionManager = usesSharedSession ? self.networkManager : nil;
+}
+
+- (void)setCompletesOnPrivateQueue:(BOOL)completesOnPrivateQueue
+{
+    _completesOnPrivateQueue = completesOnPrivateQueue;
+    
+    // the retries follow the completion queue of the session manager
+    self.networkManager.completionQueue = completesOnPrivateQueue ? self.completionQueue : nil;
+}
+
+- (dispatch_queue_t)completionQueue
+{
+    if (_completionQueue == nil) {
+        _completionQueue = dispatch_queue_create("com.onemob.network.completion", DISPATCH_QUEUE_CONCURRENT);
+    }
+    return _completionQueue;
+}
+
 
 #pragma mark - Logger
 
@@ -388,7 +705,7 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
 
 - (BOOL)handleRedirectURL:(NSURL *)redirectURL
 {
-    NSString *oauthCode = [redirectURL uq_queryDictionary][@"code"];
+    NSString *oauthCode = ACEOAuth2RACQueryValueForKey(redirectURL, @"code");
     if (oauthCode != nil && self.pendingSubscriber != nil) {
         
         @weakify(self)
@@ -443,12 +760,7 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
 
 - (RACSignal *)rac_GET:(NSString *)path parameters:(id)parameters retries:(NSInteger)retries interval:(NSTimeInterval)interval
 {
-    return [[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
-        return [[self.networkManager rac_GET:path parameters:parameters retries:retries interval:interval test:self.oauthTestBlock]
-                map:^id(RACTuple *response) {
-                    return [response first];
-                }];
-    }];
+    return [self rac_request:[ACEOAuth2RACRequest requestWithMethod:@"GET" path:path parameters:parameters retries:retries interval:interval]];
 }
 
 - (RACSignal *)rac_HEAD:(NSString *)path parameters:(id)parameters
@@ -458,12 +770,7 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
 
 - (RACSignal *)rac_HEAD:(NSString *)path parameters:(id)parameters retries:(NSInteger)retries interval:(NSTimeInterval)interval
 {
-    return [[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
-        return [[self.networkManager rac_HEAD:path parameters:parameters retries:retries interval:interval test:self.oauthTestBlock]
-                map:^id(RACTuple *response) {
-                    return [response first];
-                }];
-    }];
+    return [self rac_request:[ACEOAuth2RACRequest requestWithMethod:@"HEAD" path:path parameters:parameters retries:retries interval:interval]];
 }
 
 - (RACSignal *)rac_POST:(NSString *)path parameters:(id)parameters
@@ -473,12 +780,7 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
 
 - (RACSignal *)rac_POST:(NSString *)path parameters:(id)parameters retries:(NSInteger)retries interval:(NSTimeInterval)interval
 {
-    return [[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
-        return [[self.networkManager rac_POST:path parameters:parameters retries:retries interval:interval test:self.oauthTestBlock]
-                map:^id(RACTuple *response) {
-                    return [response first];
-                }];
-    }];
+    return [self rac_request:[ACEOAuth2RACRequest requestWithMethod:@"POST" path:path parameters:parameters retries:retries interval:interval]];
 }
 
 - (RACSignal *)rac_PUT:(NSString *)path parameters:(id)parameters
@@ -488,12 +790,7 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
 
 - (RACSignal *)rac_PUT:(NSString *)path parameters:(id)parameters retries:(NSInteger)retries interval:(NSTimeInterval)interval
 {
-    return [[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
-        return [[self.networkManager rac_PUT:path parameters:parameters retries:retries interval:interval test:self.oauthTestBlock]
-                map:^id(RACTuple *response) {
-                    return [response first];
-                }];
-    }];
+    return [self rac_request:[ACEOAuth2RACRequest requestWithMethod:@"PUT" path:path parameters:parameters retries:retries interval:interval]];
 }
 
 - (RACSignal *)rac_PATCH:(NSString *)path parameters:(id)parameters
@@ -503,12 +800,7 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
 
 - (RACSignal *)rac_PATCH:(NSString *)path parameters:(id)parameters retries:(NSInteger)retries interval:(NSTimeInterval)interval
 {
-    return [[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
-        return [[self.networkManager rac_PATCH:path parameters:parameters retries:retries interval:interval test:self.oauthTestBlock]
-                map:^id(RACTuple *response) {
-                    return [response first];
-                }];
-    }];
+    return [self rac_request:[ACEOAuth2RACRequest requestWithMethod:@"PATCH" path:path parameters:parameters retries:retries interval:interval]];
 }
 
 - (RACSignal *)rac_DELETE:(NSString *)path parameters:(id)parameters
@@ -518,14 +810,901 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
 
 - (RACSignal *)rac_DELETE:(NSString *)path parameters:(id)parameters retries:(NSInteger)retries interval:(NSTimeInterval)interval
 {
-    return [[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
-        return [[self.networkManager rac_DELETE:path parameters:parameters retries:retries interval:interval test:self.oauthTestBlock]
-                map:^id(RACTuple *response) {
-                    return [response first];
+    return [self rac_request:[ACEOAuth2RACRequest requestWithMethod:@"DELETE" path:path parameters:parameters retries:retries interval:interval]];
+}
+
+- (RACSignal *)rac_GET:(NSString *)path parameters:(id)parameters modelClass:(Class)modelClass
+{
+    ACEOAuth2RACRequest *request = [ACEOAuth2RACRequest requestWithMethod:@"GET" path:path parameters:parameters];
+    request.modelClass = modelClass;
+    return [self rac_request:request];
+}
+
+- (RACSignal *)rac_request:(ACEOAuth2RACRequest *)request
+{
+    RACSignal *signal = [[self rac_responseForRequest:request]
+                         map:^id(RACTuple *response) {
+                             return [response first];
+                         }];
+    
+    if (request.modelClass != nil) {
+        signal = [self rac_mapResponse:signal toModelClass:request.modelClass];
+    }
+    return [[self rac_deliver:signal] setNameWithFormat:@"[%@] -rac_request: %@", self.class, request];
+}
+
+- (RACSignal *)rac_requestRoute:(NSString *)name
+                         method:(NSString *)method
+                         values:(NSDictionary<NSString *, id> *)values
+                     parameters:(id)parameters
+{
+    ACEOAuth2RACRoute *route = [self routeNamed:name];
+    NSAssert(route != nil, @"The route %@ is not registered", name);
+    
+    return [self rac_request:[ACEOAuth2RACRequest requestWithMethod:method route:route values:values parameters:parameters]];
+}
+
+- (RACSignal *)rac_deliver:(RACSignal *)signal
+{
+    // the whole pipeline stays off the main thread, only the final subscriber hops to it
+    return self.deliversOnMainThread ? [signal deliverOnMainThread] : signal;
+}
+
+- (RACSignal *)rac_mapResponse:(RACSignal *)signal toModelClass:(Class)modelClass
+{
+    return [signal flattenMap:^__kindof RACSignal *(id responseObject) {
+        return [RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+            
+            // the thread delivering the response only hands it over
+            dispatch_async(self.decodeQueue, ^{
+                NSError *error;
+                id model = [ACEOAuth2RACModelMapper modelOfClass:modelClass fromResponseObject:responseObject error:&error];
+                
+                if (model != nil) {
+                    [subscriber sendNext:model];
+                    [subscriber sendCompleted];
+                    
+                } else {
+                    [subscriber sendError:error];
+                }
+            });
+            return nil;
+        }];
+    }];
+}
+
+- (RACSignal *)rac_responseForRequest:(ACEOAuth2RACRequest *)request
+{
+    return [self rac_request:request withDeadline:^RACSignal *(NSDate *deadline) {
+        
+        // the authentication is part of the budget
+        return [[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
+            return [self rac_networkSignalForRequest:request deadline:deadline];
+        }];
+    }];
+}
+
+- (RACSignal *)rac_request:(ACEOAuth2RACRequest *)request withDeadline:(RACSignal *(^)(NSDate *deadline))block
+{
+    if (request.deadline <= 0.0) {
+        return block(nil);
+    }
+    
+    return [RACSignal defer:^RACSignal *{
+        
+        // the clock starts with the subscription
+        NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:request.deadline];
+        
+        return [[block(deadline) timeout:request.deadline onScheduler:[RACScheduler scheduler]]
+                catch:^RACSignal *(NSError *error) {
+                    if ([error.domain isEqualToString:RACSignalErrorDomain] && error.code == RACSignalErrorTimedOut) {
+                        return [RACSignal error:[self deadlineErrorForRequest:request]];
+                        
+                    } else {
+                        return [RACSignal error:error];
+                    }
                 }];
     }];
 }
 
+- (NSError *)deadlineErrorForRequest:(ACEOAuth2RACRequest *)request
+{
+    return [NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                               code:ACEOAuth2RACErrorDeadlineExceeded
+                           userInfo:@{
+                                      NSLocalizedDescriptionKey: [NSString stringWithFormat:@"The request %@ %@ didn't complete within %.1f seconds",
+                                                                  request.HTTPMethod, request.path, request.deadline]
+                                      }];
+}
+
+- (RACSignal *)rac_networkSignalForRequest:(ACEOAuth2RACRequest *)request deadline:(NSDate *)deadline
+{
+    // a route missing a value fails here, before the request can join a batch
+    NSError *URLError;
+    NSURL *URL = [self URLForRequest:request error:&URLError];
+    if (URL == nil) {
+        return [RACSignal error:URLError];
+    }
+    
+    if (request.isBatchable && request.HTTPBody == nil && self.batchURLString != nil) {
+        if ([self canBatchRequest:request]) {
+            // wait for the other requests of the window
+            return [self.requestCoalescer rac_enqueueRequest:request deadline:deadline];
+        }
+        
+        ACE_LOG_DEBUG(@"Sending %@ %@ out of the batch, its parameters are not valid JSON", request.HTTPMethod, request.path);
+    }
+    
+    @weakify(self)
+    return [RACSignal defer:^RACSignal *{
+        
+        @strongify(self)
+        NSError *error;
+        NSURLRequest *URLRequest = [self URLRequestForRequest:request URL:URL error:&error];
+        if (URLRequest == nil) {
+            return [RACSignal error:error];
+        }
+        
+        // a response from the cache of an interceptor doesn't wait for a slot
+        return [self.interceptorChain rac_interceptRequest:URLRequest withBlock:^RACSignal *(NSURLRequest *URLRequest) {
+            RACSignal *networkSignal = [[self rac_compressRequestBody:URLRequest ofRequest:request] flattenMap:^__kindof RACSignal *(NSURLRequest *URLRequest) {
+                
+                // the response is a tuple with the response object and the URL response
+                return [self.networkManager rac_sendRequest:URLRequest
+                                                    retries:request.retries
+                                                   interval:request.interval
+                                                       test:self.oauthTestBlock
+                                                  configure:[self taskConfigurationForRequest:request deadline:deadline]];
+            }];
+            
+            // wait for a free slot before compressing and sending the request
+            return [self.requestQueue rac_enqueueSignal:networkSignal
+                                               priority:request.priority
+                                                   host:URLRequest.URL.host
+                                                 caller:request.callerIdentifier];
+        }];
+    }];
+}
+
+- (BOOL)canBatchRequest:(ACEOAuth2RACRequest *)request
+{
+    // the batch body is JSON, a single request with dates or data would make the serialization raise
+    return request.parameters == nil || [NSJSONSerialization isValidJSONObject:@[ request.parameters ]];
+}
+
+- (RACSignal *)rac_compressRequestBody:(NSURLRequest *)URLRequest ofRequest:(ACEOAuth2RACRequest *)request
+{
+    // only the bodies built by the request serializer, a raw body can be binary or compressed already
+    if (request.HTTPBody != nil) {
+        return [RACSignal return:URLRequest];
+    }
+    return [self rac_compressRequestBody:URLRequest];
+}
+
+- (RACSignal *)rac_compressRequestBody:(NSURLRequest *)URLRequest
+{
+    if (!self.compressesRequestBodies ||
+        URLRequest.HTTPBody.length < MAX(self.compressionThreshold, 1) ||
+        [URLRequest valueForHTTPHeaderField:@"Content-Encoding"] != nil ||
+        !ACEOAuth2RACIsCompressibleContentType([URLRequest valueForHTTPHeaderField:@"Content-Type"])) {
+        
+        return [RACSignal return:URLRequest];
+    }
+    
+    // keep the caller's thread and the queue free while compressing
+    return [[RACSignal defer:^RACSignal *{
+        NSData *body = URLRequest.HTTPBody;
+        NSData *compressedBody = ACEOAuth2RACGzipCompressData(body);
+        
+        // not worth the decompression on the server
+        if (compressedBody == nil || compressedBody.length > body.length * 0.9) {
+            return [RACSignal return:URLRequest];
+        }
+        
+        ACE_LOG_DEBUG(@"Compressed the body of %@ from %lu to %lu bytes", URLRequest.URL, (unsigned long)body.length, (unsigned long)compressedBody.length);
+        
+        NSMutableURLRequest *compressedRequest = [URLRequest mutableCopy];
+        compressedRequest.HTTPBody = compressedBody;
+        [compressedRequest setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+        [compressedRequest setValue:[NSString stringWithFormat:@"%lu", (unsigned long)compressedBody.length] forHTTPHeaderField:@"Content-Length"];
+        return [RACSignal return:compressedRequest];
+        
+    }] subscribeOn:[RACScheduler schedulerWithPriority:RACSchedulerPriorityDefault name:@"com.onemob.network.compression"]];
+}
+
+- (void (^)(RACURLSessionRetryDataTask *task))taskConfigurationForRequest:(ACEOAuth2RACRequest *)request deadline:(NSDate *)deadline
+{
+    return ^(RACURLSessionRetryDataTask *task) {
+        task.priority = ACEOAuth2RACTaskPriorityForRequestPriority(request.priority);
+        
+        if (deadline != nil) {
+            task.deadline         = deadline;
+            task.deadlineError    = [self deadlineErrorForRequest:request];
+        }
+    };
+}
+
+- (NSURL *)URLForRequest:(ACEOAuth2RACRequest *)request error:(NSError *__autoreleasing *)error
+{
+    if (request.route != nil) {
+        return [request.route URLWithValues:request.routeValues error:error];
+    }
+    NSURL *URL = [[NSURL URLWithString:request.path relativeToURL:self.networkManager.baseURL] absoluteURL];
+    if (URL == nil && error != NULL) {
+        *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadURL userInfo:@{ NSURLErrorFailingURLStringErrorKey: request.path }];
+    }
+    return URL;
+}
+
+- (NSURLRequest *)URLRequestForRequest:(ACEOAuth2RACRequest *)request URL:(NSURL *)URL error:(NSError *__autoreleasing *)error
+{
+    AFHTTPRequestSerializer *requestSerializer = self.networkManager.requestSerializer;
+    
+    // same as -requestWithMethod:URLString:parameters:error:, without parsing the URL again from a string
+    NSMutableURLRequest *URLRequest = [[NSMutableURLRequest alloc] initWithURL:URL];
+    URLRequest.HTTPMethod               = request.HTTPMethod;
+    URLRequest.allowsCellularAccess     = requestSerializer.allowsCellularAccess;
+    URLRequest.cachePolicy              = requestSerializer.cachePolicy;
+    URLRequest.HTTPShouldHandleCookies  = requestSerializer.HTTPShouldHandleCookies;
+    URLRequest.HTTPShouldUsePipelining  = requestSerializer.HTTPShouldUsePipelining;
+    URLRequest.networkServiceType       = requestSerializer.networkServiceType;
+    URLRequest.timeoutInterval          = requestSerializer.timeoutInterval;
+    
+    URLRequest = [[requestSerializer requestBySerializingRequest:URLRequest
+                                                  withParameters:request.HTTPBody ? nil : request.parameters
+                                                           error:error] mutableCopy];
+    if (URLRequest == nil) {
+        return nil;
+    }
+    
+    // the identity of the route follows the request, for the metrics and the caches
+    if (request.route != nil) {
+        [NSURLProtocol setProperty:request.route.identifier forKey:ACEOAuth2RACRouteIdentifierKey inRequest:URLRequest];
+    }
+    
+    [request.HTTPHeaders enumerateKeysAndObjectsUsingBlock:^(NSString *field, NSString *value, BOOL *stop) {
+        [URLRequest setValue:value forHTTPHeaderField:field];
+    }];
+    
+    if (request.HTTPBody != nil) {
+        URLRequest.HTTPBody = request.HTTPBody;
+    }
+    return URLRequest;
+}
+
+
+#pragma mark - Batch Signals
+
+- (RACSignal *)rac_batchRequests:(NSArray<ACEOAuth2RACRequest *> *)requests
+                   maxConcurrent:(NSUInteger)maxConcurrent
+                         ordered:(BOOL)ordered
+{
+    NSArray *batch = [requests copy];
+    
+    @weakify(self)
+    return [[self rac_deliver:[[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
+        
+        @strongify(self)
+        NSMutableArray *signals = [NSMutableArray arrayWithCapacity:batch.count];
+        [batch enumerateObjectsUsingBlock:^(ACEOAuth2RACRequest *request, NSUInteger idx, BOOL *stop) {
+            
+            RACSignal *requestSignal = [self rac_request:request withDeadline:^RACSignal *(NSDate *deadline) {
+                return [self rac_networkSignalForRequest:request deadline:deadline];
+            }];
+            
+            // a failing item is turned into a value, so it won't abort the batch
+            [signals addObject:[[requestSignal
+                                 map:^id(RACTuple *response) {
+                                     return RACTuplePack(@(idx), [response first], nil);
+                                     
+                                 }] catch:^RACSignal *(NSError *error) {
+                                     return [RACSignal return:RACTuplePack(@(idx), nil, error)];
+                                 }]];
+        }];
+        
+        // the credentials are already valid, run the requests with bounded concurrency
+        RACSignal *results = [[signals.rac_sequence signalWithScheduler:[RACScheduler immediateScheduler]] flatten:maxConcurrent];
+        return ordered ? [self rac_orderedBatchResults:results] : results;
+        
+    }]] setNameWithFormat:@"[%@] -rac_batchRequests: %lu maxConcurrent: %lu ordered: %d",
+            self.class, (unsigned long)batch.count, (unsigned long)maxConcurrent, ordered];
+}
+
+- (RACSignal *)rac_sendBatchRequests:(NSArray<ACEOAuth2RACRequest *> *)requests deadline:(NSDate *)deadline
+{
+    NSMutableArray *subRequests = [NSMutableArray arrayWithCapacity:requests.count];
+    NSInteger retries           = 0;
+    NSTimeInterval interval     = 0.0;
+    ACEOAuth2RACRequestPriority priority = ACEOAuth2RACRequestPriorityBackground;
+    ACEOAuth2RACRequest *deadlineRequest;
+    
+    for (ACEOAuth2RACRequest *request in requests) {
+        NSMutableDictionary *subRequest = [NSMutableDictionary dictionary];
+        subRequest[@"method"]       = request.HTTPMethod;
+        subRequest[@"path"]         = request.route ? [request.route pathWithValues:request.routeValues] : request.path;
+        subRequest[@"parameters"]   = request.parameters;
+        [subRequests addObject:subRequest];
+        
+        // the batch is as patient as its most patient request
+        retries     = MAX(retries, request.retries);
+        interval    = MAX(interval, request.interval);
+        priority    = MIN(priority, request.priority);
+        
+        // but not past its earliest deadline, the batch fails with the error of that request
+        if (request.deadline > 0.0 && (deadlineRequest == nil || request.deadline < deadlineRequest.deadline)) {
+            deadlineRequest = request;
+        }
+    }
+    
+    NSError *error;
+    NSData *body = [NSJSONSerialization dataWithJSONObject:@{ @"requests": subRequests } options:0 error:&error];
+    if (body == nil) {
+        return [RACSignal error:error];
+    }
+    
+    NSString *URLString = [[NSURL URLWithString:self.batchURLString relativeToURL:self.networkManager.baseURL] absoluteString];
+    NSMutableURLRequest *batchRequest = [self.networkManager.requestSerializer requestWithMethod:@"POST"
+                                                                                       URLString:URLString
+                                                                                      parameters:nil
+                                                                                           error:&error];
+    if (batchRequest == nil) {
+        return [RACSignal error:error];
+    }
+    
+    [batchRequest setValue:@"application/json" forHTTPHeaderField:@"Content-Type"];
+    batchRequest.HTTPBody = body;
+    
+    // the interceptors see the batch call, the sub-requests are only its body
+    return [self.interceptorChain rac_interceptRequest:batchRequest withBlock:^RACSignal *(NSURLRequest *URLRequest) {
+        RACSignal *batchSignal = [[self rac_compressRequestBody:URLRequest] flattenMap:^__kindof RACSignal *(NSURLRequest *URLRequest) {
+            return [self.networkManager rac_sendRequest:URLRequest
+                                                retries:retries
+                                               interval:interval
+                                                   test:self.oauthTestBlock
+                                              configure:^(RACURLSessionRetryDataTask *task) {
+                                                  if (deadlineRequest != nil) {
+                                                      [self taskConfigurationForRequest:deadlineRequest deadline:deadline](task);
+                                                  }
+                                                  task.priority = ACEOAuth2RACTaskPriorityForRequestPriority(priority);
+                                              }];
+        }];
+        
+        return [self.requestQueue rac_enqueueSignal:batchSignal
+                                           priority:priority
+                                               host:URLRequest.URL.host
+                                             caller:nil];
+    }];
+}
+
+- (RACSignal *)rac_orderedBatchResults:(RACSignal *)results
+{
+    return [RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+        
+        // hold the results completed out of order until their turn comes
+        NSMutableDictionary *pendingResults = [NSMutableDictionary dictionary];
+        __block NSUInteger nextIndex = 0;
+        
+        return [results subscribeNext:^(RACTuple *result) {
+            
+            @synchronized (pendingResults) {
+                pendingResults[result.first] = result;
+                
+                RACTuple *nextResult;
+                while ((nextResult = pendingResults[@(nextIndex)]) != nil) {
+                    [pendingResults removeObjectForKey:@(nextIndex)];
+                    nextIndex++;
+                    
+                    [subscriber sendNext:nextResult];
+                }
+            }
+            
+        } error:^(NSError *error) {
+            [subscriber sendError:error];
+            
+        } completed:^{
+            [subscriber sendCompleted];
+        }];
+    }];
+}
+
+
+#pragma mark - Streaming Signals
+
+- (RACSignal *)rac_streamGET:(NSString *)path parameters:(id)parameters itemsKey:(NSString *)itemsKey
+{
+    return [self rac_streamRequest:[ACEOAuth2RACRequest requestWithMethod:@"GET" path:path parameters:parameters] itemsKey:itemsKey];
+}
+
+- (RACSignal *)rac_streamRequest:(ACEOAuth2RACRequest *)request itemsKey:(NSString *)itemsKey
+{
+    return [[self rac_deliver:[self rac_request:request withDeadline:^RACSignal *(NSDate *deadline) {
+        return [[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
+            return [self rac_streamSignalForRequest:request itemsKey:itemsKey];
+        }];
+        
+    }]] setNameWithFormat:@"[%@] -rac_streamRequest: %@ itemsKey: %@", self.class, request, itemsKey];
+}
+
+- (RACSignal *)rac_streamSignalForRequest:(ACEOAuth2RACRequest *)request itemsKey:(NSString *)itemsKey
+{
+    NSError *URLError;
+    NSURL *URL = [self URLForRequest:request error:&URLError];
+    if (URL == nil) {
+        return [RACSignal error:URLError];
+    }
+    
+    @weakify(self)
+    RACSignal *streamSignal = [RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+        
+        @strongify(self)
+        NSError *error;
+        NSURLRequest *URLRequest = [self URLRequestForRequest:request URL:URL error:&error];
+        if (URLRequest == nil) {
+            [subscriber sendError:error];
+            return nil;
+        }
+        
+        ACEOAuth2RACJSONStreamParser *parser = [[ACEOAuth2RACJSONStreamParser alloc] initWithItemsKey:itemsKey];
+        
+        // the stream trusts the same servers of the other requests
+        self.streamingSession.securityPolicy = self.networkManager.securityPolicy;
+        
+        RACSignal *dataSignal = [self.interceptorChain rac_interceptStreamRequest:URLRequest withBlock:^RACSignal *(NSURLRequest *URLRequest) {
+            return [self.streamingSession rac_dataSignalForRequest:URLRequest];
+        }];
+        
+        return [dataSignal
+                subscribeNext:^(id chunk) {
+                    if (![chunk isKindOfClass:[NSData class]]) {
+                        // the URL response
+                        return;
+                    }
+                    
+                    // each element is sent as soon as its last byte arrives
+                    NSError *parseError;
+                    if (![parser parseData:chunk elementHandler:^(id element) {
+                        [subscriber sendNext:element];
+                        
+                    } error:&parseError]) {
+                        [subscriber sendError:parseError];
+                    }
+                    
+                } error:^(NSError *error) {
+                    [subscriber sendError:error];
+                    
+                } completed:^{
+                    NSError *parseError;
+                    if ([parser finishWithError:&parseError]) {
+                        [subscriber sendCompleted];
+                        
+                    } else {
+                        [subscriber sendError:parseError];
+                    }
+                }];
+    }];
+    
+    return [self.requestQueue rac_enqueueSignal:streamSignal
+                                       priority:request.priority
+                                           host:URL.host
+                                         caller:request.callerIdentifier];
+}
+
+
+#pragma mark - Transfer Signals
+
+- (RACSignal *)rac_downloadRequest:(ACEOAuth2RACRequest *)request
+                             toURL:(NSURL *)fileURL
+                        resumeData:(NSData *)resumeData
+                          progress:(id<RACSubscriber>)progressSubscriber
+{
+    return [[self rac_deliver:[self rac_signal:[[self rac_request:request withDeadline:^RACSignal *(NSDate *deadline) {
+        return [[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
+            return [self rac_downloadSignalForRequest:request toURL:fileURL resumeData:resumeData deadline:deadline progress:progressSubscriber];
+        }];
+        
+    }] map:^id(RACTuple *response) {
+        return [response first];
+        
+    }] finishingProgress:progressSubscriber]] setNameWithFormat:@"[%@] -rac_downloadRequest: %@ toURL: %@", self.class, request, fileURL];
+}
+
+- (RACSignal *)rac_signal:(RACSignal *)signal finishingProgress:(id<RACSubscriber>)progressSubscriber
+{
+    if (progressSubscriber == nil) {
+        return signal;
+    }
+    
+    // the progress ends with the transfer, whether it succeeds, fails or is cancelled
+    return [RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+        RACDisposable *disposable = [signal subscribeNext:^(id x) {
+            [subscriber sendNext:x];
+            
+        } error:^(NSError *error) {
+            [progressSubscriber sendError:error];
+            [subscriber sendError:error];
+            
+        } completed:^{
+            [progressSubscriber sendCompleted];
+            [subscriber sendCompleted];
+        }];
+        
+        return [RACDisposable disposableWithBlock:^{
+            [disposable dispose];
+            [progressSubscriber sendCompleted];
+        }];
+    }];
+}
+
+- (RACSignal *)rac_downloadSignalForRequest:(ACEOAuth2RACRequest *)request
+                                      toURL:(NSURL *)fileURL
+                                 resumeData:(NSData *)resumeData
+                                   deadline:(NSDate *)deadline
+                                   progress:(id<RACSubscriber>)progressSubscriber
+{
+    NSError *URLError;
+    NSURL *URL = [self URLForRequest:request error:&URLError];
+    if (URL == nil) {
+        return [RACSignal error:URLError];
+    }
+    
+    @weakify(self)
+    RACSignal *downloadSignal = [RACSignal defer:^RACSignal *{
+        
+        @strongify(self)
+        NSError *error;
+        NSURLRequest *URLRequest = [self URLRequestForRequest:request URL:URL error:&error];
+        if (URLRequest == nil) {
+            return [RACSignal error:error];
+        }
+        
+        // the body goes straight to the file, the response is a tuple with the file URL and the URL response
+        return [self.interceptorChain rac_interceptStreamRequest:URLRequest withBlock:^RACSignal *(NSURLRequest *URLRequest) {
+            return [self.networkManager rac_downloadRequest:URLRequest
+                                                 resumeData:resumeData
+                                                destination:fileURL
+                                                   progress:^(NSProgress *downloadProgress) {
+                                                       [progressSubscriber sendNext:downloadProgress];
+                                                   }
+                                                    retries:request.retries
+                                                   interval:request.interval
+                                                       test:self.oauthTestBlock
+                                                  configure:[self taskConfigurationForRequest:request deadline:deadline]];
+        }];
+    }];
+    
+    return [self.requestQueue rac_enqueueSignal:downloadSignal
+                                       priority:request.priority
+                                           host:URL.host
+                                         caller:request.callerIdentifier];
+}
+
+- (RACSignal *)rac_POST:(NSString *)path
+             parameters:(id)parameters
+               fileURLs:(NSDictionary<NSString *, NSURL *> *)fileURLs
+               progress:(id<RACSubscriber>)progressSubscriber
+{
+    ACEOAuth2RACRequest *request = [ACEOAuth2RACRequest requestWithMethod:@"POST" path:path parameters:parameters];
+    
+    return [self rac_uploadRequest:request constructingBodyWithPartsBlock:^BOOL(id<AFMultipartFormData> formData, NSError **error) {
+        
+        // a file that can't be read fails the upload, instead of being left out of the form
+        __block NSError *fileError;
+        __block BOOL appended = YES;
+        [fileURLs enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSURL *fileURL, BOOL *stop) {
+            NSError *partError;
+            appended    = [formData appendPartWithFileURL:fileURL name:name error:&partError];
+            fileError   = partError;
+            *stop       = !appended;
+        }];
+        
+        if (!appended && error != NULL) {
+            *error = fileError;
+        }
+        return appended;
+        
+    } progress:progressSubscriber];
+}
+
+- (RACSignal *)rac_uploadRequest:(ACEOAuth2RACRequest *)request
+       constructingBodyWithBlock:(void (^)(id<AFMultipartFormData> formData))block
+                        progress:(id<RACSubscriber>)progressSubscriber
+{
+    return [self rac_uploadRequest:request constructingBodyWithPartsBlock:^BOOL(id<AFMultipartFormData> formData, NSError **error) {
+        block(formData);
+        return YES;
+        
+    } progress:progressSubscriber];
+}
+
+- (RACSignal *)rac_uploadRequest:(ACEOAuth2RACRequest *)request
+  constructingBodyWithPartsBlock:(ACEOAuth2RACMultipartBodyBlock)block
+                        progress:(id<RACSubscriber>)progressSubscriber
+{
+    return [[self rac_deliver:[self rac_signal:[[self rac_request:request withDeadline:^RACSignal *(NSDate *deadline) {
+        return [[self rac_authenticate] flattenMap:^__kindof RACSignal *(AFOAuthCredential *credential) {
+            return [self rac_uploadSignalForRequest:request constructingBodyWithBlock:block deadline:deadline progress:progressSubscriber];
+        }];
+        
+    }] map:^id(RACTuple *response) {
+        return [response first];
+        
+    }] finishingProgress:progressSubscriber]] setNameWithFormat:@"[%@] -rac_uploadRequest: %@", self.class, request];
+}
+
+- (NSURLRequest *)multipartRequestForRequest:(ACEOAuth2RACRequest *)request
+                                         URL:(NSURL *)URL
+                   constructingBodyWithBlock:(ACEOAuth2RACMultipartBodyBlock)block
+                                       error:(NSError *__autoreleasing *)error
+{
+    __block NSError *partError;
+    __block BOOL constructed = YES;
+    
+    NSURLRequest *URLRequest = [self.networkManager.requestSerializer multipartFormRequestWithMethod:request.HTTPMethod
+                                                                                           URLString:[URL absoluteString]
+                                                                                          parameters:request.parameters
+                                                                           constructingBodyWithBlock:^(id<AFMultipartFormData> formData) {
+                                                                               NSError *blockError;
+                                                                               constructed  = block(formData, &blockError);
+                                                                               partError    = blockError;
+                                                                           }
+                                                                                               error:error];
+    if (URLRequest != nil && !constructed) {
+        if (error != NULL) {
+            *error = partError;
+        }
+        return nil;
+    }
+    return URLRequest;
+}
+
+- (RACSignal *)rac_uploadSignalForRequest:(ACEOAuth2RACRequest *)request
+                constructingBodyWithBlock:(ACEOAuth2RACMultipartBodyBlock)block
+                                 deadline:(NSDate *)deadline
+                                 progress:(id<RACSubscriber>)progressSubscriber
+{
+    NSError *URLError;
+    NSURL *URL = [self URLForRequest:request error:&URLError];
+    if (URL == nil) {
+        return [RACSignal error:URLError];
+    }
+    
+    @weakify(self)
+    RACSignal *uploadSignal = [RACSignal defer:^RACSignal *{
+        
+        @strongify(self)
+        NSError *error;
+        __block NSURLRequest *firstRequest = [self multipartRequestForRequest:request URL:URL constructingBodyWithBlock:block error:&error];
+        if (firstRequest == nil) {
+            return [RACSignal error:error];
+        }
+        
+        // the parts are read from their files while they are sent, every retry builds a new body stream,
+        // which goes through the interceptors again
+        return [self.interceptorChain rac_interceptStreamRequest:firstRequest withBlock:^RACSignal *(NSURLRequest *interceptedRequest) {
+            firstRequest = interceptedRequest;
+            
+            return [self.networkManager rac_uploadRequestWithBuilder:^NSURLRequest *{
+                NSURLRequest *URLRequest = firstRequest;
+                if (URLRequest == nil) {
+                    URLRequest = [self multipartRequestForRequest:request URL:URL constructingBodyWithBlock:block error:NULL];
+                    URLRequest = URLRequest ? [self.interceptorChain requestByInterceptingRequest:URLRequest] : nil;
+                }
+                firstRequest = nil;
+                return URLRequest;
+            }
+                                                            progress:^(NSProgress *uploadProgress) {
+                                                                [progressSubscriber sendNext:uploadProgress];
+                                                            }
+                                                             retries:request.retries
+                                                            interval:request.interval
+                                                                test:self.oauthTestBlock
+                                                           configure:[self taskConfigurationForRequest:request deadline:deadline]];
+        }];
+    }];
+    
+    return [self.requestQueue rac_enqueueSignal:uploadSignal
+                                       priority:request.priority
+                                           host:URL.host
+                                         caller:request.callerIdentifier];
+}
+
+- (RACSignal *)rac_uploadFileURL:(NSURL *)fileURL
+                          toPath:(NSString *)path
+                      identifier:(NSString *)identifier
+                        progress:(id<RACSubscriber>)progressSubscriber
+{
+    return [self rac_deliver:[self.chunkedUploader rac_uploadFileURL:fileURL toPath:path identifier:identifier progress:progressSubscriber]];
+}
+
+
+#pragma mark - Offline Signals
+
+- (RACSignal *)rac_enqueueOfflineRequest:(ACEOAuth2RACRequest *)request
+{
+    @weakify(self)
+    return [[self rac_deliver:[[self.offlineQueue rac_enqueueRequest:request]
+                               doCompleted:^{
+                                   @strongify(self)
+                                   
+                                   // no need to wait for a change of network
+                                   if (self.reachabilityManager.networkReachabilityStatus != AFNetworkReachabilityStatusNotReachable) {
+                                       [self.offlineQueue replay];
+                                   }
+                               }]]
+            setNameWithFormat:@"[%@] -rac_enqueueOfflineRequest: %@", self.class, request];
+}
+
+
+#pragma mark - Pagination Signals
+
+- (RACSignal *)rac_pagesForRequest:(ACEOAuth2RACRequest *)request
+{
+    return [self rac_pagesForRequest:request cursorKeyPath:nil cursorParameter:nil prefetchDepth:1];
+}
+
+- (RACSignal *)rac_pagesForRequest:(ACEOAuth2RACRequest *)request
+                     cursorKeyPath:(NSString *)cursorKeyPath
+                   cursorParameter:(NSString *)cursorParameter
+                     prefetchDepth:(NSUInteger)prefetchDepth
+{
+    return [[ACEOAuth2RACPaginator rac_pagesForRequest:request
+                                         prefetchDepth:prefetchDepth
+                                            fetchBlock:^RACSignal *(ACEOAuth2RACRequest *pageRequest) {
+                                                return [self rac_responseForRequest:pageRequest];
+                                                
+                                            } nextRequestBlock:^ACEOAuth2RACRequest *(ACEOAuth2RACRequest *pageRequest, RACTuple *response) {
+                                                return [self nextPageRequestForRequest:pageRequest
+                                                                              response:response
+                                                                         cursorKeyPath:cursorKeyPath
+                                                                       cursorParameter:cursorParameter];
+                                            }]
+            setNameWithFormat:@"[%@] -rac_pagesForRequest: %@ cursorKeyPath: %@", self.class, request, cursorKeyPath];
+}
+
+- (ACEOAuth2RACRequest *)nextPageRequestForRequest:(ACEOAuth2RACRequest *)request
+                                          response:(RACTuple *)response
+                                     cursorKeyPath:(NSString *)cursorKeyPath
+                                   cursorParameter:(NSString *)cursorParameter
+{
+    ACEOAuth2RACRequest *nextRequest = [request copy];
+    
+    // the link already contains every parameter
+    NSURL *nextURL = [self nextLinkURLForResponse:[response second]];
+    if (nextURL != nil) {
+        nextRequest.path        = [nextURL absoluteString];
+        nextRequest.route       = nil;
+        nextRequest.parameters  = nil;
+        return nextRequest;
+    }
+    
+    if (cursorKeyPath == nil || cursorParameter == nil) {
+        return nil;
+    }
+    
+    id responseObject = [response first];
+    id cursor = [responseObject isKindOfClass:[NSDictionary class]] ? [responseObject valueForKeyPath:cursorKeyPath] : nil;
+    if (cursor == nil || [cursor isEqual:[NSNull null]] || [cursor isEqual:@""]) {
+        return nil;
+    }
+    
+    NSMutableDictionary *parameters = [NSMutableDictionary dictionary];
+    if ([request.parameters isKindOfClass:[NSDictionary class]]) {
+        [parameters addEntriesFromDictionary:request.parameters];
+    }
+    parameters[cursorParameter] = cursor;
+    
+    nextRequest.parameters = parameters;
+    return nextRequest;
+}
+
+- (NSURL *)nextLinkURLForResponse:(NSURLResponse *)response
+{
+    if (![response isKindOfClass:[NSHTTPURLResponse class]]) {
+        return nil;
+    }
+    
+    NSDictionary *headers = [(NSHTTPURLResponse *)response allHeaderFields];
+    NSString *linkHeader;
+    for (NSString *name in headers) {
+        if ([name caseInsensitiveCompare:@"Link"] == NSOrderedSame) {
+            linkHeader = headers[name];
+            break;
+        }
+    }
+    
+    // Link: <https://api.example.com/items?page=2>; rel="next", <https://api.example.com/items?page=9>; rel="last"
+    for (NSString *link in [linkHeader componentsSeparatedByString:@","]) {
+        NSRange start   = [link rangeOfString:@"<"];
+        NSRange end     = [link rangeOfString:@">"];
+        if (start.location == NSNotFound || end.location == NSNotFound || end.location < start.location) {
+            continue;
+        }
+        
+        for (NSString *parameter in [[link substringFromIndex:NSMaxRange(end)] componentsSeparatedByString:@";"]) {
+            NSArray<NSString *> *pair = [parameter componentsSeparatedByString:@"="];
+            if (pair.count != 2 || [[pair[0] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]] caseInsensitiveCompare:@"rel"] != NSOrderedSame) {
+                continue;
+            }
+            
+            NSString *relations = [pair[1] stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"\" \t"]];
+            for (NSString *relation in [relations componentsSeparatedByString:@" "]) {
+                if ([relation caseInsensitiveCompare:@"next"] == NSOrderedSame) {
+                    NSRange target = NSMakeRange(NSMaxRange(start), end.location - NSMaxRange(start));
+                    return [NSURL URLWithString:[link substringWithRange:target] relativeToURL:response.URL];
+                }
+            }
+        }
+    }
+    return nil;
+}
+
+
+#pragma mark - Pre-warm
+
+- (void)setPrewarmURLString:(NSString *)prewarmURLString
+{
+    _prewarmURLString = [prewarmURLString copy];
+    [self prewarmConnections];
+}
+
+- (void)prewarmConnections
+{
+    if (self.prewarmURLString == nil ||
+        self.reachabilityManager.networkReachabilityStatus == AFNetworkReachabilityStatusNotReachable) {
+        
+        return;
+    }
+    
+    @synchronized (self) {
+        NSDate *now = [NSDate date];
+        if (self.prewarmDate != nil && [now timeIntervalSinceDate:self.prewarmDate] < self.prewarmInterval) {
+            return;
+        }
+        self.prewarmDate = now;
+        
+        [self.prewarmTasks makeObjectsPerformSelector:@selector(cancel)];
+        
+        NSMutableArray<NSURLSessionDataTask *> *tasks = [NSMutableArray arrayWithCapacity:2];
+        [tasks addObject:[self prewarmTaskWithSessionManager:self.networkManager]];
+        
+        // the token host needs its own connection
+        NSURL *apiBaseURL   = self.networkManager.baseURL;
+        NSURL *oauthBaseURL = self.oauthManager.baseURL;
+        if (![apiBaseURL.scheme isEqualToString:oauthBaseURL.scheme] ||
+            ![apiBaseURL.host isEqualToString:oauthBaseURL.host] ||
+            !((apiBaseURL.port == nil && oauthBaseURL.port == nil) || [apiBaseURL.port isEqualToNumber:oauthBaseURL.port])) {
+            
+            [tasks addObject:[self prewarmTaskWithSessionManager:self.oauthManager]];
+        }
+        
+        self.prewarmTasks = tasks;
+        [tasks makeObjectsPerformSelector:@selector(resume)];
+    }
+}
+
+- (void)cancelPrewarming
+{
+    @synchronized (self) {
+        [self.prewarmTasks makeObjectsPerformSelector:@selector(cancel)];
+        self.prewarmTasks = nil;
+    }
+}
+
+- (NSURLSessionDataTask *)prewarmTaskWithSessionManager:(AFHTTPSessionManager *)sessionManager
+{
+    NSURL *URL = [NSURL URLWithString:self.prewarmURLString relativeToURL:sessionManager.baseURL];
+    
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:URL cachePolicy:NSURLRequestReloadIgnoringLocalCacheData timeoutInterval:10.0];
+    request.HTTPMethod = @"HEAD";
+    
+    // only the connection matters, not the response
+    return [sessionManager dataTaskWithRequest:request completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+        if (error.code != NSURLErrorCancelled) {
+            ACE_LOG_DEBUG(@"Pre-warmed the connection to %@", URL.host);
+        }
+    }];
+}
+
 
 #pragma mark - Other Signals
 
@@ -553,6 +1732,7 @@ NSTimeInterval const ACEDefaultRetryTimeInterval = 5.0;
              }] finally:^{
                  // remove the bearer
                  self.oauthManager.requestSerializer = [AFHTTPRequestSerializer serializer];
+                 [self configureRequestSerializerOfSessionManager:self.oauthManager];
                  
                  // clean the oauth credentials
                  self.oauthCredential = nil;
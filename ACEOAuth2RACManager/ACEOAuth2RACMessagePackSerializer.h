@@ -0,0 +1,51 @@
+// ACEOAuth2RACMessagePackSerializer.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "AFURLResponseSerialization.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Decode a MessagePack document into Foundation objects.
+
+ Maps become `NSDictionary`, arrays `NSArray`, strings `NSString`, binaries `NSData`, nil `NSNull`,
+ booleans and numbers `NSNumber`, and the timestamp extension `NSDate`. The other extensions are returned as `NSData`.
+
+ @param data The MessagePack document.
+ @param error The error if the document is not valid.
+
+ @return The decoded object, nil if the document is not valid.
+ */
+extern id _Nullable ACEOAuth2RACMessagePackObjectWithData(NSData *data, NSError * _Nullable __autoreleasing * _Nullable error);
+
+/**
+ `ACEOAuth2RACMessagePackResponseSerializer` decodes the MessagePack responses.
+
+ By default, it accepts the `application/msgpack` and `application/x-msgpack` MIME types.
+ */
+@interface ACEOAuth2RACMessagePackResponseSerializer : AFHTTPResponseSerializer
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,338 @@
+// ACEOAuth2RACMessagePackSerializer.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACMessagePackSerializer.h"
+#import "ACEOAuth2RACManager.h"
+
+// nesting deeper than this is rejected, instead of running out of stack
+static NSUInteger const ACEOAuth2RACMessagePackMaxDepth = 512;
+
+typedef struct {
+    const uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger position;
+} ACEOAuth2RACMessagePackReader;
+
+static id ACEOAuth2RACMessagePackReadObject(ACEOAuth2RACMessagePackReader *reader, NSUInteger depth);
+
+#pragma mark - Reader
+
+static inline BOOL ACEOAuth2RACMessagePackCanRead(ACEOAuth2RACMessagePackReader *reader, NSUInteger length)
+{
+    return reader->length - reader->position >= length;
+}
+
+static inline uint64_t ACEOAuth2RACMessagePackReadUInt(ACEOAuth2RACMessagePackReader *reader, NSUInteger size)
+{
+    // big endian
+    uint64_t value = 0;
+    for (NSUInteger i = 0; i < size; i++) {
+        value = (value << 8) | reader->bytes[reader->position + i];
+    }
+    reader->position += size;
+    return value;
+}
+
+static NSNumber *ACEOAuth2RACMessagePackReadInteger(ACEOAuth2RACMessagePackReader *reader, NSUInteger size, BOOL isSigned)
+{
+    if (!ACEOAuth2RACMessagePackCanRead(reader, size)) {
+        return nil;
+    }
+    
+    uint64_t value = ACEOAuth2RACMessagePackReadUInt(reader, size);
+    if (!isSigned) {
+        return @(value);
+    }
+    
+    switch (size) {
+        case 1:     return @((int8_t)value);
+        case 2:     return @((int16_t)value);
+        case 4:     return @((int32_t)value);
+        default:    return @((int64_t)value);
+    }
+}
+
+static NSNumber *ACEOAuth2RACMessagePackReadFloat(ACEOAuth2RACMessagePackReader *reader, NSUInteger size)
+{
+    if (!ACEOAuth2RACMessagePackCanRead(reader, size)) {
+        return nil;
+    }
+    
+    uint64_t value = ACEOAuth2RACMessagePackReadUInt(reader, size);
+    if (size == 4) {
+        uint32_t bits = (uint32_t)value;
+        float number;
+        memcpy(&number, &bits, sizeof(number));
+        return @(number);
+    }
+    
+    double number;
+    memcpy(&number, &value, sizeof(number));
+    return @(number);
+}
+
+static BOOL ACEOAuth2RACMessagePackReadLength(ACEOAuth2RACMessagePackReader *reader, NSUInteger size, NSUInteger *length)
+{
+    if (!ACEOAuth2RACMessagePackCanRead(reader, size)) {
+        return NO;
+    }
+    *length = (NSUInteger)ACEOAuth2RACMessagePackReadUInt(reader, size);
+    return YES;
+}
+
+static NSString *ACEOAuth2RACMessagePackReadString(ACEOAuth2RACMessagePackReader *reader, NSUInteger length)
+{
+    if (!ACEOAuth2RACMessagePackCanRead(reader, length)) {
+        return nil;
+    }
+    
+    NSString *string = [[NSString alloc] initWithBytes:reader->bytes + reader->position length:length encoding:NSUTF8StringEncoding];
+    reader->position += length;
+    return string;
+}
+
+static NSData *ACEOAuth2RACMessagePackReadData(ACEOAuth2RACMessagePackReader *reader, NSUInteger length)
+{
+    if (!ACEOAuth2RACMessagePackCanRead(reader, length)) {
+        return nil;
+    }
+    
+    NSData *data = [NSData dataWithBytes:reader->bytes + reader->position length:length];
+    reader->position += length;
+    return data;
+}
+
+static id ACEOAuth2RACMessagePackReadExtension(ACEOAuth2RACMessagePackReader *reader, NSUInteger length)
+{
+    if (!ACEOAuth2RACMessagePackCanRead(reader, length + 1)) {
+        return nil;
+    }
+    
+    int8_t type = (int8_t)reader->bytes[reader->position];
+    reader->position++;
+    
+    if (type != -1) {
+        return ACEOAuth2RACMessagePackReadData(reader, length);
+    }
+    
+    // the timestamp extension, in its 32, 64 and 96 bit forms
+    uint64_t seconds;
+    uint32_t nanoseconds = 0;
+    switch (length) {
+        case 4:
+            seconds = ACEOAuth2RACMessagePackReadUInt(reader, 4);
+            break;
+            
+        case 8: {
+            uint64_t value = ACEOAuth2RACMessagePackReadUInt(reader, 8);
+            nanoseconds = (uint32_t)(value >> 34);
+            seconds     = value & 0x00000003ffffffffULL;
+            break;
+        }
+            
+        case 12:
+            nanoseconds = (uint32_t)ACEOAuth2RACMessagePackReadUInt(reader, 4);
+            seconds     = ACEOAuth2RACMessagePackReadUInt(reader, 8);
+            return [NSDate dateWithTimeIntervalSince1970:(int64_t)seconds + nanoseconds / 1e9];
+            
+        default:
+            return nil;
+    }
+    return [NSDate dateWithTimeIntervalSince1970:seconds + nanoseconds / 1e9];
+}
+
+static NSArray *ACEOAuth2RACMessagePackReadArray(ACEOAuth2RACMessagePackReader *reader, NSUInteger count, NSUInteger depth)
+{
+    // every element takes at least a byte, don't trust the count for the capacity
+    if (!ACEOAuth2RACMessagePackCanRead(reader, count)) {
+        return nil;
+    }
+    
+    NSMutableArray *array = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        id object = ACEOAuth2RACMessagePackReadObject(reader, depth + 1);
+        if (object == nil) {
+            return nil;
+        }
+        [array addObject:object];
+    }
+    return array;
+}
+
+static NSDictionary *ACEOAuth2RACMessagePackReadMap(ACEOAuth2RACMessagePackReader *reader, NSUInteger count, NSUInteger depth)
+{
+    if (count > (reader->length - reader->position) / 2) {
+        return nil;
+    }
+    
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        id key = ACEOAuth2RACMessagePackReadObject(reader, depth + 1);
+        if (key == nil) {
+            return nil;
+        }
+        
+        id value = ACEOAuth2RACMessagePackReadObject(reader, depth + 1);
+        if (value == nil) {
+            return nil;
+        }
+        dictionary[key] = value;
+    }
+    return dictionary;
+}
+
+static id ACEOAuth2RACMessagePackReadObject(ACEOAuth2RACMessagePackReader *reader, NSUInteger depth)
+{
+    if (depth > ACEOAuth2RACMessagePackMaxDepth || !ACEOAuth2RACMessagePackCanRead(reader, 1)) {
+        return nil;
+    }
+    
+    uint8_t type = reader->bytes[reader->position++];
+    NSUInteger length;
+    
+    if (type <= 0x7f) {
+        return @(type);
+        
+    } else if (type >= 0xe0) {
+        return @((int8_t)type);
+        
+    } else if (type <= 0x8f) {
+        return ACEOAuth2RACMessagePackReadMap(reader, type & 0x0f, depth);
+        
+    } else if (type <= 0x9f) {
+        return ACEOAuth2RACMessagePackReadArray(reader, type & 0x0f, depth);
+        
+    } else if (type <= 0xbf) {
+        return ACEOAuth2RACMessagePackReadString(reader, type & 0x1f);
+    }
+    
+    switch (type) {
+        case 0xc0:  return [NSNull null];
+        case 0xc2:  return @NO;
+        case 0xc3:  return @YES;
+            
+        case 0xc4:  return ACEOAuth2RACMessagePackReadLength(reader, 1, &length) ? ACEOAuth2RACMessagePackReadData(reader, length) : nil;
+        case 0xc5:  return ACEOAuth2RACMessagePackReadLength(reader, 2, &length) ? ACEOAuth2RACMessagePackReadData(reader, length) : nil;
+        case 0xc6:  return ACEOAuth2RACMessagePackReadLength(reader, 4, &length) ? ACEOAuth2RACMessagePackReadData(reader, length) : nil;
+            
+        case 0xc7:  return ACEOAuth2RACMessagePackReadLength(reader, 1, &length) ? ACEOAuth2RACMessagePackReadExtension(reader, length) : nil;
+        case 0xc8:  return ACEOAuth2RACMessagePackReadLength(reader, 2, &length) ? ACEOAuth2RACMessagePackReadExtension(reader, length) : nil;
+        case 0xc9:  return ACEOAuth2RACMessagePackReadLength(reader, 4, &length) ? ACEOAuth2RACMessagePackReadExtension(reader, length) : nil;
+            
+        case 0xca:  return ACEOAuth2RACMessagePackReadFloat(reader, 4);
+        case 0xcb:  return ACEOAuth2RACMessagePackReadFloat(reader, 8);
+            
+        case 0xcc:  return ACEOAuth2RACMessagePackReadInteger(reader, 1, NO);
+        case 0xcd:  return ACEOAuth2RACMessagePackReadInteger(reader, 2, NO);
+        case 0xce:  return ACEOAuth2RACMessagePackReadInteger(reader, 4, NO);
+        case 0xcf:  return ACEOAuth2RACMessagePackReadInteger(reader, 8, NO);
+        case 0xd0:  return ACEOAuth2RACMessagePackReadInteger(reader, 1, YES);
+        case 0xd1:  return ACEOAuth2RACMessagePackReadInteger(reader, 2, YES);
+        case 0xd2:  return ACEOAuth2RACMessagePackReadInteger(reader, 4, YES);
+        case 0xd3:  return ACEOAuth2RACMessagePackReadInteger(reader, 8, YES);
+            
+        case 0xd4:  return ACEOAuth2RACMessagePackReadExtension(reader, 1);
+        case 0xd5:  return ACEOAuth2RACMessagePackReadExtension(reader, 2);
+        case 0xd6:  return ACEOAuth2RACMessagePackReadExtension(reader, 4);
+        case 0xd7:  return ACEOAuth2RACMessagePackReadExtension(reader, 8);
+        case 0xd8:  return ACEOAuth2RACMessagePackReadExtension(reader, 16);
+            
+        case 0xd9:  return ACEOAuth2RACMessagePackReadLength(reader, 1, &length) ? ACEOAuth2RACMessagePackReadString(reader, length) : nil;
+        case 0xda:  return ACEOAuth2RACMessagePackReadLength(reader, 2, &length) ? ACEOAuth2RACMessagePackReadString(reader, length) : nil;
+        case 0xdb:  return ACEOAuth2RACMessagePackReadLength(reader, 4, &length) ? ACEOAuth2RACMessagePackReadString(reader, length) : nil;
+            
+        case 0xdc:  return ACEOAuth2RACMessagePackReadLength(reader, 2, &length) ? ACEOAuth2RACMessagePackReadArray(reader, length, depth) : nil;
+        case 0xdd:  return ACEOAuth2RACMessagePackReadLength(reader, 4, &length) ? ACEOAuth2RACMessagePackReadArray(reader, length, depth) : nil;
+        case 0xde:  return ACEOAuth2RACMessagePackReadLength(reader, 2, &length) ? ACEOAuth2RACMessagePackReadMap(reader, length, depth) : nil;
+        case 0xdf:  return ACEOAuth2RACMessagePackReadLength(reader, 4, &length) ? ACEOAuth2RACMessagePackReadMap(reader, length, depth) : nil;
+            
+        default:
+            // 0xc1 is never used
+            return nil;
+    }
+}
+
+id ACEOAuth2RACMessagePackObjectWithData(NSData *data, NSError *__autoreleasing *error)
+{
+    ACEOAuth2RACMessagePackReader reader = { data.bytes, data.length, 0 };
+    id object = ACEOAuth2RACMessagePackReadObject(&reader, 0);
+    
+    if (object == nil || reader.position != reader.length) {
+        if (error != NULL) {
+            *error = [NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                                         code:ACEOAuth2RACErrorInvalidMessagePack
+                                     userInfo:@{
+                                                NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Invalid MessagePack data around byte %lu", (unsigned long)reader.position]
+                                                }];
+        }
+        return nil;
+    }
+    return object;
+}
+
+
+#pragma mark -
+
+@implementation ACEOAuth2RACMessagePackResponseSerializer
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self.acceptableContentTypes = [NSSet setWithObjects:@"application/msgpack", @"application/x-msgpack", nil];
+    }
+    return self;
+}
+
+
+#pragma mark - AFURLResponseSerialization
+
+- (id)responseObjectForResponse:(NSURLResponse *)response data:(NSData *)data error:(NSError *__autoreleasing *)error
+{
+    // like the JSON serializer, the body of an error response is still decoded
+    NSError *validationError;
+    if (![self validateResponse:(NSHTTPURLResponse *)response data:data error:&validationError]) {
+        if (error != NULL) {
+            *error = validationError;
+        }
+        
+        if ([validationError.domain isEqualToString:AFURLResponseSerializationErrorDomain] && validationError.code == NSURLErrorCannotDecodeContentData) {
+            return nil;
+        }
+    }
+    
+    if (data.length == 0) {
+        return nil;
+    }
+    
+    NSError *decodingError;
+    id responseObject = ACEOAuth2RACMessagePackObjectWithData(data, &decodingError);
+    
+    if (validationError == nil && error != NULL) {
+        *error = decodingError;
+    }
+    return responseObject;
+}
+
+@end
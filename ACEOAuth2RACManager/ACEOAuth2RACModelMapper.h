@@ -0,0 +1,52 @@
+// ACEOAuth2RACModelMapper.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import <Foundation/Foundation.h>
+
+#import "ACEOAuth2RACProtocols.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `ACEOAuth2RACModelMapper` fills model objects from the decoded responses.
+
+ The properties of each model class are read with the Objective-C runtime only the first time
+ the class is mapped, then kept in a cache shared by every thread.
+ */
+@interface ACEOAuth2RACModelMapper : NSObject
+
+/**
+ Map a response object to models.
+
+ @param modelClass The class of the models.
+ @param responseObject A dictionary, mapped to a single model, or an array of dictionaries, mapped to an array of models.
+ @param error The error if the response object can't be mapped.
+
+ @return The model or the array of models, nil if the response object can't be mapped.
+ */
++ (nullable id)modelOfClass:(Class)modelClass fromResponseObject:(nullable id)responseObject error:(NSError * _Nullable __autoreleasing *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
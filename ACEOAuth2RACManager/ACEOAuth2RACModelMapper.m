@@ -0,0 +1,273 @@
+// ACEOAuth2RACModelMapper.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACModelMapper.h"
+#import "ACEOAuth2RACManager.h"
+
+#import <objc/runtime.h>
+
+@interface ACEOAuth2RACModelProperty : NSObject
+@property (nonatomic, strong) NSString *name;
+@property (nonatomic, strong) NSArray<NSString *> *keyPath;
+@property (nonatomic, assign) BOOL scalar;
+
+// nil for `id` and for the scalars
+@property (nonatomic, strong) Class valueClass;
+
+// the class of the nested model, or of the elements of the array
+@property (nonatomic, strong) Class modelClass;
+@end
+
+@implementation ACEOAuth2RACModelProperty
+@end
+
+#pragma mark -
+
+@implementation ACEOAuth2RACModelMapper
+
++ (id)modelOfClass:(Class)modelClass fromResponseObject:(id)responseObject error:(NSError *__autoreleasing *)error
+{
+    if ([responseObject isKindOfClass:[NSDictionary class]]) {
+        return [self modelOfClass:modelClass fromDictionary:responseObject error:error];
+        
+    } else if ([responseObject isKindOfClass:[NSArray class]]) {
+        return [self modelsOfClass:modelClass fromArray:responseObject error:error];
+        
+    } else {
+        return [self failWithReason:[NSString stringWithFormat:@"Can't map %@ to %@", [responseObject class], modelClass] error:error];
+    }
+}
+
++ (NSArray *)modelsOfClass:(Class)modelClass fromArray:(NSArray *)array error:(NSError *__autoreleasing *)error
+{
+    NSMutableArray *models = [NSMutableArray arrayWithCapacity:array.count];
+    for (id element in array) {
+        if (![element isKindOfClass:[NSDictionary class]]) {
+            return [self failWithReason:[NSString stringWithFormat:@"Can't map %@ to %@", [element class], modelClass] error:error];
+        }
+        
+        id model = [self modelOfClass:modelClass fromDictionary:element error:error];
+        if (model == nil) {
+            return nil;
+        }
+        [models addObject:model];
+    }
+    return models;
+}
+
++ (id)modelOfClass:(Class)modelClass fromDictionary:(NSDictionary *)dictionary error:(NSError *__autoreleasing *)error
+{
+    id model = [modelClass new];
+    
+    for (ACEOAuth2RACModelProperty *property in [self propertiesOfClass:modelClass]) {
+        id value = dictionary;
+        for (NSString *key in property.keyPath) {
+            value = [value isKindOfClass:[NSDictionary class]] ? value[key] : nil;
+        }
+        
+        if (value == nil) {
+            continue;
+            
+        } else if (value == [NSNull null]) {
+            // the scalars keep their default value
+            if (!property.scalar) {
+                [model setValue:nil forKey:property.name];
+            }
+            continue;
+        }
+        
+        if (property.modelClass != nil && ([value isKindOfClass:[NSDictionary class]] || [value isKindOfClass:[NSArray class]])) {
+            value = [self modelOfClass:property.modelClass fromResponseObject:value error:error];
+            if (value == nil) {
+                return nil;
+            }
+            
+        } else {
+            value = [self value:value forProperty:property];
+        }
+        
+        if (value != nil) {
+            [model setValue:value forKey:property.name];
+        }
+    }
+    return model;
+}
+
++ (id)value:(id)value forProperty:(ACEOAuth2RACModelProperty *)property
+{
+    Class valueClass = property.scalar ? [NSNumber class] : property.valueClass;
+    
+    if (valueClass == nil || [value isKindOfClass:valueClass]) {
+        return value;
+    }
+    
+    // the conversions between the types found in the responses, anything else is ignored
+    if (valueClass == [NSString class] && [value isKindOfClass:[NSNumber class]]) {
+        return [value stringValue];
+        
+    } else if (valueClass == [NSNumber class] && [value isKindOfClass:[NSString class]]) {
+        NSDecimalNumber *number = [NSDecimalNumber decimalNumberWithString:value locale:@{ NSLocaleDecimalSeparator: @"." }];
+        return [number isEqual:[NSDecimalNumber notANumber]] ? nil : number;
+        
+    } else if (valueClass == [NSURL class] && [value isKindOfClass:[NSString class]]) {
+        return [NSURL URLWithString:value];
+        
+    } else if (valueClass == [NSDate class] && [value isKindOfClass:[NSNumber class]]) {
+        return [NSDate dateWithTimeIntervalSince1970:[value doubleValue]];
+        
+    } else {
+        return nil;
+    }
+}
+
++ (id)failWithReason:(NSString *)reason error:(NSError *__autoreleasing *)error
+{
+    if (error != NULL) {
+        *error = [NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                                     code:ACEOAuth2RACErrorModelMapping
+                                 userInfo:@{ NSLocalizedDescriptionKey: reason }];
+    }
+    return nil;
+}
+
+
+#pragma mark - Metadata
+
++ (NSArray<ACEOAuth2RACModelProperty *> *)propertiesOfClass:(Class)modelClass
+{
+    static NSMutableDictionary *cache;
+    static dispatch_semaphore_t lock;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        cache   = [NSMutableDictionary dictionary];
+        lock    = dispatch_semaphore_create(1);
+    });
+    
+    dispatch_semaphore_wait(lock, DISPATCH_TIME_FOREVER);
+    NSArray<ACEOAuth2RACModelProperty *> *properties = cache[(id<NSCopying>)modelClass];
+    dispatch_semaphore_signal(lock);
+    
+    if (properties == nil) {
+        // two threads can read the same class at the same time, the result is the same
+        properties = [self readPropertiesOfClass:modelClass];
+        
+        dispatch_semaphore_wait(lock, DISPATCH_TIME_FOREVER);
+        cache[(id<NSCopying>)modelClass] = properties;
+        dispatch_semaphore_signal(lock);
+    }
+    return properties;
+}
+
++ (NSArray<ACEOAuth2RACModelProperty *> *)readPropertiesOfClass:(Class)modelClass
+{
+    NSDictionary<NSString *, NSString *> *keyPaths = nil;
+    if ([modelClass respondsToSelector:@selector(responseKeyPathsByPropertyKey)]) {
+        keyPaths = [modelClass responseKeyPathsByPropertyKey];
+    }
+    
+    NSDictionary<NSString *, Class> *modelClasses = nil;
+    if ([modelClass respondsToSelector:@selector(modelClassesByPropertyKey)]) {
+        modelClasses = [modelClass modelClassesByPropertyKey];
+    }
+    
+    NSMutableArray<ACEOAuth2RACModelProperty *> *properties = [NSMutableArray array];
+    NSMutableSet<NSString *> *names = [NSMutableSet set];
+    
+    for (Class currentClass = modelClass; currentClass != Nil && currentClass != [NSObject class]; currentClass = class_getSuperclass(currentClass)) {
+        unsigned int count = 0;
+        objc_property_t *propertyList = class_copyPropertyList(currentClass, &count);
+        
+        for (unsigned int i = 0; i < count; i++) {
+            NSString *name = @(property_getName(propertyList[i]));
+            if ([names containsObject:name]) {
+                // redeclared by a subclass
+                continue;
+            }
+            
+            ACEOAuth2RACModelProperty *property = [self propertyNamed:name attributes:propertyList[i]];
+            if (property == nil) {
+                continue;
+            }
+            
+            property.keyPath    = [keyPaths[name] ?: name componentsSeparatedByString:@"."];
+            property.modelClass = modelClasses[name];
+            
+            if (property.modelClass == nil && [property.valueClass conformsToProtocol:@protocol(ACEOAuth2RACModel)]) {
+                property.modelClass = property.valueClass;
+            }
+            
+            [names addObject:name];
+            [properties addObject:property];
+        }
+        free(propertyList);
+    }
+    return properties;
+}
+
++ (ACEOAuth2RACModelProperty *)propertyNamed:(NSString *)name attributes:(objc_property_t)attributes
+{
+    char *readonly  = property_copyAttributeValue(attributes, "R");
+    char *ivar      = property_copyAttributeValue(attributes, "V");
+    char *type      = property_copyAttributeValue(attributes, "T");
+    
+    ACEOAuth2RACModelProperty *property = nil;
+    
+    // computed read only properties can't be set
+    if (type != NULL && (readonly == NULL || ivar != NULL)) {
+        property = [ACEOAuth2RACModelProperty new];
+        property.name = name;
+        
+        switch (type[0]) {
+            case '@': {
+                // @"ClassName", @"<Protocol>" or a bare @ for `id`, but not the blocks
+                size_t length = strlen(type);
+                if (length > 3 && type[1] == '"' && type[2] != '<') {
+                    NSString *className = [[NSString alloc] initWithBytes:type + 2 length:strcspn(type + 2, "\"<") encoding:NSUTF8StringEncoding];
+                    property.valueClass = NSClassFromString(className);
+                    
+                } else if (length > 1 && type[1] == '?') {
+                    property = nil;
+                }
+                break;
+            }
+                
+            case 'c': case 'C': case 's': case 'S': case 'i': case 'I':
+            case 'l': case 'L': case 'q': case 'Q': case 'f': case 'd': case 'B':
+                property.scalar = YES;
+                break;
+                
+            default:
+                // structs, pointers and the other types the responses can't contain
+                property = nil;
+                break;
+        }
+    }
+    
+    free(readonly);
+    free(ivar);
+    free(type);
+    return property;
+}
+
+@end
@@ -0,0 +1,47 @@
+// ACEOAuth2RACOAuthManager.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "AFOAuth2Manager.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `ACEOAuth2RACOAuthManager` runs the token calls over the session of another manager, so they share
+ its connections to the server instead of opening their own.
+ 
+ The requests are still built by the request serializer of this manager, and the responses decoded by its response serializer,
+ registered by URL in the `ACEOAuth2RACResponseSerializer` of the shared manager. The session level settings, like the security policy,
+ are the ones of the shared manager.
+ */
+@interface ACEOAuth2RACOAuthManager : AFOAuth2Manager
+
+/**
+ The manager running the tasks. Default is nil, which uses the session of this manager.
+ While its response serializer isn't an `ACEOAuth2RACResponseSerializer`, the tasks run on the session of this manager.
+ */
+@property (nonatomic, strong, nullable) AFHTTPSessionManager *sharedSessionManager;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,61 @@
+// ACEOAuth2RACOAuthManager.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACOAuthManager.h"
+#import "ACEOAuth2RACResponseSerializer.h"
+
+@implementation ACEOAuth2RACOAuthManager
+
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
+                               uploadProgress:(void (^)(NSProgress *uploadProgress))uploadProgressBlock
+                             downloadProgress:(void (^)(NSProgress *downloadProgress))downloadProgressBlock
+                            completionHandler:(void (^)(NSURLResponse *response, id responseObject, NSError *error))completionHandler
+{
+    // the shared session decodes the response with the serializer of this manager, registered by URL,
+    // so a shared manager whose serializer was replaced runs the task on the session of this manager
+    AFHTTPSessionManager *sessionManager = self.sharedSessionManager;
+    ACEOAuth2RACResponseSerializer *responseSerializer = (ACEOAuth2RACResponseSerializer *)sessionManager.responseSerializer;
+    if (sessionManager == nil || ![responseSerializer isKindOfClass:[ACEOAuth2RACResponseSerializer class]]) {
+        return [super dataTaskWithRequest:request uploadProgress:uploadProgressBlock downloadProgress:downloadProgressBlock completionHandler:completionHandler];
+    }
+    
+    if ([responseSerializer serializerForURL:request.URL] != self.responseSerializer) {
+        [responseSerializer setSerializer:self.responseSerializer forURL:request.URL];
+    }
+    
+    // keep the completion queue of this manager
+    dispatch_queue_t completionQueue = self.completionQueue ?: dispatch_get_main_queue();
+    void (^handler)(NSURLResponse *, id, NSError *) = completionHandler;
+    if (completionHandler != nil && completionQueue != (sessionManager.completionQueue ?: dispatch_get_main_queue())) {
+        handler = ^(NSURLResponse *response, id responseObject, NSError *error) {
+            dispatch_async(completionQueue, ^{
+                completionHandler(response, responseObject, error);
+            });
+        };
+    }
+    
+    return [sessionManager dataTaskWithRequest:request uploadProgress:uploadProgressBlock downloadProgress:downloadProgressBlock completionHandler:handler];
+}
+
+@end
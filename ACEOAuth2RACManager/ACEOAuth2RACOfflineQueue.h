@@ -0,0 +1,115 @@
+// ACEOAuth2RACOfflineQueue.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ReactiveObjC.h"
+
+#import "ACEOAuth2RACRequest.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Block in charge of sending a request of the queue.
+ The returned signal must complete when the server accepted the request, or fail.
+ */
+typedef RACSignal * _Nonnull (^ACEOAuth2RACOfflineQueueSendBlock)(ACEOAuth2RACRequest *request);
+
+/**
+ `ACEOAuth2RACOfflineQueue` keeps the requests changing the data on the server, like `POST`, `PUT`, `PATCH` and `DELETE`,
+ and sends them in order when the network is available.
+
+ The requests are appended to a journal file, each record with its checksum, and written to disk before they are accepted.
+ The end of a journal torn by a crash is discarded when it's loaded. A request running when the process is killed is sent
+ again by the next replay, with the same `Idempotency-Key` header, so the server can recognize it.
+
+ A `PUT` replaces the pending `PUT` and `PATCH` requests of the same path, and a `PATCH` with a dictionary of parameters
+ is merged with the pending `PATCH` requests of the same path, up to the previous request with another method.
+ The merged request takes the place of the last one.
+ */
+@interface ACEOAuth2RACOfflineQueue : NSObject
+
+/**
+ The journal file. Default is a file named after the identifier of the queue, in `ACEOAuth2RACOffline`
+ in the application support directory. It must be set before the first request.
+ */
+@property (nonatomic, strong) NSURL *journalURL;
+
+/**
+ The maximum number of requests sent at the same time during a replay. Default is 4, 0 means no limit.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrentRequests;
+
+/**
+ The maximum number of requests to the same path sent at the same time. Default is 1, which keeps their order.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrentRequestsPerResource;
+
+/**
+ The time to wait before replaying again after a temporary error, doubled after each one up to 5 minutes,
+ or the `Retry-After` of the server when it's longer. Default is 2 seconds, 0 waits for the next call to `-replay`.
+ */
+@property (nonatomic, assign) NSTimeInterval retryInterval;
+
+/**
+ The number of requests in the journal, updated on a private queue.
+ */
+@property (atomic, assign, readonly) NSUInteger pendingRequestCount;
+
+/**
+ The signal sending a `RACTuple` with the request and the error, for each request rejected by the server.
+ The rejected requests are removed from the journal, a failed authentication included. Only the requests failing
+ because of the network or a temporary error of the server stay in the journal, and pause the replay for `retryInterval`.
+ */
+@property (nonatomic, strong, readonly) RACSignal *rac_failedRequests;
+
+/**
+ Create a queue with its own journal.
+
+ @param identifier The identifier of the queue, like the base URL of the requests. The queues sending to different servers
+ must have different identifiers, so a queue never replays the requests of another one.
+ @param sendBlock The block sending the requests.
+
+ @return The queue, its journal is loaded on the first use.
+ */
+- (instancetype)initWithIdentifier:(NSString *)identifier sendBlock:(ACEOAuth2RACOfflineQueueSendBlock)sendBlock;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Return a signal adding a request to the journal. The method, the path, the parameters, the headers and the body are kept,
+ the parameters must be valid JSON objects.
+
+ @param request The request to add.
+
+ @return The signal completing when the request is written to disk.
+ */
+- (RACSignal *)rac_enqueueRequest:(ACEOAuth2RACRequest *)request;
+
+/**
+ Send the requests of the journal, in order, until the journal is empty or a request fails because of the network
+ or a temporary error of the server. The requests added during the replay are sent as well.
+ */
+- (void)replay;
+
+@end
+
+NS_ASSUME_NONNULL_END
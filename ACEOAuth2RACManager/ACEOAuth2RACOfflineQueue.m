@@ -0,0 +1,610 @@
+// ACEOAuth2RACOfflineQueue.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACOfflineQueue.h"
+#import "ACEOAuth2RACManager.h"
+#import "ACEOAuth2RACManagerPrivate.h"
+
+#import "AFURLResponseSerialization.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+#import <zlib.h>
+
+// each record of the journal is a JSON object, preceded by its length and checksum in little endian
+typedef struct {
+    uint32_t length;
+    uint32_t checksum;
+} ACEOAuth2RACOfflineRecordHeader;
+
+// the journal is rewritten when most of its records are obsolete
+static const NSUInteger ACEOAuth2RACOfflineCompactionThreshold = 64;
+
+// the longest wait between two replays after a temporary error
+static const NSTimeInterval ACEOAuth2RACOfflineMaxRetryInterval = 300.0;
+
+static BOOL ACEOAuth2RACOfflineIsTransientError(NSError *error)
+{
+    if ([error.domain isEqualToString:NSURLErrorDomain]) {
+        switch (error.code) {
+            case NSURLErrorTimedOut:
+            case NSURLErrorCannotFindHost:
+            case NSURLErrorCannotConnectToHost:
+            case NSURLErrorNetworkConnectionLost:
+            case NSURLErrorDNSLookupFailed:
+            case NSURLErrorNotConnectedToInternet:
+            case NSURLErrorInternationalRoamingOff:
+            case NSURLErrorCallIsActive:
+            case NSURLErrorDataNotAllowed:
+            case NSURLErrorSecureConnectionFailed:
+                return YES;
+        }
+    }
+    
+    if ([error.domain isEqualToString:ACEOAuth2RACErrorDomain] && error.code == ACEOAuth2RACErrorDeadlineExceeded) {
+        return YES;
+    }
+    
+    // a temporary error of the server, the rejections and the authentication failures are reported instead
+    NSHTTPURLResponse *response = error.userInfo[AFNetworkingOperationFailingURLResponseErrorKey];
+    if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
+        NSInteger statusCode = response.statusCode;
+        return statusCode == 408 || statusCode == 429 || statusCode >= 500;
+    }
+    
+    // any other error would stall the journal forever
+    return NO;
+}
+
+static NSTimeInterval ACEOAuth2RACOfflineRetryAfterInterval(NSError *error)
+{
+    // only the number of seconds, the HTTP date format is rare on the APIs
+    NSHTTPURLResponse *response = error.userInfo[AFNetworkingOperationFailingURLResponseErrorKey];
+    if (![response isKindOfClass:[NSHTTPURLResponse class]]) {
+        return 0.0;
+    }
+    return MAX([response.allHeaderFields[@"Retry-After"] doubleValue], 0.0);
+}
+
+static BOOL ACEOAuth2RACOfflineWrite(int fd, const uint8_t *bytes, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NO;
+        }
+        bytes += written;
+        length -= written;
+    }
+    return YES;
+}
+
+static NSError *ACEOAuth2RACOfflinePOSIXError(NSURL *URL)
+{
+    return [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{ NSURLErrorKey: URL }];
+}
+
+#pragma mark -
+
+@interface ACEOAuth2RACOfflineEntry : NSObject
+@property (nonatomic, assign) uint64_t number;
+@property (nonatomic, strong) NSDictionary *record;
+@property (nonatomic, strong) ACEOAuth2RACRequest *request;
+@property (nonatomic, assign, getter=isRunning) BOOL running;
+@property (nonatomic, readonly) NSString *resource;
+@property (nonatomic, readonly) NSString *method;
+@end
+
+@implementation ACEOAuth2RACOfflineEntry
+
+- (NSString *)resource
+{
+    return self.record[@"path"];
+}
+
+- (NSString *)method
+{
+    return self.record[@"method"];
+}
+
+@end
+
+#pragma mark -
+
+@interface ACEOAuth2RACOfflineQueue ()
+@property (nonatomic, copy) ACEOAuth2RACOfflineQueueSendBlock sendBlock;
+@property (nonatomic, strong) RACSubject *failedRequests;
+@property (atomic, assign, readwrite) NSUInteger pendingRequestCount;
+
+// the state of the journal is accessed only on the queue
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, strong) NSMutableArray<ACEOAuth2RACOfflineEntry *> *entries;
+@property (nonatomic, assign) uint64_t nextNumber;
+@property (nonatomic, assign) NSUInteger recordCount;
+@property (nonatomic, assign, getter=isLoaded) BOOL loaded;
+@property (nonatomic, assign, getter=isReplaying) BOOL replaying;
+@property (nonatomic, assign) NSUInteger failureCount;
+@property (nonatomic, strong) RACDisposable *scheduledReplay;
+@end
+
+@implementation ACEOAuth2RACOfflineQueue
+
+- (instancetype)initWithIdentifier:(NSString *)identifier sendBlock:(ACEOAuth2RACOfflineQueueSendBlock)sendBlock
+{
+    self = [super init];
+    if (self) {
+        self.sendBlock              = sendBlock;
+        self.failedRequests         = [RACSubject subject];
+        self.queue                  = dispatch_queue_create("com.onemob.network.offline", DISPATCH_QUEUE_SERIAL);
+        self.entries                = [NSMutableArray array];
+        self.nextNumber             = 1;
+        
+        self.maxConcurrentRequests              = 4;
+        self.maxConcurrentRequestsPerResource   = 1;
+        self.retryInterval                      = 2.0;
+        
+        NSURL *supportURL = [[[NSFileManager defaultManager] URLsForDirectory:NSApplicationSupportDirectory inDomains:NSUserDomainMask] firstObject];
+        NSString *fileName = [identifier stringByAddingPercentEncodingWithAllowedCharacters:[NSCharacterSet alphanumericCharacterSet]];
+        self.journalURL             = [[supportURL URLByAppendingPathComponent:@"ACEOAuth2RACOffline" isDirectory:YES] URLByAppendingPathComponent:[fileName stringByAppendingPathExtension:@"journal"]];
+    }
+    return self;
+}
+
+- (RACSignal *)rac_failedRequests
+{
+    return self.failedRequests;
+}
+
+
+#pragma mark - Signals
+
+- (RACSignal *)rac_enqueueRequest:(ACEOAuth2RACRequest *)request
+{
+    // the request can change after the call
+    ACEOAuth2RACRequest *queuedRequest = [request copy];
+    
+    @weakify(self)
+    return [[RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+        
+        @strongify(self)
+        dispatch_async(self.queue, ^{
+            [self loadJournal];
+            
+            NSError *error;
+            if ([self addRequest:queuedRequest error:&error]) {
+                [subscriber sendCompleted];
+                [self sendPendingRequests];
+                
+            } else {
+                [subscriber sendError:error];
+            }
+        });
+        return nil;
+        
+    }] setNameWithFormat:@"[%@] -rac_enqueueRequest: %@", self.class, request];
+}
+
+- (void)replay
+{
+    dispatch_async(self.queue, ^{
+        [self loadJournal];
+        
+        [self.scheduledReplay dispose];
+        self.scheduledReplay = nil;
+        
+        self.replaying = YES;
+        [self sendPendingRequests];
+    });
+}
+
+
+#pragma mark - Requests
+
+- (BOOL)addRequest:(ACEOAuth2RACRequest *)request error:(NSError *__autoreleasing *)error
+{
+    NSString *path = request.route ? [request.route pathWithValues:request.routeValues] : request.path;
+    if (path == nil) {
+        if (error != NULL) {
+            *error = [NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                                         code:ACEOAuth2RACErrorMissingRouteValue
+                                     userInfo:@{
+                                                NSLocalizedDescriptionKey: [NSString stringWithFormat:@"The values of the route %@ are missing", request.route.identifier]
+                                                }];
+        }
+        return NO;
+    }
+    
+    NSMutableDictionary *record = [NSMutableDictionary dictionary];
+    record[@"op"]           = @"add";
+    record[@"id"]           = @(self.nextNumber);
+    record[@"key"]          = [[NSUUID UUID] UUIDString];
+    record[@"method"]       = [request.HTTPMethod uppercaseString];
+    record[@"path"]         = path;
+    record[@"parameters"]   = request.parameters;
+    record[@"headers"]      = request.HTTPHeaders.count > 0 ? request.HTTPHeaders : nil;
+    record[@"body"]         = [request.HTTPBody base64EncodedStringWithOptions:0];
+    
+    NSArray<ACEOAuth2RACOfflineEntry *> *superseded = [self entriesSupersededByRecord:record];
+    
+    if (![NSJSONSerialization isValidJSONObject:record]) {
+        if (error != NULL) {
+            *error = [NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                                         code:ACEOAuth2RACErrorInvalidOfflineRequest
+                                     userInfo:@{
+                                                NSLocalizedDescriptionKey: [NSString stringWithFormat:@"The parameters of the request %@ %@ are not valid JSON objects",
+                                                                            request.HTTPMethod, path]
+                                                }];
+        }
+        return NO;
+    }
+    
+    // the new request is written first, a crash in between sends both
+    NSMutableArray<NSDictionary *> *records = [NSMutableArray arrayWithObject:record];
+    for (ACEOAuth2RACOfflineEntry *entry in superseded) {
+        [records addObject:@{ @"op": @"done", @"id": @(entry.number) }];
+    }
+    
+    if (![self appendRecords:records error:error]) {
+        return NO;
+    }
+    
+    for (ACEOAuth2RACOfflineEntry *entry in superseded) {
+        ACE_LOG_DEBUG(@"Offline request %@ %@ superseded by %@", entry.method, entry.resource, record[@"method"]);
+        [self.entries removeObjectIdenticalTo:entry];
+    }
+    [self addEntryWithRecord:record];
+    
+    self.pendingRequestCount = self.entries.count;
+    return YES;
+}
+
+- (NSArray<ACEOAuth2RACOfflineEntry *> *)entriesSupersededByRecord:(NSMutableDictionary *)record
+{
+    NSString *method = record[@"method"];
+    BOOL isPut      = [method isEqualToString:@"PUT"];
+    BOOL isPatch    = [method isEqualToString:@"PATCH"];
+    if (!isPut && !isPatch) {
+        return @[];
+    }
+    
+    NSMutableArray<ACEOAuth2RACOfflineEntry *> *superseded = [NSMutableArray array];
+    for (ACEOAuth2RACOfflineEntry *entry in self.entries.reverseObjectEnumerator) {
+        if (![entry.resource isEqualToString:record[@"path"]]) {
+            continue;
+        }
+        
+        // already on its way to the server
+        if (entry.isRunning) {
+            break;
+        }
+        
+        if (isPut && ([entry.method isEqualToString:@"PUT"] || [entry.method isEqualToString:@"PATCH"])) {
+            [superseded addObject:entry];
+            
+        } else if (isPatch && [entry.method isEqualToString:@"PATCH"] &&
+                   [entry.record[@"parameters"] isKindOfClass:[NSDictionary class]] &&
+                   [record[@"parameters"] isKindOfClass:[NSDictionary class]] &&
+                   entry.record[@"body"] == nil && record[@"body"] == nil &&
+                   [(entry.record[@"headers"] ?: @{}) isEqual:(record[@"headers"] ?: @{})]) {
+            
+            // the later values win
+            NSMutableDictionary *parameters = [entry.record[@"parameters"] mutableCopy];
+            [parameters addEntriesFromDictionary:record[@"parameters"]];
+            record[@"parameters"] = parameters;
+            [superseded addObject:entry];
+            
+        } else {
+            break;
+        }
+    }
+    return superseded;
+}
+
+- (void)addEntryWithRecord:(NSDictionary *)record
+{
+    ACEOAuth2RACRequest *request = [ACEOAuth2RACRequest requestWithMethod:record[@"method"]
+                                                                     path:record[@"path"]
+                                                               parameters:record[@"parameters"]];
+    
+    NSMutableDictionary *headers = [record[@"headers"] mutableCopy] ?: [NSMutableDictionary dictionary];
+    headers[@"Idempotency-Key"] = record[@"key"];
+    request.HTTPHeaders = headers;
+    request.priority    = ACEOAuth2RACRequestPriorityBackground;
+    
+    if (record[@"body"] != nil) {
+        request.HTTPBody = [[NSData alloc] initWithBase64EncodedString:record[@"body"] options:0];
+    }
+    
+    ACEOAuth2RACOfflineEntry *entry = [ACEOAuth2RACOfflineEntry new];
+    entry.number    = [record[@"id"] unsignedLongLongValue];
+    entry.record    = [record copy];
+    entry.request   = request;
+    
+    [self.entries addObject:entry];
+    self.nextNumber = MAX(self.nextNumber, entry.number + 1);
+}
+
+
+#pragma mark - Replay
+
+- (void)sendPendingRequests
+{
+    if (!self.isReplaying) {
+        return;
+    }
+    
+    NSUInteger running = 0;
+    NSCountedSet<NSString *> *runningResources = [NSCountedSet set];
+    for (ACEOAuth2RACOfflineEntry *entry in self.entries) {
+        if (entry.isRunning) {
+            running++;
+            [runningResources addObject:entry.resource];
+        }
+    }
+    
+    // a resource waiting for a slot keeps the order of its requests
+    NSMutableSet<NSString *> *waitingResources = [NSMutableSet set];
+    
+    for (ACEOAuth2RACOfflineEntry *entry in [self.entries copy]) {
+        if (self.maxConcurrentRequests > 0 && running >= self.maxConcurrentRequests) {
+            break;
+        }
+        if (entry.isRunning || [waitingResources containsObject:entry.resource]) {
+            continue;
+        }
+        if (self.maxConcurrentRequestsPerResource > 0 && [runningResources countForObject:entry.resource] >= self.maxConcurrentRequestsPerResource) {
+            [waitingResources addObject:entry.resource];
+            continue;
+        }
+        
+        entry.running = YES;
+        running++;
+        [runningResources addObject:entry.resource];
+        [self sendEntry:entry];
+    }
+}
+
+- (void)sendEntry:(ACEOAuth2RACOfflineEntry *)entry
+{
+    [self.sendBlock(entry.request)
+     subscribeError:^(NSError *error) {
+         dispatch_async(self.queue, ^{
+             [self finishEntry:entry withError:error];
+         });
+         
+     } completed:^{
+         dispatch_async(self.queue, ^{
+             [self finishEntry:entry withError:nil];
+         });
+     }];
+}
+
+- (void)finishEntry:(ACEOAuth2RACOfflineEntry *)entry withError:(NSError *)error
+{
+    entry.running = NO;
+    
+    if (error != nil && ACEOAuth2RACOfflineIsTransientError(error)) {
+        // wait for the next change of network, or for the server to come back
+        ACE_LOG_DEBUG(@"Offline request %@ %@ postponed: %@", entry.method, entry.resource, error.localizedDescription);
+        if (self.isReplaying) {
+            self.replaying = NO;
+            [self scheduleReplayAfterError:error];
+        }
+        return;
+    }
+    
+    self.failureCount = 0;
+    
+    NSError *journalError;
+    if (![self appendRecords:@[ @{ @"op": @"done", @"id": @(entry.number) } ] error:&journalError]) {
+        // sent again after a restart, the server knows its key
+        ACE_LOG_ERROR(@"Cannot update the offline journal: %@", journalError);
+    }
+    
+    [self.entries removeObjectIdenticalTo:entry];
+    self.pendingRequestCount = self.entries.count;
+    
+    if (error != nil) {
+        ACE_LOG_WARNING(@"Offline request %@ %@ rejected: %@", entry.method, entry.resource, error.localizedDescription);
+        [self.failedRequests sendNext:RACTuplePack(entry.request, error)];
+    }
+    
+    [self compactJournalIfNeeded];
+    [self sendPendingRequests];
+}
+
+- (void)scheduleReplayAfterError:(NSError *)error
+{
+    if (self.retryInterval <= 0.0) {
+        return;
+    }
+    
+    // doubled after each temporary error, with a jitter so the clients of a server coming back don't replay together
+    NSTimeInterval interval = MIN(self.retryInterval * pow(2.0, MIN(self.failureCount, 16)), ACEOAuth2RACOfflineMaxRetryInterval);
+    interval = MAX(interval * (0.5 + arc4random_uniform(501) / 1000.0), ACEOAuth2RACOfflineRetryAfterInterval(error));
+    self.failureCount++;
+    
+    ACE_LOG_DEBUG(@"Replaying the offline requests in %.1f seconds", interval);
+    
+    @weakify(self)
+    self.scheduledReplay = [[RACScheduler scheduler] afterDelay:interval schedule:^{
+        @strongify(self)
+        [self replay];
+    }];
+}
+
+
+#pragma mark - Journal
+
+- (void)loadJournal
+{
+    if (self.isLoaded) {
+        return;
+    }
+    self.loaded = YES;
+    
+    NSData *data = [NSData dataWithContentsOfURL:self.journalURL options:NSDataReadingMappedIfSafe error:nil];
+    const uint8_t *bytes = data.bytes;
+    NSUInteger length = data.length;
+    NSUInteger offset = 0;
+    
+    NSMutableDictionary<NSNumber *, NSDictionary *> *records = [NSMutableDictionary dictionary];
+    NSUInteger recordCount = 0;
+    
+    while (length - offset >= sizeof(ACEOAuth2RACOfflineRecordHeader)) {
+        ACEOAuth2RACOfflineRecordHeader header;
+        memcpy(&header, bytes + offset, sizeof(header));
+        
+        NSUInteger recordLength = CFSwapInt32LittleToHost(header.length);
+        const uint8_t *payload = bytes + offset + sizeof(header);
+        if (recordLength > length - offset - sizeof(header) ||
+            crc32(0, payload, (uInt)recordLength) != CFSwapInt32LittleToHost(header.checksum)) {
+            
+            break;
+        }
+        
+        NSDictionary *record = [NSJSONSerialization JSONObjectWithData:[NSData dataWithBytes:payload length:recordLength] options:0 error:nil];
+        if (![record isKindOfClass:[NSDictionary class]]) {
+            break;
+        }
+        
+        if ([record[@"op"] isEqualToString:@"add"]) {
+            records[record[@"id"]] = record;
+            
+        } else if ([record[@"op"] isEqualToString:@"done"]) {
+            [records removeObjectForKey:record[@"id"]];
+        }
+        
+        recordCount++;
+        offset += sizeof(header) + recordLength;
+    }
+    
+    // the tail written during a crash
+    if (offset < length) {
+        ACE_LOG_WARNING(@"Discarding %lu bytes at the end of the offline journal", (unsigned long)(length - offset));
+        truncate(self.journalURL.fileSystemRepresentation, offset);
+    }
+    
+    for (NSNumber *number in [records.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        [self addEntryWithRecord:records[number]];
+    }
+    
+    self.recordCount            = recordCount;
+    self.pendingRequestCount    = self.entries.count;
+    [self compactJournalIfNeeded];
+}
+
+- (NSData *)dataOfRecords:(NSArray<NSDictionary *> *)records error:(NSError *__autoreleasing *)error
+{
+    NSMutableData *data = [NSMutableData data];
+    for (NSDictionary *record in records) {
+        NSData *payload = [NSJSONSerialization dataWithJSONObject:record options:0 error:error];
+        if (payload == nil) {
+            return nil;
+        }
+        
+        ACEOAuth2RACOfflineRecordHeader header;
+        header.length   = CFSwapInt32HostToLittle((uint32_t)payload.length);
+        header.checksum = CFSwapInt32HostToLittle((uint32_t)crc32(0, payload.bytes, (uInt)payload.length));
+        
+        [data appendBytes:&header length:sizeof(header)];
+        [data appendData:payload];
+    }
+    return data;
+}
+
+- (BOOL)appendRecords:(NSArray<NSDictionary *> *)records error:(NSError *__autoreleasing *)error
+{
+    NSData *data = [self dataOfRecords:records error:error];
+    if (data == nil) {
+        return NO;
+    }
+    
+    [[NSFileManager defaultManager] createDirectoryAtURL:[self.journalURL URLByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+    
+    int fd = open(self.journalURL.fileSystemRepresentation, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        if (error != NULL) {
+            *error = ACEOAuth2RACOfflinePOSIXError(self.journalURL);
+        }
+        return NO;
+    }
+    
+    off_t size = lseek(fd, 0, SEEK_END);
+    BOOL written = ACEOAuth2RACOfflineWrite(fd, data.bytes, data.length) && fsync(fd) == 0;
+    if (!written) {
+        if (error != NULL) {
+            *error = ACEOAuth2RACOfflinePOSIXError(self.journalURL);
+        }
+        
+        // never leave half a record before the next one
+        ftruncate(fd, size);
+    }
+    close(fd);
+    
+    if (written) {
+        self.recordCount += records.count;
+    }
+    return written;
+}
+
+- (void)compactJournalIfNeeded
+{
+    if (self.recordCount < ACEOAuth2RACOfflineCompactionThreshold || self.recordCount < self.entries.count * 4) {
+        return;
+    }
+    
+    NSMutableArray<NSDictionary *> *records = [NSMutableArray arrayWithCapacity:self.entries.count];
+    for (ACEOAuth2RACOfflineEntry *entry in self.entries) {
+        [records addObject:entry.record];
+    }
+    
+    NSData *data = [self dataOfRecords:records error:nil];
+    NSString *path = [self.journalURL.path stringByAppendingPathExtension:@"tmp"];
+    
+    int fd = open(path.fileSystemRepresentation, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return;
+    }
+    BOOL written = data != nil && ACEOAuth2RACOfflineWrite(fd, data.bytes, data.length) && fsync(fd) == 0;
+    close(fd);
+    
+    // the rename replaces the journal as a whole, the old one survives a crash until then
+    if (written && rename(path.fileSystemRepresentation, self.journalURL.fileSystemRepresentation) == 0) {
+        int directory = open([self.journalURL URLByDeletingLastPathComponent].fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+        if (directory >= 0) {
+            fsync(directory);
+            close(directory);
+        }
+        self.recordCount = records.count;
+        
+    } else {
+        unlink(path.fileSystemRepresentation);
+    }
+}
+
+@end
@@ -0,0 +1,68 @@
+// ACEOAuth2RACPaginator.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ReactiveObjC.h"
+
+@class ACEOAuth2RACRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Block in charge of fetching a single page.
+ The returned signal must send a `RACTuple` with the response object and the URL response.
+ */
+typedef RACSignal * _Nonnull (^ACEOAuth2RACPaginatorFetchBlock)(ACEOAuth2RACRequest *request);
+
+/**
+ Block returning the request of the page following `response`, nil if it was the last page.
+ */
+typedef ACEOAuth2RACRequest * _Nullable (^ACEOAuth2RACPaginatorNextRequestBlock)(ACEOAuth2RACRequest *request, RACTuple *response);
+
+/**
+ `ACEOAuth2RACPaginator` walks a paginated endpoint, fetching the next pages while the current one is processed.
+ */
+@interface ACEOAuth2RACPaginator : NSObject
+
+/**
+ Return a signal walking the pages starting from `request`.
+ 
+ Every subscription has its own paginator. The pages are delivered one at a time on a private serial scheduler,
+ and at most `prefetchDepth` pages are fetched ahead of the one being delivered.
+ Disposing the subscription cancels the page in flight and stops the fetching.
+
+ @param request The request of the first page.
+ @param prefetchDepth The maximum number of pages to fetch ahead, at least 1.
+ @param fetchBlock The block fetching a single page.
+ @param nextRequestBlock The block building the request of the next page.
+
+ @return The signal sending the response object of each page.
+ */
++ (RACSignal *)rac_pagesForRequest:(ACEOAuth2RACRequest *)request
+                     prefetchDepth:(NSUInteger)prefetchDepth
+                        fetchBlock:(ACEOAuth2RACPaginatorFetchBlock)fetchBlock
+                  nextRequestBlock:(ACEOAuth2RACPaginatorNextRequestBlock)nextRequestBlock;
+
+@end
+
+NS_ASSUME_NONNULL_END
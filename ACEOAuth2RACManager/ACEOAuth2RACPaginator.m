@@ -0,0 +1,225 @@
+// ACEOAuth2RACPaginator.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACPaginator.h"
+#import "ACEOAuth2RACManagerPrivate.h"
+
+@interface ACEOAuth2RACPaginator ()
+@property (nonatomic, copy) ACEOAuth2RACPaginatorFetchBlock fetchBlock;
+@property (nonatomic, copy) ACEOAuth2RACPaginatorNextRequestBlock nextRequestBlock;
+@property (nonatomic, assign) NSUInteger prefetchDepth;
+
+@property (nonatomic, strong) id<RACSubscriber> subscriber;
+@property (nonatomic, strong) RACScheduler *deliveryScheduler;
+@property (nonatomic, strong) RACSerialDisposable *fetchDisposable;
+
+// state, accessed only while synchronized on self
+@property (nonatomic, strong) NSMutableArray *pages;
+@property (nonatomic, strong) ACEOAuth2RACRequest *nextRequest;
+@property (nonatomic, strong) NSError *error;
+@property (nonatomic, assign) BOOL fetching;
+@property (nonatomic, assign) BOOL delivering;
+@property (nonatomic, assign) BOOL disposed;
+@end
+
+@implementation ACEOAuth2RACPaginator
+
++ (RACSignal *)rac_pagesForRequest:(ACEOAuth2RACRequest *)request
+                     prefetchDepth:(NSUInteger)prefetchDepth
+                        fetchBlock:(ACEOAuth2RACPaginatorFetchBlock)fetchBlock
+                  nextRequestBlock:(ACEOAuth2RACPaginatorNextRequestBlock)nextRequestBlock
+{
+    return [[RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+        
+        ACEOAuth2RACPaginator *paginator = [ACEOAuth2RACPaginator new];
+        paginator.fetchBlock        = fetchBlock;
+        paginator.nextRequestBlock  = nextRequestBlock;
+        paginator.prefetchDepth     = MAX(prefetchDepth, 1);
+        paginator.subscriber        = subscriber;
+        paginator.nextRequest       = request;
+        
+        [paginator start];
+        
+        return [RACDisposable disposableWithBlock:^{
+            [paginator dispose];
+        }];
+        
+    }] setNameWithFormat:@"[%@] +rac_pagesForRequest: %@ prefetchDepth: %lu", self.class, request, (unsigned long)prefetchDepth];
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self.pages              = [NSMutableArray array];
+        self.fetchDisposable    = [RACSerialDisposable new];
+        self.deliveryScheduler  = [RACScheduler schedulerWithPriority:RACSchedulerPriorityDefault name:@"com.onemob.network.pages"];
+    }
+    return self;
+}
+
+- (void)start
+{
+    @synchronized (self) {
+        [self fetchIfNeeded];
+    }
+}
+
+- (void)dispose
+{
+    @synchronized (self) {
+        self.disposed = YES;
+        [self.pages removeAllObjects];
+    }
+    [self.fetchDisposable dispose];
+}
+
+
+#pragma mark - Fetching
+
+- (void)fetchIfNeeded
+{
+    // pages are fetched one after the other, each one tells where the next one is
+    if (self.disposed || self.fetching || self.error != nil || self.nextRequest == nil || self.pages.count >= self.prefetchDepth) {
+        return;
+    }
+    
+    ACEOAuth2RACRequest *request = self.nextRequest;
+    self.nextRequest    = nil;
+    self.fetching       = YES;
+    
+    // installed before subscribing, a fetch completing synchronously starts the next one with its own
+    RACSerialDisposable *disposable = [RACSerialDisposable new];
+    self.fetchDisposable.disposable = disposable;
+    
+    __block RACTuple *pageResponse;
+    disposable.disposable = [self.fetchBlock(request)
+                             subscribeNext:^(RACTuple *response) {
+                                 pageResponse = response;
+                                 
+                             } error:^(NSError *error) {
+                                 [self didFailWithError:error];
+                                 
+                             } completed:^{
+                                 [self didFetchResponse:pageResponse forRequest:request];
+                             }];
+}
+
+- (void)didFetchResponse:(RACTuple *)response forRequest:(ACEOAuth2RACRequest *)request
+{
+    @synchronized (self) {
+        self.fetching = NO;
+        
+        if (self.disposed) {
+            return;
+        }
+        
+        if (response == nil) {
+            // no page, so nothing tells where the next one is, the pages already fetched end the signal
+            [self deliverIfNeeded];
+            return;
+        }
+        
+        [self.pages addObject:[response first] ?: [NSNull null]];
+        self.nextRequest = self.nextRequestBlock(request, response);
+        
+        ACE_LOG_DEBUG(@"Fetched page %@, %lu pages ready", request.path, (unsigned long)self.pages.count);
+        
+        [self fetchIfNeeded];
+        [self deliverIfNeeded];
+    }
+}
+
+- (void)didFailWithError:(NSError *)error
+{
+    @synchronized (self) {
+        self.fetching   = NO;
+        self.error      = error;
+        
+        [self deliverIfNeeded];
+    }
+}
+
+
+#pragma mark - Delivery
+
+- (void)deliverIfNeeded
+{
+    if (self.delivering || self.disposed) {
+        return;
+    }
+    
+    self.delivering = YES;
+    [self.deliveryScheduler schedule:^{
+        [self deliver];
+    }];
+}
+
+- (void)deliver
+{
+    while (YES) {
+        id page;
+        NSError *error;
+        BOOL completed = NO;
+        
+        @synchronized (self) {
+            if (self.disposed) {
+                self.delivering = NO;
+                return;
+                
+            } else if (self.pages.count > 0) {
+                page = self.pages.firstObject;
+                [self.pages removeObjectAtIndex:0];
+                
+                // a slot is free, fetch the next page while this one is processed
+                [self fetchIfNeeded];
+                
+            } else if (self.error != nil) {
+                error = self.error;
+                
+            } else if (!self.fetching && self.nextRequest == nil) {
+                completed = YES;
+                
+            } else {
+                // wait for the page in flight
+                self.delivering = NO;
+                return;
+            }
+        }
+        
+        if (page != nil) {
+            [self.subscriber sendNext:page == [NSNull null] ? nil : page];
+            
+        } else if (error != nil) {
+            [self.subscriber sendError:error];
+            return;
+            
+        } else if (completed) {
+            [self.subscriber sendCompleted];
+            return;
+        }
+    }
+}
+
+@end
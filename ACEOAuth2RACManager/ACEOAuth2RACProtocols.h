@@ -24,6 +24,7 @@
 #import <Foundation/Foundation.h>
 
 @class ACEOAuth2RACManager;
+@class RACTuple;
 
 @protocol ACEOAuth2RACManagerCoordinator <NSObject>
 
@@ -87,3 +88,84 @@ failedAuthenticationWithError:(nonnull NSError *)error
                                 withIdentifier:(nonnull NSString *)identifier;
 
 @end
+
+#pragma mark -
+
+/**
+ `ACEOAuth2RACModel` is adopted by the model classes filled from the responses.
+ Every property is mapped from the response key with the same name, unless specified otherwise.
+ */
+@protocol ACEOAuth2RACModel <NSObject>
+
+@optional
+
+/**
+ The key paths in the response of the properties not named like their key.
+ 
+ @return A dictionary with the property names as keys and the key paths as values.
+ */
++ (nonnull NSDictionary<NSString *, NSString *> *)responseKeyPathsByPropertyKey;
+
+/**
+ The model classes of the elements of the array properties.
+ The properties with a type adopting `ACEOAuth2RACModel` don't need to be listed.
+ 
+ @return A dictionary with the property names as keys and the model classes as values.
+ */
++ (nonnull NSDictionary<NSString *, Class> *)modelClassesByPropertyKey;
+
+@end
+
+#pragma mark -
+
+/**
+ `ACEOAuth2RACInterceptor` is adopted by the objects taking part in every request of the network manager,
+ in the order they are added. The requests go through the interceptors in order, and the responses and the errors
+ come back in the reverse order. The methods can be called on any thread.
+ 
+ The responses are tuples with the response object and the `NSURLResponse`.
+ */
+@protocol ACEOAuth2RACInterceptor <NSObject>
+
+@optional
+
+/**
+ Modify the request before it's sent, like adding a header.
+ 
+ @param request The request built by the previous interceptors.
+ 
+ @return The request to send.
+ */
+- (nonnull NSURLRequest *)interceptRequest:(nonnull NSURLRequest *)request;
+
+/**
+ Answer the request without calling the server, like from a cache.
+ Only the interceptors before this one see the response, which doesn't wait for a slot of the request queue.
+ 
+ @param request The request to send.
+ 
+ @return The response, or nil to send the request.
+ */
+- (nullable RACTuple *)cachedResponseForRequest:(nonnull NSURLRequest *)request;
+
+/**
+ Transform the response of a request.
+ 
+ @param response The tuple with the response object and the `NSURLResponse`.
+ @param request The request sent.
+ 
+ @return The response passed to the previous interceptors.
+ */
+- (nonnull RACTuple *)interceptResponse:(nonnull RACTuple *)response forRequest:(nonnull NSURLRequest *)request;
+
+/**
+ Transform the error of a request, after the retries.
+ 
+ @param error The error of the request.
+ @param request The request sent.
+ 
+ @return The error passed to the previous interceptors.
+ */
+- (nonnull NSError *)interceptError:(nonnull NSError *)error forRequest:(nonnull NSURLRequest *)request;
+
+@end
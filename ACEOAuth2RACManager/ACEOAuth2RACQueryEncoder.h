@@ -0,0 +1,70 @@
+// ACEOAuth2RACQueryEncoder.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `ACEOAuth2RACQueryEncoder` builds the same query strings of `AFQueryStringFromParameters`, writing every pair
+ straight into a single UTF-8 buffer and percent-encoding with a lookup table, without an object per pair.
+ */
+@interface ACEOAuth2RACQueryEncoder : NSObject
+
+/**
+ YES to sort the keys of the dictionaries and the objects of the sets by their description, like AFNetworking does.
+ NO keeps the order of the enumeration, which saves a sort for each dictionary. Default is YES.
+ */
+@property (nonatomic, assign) BOOL sortsKeys;
+
+/**
+ Register a dictionary of parameters sent unchanged by many requests, like a set of filters.
+ Its encoding is kept and copied as it is, every time the returned dictionary is found among the parameters.
+ The encoder doesn't retain the dictionary, the encoding is kept only while the caller holds it.
+
+ @param parameters The constant parameters.
+
+ @return The immutable dictionary to use in the parameters of the requests.
+ */
+- (NSDictionary *)constantParameters:(NSDictionary *)parameters;
+
+/**
+ Forget the encoding of a dictionary returned by `constantParameters:`, it's encoded as any other from now on.
+
+ @param parameters The dictionary returned by `constantParameters:`.
+ */
+- (void)removeConstantParameters:(NSDictionary *)parameters;
+
+/**
+ Encode the parameters of a request.
+
+ @param parameters The parameters, usually a dictionary.
+
+ @return The percent-encoded query string.
+ */
+- (NSString *)queryStringFromParameters:(id)parameters;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,328 @@
+// ACEOAuth2RACQueryEncoder.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACQueryEncoder.h"
+
+typedef struct {
+    uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger capacity;
+} ACEOAuth2RACQueryBuffer;
+
+typedef struct {
+    ACEOAuth2RACQueryBuffer output;
+    
+    // the encoded field of the current value, like `filter%5Bname%5D`
+    ACEOAuth2RACQueryBuffer field;
+    
+    // the UTF-8 bytes of the string being encoded
+    ACEOAuth2RACQueryBuffer scratch;
+    
+    // a pair can be empty, like a null value without a field, and still needs its separator
+    BOOL hasPairs;
+    BOOL sortsKeys;
+} ACEOAuth2RACQueryContext;
+
+// the characters left as they are, the same of AFPercentEscapedStringFromString
+static BOOL ACEOAuth2RACQueryAllowedCharacters[256];
+
+@interface ACEOAuth2RACQueryEncoder ()
+
+// the encodings of the constant parameters, keyed weakly by the dictionary and then by the encoded field
+@property (nonatomic, strong) NSMapTable<NSDictionary *, NSMutableDictionary<NSData *, NSData *> *> *constantEncodings;
+
+- (NSData *)encodingOfConstantParameters:(NSDictionary *)parameters field:(NSData *)field isConstant:(BOOL *)isConstant;
+- (void)setEncoding:(NSData *)encoding ofConstantParameters:(NSDictionary *)parameters field:(NSData *)field;
+
+@end
+
+
+#pragma mark - Buffer
+
+static inline void ACEOAuth2RACQueryBufferReserve(ACEOAuth2RACQueryBuffer *buffer, NSUInteger length)
+{
+    if (buffer->length + length <= buffer->capacity) {
+        return;
+    }
+    
+    NSUInteger capacity = MAX(buffer->capacity * 2, buffer->length + length);
+    uint8_t *bytes = realloc(buffer->bytes, capacity);
+    if (bytes == NULL) {
+        [NSException raise:NSMallocException format:@"Out of memory encoding the query string"];
+    }
+    
+    buffer->bytes       = bytes;
+    buffer->capacity    = capacity;
+}
+
+static inline void ACEOAuth2RACQueryBufferAppend(ACEOAuth2RACQueryBuffer *buffer, const void *bytes, NSUInteger length)
+{
+    ACEOAuth2RACQueryBufferReserve(buffer, length);
+    memcpy(buffer->bytes + buffer->length, bytes, length);
+    buffer->length += length;
+}
+
+static void ACEOAuth2RACQueryBufferAppendEscaped(ACEOAuth2RACQueryBuffer *buffer, const uint8_t *bytes, NSUInteger length)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    
+    ACEOAuth2RACQueryBufferReserve(buffer, length * 3);
+    uint8_t *output = buffer->bytes + buffer->length;
+    
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t c = bytes[i];
+        if (ACEOAuth2RACQueryAllowedCharacters[c]) {
+            *output++ = c;
+            
+        } else {
+            *output++ = '%';
+            *output++ = hex[c >> 4];
+            *output++ = hex[c & 0x0f];
+        }
+    }
+    
+    buffer->length = output - buffer->bytes;
+}
+
+static void ACEOAuth2RACQueryAppendString(ACEOAuth2RACQueryContext *context, ACEOAuth2RACQueryBuffer *buffer, id object)
+{
+    NSString *string = [object isKindOfClass:[NSString class]] ? object : [object description];
+    CFStringRef stringRef = (__bridge CFStringRef)string;
+    
+    // the bytes of most strings are available without converting them
+    const char *UTF8String = CFStringGetCStringPtr(stringRef, kCFStringEncodingUTF8);
+    if (UTF8String != NULL) {
+        ACEOAuth2RACQueryBufferAppendEscaped(buffer, (const uint8_t *)UTF8String, strlen(UTF8String));
+        return;
+    }
+    
+    CFIndex length = CFStringGetLength(stringRef);
+    CFIndex usedLength = 0;
+    
+    context->scratch.length = 0;
+    ACEOAuth2RACQueryBufferReserve(&context->scratch, length * 3);
+    CFStringGetBytes(stringRef, CFRangeMake(0, length), kCFStringEncodingUTF8, 0, false, context->scratch.bytes, context->scratch.capacity, &usedLength);
+    
+    ACEOAuth2RACQueryBufferAppendEscaped(buffer, context->scratch.bytes, usedLength);
+}
+
+
+#pragma mark - Encoding
+
+static NSArray *ACEOAuth2RACQuerySortedObjects(NSArray *objects)
+{
+    return [objects sortedArrayUsingComparator:^NSComparisonResult(id object1, id object2) {
+        return [[object1 description] compare:[object2 description]];
+    }];
+}
+
+static void ACEOAuth2RACQueryEncodeValue(ACEOAuth2RACQueryContext *context, ACEOAuth2RACQueryEncoder *encoder, id value, BOOL hasField)
+{
+    NSUInteger fieldLength = context->field.length;
+    
+    if ([value isKindOfClass:[NSDictionary class]]) {
+        NSDictionary *dictionary = value;
+        
+        // the constant parameters are encoded once for each field
+        BOOL isConstant = NO;
+        NSData *field = nil;
+        if (hasField) {
+            field = [NSData dataWithBytes:context->field.bytes length:context->field.length];
+            
+            NSData *encoding = [encoder encodingOfConstantParameters:dictionary field:field isConstant:&isConstant];
+            if (encoding != nil) {
+                // the pairs with a field are never empty
+                if (encoding.length > 0) {
+                    if (context->hasPairs) {
+                        ACEOAuth2RACQueryBufferAppend(&context->output, "&", 1);
+                    }
+                    ACEOAuth2RACQueryBufferAppend(&context->output, encoding.bytes, encoding.length);
+                    context->hasPairs = YES;
+                }
+                return;
+            }
+        }
+        
+        NSUInteger start    = context->output.length;
+        BOOL hadPairs       = context->hasPairs;
+        NSArray *keys = context->sortsKeys ? ACEOAuth2RACQuerySortedObjects(dictionary.allKeys) : dictionary.allKeys;
+        
+        for (id key in keys) {
+            if (hasField) {
+                ACEOAuth2RACQueryBufferAppend(&context->field, "%5B", 3);
+                ACEOAuth2RACQueryAppendString(context, &context->field, key);
+                ACEOAuth2RACQueryBufferAppend(&context->field, "%5D", 3);
+                
+            } else {
+                ACEOAuth2RACQueryAppendString(context, &context->field, key);
+            }
+            
+            ACEOAuth2RACQueryEncodeValue(context, encoder, dictionary[key], YES);
+            context->field.length = fieldLength;
+        }
+        
+        if (isConstant) {
+            // without the separator from the previous pairs
+            NSUInteger offset = (hadPairs && context->output.length > start) ? 1 : 0;
+            NSData *encoding = [NSData dataWithBytes:context->output.bytes + start + offset length:context->output.length - start - offset];
+            [encoder setEncoding:encoding ofConstantParameters:dictionary field:field];
+        }
+        
+    } else if ([value isKindOfClass:[NSArray class]]) {
+        for (id nestedValue in value) {
+            // same as the `%@[]` format of AFNetworking, nil included
+            if (!hasField) {
+                ACEOAuth2RACQueryBufferAppend(&context->field, "%28null%29", 10);
+            }
+            ACEOAuth2RACQueryBufferAppend(&context->field, "%5B%5D", 6);
+            
+            ACEOAuth2RACQueryEncodeValue(context, encoder, nestedValue, YES);
+            context->field.length = fieldLength;
+        }
+        
+    } else if ([value isKindOfClass:[NSSet class]]) {
+        NSArray *objects = context->sortsKeys ? ACEOAuth2RACQuerySortedObjects([value allObjects]) : [value allObjects];
+        for (id nestedValue in objects) {
+            ACEOAuth2RACQueryEncodeValue(context, encoder, nestedValue, hasField);
+        }
+        
+    } else {
+        if (context->hasPairs) {
+            ACEOAuth2RACQueryBufferAppend(&context->output, "&", 1);
+        }
+        context->hasPairs = YES;
+        
+        // without a field, AFNetworking escapes the description of nil into an empty string, like `=value`
+        ACEOAuth2RACQueryBufferAppend(&context->output, context->field.bytes, context->field.length);
+        
+        if (value != [NSNull null]) {
+            ACEOAuth2RACQueryBufferAppend(&context->output, "=", 1);
+            ACEOAuth2RACQueryAppendString(context, &context->output, value);
+        }
+    }
+}
+
+
+#pragma mark -
+
+@implementation ACEOAuth2RACQueryEncoder
+
++ (void)initialize
+{
+    if (self == [ACEOAuth2RACQueryEncoder class]) {
+        const char *allowed = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-._~/?";
+        for (const char *c = allowed; *c != '\0'; c++) {
+            ACEOAuth2RACQueryAllowedCharacters[(uint8_t)*c] = YES;
+        }
+    }
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self.sortsKeys          = YES;
+        self.constantEncodings  = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+                                                        valueOptions:NSPointerFunctionsStrongMemory];
+    }
+    return self;
+}
+
+- (void)setSortsKeys:(BOOL)sortsKeys
+{
+    _sortsKeys = sortsKeys;
+    
+    // the cached encodings follow the previous order
+    @synchronized (self.constantEncodings) {
+        for (NSDictionary *parameters in self.constantEncodings) {
+            [[self.constantEncodings objectForKey:parameters] removeAllObjects];
+        }
+    }
+}
+
+
+#pragma mark - Constant Parameters
+
+- (NSDictionary *)constantParameters:(NSDictionary *)parameters
+{
+    NSDictionary *constantParameters = [parameters copy];
+    
+    @synchronized (self.constantEncodings) {
+        if ([self.constantEncodings objectForKey:constantParameters] == nil) {
+            [self.constantEncodings setObject:[NSMutableDictionary dictionary] forKey:constantParameters];
+        }
+    }
+    return constantParameters;
+}
+
+- (void)removeConstantParameters:(NSDictionary *)parameters
+{
+    @synchronized (self.constantEncodings) {
+        [self.constantEncodings removeObjectForKey:parameters];
+    }
+}
+
+- (NSData *)encodingOfConstantParameters:(NSDictionary *)parameters field:(NSData *)field isConstant:(BOOL *)isConstant
+{
+    @synchronized (self.constantEncodings) {
+        NSMutableDictionary *encodings = [self.constantEncodings objectForKey:parameters];
+        *isConstant = (encodings != nil);
+        return encodings[field];
+    }
+}
+
+- (void)setEncoding:(NSData *)encoding ofConstantParameters:(NSDictionary *)parameters field:(NSData *)field
+{
+    @synchronized (self.constantEncodings) {
+        [self.constantEncodings objectForKey:parameters][field] = encoding;
+    }
+}
+
+
+#pragma mark - Encoding
+
+- (NSString *)queryStringFromParameters:(id)parameters
+{
+    ACEOAuth2RACQueryContext context;
+    memset(&context, 0, sizeof(context));
+    context.sortsKeys = self.sortsKeys;
+    
+    ACEOAuth2RACQueryEncodeValue(&context, self, parameters, NO);
+    
+    free(context.field.bytes);
+    free(context.scratch.bytes);
+    
+    if (context.output.length == 0) {
+        free(context.output.bytes);
+        return @"";
+    }
+    
+    // only ASCII characters are left after the encoding
+    return [[NSString alloc] initWithBytesNoCopy:context.output.bytes
+                                          length:context.output.length
+                                        encoding:NSASCIIStringEncoding
+                                    freeWhenDone:YES];
+}
+
+@end
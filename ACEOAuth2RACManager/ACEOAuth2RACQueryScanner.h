@@ -0,0 +1,53 @@
+// ACEOAuth2RACQueryScanner.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Find a parameter in the query of a URL, or in its fragment for the responses sent like `#code=...`.
+
+ The bytes of the URL are scanned in place, the only objects created are the values of the key.
+ The keys and the values are percent-decoded, with `+` decoded as a space.
+
+ @param URL The URL to scan.
+ @param key The name of the parameter, like `code`, `state` or `error`.
+
+ @return The decoded value of the last occurrence in the query, or in the fragment when the query doesn't have it.
+ Nil if the parameter is missing.
+ An empty string if the parameter has no value.
+ */
+extern NSString * _Nullable ACEOAuth2RACQueryValueForKey(NSURL *URL, NSString *key);
+
+/**
+ Count the parameters in the query and in the fragment of a URL, scanning its bytes in place.
+
+ @param URL The URL to scan.
+
+ @return The number of parameters.
+ */
+extern NSUInteger ACEOAuth2RACQueryParameterCount(NSURL *URL);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,180 @@
+// ACEOAuth2RACQueryScanner.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACQueryScanner.h"
+
+typedef void (^ACEOAuth2RACQueryPairBlock)(const uint8_t *key, NSUInteger keyLength, const uint8_t *value, NSUInteger valueLength, BOOL inFragment, BOOL *stop);
+
+static inline int ACEOAuth2RACQueryHexValue(uint8_t c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// decode the next byte of an encoded component, return the position after it
+static inline NSUInteger ACEOAuth2RACQueryDecodeByte(const uint8_t *bytes, NSUInteger length, NSUInteger position, uint8_t *byte)
+{
+    uint8_t c = bytes[position];
+    
+    if (c == '+') {
+        *byte = ' ';
+        
+    } else if (c == '%' && position + 2 < length && ACEOAuth2RACQueryHexValue(bytes[position + 1]) >= 0 && ACEOAuth2RACQueryHexValue(bytes[position + 2]) >= 0) {
+        *byte = (uint8_t)((ACEOAuth2RACQueryHexValue(bytes[position + 1]) << 4) | ACEOAuth2RACQueryHexValue(bytes[position + 2]));
+        return position + 3;
+        
+    } else {
+        // a malformed escape is kept as it is
+        *byte = c;
+    }
+    return position + 1;
+}
+
+static BOOL ACEOAuth2RACQueryComponentEquals(const uint8_t *bytes, NSUInteger length, const uint8_t *string, NSUInteger stringLength)
+{
+    NSUInteger position = 0;
+    NSUInteger index    = 0;
+    
+    while (position < length && index < stringLength) {
+        uint8_t byte;
+        position = ACEOAuth2RACQueryDecodeByte(bytes, length, position, &byte);
+        if (byte != string[index++]) {
+            return NO;
+        }
+    }
+    return position == length && index == stringLength;
+}
+
+static void ACEOAuth2RACQueryScanComponent(const uint8_t *bytes, NSUInteger length, BOOL inFragment, ACEOAuth2RACQueryPairBlock block, BOOL *stop)
+{
+    NSUInteger start = 0;
+    
+    while (start < length && !*stop) {
+        const uint8_t *pair = bytes + start;
+        const uint8_t *end  = memchr(pair, '&', length - start);
+        NSUInteger pairLength = end ? (NSUInteger)(end - pair) : length - start;
+        
+        if (pairLength > 0) {
+            const uint8_t *separator = memchr(pair, '=', pairLength);
+            if (separator != NULL) {
+                NSUInteger keyLength = separator - pair;
+                block(pair, keyLength, separator + 1, pairLength - keyLength - 1, inFragment, stop);
+                
+            } else {
+                block(pair, pairLength, NULL, 0, inFragment, stop);
+            }
+        }
+        
+        start += pairLength + 1;
+    }
+}
+
+static void ACEOAuth2RACQueryScan(NSURL *URL, ACEOAuth2RACQueryPairBlock block)
+{
+    CFURLRef URLRef = (__bridge CFURLRef)URL.absoluteURL;
+    
+    // the URL string as it is, on the stack for the usual sizes
+    uint8_t stackBuffer[1024];
+    uint8_t *bytes = stackBuffer;
+    
+    CFIndex length = CFURLGetBytes(URLRef, bytes, sizeof(stackBuffer));
+    if (length < 0) {
+        length = CFURLGetBytes(URLRef, NULL, 0);
+        bytes = malloc(length);
+        if (bytes == NULL) {
+            return;
+        }
+        CFURLGetBytes(URLRef, bytes, length);
+    }
+    
+    const uint8_t *fragment = memchr(bytes, '#', length);
+    NSUInteger fragmentStart = fragment ? (NSUInteger)(fragment - bytes) : (NSUInteger)length;
+    
+    const uint8_t *query = memchr(bytes, '?', fragmentStart);
+    BOOL stop = NO;
+    
+    if (query != NULL) {
+        NSUInteger queryStart = query - bytes + 1;
+        ACEOAuth2RACQueryScanComponent(bytes + queryStart, fragmentStart - queryStart, NO, block, &stop);
+    }
+    
+    if (fragment != NULL && !stop) {
+        ACEOAuth2RACQueryScanComponent(bytes + fragmentStart + 1, length - fragmentStart - 1, YES, block, &stop);
+    }
+    
+    if (bytes != stackBuffer) {
+        free(bytes);
+    }
+}
+
+NSString *ACEOAuth2RACQueryValueForKey(NSURL *URL, NSString *key)
+{
+    const char *keyString = key.UTF8String;
+    NSUInteger keyStringLength = strlen(keyString);
+    
+    __block NSString *result = nil;
+    ACEOAuth2RACQueryScan(URL, ^(const uint8_t *pairKey, NSUInteger keyLength, const uint8_t *value, NSUInteger valueLength, BOOL inFragment, BOOL *stop) {
+        if (inFragment && result != nil) {
+            // the fragment is a fallback for the parameters missing from the query
+            *stop = YES;
+            return;
+        }
+        
+        if (!ACEOAuth2RACQueryComponentEquals(pairKey, keyLength, (const uint8_t *)keyString, keyStringLength)) {
+            return;
+        }
+        
+        // the decoded value is never longer than the encoded one
+        uint8_t stackBuffer[256];
+        uint8_t *decoded = (valueLength <= sizeof(stackBuffer)) ? stackBuffer : malloc(valueLength);
+        if (decoded == NULL) {
+            *stop = YES;
+            return;
+        }
+        
+        NSUInteger decodedLength = 0;
+        for (NSUInteger position = 0; position < valueLength; ) {
+            position = ACEOAuth2RACQueryDecodeByte(value, valueLength, position, decoded + decodedLength++);
+        }
+        
+        // a repeated key takes the last value, like the query dictionaries
+        result = [[NSString alloc] initWithBytes:decoded length:decodedLength encoding:NSUTF8StringEncoding];
+        
+        if (decoded != stackBuffer) {
+            free(decoded);
+        }
+    });
+    return result;
+}
+
+NSUInteger ACEOAuth2RACQueryParameterCount(NSURL *URL)
+{
+    __block NSUInteger count = 0;
+    ACEOAuth2RACQueryScan(URL, ^(const uint8_t *key, NSUInteger keyLength, const uint8_t *value, NSUInteger valueLength, BOOL inFragment, BOOL *stop) {
+        count++;
+    });
+    return count;
+}
@@ -0,0 +1,172 @@
+// ACEOAuth2RACRequest.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import <Foundation/Foundation.h>
+
+@class ACEOAuth2RACRoute;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The priority classes of the requests, from the most to the least urgent.
+ */
+typedef NS_ENUM(NSInteger, ACEOAuth2RACRequestPriority) {
+    ACEOAuth2RACRequestPriorityInteractive,     // the user is waiting for it
+    ACEOAuth2RACRequestPriorityDefault,
+    ACEOAuth2RACRequestPriorityBackground,      // sync and prefetch
+};
+
+/**
+ `ACEOAuth2RACRequest` describes a single call to the server api.
+ It is used by the network manager to run requests in batch.
+ */
+@interface ACEOAuth2RACRequest : NSObject <NSCopying>
+
+/**
+ The HTTP method of the request (`GET`, `HEAD`, `POST`, `PUT`, `PATCH` or `DELETE`).
+ */
+@property (nonatomic, copy) NSString *HTTPMethod;
+
+/**
+ The URL path relative to the apiURLString.
+ */
+@property (nonatomic, copy) NSString *path;
+
+/**
+ The optional compiled route of the request. When it is set, the URL is produced by the route from `routeValues`,
+ and `path` is only used to describe the request.
+ */
+@property (nonatomic, strong, nullable) ACEOAuth2RACRoute *route;
+
+/**
+ The values of the placeholders of `route`.
+ */
+@property (nonatomic, copy, nullable) NSDictionary<NSString *, id> *routeValues;
+
+/**
+ The optional parameters for the request.
+ */
+@property (nonatomic, strong, nullable) id parameters;
+
+/**
+ The optional HTTP headers added to the request, replacing the default ones with the same name.
+ */
+@property (nonatomic, copy, nullable) NSDictionary<NSString *, NSString *> *HTTPHeaders;
+
+/**
+ The optional raw body of the request. When it is set the parameters are not encoded in the body, and the request is never batched.
+ */
+@property (nonatomic, copy, nullable) NSData *HTTPBody;
+
+/**
+ The optional class of the models the response is mapped to, adopting `ACEOAuth2RACModel`.
+ The mapping runs on a concurrent background queue before the response is delivered.
+ 
+ @see `ACEOAuth2RACModelMapper`
+ */
+@property (nonatomic, strong, nullable) Class modelClass;
+
+/**
+ The desired number of retries before giving up. Default is 1.
+ */
+@property (nonatomic, assign) NSInteger retries;
+
+/**
+ The interval between each retry. Default is `ACEDefaultRetryTimeInterval`.
+ */
+@property (nonatomic, assign) NSTimeInterval interval;
+
+/**
+ YES if the request can be packed with others into a single call to the batch endpoint. Default is NO.
+ A request whose parameters can't be written as JSON is always sent on its own.
+ 
+ @see `ACEOAuth2RACManager.batchURLString`
+ */
+@property (nonatomic, assign, getter=isBatchable) BOOL batchable;
+
+/**
+ The priority class of the request. Default is `ACEOAuth2RACRequestPriorityDefault`.
+ */
+@property (nonatomic, assign) ACEOAuth2RACRequestPriority priority;
+
+/**
+ The identifier of the component making the request, used to share the slots fairly between callers.
+ 
+ @see `ACEOAuth2RACRequestQueue.ordering`
+ */
+@property (nonatomic, copy, nullable) NSString *callerIdentifier;
+
+/**
+ The total time budget of the request, covering the authentication, the time in queue, every attempt and every retry interval.
+ When it runs out the signal fails with `ACEOAuth2RACErrorDeadlineExceeded`. Default is 0, which means no deadline.
+ */
+@property (nonatomic, assign) NSTimeInterval deadline;
+
+/**
+ Creates a request with the default number of retries.
+
+ @param method The HTTP method.
+ @param path The URL path relative to the apiURLString.
+ @param parameters The optional parameters for this request.
+
+ @return The newly-created request.
+ */
++ (instancetype)requestWithMethod:(NSString *)method
+                             path:(NSString *)path
+                       parameters:(nullable id)parameters;
+
+/**
+ Creates a request with a fixed number of retries.
+
+ @param method The HTTP method.
+ @param path The URL path relative to the apiURLString.
+ @param parameters The optional parameters for this request.
+ @param retries The desired number of retries before giving up.
+ @param interval The interval between each retry.
+
+ @return The newly-created request.
+ */
++ (instancetype)requestWithMethod:(NSString *)method
+                             path:(NSString *)path
+                       parameters:(nullable id)parameters
+                          retries:(NSInteger)retries
+                         interval:(NSTimeInterval)interval;
+
+/**
+ Creates a request to a compiled route, with the default number of retries.
+
+ @param method The HTTP method.
+ @param route The compiled route.
+ @param values The values of the placeholders of the route.
+ @param parameters The optional parameters for this request.
+
+ @return The newly-created request.
+ */
++ (instancetype)requestWithMethod:(NSString *)method
+                            route:(ACEOAuth2RACRoute *)route
+                           values:(nullable NSDictionary<NSString *, id> *)values
+                       parameters:(nullable id)parameters;
+
+@end
+
+NS_ASSUME_NONNULL_END
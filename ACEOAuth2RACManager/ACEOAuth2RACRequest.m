@@ -0,0 +1,107 @@
+// ACEOAuth2RACRequest.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import "ACEOAuth2RACRequest.h"
+#import "ACEOAuth2RACManager.h"
+#import "ACEOAuth2RACRoute.h"
+
+@implementation ACEOAuth2RACRequest
+
++ (instancetype)requestWithMethod:(NSString *)method
+                             path:(NSString *)path
+                       parameters:(id)parameters
+{
+    return [self requestWithMethod:method path:path parameters:parameters retries:1 interval:ACEDefaultRetryTimeInterval];
+}
+
++ (instancetype)requestWithMethod:(NSString *)method
+                             path:(NSString *)path
+                       parameters:(id)parameters
+                          retries:(NSInteger)retries
+                         interval:(NSTimeInterval)interval
+{
+    ACEOAuth2RACRequest *request = [self new];
+    request.HTTPMethod  = method;
+    request.path        = path;
+    request.parameters  = parameters;
+    request.retries     = retries;
+    request.interval    = interval;
+    return request;
+}
+
++ (instancetype)requestWithMethod:(NSString *)method
+                            route:(ACEOAuth2RACRoute *)route
+                           values:(NSDictionary<NSString *, id> *)values
+                       parameters:(id)parameters
+{
+    ACEOAuth2RACRequest *request = [self requestWithMethod:method path:route.URLTemplate parameters:parameters];
+    request.route       = route;
+    request.routeValues = values;
+    return request;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _HTTPMethod = @"GET";
+        _path       = @"";
+        _retries    = 1;
+        _interval   = ACEDefaultRetryTimeInterval;
+        _priority   = ACEOAuth2RACRequestPriorityDefault;
+    }
+    return self;
+}
+
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    ACEOAuth2RACRequest *request = [[[self class] allocWithZone:zone] init];
+    request.HTTPMethod  = self.HTTPMethod;
+    request.path        = self.path;
+    request.route       = self.route;
+    request.routeValues = self.routeValues;
+    request.parameters  = self.parameters;
+    request.HTTPHeaders = self.HTTPHeaders;
+    request.HTTPBody    = self.HTTPBody;
+    request.modelClass  = self.modelClass;
+    request.retries     = self.retries;
+    request.interval    = self.interval;
+    request.batchable   = self.batchable;
+    request.priority    = self.priority;
+    request.callerIdentifier = self.callerIdentifier;
+    request.deadline    = self.deadline;
+    return request;
+}
+
+
+#pragma mark - Description
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p, %@ %@>", self.class, self, self.HTTPMethod, self.path];
+}
+
+@end
@@ -0,0 +1,68 @@
+// ACEOAuth2RACRequestCoalescer.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import "ReactiveObjC.h"
+
+@class ACEOAuth2RACRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Block in charge of sending a group of requests to the batch endpoint.
+ The returned signal must send a `RACTuple` with the response object and the URL response.
+ `deadline` is the earliest deadline of the requests, nil when none of them has one.
+ */
+typedef RACSignal * _Nonnull (^ACEOAuth2RACRequestCoalescerFlushBlock)(NSArray<ACEOAuth2RACRequest *> *requests, NSDate * _Nullable deadline);
+
+/**
+ `ACEOAuth2RACRequestCoalescer` collects the requests arriving within a time window
+ and sends them to the server as a single batch call.
+ */
+@interface ACEOAuth2RACRequestCoalescer : NSObject
+
+/**
+ The time to wait for more requests before sending the batch.
+ */
+@property (nonatomic, assign) NSTimeInterval window;
+
+/**
+ The maximum number of requests in a single batch. When it is reached the batch is sent immediately.
+ */
+@property (nonatomic, assign) NSUInteger sizeLimit;
+
+- (instancetype)initWithFlushBlock:(ACEOAuth2RACRequestCoalescerFlushBlock)flushBlock;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Add a request to the next batch.
+
+ @param request The request to add.
+ @param deadline The date the request must complete by, the batch call is bounded by the earliest one. Can be nil.
+
+ @return The signal sending a `RACTuple` with the sub-response body and the URL response of the batch call.
+ */
+- (RACSignal *)rac_enqueueRequest:(ACEOAuth2RACRequest *)request deadline:(nullable NSDate *)deadline;
+
+@end
+
+NS_ASSUME_NONNULL_END
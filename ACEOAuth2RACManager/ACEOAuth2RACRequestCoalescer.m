@@ -0,0 +1,185 @@
+// ACEOAuth2RACRequestCoalescer.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import "ACEOAuth2RACRequestCoalescer.h"
+#import "ACEOAuth2RACManager.h"
+#import "ACEOAuth2RACManagerPrivate.h"
+
+@interface ACEOAuth2RACCoalescedRequest : NSObject
+@property (nonatomic, strong) ACEOAuth2RACRequest *request;
+@property (nonatomic, strong) NSDate *deadline;
+@property (nonatomic, strong) id<RACSubscriber> subscriber;
+@end
+
+@implementation ACEOAuth2RACCoalescedRequest
+@end
+
+#pragma mark -
+
+@interface ACEOAuth2RACRequestCoalescer ()
+@property (nonatomic, copy) ACEOAuth2RACRequestCoalescerFlushBlock flushBlock;
+@property (nonatomic, strong) dispatch_queue_t queue;
+
+// pending requests, accessed only on the queue
+@property (nonatomic, strong) NSMutableArray<ACEOAuth2RACCoalescedRequest *> *pendingRequests;
+@property (nonatomic, assign) NSUInteger generation;
+@end
+
+@implementation ACEOAuth2RACRequestCoalescer
+
+- (instancetype)initWithFlushBlock:(ACEOAuth2RACRequestCoalescerFlushBlock)flushBlock
+{
+    self = [super init];
+    if (self) {
+        self.flushBlock         = flushBlock;
+        self.queue              = dispatch_queue_create("com.onemob.network.coalescer", DISPATCH_QUEUE_SERIAL);
+        self.pendingRequests    = [NSMutableArray array];
+
+        self.window             = 0.05;
+        self.sizeLimit          = 20;
+    }
+    return self;
+}
+
+
+#pragma mark - Signals
+
+- (RACSignal *)rac_enqueueRequest:(ACEOAuth2RACRequest *)request deadline:(NSDate *)deadline
+{
+    @weakify(self)
+    return [[RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+
+        ACEOAuth2RACCoalescedRequest *coalescedRequest = [ACEOAuth2RACCoalescedRequest new];
+        coalescedRequest.request    = request;
+        coalescedRequest.deadline   = deadline;
+        coalescedRequest.subscriber = subscriber;
+
+        @strongify(self)
+        dispatch_async(self.queue, ^{
+            [self.pendingRequests addObject:coalescedRequest];
+
+            if (self.pendingRequests.count >= MAX(self.sizeLimit, 1)) {
+                // the batch is full, don't wait for the window
+                [self flush];
+
+            } else if (self.pendingRequests.count == 1) {
+                // first request of a new window
+                NSUInteger generation = self.generation;
+                dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.window * NSEC_PER_SEC)), self.queue, ^{
+                    if (generation == self.generation) {
+                        [self flush];
+                    }
+                });
+            }
+        });
+
+        return [RACDisposable disposableWithBlock:^{
+            @strongify(self)
+            dispatch_async(self.queue, ^{
+                // a request still waiting for its window is never sent
+                [self.pendingRequests removeObjectIdenticalTo:coalescedRequest];
+            });
+        }];
+
+    }] setNameWithFormat:@"[%@] -rac_enqueueRequest: %@ deadline: %@", self.class, request, deadline];
+}
+
+
+#pragma mark - Batch
+
+- (void)flush
+{
+    // start a new window
+    self.generation++;
+
+    NSArray<ACEOAuth2RACCoalescedRequest *> *coalescedRequests = [self.pendingRequests copy];
+    [self.pendingRequests removeAllObjects];
+
+    if (coalescedRequests.count == 0) {
+        return;
+    }
+
+    ACE_LOG_DEBUG(@"Sending %lu requests in batch", (unsigned long)coalescedRequests.count);
+
+    // the batch can't outlive the most urgent of its requests
+    NSDate *deadline;
+    for (ACEOAuth2RACCoalescedRequest *coalescedRequest in coalescedRequests) {
+        if (coalescedRequest.deadline != nil && (deadline == nil || [coalescedRequest.deadline compare:deadline] == NSOrderedAscending)) {
+            deadline = coalescedRequest.deadline;
+        }
+    }
+
+    [self.flushBlock([coalescedRequests valueForKey:@"request"], deadline)
+     subscribeNext:^(RACTuple *response) {
+         [self dispatchResponse:response toRequests:coalescedRequests];
+
+     } error:^(NSError *error) {
+         // the whole batch failed
+         for (ACEOAuth2RACCoalescedRequest *coalescedRequest in coalescedRequests) {
+             [coalescedRequest.subscriber sendError:error];
+         }
+     }];
+}
+
+- (void)dispatchResponse:(RACTuple *)response toRequests:(NSArray<ACEOAuth2RACCoalescedRequest *> *)coalescedRequests
+{
+    // the sub-responses come in the same order of the requests
+    id responseObject = [response first];
+    NSArray *subResponses = [responseObject isKindOfClass:[NSDictionary class]] ? responseObject[@"responses"] : responseObject;
+    if (![subResponses isKindOfClass:[NSArray class]]) {
+        subResponses = nil;
+    }
+
+    [coalescedRequests enumerateObjectsUsingBlock:^(ACEOAuth2RACCoalescedRequest *coalescedRequest, NSUInteger idx, BOOL *stop) {
+
+        NSDictionary *subResponse = (idx < subResponses.count) ? subResponses[idx] : nil;
+        if (![subResponse isKindOfClass:[NSDictionary class]]) {
+            [coalescedRequest.subscriber sendError:[NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                                                                       code:ACEOAuth2RACErrorBadBatchResponse
+                                                                   userInfo:@{
+                                                                              NSLocalizedDescriptionKey: @"Missing response in the batch"
+                                                                              }]];
+            return;
+        }
+
+        NSInteger statusCode = [subResponse[@"status"] integerValue];
+        id body = [subResponse[@"body"] isEqual:[NSNull null]] ? nil : subResponse[@"body"];
+
+        if (statusCode >= 200 && statusCode < 300) {
+            [coalescedRequest.subscriber sendNext:RACTuplePack(body, [response second])];
+            [coalescedRequest.subscriber sendCompleted];
+
+        } else {
+            NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+            userInfo[NSLocalizedDescriptionKey]             = [NSHTTPURLResponse localizedStringForStatusCode:statusCode];
+            userInfo[ACEOAuth2RACStatusCodeErrorKey]        = @(statusCode);
+            userInfo[ACEOAuth2RACResponseObjectErrorKey]    = body;
+
+            [coalescedRequest.subscriber sendError:[NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                                                                       code:ACEOAuth2RACErrorBatchRequestFailed
+                                                                   userInfo:userInfo]];
+        }
+    }];
+}
+
+@end
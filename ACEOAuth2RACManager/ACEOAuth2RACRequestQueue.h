@@ -0,0 +1,152 @@
+// ACEOAuth2RACRequestQueue.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import "ReactiveObjC.h"
+
+#import "ACEOAuth2RACRequest.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Map a request priority class to the corresponding `NSURLSessionTask` priority.
+ */
+extern float ACEOAuth2RACTaskPriorityForRequestPriority(ACEOAuth2RACRequestPriority priority);
+
+/**
+ How the queued requests of the same priority class are ordered.
+ */
+typedef NS_ENUM(NSInteger, ACEOAuth2RACRequestQueueOrdering) {
+    ACEOAuth2RACRequestQueueOrderingFIFO,           // first come, first served
+    ACEOAuth2RACRequestQueueOrderingWeightedFair,   // callers share the slots according to their weight
+};
+
+/**
+ `ACEOAuth2RACRequestQueue` controls the admission of the requests to the network session.
+
+ Each priority class has its own concurrency limit, and when a slot is released
+ the queued interactive requests are always started before the default and background ones.
+ The requests to the same host are limited as well, so a burst of calls never floods the session.
+ */
+@interface ACEOAuth2RACRequestQueue : NSObject
+
+/**
+ The ordering of the requests within a priority class. Default is `ACEOAuth2RACRequestQueueOrderingFIFO`.
+ */
+@property (nonatomic, assign) ACEOAuth2RACRequestQueueOrdering ordering;
+
+/**
+ The maximum number of requests to the same host running at the same time. Default is 4, 0 means no limit.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrentRequestsPerHost;
+
+/**
+ The number of requests waiting for a slot. It is KVO compliant, the notifications are sent on a private queue
+ where the other metrics and limits can be read.
+ */
+@property (nonatomic, assign, readonly) NSUInteger pendingRequestCount;
+
+/**
+ The number of requests running. It is KVO compliant, the notifications are sent on a private queue
+ where the other metrics and limits can be read.
+ */
+@property (nonatomic, assign, readonly) NSUInteger runningRequestCount;
+
+/**
+ The maximum number of requests running at the same time, regardless of their priority. Default is 8, 0 means no limit.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrentRequests;
+
+/**
+ Return the maximum number of requests of a priority class running at the same time.
+ The defaults are 8 for interactive, 6 for default and 2 for background requests.
+
+ @param priority The priority class.
+
+ @return The concurrency limit, 0 means no limit.
+ */
+- (NSUInteger)maxConcurrentRequestsForPriority:(ACEOAuth2RACRequestPriority)priority;
+
+/**
+ Set the maximum number of requests of a priority class running at the same time.
+
+ @param maxConcurrentRequests The concurrency limit, 0 means no limit.
+ @param priority The priority class.
+ */
+- (void)setMaxConcurrentRequests:(NSUInteger)maxConcurrentRequests forPriority:(ACEOAuth2RACRequestPriority)priority;
+
+/**
+ Set the share of the slots given to a caller when the ordering is `ACEOAuth2RACRequestQueueOrderingWeightedFair`.
+
+ @param weight The weight of the caller, default is 1.
+ @param caller The identifier of the caller.
+ */
+- (void)setWeight:(NSUInteger)weight forCaller:(NSString *)caller;
+
+/**
+ Return the number of requests of a priority class waiting for a slot.
+
+ @param priority The priority class.
+
+ @return The depth of the queue for that class.
+ */
+- (NSUInteger)pendingRequestCountForPriority:(ACEOAuth2RACRequestPriority)priority;
+
+/**
+ Return the number of requests to a host waiting for a slot.
+
+ @param host The host of the requests.
+
+ @return The depth of the queue for that host.
+ */
+- (NSUInteger)pendingRequestCountForHost:(NSString *)host;
+
+/**
+ Return a signal that subscribes to `signal` only when the queue admits it.
+ Disposing the returned signal while it is waiting removes it from the queue.
+
+ @param signal The signal executing the request.
+ @param priority The priority class of the request.
+
+ @return The signal forwarding the events of `signal`.
+ */
+- (RACSignal *)rac_enqueueSignal:(RACSignal *)signal priority:(ACEOAuth2RACRequestPriority)priority;
+
+/**
+ Return a signal that subscribes to `signal` only when the queue admits it.
+ Disposing the returned signal while it is waiting removes it from the queue.
+
+ @param signal The signal executing the request.
+ @param priority The priority class of the request.
+ @param host The host of the request, nil to skip the per-host limit.
+ @param caller The identifier of the caller, used for the weighted fair ordering.
+
+ @return The signal forwarding the events of `signal`.
+ */
+- (RACSignal *)rac_enqueueSignal:(RACSignal *)signal
+                        priority:(ACEOAuth2RACRequestPriority)priority
+                            host:(nullable NSString *)host
+                          caller:(nullable NSString *)caller;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,411 @@
+// ACEOAuth2RACRequestQueue.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import "ACEOAuth2RACRequestQueue.h"
+
+#define ACE_REQUEST_PRIORITY_COUNT  (ACEOAuth2RACRequestPriorityBackground + 1)
+
+float ACEOAuth2RACTaskPriorityForRequestPriority(ACEOAuth2RACRequestPriority priority)
+{
+    switch (priority) {
+        case ACEOAuth2RACRequestPriorityInteractive:
+            return NSURLSessionTaskPriorityHigh;
+
+        case ACEOAuth2RACRequestPriorityBackground:
+            return NSURLSessionTaskPriorityLow;
+
+        default:
+            return NSURLSessionTaskPriorityDefault;
+    }
+}
+
+typedef NS_ENUM(NSInteger, ACEOAuth2RACQueuedRequestState) {
+    ACEOAuth2RACQueuedRequestStatePending,
+    ACEOAuth2RACQueuedRequestStateRunning,
+    ACEOAuth2RACQueuedRequestStateFinished,
+};
+
+@interface ACEOAuth2RACQueuedRequest : NSObject
+@property (nonatomic, strong) RACSignal *signal;
+@property (nonatomic, strong) id<RACSubscriber> subscriber;
+@property (nonatomic, strong) RACSerialDisposable *disposable;
+@property (nonatomic, assign) ACEOAuth2RACRequestPriority priority;
+@property (nonatomic, assign) ACEOAuth2RACQueuedRequestState state;
+@property (nonatomic, copy)   NSString *host;
+@property (nonatomic, copy)   NSString *caller;
+
+// position in the queue, the lowest tag runs first
+@property (nonatomic, assign) double tag;
+@end
+
+@implementation ACEOAuth2RACQueuedRequest
+@end
+
+#pragma mark -
+
+@interface ACEOAuth2RACRequestQueue ()
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, strong) RACScheduler *subscriptionScheduler;
+
+// state changed only on the queue, the parts read by the getters are guarded by the lock of self
+@property (nonatomic, strong) NSArray<NSMutableArray<ACEOAuth2RACQueuedRequest *> *> *pendingRequests;
+@property (nonatomic, strong) NSCountedSet<NSString *> *pendingHosts;
+@property (nonatomic, strong) NSCountedSet<NSString *> *runningHosts;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *callerWeights;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *callerTags;
+@property (nonatomic, assign) double virtualTime;
+@property (nonatomic, assign) NSUInteger sequence;
+
+@property (nonatomic, assign, readwrite) NSUInteger pendingRequestCount;
+@property (nonatomic, assign, readwrite) NSUInteger runningRequestCount;
+@end
+
+@implementation ACEOAuth2RACRequestQueue {
+    NSUInteger _maxConcurrentRequests;
+    NSUInteger _maxConcurrentRequestsPerPriority[ACE_REQUEST_PRIORITY_COUNT];
+    NSUInteger _maxConcurrentRequestsPerHost;
+    ACEOAuth2RACRequestQueueOrdering _ordering;
+
+    NSUInteger _runningRequestsPerPriority[ACE_REQUEST_PRIORITY_COUNT];
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self.queue = dispatch_queue_create("com.onemob.network.requests", DISPATCH_QUEUE_SERIAL);
+        self.subscriptionScheduler = [RACScheduler schedulerWithPriority:RACSchedulerPriorityDefault name:@"com.onemob.network.requests.subscription"];
+
+        NSMutableArray *pendingRequests = [NSMutableArray arrayWithCapacity:ACE_REQUEST_PRIORITY_COUNT];
+        for (NSInteger priority = 0; priority < ACE_REQUEST_PRIORITY_COUNT; priority++) {
+            [pendingRequests addObject:[NSMutableArray array]];
+        }
+        self.pendingRequests    = pendingRequests;
+        self.pendingHosts       = [NSCountedSet set];
+        self.runningHosts       = [NSCountedSet set];
+        self.callerWeights      = [NSMutableDictionary dictionary];
+        self.callerTags         = [NSMutableDictionary dictionary];
+
+        _maxConcurrentRequests          = 8;
+        _maxConcurrentRequestsPerHost   = 4;
+        _maxConcurrentRequestsPerPriority[ACEOAuth2RACRequestPriorityInteractive]   = 8;
+        _maxConcurrentRequestsPerPriority[ACEOAuth2RACRequestPriorityDefault]       = 6;
+        _maxConcurrentRequestsPerPriority[ACEOAuth2RACRequestPriorityBackground]    = 2;
+    }
+    return self;
+}
+
+
+#pragma mark - Limits
+
+- (NSUInteger)maxConcurrentRequests
+{
+    @synchronized (self) {
+        return _maxConcurrentRequests;
+    }
+}
+
+- (void)setMaxConcurrentRequests:(NSUInteger)maxConcurrentRequests
+{
+    dispatch_async(self.queue, ^{
+        @synchronized (self) {
+            self->_maxConcurrentRequests = maxConcurrentRequests;
+        }
+
+        // the limit could be higher now
+        [self startPendingRequests];
+    });
+}
+
+- (NSUInteger)maxConcurrentRequestsPerHost
+{
+    @synchronized (self) {
+        return _maxConcurrentRequestsPerHost;
+    }
+}
+
+- (void)setMaxConcurrentRequestsPerHost:(NSUInteger)maxConcurrentRequests
+{
+    dispatch_async(self.queue, ^{
+        @synchronized (self) {
+            self->_maxConcurrentRequestsPerHost = maxConcurrentRequests;
+        }
+
+        // the limit could be higher now
+        [self startPendingRequests];
+    });
+}
+
+- (NSUInteger)maxConcurrentRequestsForPriority:(ACEOAuth2RACRequestPriority)priority
+{
+    NSParameterAssert(priority >= 0 && priority < ACE_REQUEST_PRIORITY_COUNT);
+
+    @synchronized (self) {
+        return _maxConcurrentRequestsPerPriority[priority];
+    }
+}
+
+- (void)setMaxConcurrentRequests:(NSUInteger)maxConcurrentRequests forPriority:(ACEOAuth2RACRequestPriority)priority
+{
+    NSParameterAssert(priority >= 0 && priority < ACE_REQUEST_PRIORITY_COUNT);
+
+    dispatch_async(self.queue, ^{
+        @synchronized (self) {
+            self->_maxConcurrentRequestsPerPriority[priority] = maxConcurrentRequests;
+        }
+
+        // the limit could be higher now
+        [self startPendingRequests];
+    });
+}
+
+
+#pragma mark - Ordering
+
+- (ACEOAuth2RACRequestQueueOrdering)ordering
+{
+    @synchronized (self) {
+        return _ordering;
+    }
+}
+
+- (void)setOrdering:(ACEOAuth2RACRequestQueueOrdering)ordering
+{
+    dispatch_async(self.queue, ^{
+        @synchronized (self) {
+            self->_ordering = ordering;
+        }
+    });
+}
+
+- (void)setWeight:(NSUInteger)weight forCaller:(NSString *)caller
+{
+    dispatch_async(self.queue, ^{
+        self.callerWeights[caller] = @(MAX(weight, 1));
+    });
+}
+
+- (double)tagForCaller:(NSString *)caller
+{
+    if (_ordering == ACEOAuth2RACRequestQueueOrderingFIFO) {
+        return (double)self.sequence++;
+    }
+
+    // start-time fair queueing: each caller advances its own clock by the inverse of its weight,
+    // so a caller with weight 2 gets twice the slots of a caller with weight 1
+    NSString *key   = caller ?: @"";
+    double weight   = MAX([self.callerWeights[key] doubleValue], 1.0);
+    double tag      = MAX([self.callerTags[key] doubleValue], self.virtualTime) + 1.0 / weight;
+
+    self.callerTags[key] = @(tag);
+    return tag;
+}
+
+
+#pragma mark - Metrics
+
+- (NSUInteger)pendingRequestCountForPriority:(ACEOAuth2RACRequestPriority)priority
+{
+    NSParameterAssert(priority >= 0 && priority < ACE_REQUEST_PRIORITY_COUNT);
+
+    @synchronized (self) {
+        return self.pendingRequests[priority].count;
+    }
+}
+
+- (NSUInteger)pendingRequestCountForHost:(NSString *)host
+{
+    @synchronized (self) {
+        return [self.pendingHosts countForObject:host];
+    }
+}
+
+
+#pragma mark - Signals
+
+- (RACSignal *)rac_enqueueSignal:(RACSignal *)signal priority:(ACEOAuth2RACRequestPriority)priority
+{
+    return [self rac_enqueueSignal:signal priority:priority host:nil caller:nil];
+}
+
+- (RACSignal *)rac_enqueueSignal:(RACSignal *)signal
+                        priority:(ACEOAuth2RACRequestPriority)priority
+                            host:(NSString *)host
+                          caller:(NSString *)caller
+{
+    NSParameterAssert(priority >= 0 && priority < ACE_REQUEST_PRIORITY_COUNT);
+
+    return [[RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+
+        ACEOAuth2RACQueuedRequest *queuedRequest = [ACEOAuth2RACQueuedRequest new];
+        queuedRequest.signal        = signal;
+        queuedRequest.subscriber    = subscriber;
+        queuedRequest.priority      = priority;
+        queuedRequest.host          = host;
+        queuedRequest.caller        = caller;
+        queuedRequest.disposable    = [RACSerialDisposable new];
+
+        dispatch_async(self.queue, ^{
+            queuedRequest.tag = [self tagForCaller:caller];
+
+            @synchronized (self) {
+                [self.pendingRequests[priority] addObject:queuedRequest];
+                if (host != nil) {
+                    [self.pendingHosts addObject:host];
+                }
+            }
+            self.pendingRequestCount++;
+
+            [self startPendingRequests];
+        });
+
+        return [RACDisposable disposableWithBlock:^{
+            dispatch_async(self.queue, ^{
+                switch (queuedRequest.state) {
+                    case ACEOAuth2RACQueuedRequestStatePending:
+                        // never started, just forget about it
+                        [self removePendingRequest:queuedRequest];
+                        queuedRequest.state = ACEOAuth2RACQueuedRequestStateFinished;
+                        break;
+
+                    case ACEOAuth2RACQueuedRequestStateRunning:
+                        [queuedRequest.disposable dispose];
+                        [self finishRequest:queuedRequest];
+                        break;
+
+                    default:
+                        break;
+                }
+            });
+        }];
+
+    }] setNameWithFormat:@"[%@] -rac_enqueueSignal: %@ priority: %ld host: %@ caller: %@",
+            self.class, signal.name, (long)priority, host, caller];
+}
+
+
+#pragma mark - Scheduling
+
+- (BOOL)canStartRequestWithPriority:(ACEOAuth2RACRequestPriority)priority
+{
+    NSUInteger maxConcurrentRequests = _maxConcurrentRequestsPerPriority[priority];
+
+    return (_maxConcurrentRequests == 0 || self.runningRequestCount < _maxConcurrentRequests) &&
+           (maxConcurrentRequests == 0 || _runningRequestsPerPriority[priority] < maxConcurrentRequests);
+}
+
+- (BOOL)canStartRequestToHost:(NSString *)host
+{
+    return host == nil || _maxConcurrentRequestsPerHost == 0 || [self.runningHosts countForObject:host] < _maxConcurrentRequestsPerHost;
+}
+
+- (ACEOAuth2RACQueuedRequest *)nextPendingRequestWithPriority:(ACEOAuth2RACRequestPriority)priority
+{
+    // a busy host doesn't block the requests to the other ones
+    ACEOAuth2RACQueuedRequest *nextRequest;
+    for (ACEOAuth2RACQueuedRequest *queuedRequest in self.pendingRequests[priority]) {
+        if ((nextRequest == nil || queuedRequest.tag < nextRequest.tag) && [self canStartRequestToHost:queuedRequest.host]) {
+            nextRequest = queuedRequest;
+        }
+    }
+    return nextRequest;
+}
+
+- (void)removePendingRequest:(ACEOAuth2RACQueuedRequest *)queuedRequest
+{
+    @synchronized (self) {
+        [self.pendingRequests[queuedRequest.priority] removeObjectIdenticalTo:queuedRequest];
+        if (queuedRequest.host != nil) {
+            [self.pendingHosts removeObject:queuedRequest.host];
+        }
+    }
+    self.pendingRequestCount--;
+}
+
+- (void)startPendingRequests
+{
+    // the classes are sorted by priority, the lower ones only get the slots left
+    for (NSInteger priority = 0; priority < ACE_REQUEST_PRIORITY_COUNT; priority++) {
+        while ([self canStartRequestWithPriority:priority]) {
+            ACEOAuth2RACQueuedRequest *queuedRequest = [self nextPendingRequestWithPriority:priority];
+            if (queuedRequest == nil) {
+                break;
+            }
+
+            [self removePendingRequest:queuedRequest];
+            [self startRequest:queuedRequest];
+        }
+    }
+}
+
+- (void)startRequest:(ACEOAuth2RACQueuedRequest *)queuedRequest
+{
+    queuedRequest.state = ACEOAuth2RACQueuedRequestStateRunning;
+
+    self.virtualTime = MAX(self.virtualTime, queuedRequest.tag);
+    self.runningRequestCount++;
+    _runningRequestsPerPriority[queuedRequest.priority]++;
+    if (queuedRequest.host != nil) {
+        [self.runningHosts addObject:queuedRequest.host];
+    }
+
+    // a synchronous signal must not run the callbacks of the subscriber on the queue
+    [self.subscriptionScheduler schedule:^{
+        queuedRequest.disposable.disposable =
+        [queuedRequest.signal subscribeNext:^(id x) {
+            [queuedRequest.subscriber sendNext:x];
+
+        } error:^(NSError *error) {
+            dispatch_async(self.queue, ^{
+                [self finishRequest:queuedRequest];
+            });
+            [queuedRequest.subscriber sendError:error];
+
+        } completed:^{
+            dispatch_async(self.queue, ^{
+                [self finishRequest:queuedRequest];
+            });
+            [queuedRequest.subscriber sendCompleted];
+        }];
+    }];
+}
+
+- (void)finishRequest:(ACEOAuth2RACQueuedRequest *)queuedRequest
+{
+    if (queuedRequest.state != ACEOAuth2RACQueuedRequestStateRunning) {
+        return;
+    }
+
+    queuedRequest.state = ACEOAuth2RACQueuedRequestStateFinished;
+
+    self.runningRequestCount--;
+    _runningRequestsPerPriority[queuedRequest.priority]--;
+    if (queuedRequest.host != nil) {
+        [self.runningHosts removeObject:queuedRequest.host];
+    }
+
+    // release the slot
+    [self startPendingRequests];
+}
+
+@end
@@ -0,0 +1,93 @@
+// ACEOAuth2RACResponseSerializer.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "AFURLResponseSerialization.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `ACEOAuth2RACResponseSerializer` picks the serializer of each response from its content type,
+ or from its URL when a serializer is registered for it.
+
+ Unlike `AFCompoundResponseSerializer`, which tries the serializers in order, the lookup is a single
+ dictionary access. The responses of an unregistered content type, or without a body, go to the default serializer.
+ */
+@interface ACEOAuth2RACResponseSerializer : AFHTTPResponseSerializer
+
+/**
+ The serializer used when the content type is not registered.
+ */
+@property (nonatomic, strong, readonly) AFHTTPResponseSerializer *defaultSerializer;
+
+/**
+ The registered content types, in order of preference, followed by the ones of the default serializer.
+ */
+@property (nonatomic, strong, readonly) NSArray<NSString *> *contentTypes;
+
+/**
+ The value of the `Accept` header advertising the content types, with decreasing quality values.
+ */
+@property (nonatomic, strong, readonly) NSString *acceptHeaderValue;
+
+- (instancetype)initWithDefaultSerializer:(AFHTTPResponseSerializer *)defaultSerializer;
+
+/**
+ Register the serializer of a content type, replacing the previous one.
+ The content types registered first are preferred.
+
+ @param serializer The serializer, nil to remove the registration.
+ @param contentType The MIME type of the responses, like `application/msgpack`.
+ */
+- (void)setSerializer:(nullable AFHTTPResponseSerializer *)serializer forContentType:(NSString *)contentType;
+
+/**
+ Return the serializer decoding the responses of a content type.
+
+ @param contentType The MIME type of the responses.
+
+ @return The registered serializer, or the default one.
+ */
+- (AFHTTPResponseSerializer *)serializerForContentType:(nullable NSString *)contentType;
+
+/**
+ Register the serializer of the responses from a URL, whatever their content type.
+ Used to decode the responses of another manager sharing the same session.
+
+ @param serializer The serializer, nil to remove the registration.
+ @param URL The URL of the responses.
+ */
+- (void)setSerializer:(nullable AFHTTPResponseSerializer *)serializer forURL:(NSURL *)URL;
+
+/**
+ Return the serializer registered for the responses from a URL.
+
+ @param URL The URL of the responses.
+
+ @return The registered serializer, or nil.
+ */
+- (nullable AFHTTPResponseSerializer *)serializerForURL:(nullable NSURL *)URL;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,148 @@
+// ACEOAuth2RACResponseSerializer.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACResponseSerializer.h"
+
+@interface ACEOAuth2RACResponseSerializer ()
+@property (nonatomic, strong, readwrite) AFHTTPResponseSerializer *defaultSerializer;
+
+// replaced as a whole, the responses are serialized on the session queues
+@property (atomic, copy) NSDictionary<NSString *, AFHTTPResponseSerializer *> *serializers;
+@property (atomic, copy) NSArray<NSString *> *registeredContentTypes;
+@property (atomic, copy) NSDictionary<NSString *, AFHTTPResponseSerializer *> *URLSerializers;
+@end
+
+@implementation ACEOAuth2RACResponseSerializer
+
+- (instancetype)initWithDefaultSerializer:(AFHTTPResponseSerializer *)defaultSerializer
+{
+    self = [super init];
+    if (self) {
+        self.defaultSerializer      = defaultSerializer;
+        self.serializers            = @{};
+        self.registeredContentTypes = @[];
+        self.URLSerializers         = @{};
+    }
+    return self;
+}
+
+- (instancetype)init
+{
+    return [self initWithDefaultSerializer:[AFJSONResponseSerializer serializer]];
+}
+
+
+#pragma mark - Registry
+
+- (void)setSerializer:(AFHTTPResponseSerializer *)serializer forContentType:(NSString *)contentType
+{
+    @synchronized (self) {
+        NSString *key = [contentType lowercaseString];
+        
+        NSMutableDictionary *serializers    = [self.serializers mutableCopy];
+        NSMutableArray *contentTypes        = [self.registeredContentTypes mutableCopy];
+        
+        serializers[key] = serializer;
+        [contentTypes removeObject:key];
+        if (serializer != nil) {
+            [contentTypes addObject:key];
+        }
+        
+        self.serializers            = serializers;
+        self.registeredContentTypes = contentTypes;
+    }
+}
+
+- (AFHTTPResponseSerializer *)serializerForContentType:(NSString *)contentType
+{
+    AFHTTPResponseSerializer *serializer = contentType ? self.serializers[[contentType lowercaseString]] : nil;
+    return serializer ?: self.defaultSerializer;
+}
+
+- (void)setSerializer:(AFHTTPResponseSerializer *)serializer forURL:(NSURL *)URL
+{
+    @synchronized (self) {
+        NSMutableDictionary *serializers = [self.URLSerializers mutableCopy];
+        serializers[URL.absoluteString] = serializer;
+        self.URLSerializers = serializers;
+    }
+}
+
+- (AFHTTPResponseSerializer *)serializerForURL:(NSURL *)URL
+{
+    NSDictionary<NSString *, AFHTTPResponseSerializer *> *serializers = self.URLSerializers;
+    return (serializers.count > 0 && URL != nil) ? serializers[URL.absoluteString] : nil;
+}
+
+- (NSArray<NSString *> *)contentTypes
+{
+    NSMutableArray *contentTypes = [self.registeredContentTypes mutableCopy];
+    for (NSString *contentType in [self.defaultSerializer.acceptableContentTypes.allObjects sortedArrayUsingSelector:@selector(compare:)]) {
+        if (![contentTypes containsObject:contentType]) {
+            [contentTypes addObject:contentType];
+        }
+    }
+    return contentTypes;
+}
+
+- (NSString *)acceptHeaderValue
+{
+    NSArray<NSString *> *contentTypes = self.contentTypes;
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:contentTypes.count];
+    
+    [contentTypes enumerateObjectsUsingBlock:^(NSString *contentType, NSUInteger idx, BOOL *stop) {
+        // the first one has the implicit quality of 1
+        float quality = MAX(1.0f - idx * 0.1f, 0.1f);
+        [values addObject:idx == 0 ? contentType : [NSString stringWithFormat:@"%@;q=%.1f", contentType, quality]];
+    }];
+    return [values componentsJoinedByString:@", "];
+}
+
+- (NSSet<NSString *> *)acceptableContentTypes
+{
+    return [NSSet setWithArray:self.contentTypes];
+}
+
+
+#pragma mark - AFURLResponseSerialization
+
+- (id)responseObjectForResponse:(NSURLResponse *)response data:(NSData *)data error:(NSError *__autoreleasing *)error
+{
+    AFHTTPResponseSerializer *serializer = [self serializerForURL:response.URL] ?: [self serializerForContentType:response.MIMEType];
+    return [serializer responseObjectForResponse:response data:data error:error];
+}
+
+
+#pragma mark - NSCopying
+
+- (instancetype)copyWithZone:(NSZone *)zone
+{
+    ACEOAuth2RACResponseSerializer *serializer = [[[self class] allocWithZone:zone] initWithDefaultSerializer:[self.defaultSerializer copyWithZone:zone]];
+    serializer.serializers              = self.serializers;
+    serializer.registeredContentTypes   = self.registeredContentTypes;
+    serializer.URLSerializers           = self.URLSerializers;
+    return serializer;
+}
+
+@end
@@ -0,0 +1,100 @@
+// ACEOAuth2RACRoute.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The key of the `NSURLProtocol` property holding the identifier of the route of a request.
+ */
+extern NSString * const ACEOAuth2RACRouteIdentifierKey;
+
+/**
+ `ACEOAuth2RACRoute` is a URL template like `users/{id}/posts`, compiled once against the base URL.
+
+ The values are percent-encoded as path segments, or as query values after the `?` of the template,
+ while they are copied into a single UTF-8 buffer, and the final `NSURL` is created from those bytes, without resolving a relative string each time.
+ The identifier of the route is the same for every URL it produces, so it can key the metrics and the caches.
+ */
+@interface ACEOAuth2RACRoute : NSObject
+
+/**
+ The identifier of the route, the name given at registration or the template itself.
+ */
+@property (nonatomic, copy, readonly) NSString *identifier;
+
+/**
+ The template of the route.
+ */
+@property (nonatomic, copy, readonly) NSString *URLTemplate;
+
+/**
+ The names of the placeholders, in order of appearance.
+ */
+@property (nonatomic, copy, readonly) NSArray<NSString *> *placeholders;
+
+/**
+ Compile a template.
+
+ @param URLTemplate The template, with placeholders between braces. Relative templates are resolved against `baseURL`
+ like `+[NSURL URLWithString:relativeToURL:]` does, without support for the dot segments.
+ @param identifier The identifier of the route, nil to use the template.
+ @param baseURL The base URL of the relative templates.
+
+ @return The compiled route.
+ */
+- (instancetype)initWithURLTemplate:(NSString *)URLTemplate identifier:(nullable NSString *)identifier baseURL:(nullable NSURL *)baseURL;
+
+/**
+ Return the URL with the placeholders replaced by `values`.
+
+ @param values The values of the placeholders, strings or numbers.
+ @param error The error if a value is missing.
+
+ @return The absolute URL, nil if a value is missing.
+ */
+- (nullable NSURL *)URLWithValues:(nullable NSDictionary<NSString *, id> *)values error:(NSError * _Nullable __autoreleasing * _Nullable)error;
+
+/**
+ Return the path with the placeholders replaced by `values`, relative to the base URL.
+
+ @param values The values of the placeholders, strings or numbers.
+
+ @return The relative path, nil if a value is missing.
+ */
+- (nullable NSString *)pathWithValues:(nullable NSDictionary<NSString *, id> *)values;
+
+/**
+ Return the identifier of the route that produced a request.
+
+ @param request The request.
+
+ @return The identifier of the route, nil if the request doesn't come from a route.
+ */
++ (nullable NSString *)identifierForURLRequest:(NSURLRequest *)request;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,251 @@
+// ACEOAuth2RACRoute.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACRoute.h"
+#import "ACEOAuth2RACManager.h"
+
+NSString * const ACEOAuth2RACRouteIdentifierKey = @"ACEOAuth2RACRouteIdentifier";
+
+// the characters left as they are in a path segment (RFC 3986 pchar), in a query value, and in the literal parts of a template
+static BOOL ACEOAuth2RACRouteSegmentCharacters[256];
+static BOOL ACEOAuth2RACRouteQueryCharacters[256];
+static BOOL ACEOAuth2RACRouteLiteralCharacters[256];
+
+static void ACEOAuth2RACRouteSetupCharacters(void)
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        const char *segment = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-._~!$&'()*+,;=:@";
+        for (const char *c = segment; *c != '\0'; c++) {
+            ACEOAuth2RACRouteSegmentCharacters[(uint8_t)*c] = YES;
+            ACEOAuth2RACRouteLiteralCharacters[(uint8_t)*c] = YES;
+        }
+        
+        // same as the query encoder, `&`, `=` and `+` would split or change the value
+        const char *query = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-._~/?";
+        for (const char *c = query; *c != '\0'; c++) {
+            ACEOAuth2RACRouteQueryCharacters[(uint8_t)*c] = YES;
+        }
+        
+        // the literal parts can hold several segments, a query, and escapes already
+        ACEOAuth2RACRouteLiteralCharacters['/'] = YES;
+        ACEOAuth2RACRouteLiteralCharacters['?'] = YES;
+        ACEOAuth2RACRouteLiteralCharacters['%'] = YES;
+    });
+}
+
+// append `length` bytes percent-encoding the ones not in `characters`, return the end of the output
+static uint8_t *ACEOAuth2RACRouteAppendEncoded(uint8_t *output, const uint8_t *bytes, NSUInteger length, const BOOL *characters)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t c = bytes[i];
+        if (characters[c]) {
+            *output++ = c;
+            
+        } else {
+            *output++ = '%';
+            *output++ = hex[c >> 4];
+            *output++ = hex[c & 0x0f];
+        }
+    }
+    return output;
+}
+
+static NSData *ACEOAuth2RACRouteEncodedData(NSString *string, const BOOL *characters)
+{
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *encodedData = [NSMutableData dataWithLength:data.length * 3];
+    
+    uint8_t *end = ACEOAuth2RACRouteAppendEncoded(encodedData.mutableBytes, data.bytes, data.length, characters);
+    encodedData.length = end - (uint8_t *)encodedData.mutableBytes;
+    return encodedData;
+}
+
+@interface ACEOAuth2RACRoute ()
+@property (nonatomic, copy) NSString *identifier;
+@property (nonatomic, copy) NSString *URLTemplate;
+@property (nonatomic, copy) NSArray<NSString *> *placeholders;
+
+// the placeholders following the `?` of the template
+@property (nonatomic, copy) NSIndexSet *queryPlaceholderIndexes;
+
+// the scheme, the host and the directory of the base URL the template is resolved against
+@property (nonatomic, strong) NSData *prefix;
+
+// the encoded parts of the template around the placeholders, one more than the placeholders
+@property (nonatomic, copy) NSArray<NSData *> *literals;
+@property (nonatomic, assign) NSUInteger literalsLength;
+@end
+
+@implementation ACEOAuth2RACRoute
+
+- (instancetype)initWithURLTemplate:(NSString *)URLTemplate identifier:(NSString *)identifier baseURL:(NSURL *)baseURL
+{
+    self = [super init];
+    if (self) {
+        ACEOAuth2RACRouteSetupCharacters();
+        
+        self.URLTemplate    = URLTemplate;
+        self.identifier     = identifier ?: URLTemplate;
+        
+        NSMutableArray *placeholders            = [NSMutableArray array];
+        NSMutableArray *literals                = [NSMutableArray array];
+        NSMutableIndexSet *queryPlaceholders    = [NSMutableIndexSet indexSet];
+        BOOL inQuery                            = NO;
+        
+        NSScanner *scanner = [NSScanner scannerWithString:URLTemplate];
+        scanner.charactersToBeSkipped = nil;
+        
+        while (YES) {
+            NSString *literal = @"";
+            [scanner scanUpToString:@"{" intoString:&literal];
+            [literals addObject:ACEOAuth2RACRouteEncodedData(literal, ACEOAuth2RACRouteLiteralCharacters)];
+            self.literalsLength += [literals.lastObject length];
+            inQuery = inQuery || [literal rangeOfString:@"?"].location != NSNotFound;
+            
+            NSString *placeholder;
+            if (![scanner scanString:@"{" intoString:NULL] ||
+                ![scanner scanUpToString:@"}" intoString:&placeholder] ||
+                ![scanner scanString:@"}" intoString:NULL]) {
+                break;
+            }
+            if (inQuery) {
+                [queryPlaceholders addIndex:placeholders.count];
+            }
+            [placeholders addObject:placeholder];
+        }
+        
+        NSAssert(scanner.isAtEnd, @"Invalid route template %@", URLTemplate);
+        
+        self.placeholders               = placeholders;
+        self.queryPlaceholderIndexes    = queryPlaceholders;
+        self.literals                   = literals;
+        
+        // resolve the template once, like +[NSURL URLWithString:relativeToURL:] would do
+        NSString *prefix = @"";
+        if (baseURL != nil && [URLTemplate rangeOfString:@"://"].location == NSNotFound) {
+            prefix = [[NSURL URLWithString:[URLTemplate hasPrefix:@"/"] ? @"/" : @"." relativeToURL:baseURL] absoluteString];
+            
+            // the template brings its own slash
+            if ([URLTemplate hasPrefix:@"/"]) {
+                prefix = [prefix substringToIndex:prefix.length - 1];
+            }
+        }
+        self.prefix = [prefix dataUsingEncoding:NSUTF8StringEncoding];
+    }
+    return self;
+}
+
+
+#pragma mark - Expansion
+
+- (NSMutableData *)dataWithValues:(NSDictionary<NSString *, id> *)values prefix:(BOOL)prefix missingPlaceholder:(NSString **)missingPlaceholder
+{
+    NSUInteger capacity = self.literalsLength + (prefix ? self.prefix.length : 0);
+    NSMutableData *data = [NSMutableData dataWithLength:capacity + 64];
+    
+    uint8_t *output = data.mutableBytes;
+    if (prefix) {
+        memcpy(output, self.prefix.bytes, self.prefix.length);
+        output += self.prefix.length;
+    }
+    
+    for (NSUInteger i = 0; i < self.literals.count; i++) {
+        NSData *literal = self.literals[i];
+        memcpy(output, literal.bytes, literal.length);
+        output += literal.length;
+        
+        if (i == self.placeholders.count) {
+            break;
+        }
+        
+        id value = values[self.placeholders[i]];
+        if (value == nil) {
+            *missingPlaceholder = self.placeholders[i];
+            return nil;
+        }
+        
+        NSString *string = [value isKindOfClass:[NSString class]] ? value : [value description];
+        const char *UTF8String = string.UTF8String;
+        NSUInteger length = strlen(UTF8String);
+        
+        // room for every byte escaped, and for the following literals
+        NSUInteger offset = output - (uint8_t *)data.mutableBytes;
+        capacity += length * 3;
+        if (data.length < capacity) {
+            data.length = capacity;
+        }
+        
+        const BOOL *characters = [self.queryPlaceholderIndexes containsIndex:i] ? ACEOAuth2RACRouteQueryCharacters : ACEOAuth2RACRouteSegmentCharacters;
+        output = ACEOAuth2RACRouteAppendEncoded((uint8_t *)data.mutableBytes + offset, (const uint8_t *)UTF8String, length, characters);
+    }
+    
+    data.length = output - (uint8_t *)data.mutableBytes;
+    return data;
+}
+
+- (NSURL *)URLWithValues:(NSDictionary<NSString *, id> *)values error:(NSError *__autoreleasing *)error
+{
+    NSString *missingPlaceholder;
+    NSData *data = [self dataWithValues:values prefix:YES missingPlaceholder:&missingPlaceholder];
+    
+    if (data == nil) {
+        if (error != NULL) {
+            *error = [NSError errorWithDomain:ACEOAuth2RACErrorDomain
+                                         code:ACEOAuth2RACErrorMissingRouteValue
+                                     userInfo:@{
+                                                NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Missing the value of {%@} for the route %@",
+                                                                            missingPlaceholder, self.identifier]
+                                                }];
+        }
+        return nil;
+    }
+    
+    // straight from the bytes, the URL is already absolute and encoded
+    return CFBridgingRelease(CFURLCreateWithBytes(kCFAllocatorDefault, data.bytes, data.length, kCFStringEncodingUTF8, NULL));
+}
+
+- (NSString *)pathWithValues:(NSDictionary<NSString *, id> *)values
+{
+    NSString *missingPlaceholder;
+    NSData *data = [self dataWithValues:values prefix:NO missingPlaceholder:&missingPlaceholder];
+    return data ? [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] : nil;
+}
+
++ (NSString *)identifierForURLRequest:(NSURLRequest *)request
+{
+    return [NSURLProtocol propertyForKey:ACEOAuth2RACRouteIdentifierKey inRequest:request];
+}
+
+
+#pragma mark - Description
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p, %@ %@>", self.class, self, self.identifier, self.URLTemplate];
+}
+
+@end
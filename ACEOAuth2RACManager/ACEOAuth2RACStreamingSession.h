@@ -0,0 +1,62 @@
+// ACEOAuth2RACStreamingSession.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import "ReactiveObjC.h"
+
+#import "AFSecurityPolicy.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `ACEOAuth2RACStreamingSession` runs data tasks delivering the body as it arrives,
+ without accumulating it like `AFURLSessionManager` does.
+
+ The server trust is evaluated with `securityPolicy`, the same way `AFURLSessionManager` does.
+ */
+@interface ACEOAuth2RACStreamingSession : NSObject
+
+/**
+ The policy evaluating the server trust, usually the one of the network manager. Default is `+[AFSecurityPolicy defaultPolicy]`.
+ */
+@property (atomic, strong) AFSecurityPolicy *securityPolicy;
+
+- (instancetype)initWithSessionConfiguration:(nullable NSURLSessionConfiguration *)configuration;
+
+/**
+ Return a signal executing the request.
+
+ @param request The request to execute.
+
+ @return The signal sending the `NSHTTPURLResponse`, followed by the chunks of the body as `NSData`.
+ It fails with the same error of `AFHTTPResponseSerializer` if the status code is not 2xx.
+ */
+- (RACSignal *)rac_dataSignalForRequest:(NSURLRequest *)request;
+
+/**
+ Cancel the running tasks and release the session.
+ */
+- (void)invalidate;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,167 @@
+// ACEOAuth2RACStreamingSession.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import "ACEOAuth2RACStreamingSession.h"
+
+#import "AFURLResponseSerialization.h"
+
+@interface ACEOAuth2RACStreamingSession ()<NSURLSessionDataDelegate>
+@property (nonatomic, strong) NSURLSession *session;
+
+// subscribers of the running tasks, keyed by task identifier
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, id<RACSubscriber>> *subscribers;
+@end
+
+@implementation ACEOAuth2RACStreamingSession
+
+- (instancetype)initWithSessionConfiguration:(NSURLSessionConfiguration *)configuration
+{
+    self = [super init];
+    if (self) {
+        NSOperationQueue *delegateQueue = [NSOperationQueue new];
+        delegateQueue.maxConcurrentOperationCount = 1;
+
+        self.subscribers    = [NSMutableDictionary dictionary];
+        self.securityPolicy = [AFSecurityPolicy defaultPolicy];
+        self.session        = [NSURLSession sessionWithConfiguration:configuration ?: [NSURLSessionConfiguration defaultSessionConfiguration]
+                                                            delegate:self
+                                                       delegateQueue:delegateQueue];
+    }
+    return self;
+}
+
+- (void)invalidate
+{
+    [self.session invalidateAndCancel];
+}
+
+
+#pragma mark - Signals
+
+- (RACSignal *)rac_dataSignalForRequest:(NSURLRequest *)request
+{
+    return [[RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+
+        NSURLSessionDataTask *task = [self.session dataTaskWithRequest:request];
+        [self setSubscriber:subscriber forTask:task];
+        [task resume];
+
+        return [RACDisposable disposableWithBlock:^{
+            [self removeSubscriberForTask:task];
+            [task cancel];
+        }];
+
+    }] setNameWithFormat:@"[%@] -rac_dataSignalForRequest: %@", self.class, request.URL];
+}
+
+
+#pragma mark - Subscribers
+
+- (void)setSubscriber:(id<RACSubscriber>)subscriber forTask:(NSURLSessionTask *)task
+{
+    @synchronized (self.subscribers) {
+        self.subscribers[@(task.taskIdentifier)] = subscriber;
+    }
+}
+
+- (id<RACSubscriber>)subscriberForTask:(NSURLSessionTask *)task
+{
+    @synchronized (self.subscribers) {
+        return self.subscribers[@(task.taskIdentifier)];
+    }
+}
+
+- (id<RACSubscriber>)removeSubscriberForTask:(NSURLSessionTask *)task
+{
+    @synchronized (self.subscribers) {
+        id<RACSubscriber> subscriber = self.subscribers[@(task.taskIdentifier)];
+        [self.subscribers removeObjectForKey:@(task.taskIdentifier)];
+        return subscriber;
+    }
+}
+
+
+#pragma mark - Session Delegate
+
+- (void)URLSession:(NSURLSession *)session
+          dataTask:(NSURLSessionDataTask *)dataTask
+didReceiveResponse:(NSURLResponse *)response
+ completionHandler:(void (^)(NSURLSessionResponseDisposition disposition))completionHandler
+{
+    NSInteger statusCode = [(NSHTTPURLResponse *)response statusCode];
+    if ([response isKindOfClass:[NSHTTPURLResponse class]] && (statusCode < 200 || statusCode >= 300)) {
+
+        // same error reported by the AFNetworking serializers, so the retry tests keep working
+        NSError *error = [NSError errorWithDomain:AFURLResponseSerializationErrorDomain
+                                             code:NSURLErrorBadServerResponse
+                                         userInfo:@{
+                                                    NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Request failed: %@ (%ld)",
+                                                                                [NSHTTPURLResponse localizedStringForStatusCode:statusCode], (long)statusCode],
+                                                    NSURLErrorFailingURLErrorKey: response.URL,
+                                                    AFNetworkingOperationFailingURLResponseErrorKey: response
+                                                    }];
+
+        [[self removeSubscriberForTask:dataTask] sendError:error];
+        completionHandler(NSURLSessionResponseCancel);
+
+    } else {
+        [[self subscriberForTask:dataTask] sendNext:response];
+        completionHandler(NSURLSessionResponseAllow);
+    }
+}
+
+- (void)URLSession:(NSURLSession *)session
+              task:(NSURLSessionTask *)task
+didReceiveChallenge:(NSURLAuthenticationChallenge *)challenge
+ completionHandler:(void (^)(NSURLSessionAuthChallengeDisposition disposition, NSURLCredential *credential))completionHandler
+{
+    // same as AFURLSessionManager, the pinning of the manager applies to the streams too
+    if (![challenge.protectionSpace.authenticationMethod isEqualToString:NSURLAuthenticationMethodServerTrust]) {
+        completionHandler(NSURLSessionAuthChallengePerformDefaultHandling, nil);
+        
+    } else if ([self.securityPolicy evaluateServerTrust:challenge.protectionSpace.serverTrust forDomain:challenge.protectionSpace.host]) {
+        completionHandler(NSURLSessionAuthChallengeUseCredential, [NSURLCredential credentialForTrust:challenge.protectionSpace.serverTrust]);
+        
+    } else {
+        completionHandler(NSURLSessionAuthChallengeCancelAuthenticationChallenge, nil);
+    }
+}
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data
+{
+    [[self subscriberForTask:dataTask] sendNext:data];
+}
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didCompleteWithError:(NSError *)error
+{
+    id<RACSubscriber> subscriber = [self removeSubscriberForTask:task];
+
+    if (error) {
+        [subscriber sendError:error];
+
+    } else {
+        [subscriber sendCompleted];
+    }
+}
+
+@end
@@ -0,0 +1,106 @@
+// ACEOAuth2RACTransportProfile.h
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `ACEOAuth2RACTransportProfile` groups the settings of the sessions tuned for a kind of traffic,
+ applied in the same way to the API and OAuth sessions of the network manager.
+ */
+@interface ACEOAuth2RACTransportProfile : NSObject <NSCopying>
+
+/**
+ The name of the profile, also used for the path of its URL cache.
+ */
+@property (nonatomic, copy, nullable) NSString *name;
+
+/**
+ The maximum number of simultaneous connections to a host. Default is 4.
+ */
+@property (nonatomic, assign) NSInteger HTTPMaximumConnectionsPerHost;
+
+/**
+ The time to wait for more data before giving up on a request. Default is 60 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval timeoutIntervalForRequest;
+
+/**
+ The maximum time of a request, including the retries of the system. Default is 7 days.
+ */
+@property (nonatomic, assign) NSTimeInterval timeoutIntervalForResource;
+
+/**
+ YES to send the requests without waiting for the previous responses on a HTTP/1.1 connection. Default is NO.
+ */
+@property (nonatomic, assign) BOOL HTTPShouldUsePipelining;
+
+/**
+ NO to never use the cellular connections. Default is YES.
+ */
+@property (nonatomic, assign) BOOL allowsCellularAccess;
+
+/**
+ The memory capacity of the URL cache, in bytes. Default is 4 MB.
+ */
+@property (nonatomic, assign) NSUInteger URLCacheMemoryCapacity;
+
+/**
+ The disk capacity of the URL cache, in bytes. Default is 20 MB.
+ */
+@property (nonatomic, assign) NSUInteger URLCacheDiskCapacity;
+
+/**
+ The URL cache of the profile, created the first time it's applied and shared by all the sessions using it.
+ */
+@property (nonatomic, strong, readonly) NSURLCache *URLCache;
+
+/**
+ Many short calls the user is waiting for: more connections, short timeouts and pipelining.
+ */
++ (instancetype)lowLatencyProfile;
+
+/**
+ Few large transfers: fewer connections, long timeouts and a small memory cache.
+ */
++ (instancetype)bulkProfile;
+
+/**
+ Paid or slow networks: fewer connections and a larger cache, to download the same data only once.
+ */
++ (instancetype)meteredProfile;
+
+/**
+ Return a copy of a session configuration with the settings of the profile.
+
+ @param configuration The configuration to start from, nil for the default one.
+
+ @return The new configuration.
+ */
+- (NSURLSessionConfiguration *)sessionConfigurationWithConfiguration:(nullable NSURLSessionConfiguration *)configuration;
+
+@end
+
+NS_ASSUME_NONNULL_END
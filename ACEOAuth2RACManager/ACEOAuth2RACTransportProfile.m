@@ -0,0 +1,154 @@
+// ACEOAuth2RACTransportProfile.m
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#import "ACEOAuth2RACTransportProfile.h"
+
+@implementation ACEOAuth2RACTransportProfile
+
+@synthesize URLCache = _URLCache;
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self.HTTPMaximumConnectionsPerHost  = 4;
+        self.timeoutIntervalForRequest      = 60.0;
+        self.timeoutIntervalForResource     = 7 * 24 * 60 * 60;
+        self.allowsCellularAccess           = YES;
+        self.URLCacheMemoryCapacity         = 4 * 1024 * 1024;
+        self.URLCacheDiskCapacity           = 20 * 1024 * 1024;
+    }
+    return self;
+}
+
+
+#pragma mark - Presets
+
++ (instancetype)lowLatencyProfile
+{
+    ACEOAuth2RACTransportProfile *profile = [self new];
+    profile.name                            = @"low-latency";
+    profile.HTTPMaximumConnectionsPerHost   = 6;
+    profile.timeoutIntervalForRequest       = 15.0;
+    profile.timeoutIntervalForResource      = 60.0;
+    profile.HTTPShouldUsePipelining         = YES;
+    return profile;
+}
+
++ (instancetype)bulkProfile
+{
+    ACEOAuth2RACTransportProfile *profile = [self new];
+    profile.name                            = @"bulk";
+    profile.HTTPMaximumConnectionsPerHost   = 2;
+    profile.timeoutIntervalForRequest       = 120.0;
+    profile.timeoutIntervalForResource      = 24 * 60 * 60;
+    profile.URLCacheMemoryCapacity          = 1 * 1024 * 1024;
+    profile.URLCacheDiskCapacity            = 50 * 1024 * 1024;
+    return profile;
+}
+
++ (instancetype)meteredProfile
+{
+    ACEOAuth2RACTransportProfile *profile = [self new];
+    profile.name                            = @"metered";
+    profile.HTTPMaximumConnectionsPerHost   = 2;
+    profile.timeoutIntervalForRequest       = 30.0;
+    profile.timeoutIntervalForResource      = 5 * 60;
+    profile.URLCacheMemoryCapacity          = 8 * 1024 * 1024;
+    profile.URLCacheDiskCapacity            = 100 * 1024 * 1024;
+    return profile;
+}
+
+
+#pragma mark - Properties
+
+- (void)setURLCacheMemoryCapacity:(NSUInteger)URLCacheMemoryCapacity
+{
+    @synchronized (self) {
+        _URLCacheMemoryCapacity = URLCacheMemoryCapacity;
+        _URLCache.memoryCapacity = URLCacheMemoryCapacity;
+    }
+}
+
+- (void)setURLCacheDiskCapacity:(NSUInteger)URLCacheDiskCapacity
+{
+    @synchronized (self) {
+        _URLCacheDiskCapacity = URLCacheDiskCapacity;
+        _URLCache.diskCapacity = URLCacheDiskCapacity;
+    }
+}
+
+- (NSURLCache *)URLCache
+{
+    @synchronized (self) {
+        if (_URLCache == nil) {
+            NSString *diskPath = [NSString stringWithFormat:@"com.onemob.network.%@", self.name ?: @"cache"];
+            _URLCache = [[NSURLCache alloc] initWithMemoryCapacity:self.URLCacheMemoryCapacity
+                                                      diskCapacity:self.URLCacheDiskCapacity
+                                                          diskPath:diskPath];
+        }
+        return _URLCache;
+    }
+}
+
+
+#pragma mark - Configuration
+
+- (NSURLSessionConfiguration *)sessionConfigurationWithConfiguration:(NSURLSessionConfiguration *)configuration
+{
+    NSURLSessionConfiguration *sessionConfiguration = [configuration copy] ?: [NSURLSessionConfiguration defaultSessionConfiguration];
+    
+    sessionConfiguration.HTTPMaximumConnectionsPerHost  = self.HTTPMaximumConnectionsPerHost;
+    sessionConfiguration.timeoutIntervalForRequest      = self.timeoutIntervalForRequest;
+    sessionConfiguration.timeoutIntervalForResource     = self.timeoutIntervalForResource;
+    sessionConfiguration.HTTPShouldUsePipelining        = self.HTTPShouldUsePipelining;
+    sessionConfiguration.allowsCellularAccess           = self.allowsCellularAccess;
+    sessionConfiguration.URLCache                       = self.URLCache;
+    
+    return sessionConfiguration;
+}
+
+
+#pragma mark - NSCopying
+
+- (instancetype)copyWithZone:(NSZone *)zone
+{
+    ACEOAuth2RACTransportProfile *profile = [[[self class] allocWithZone:zone] init];
+    profile.name                            = self.name;
+    profile.HTTPMaximumConnectionsPerHost   = self.HTTPMaximumConnectionsPerHost;
+    profile.timeoutIntervalForRequest       = self.timeoutIntervalForRequest;
+    profile.timeoutIntervalForResource      = self.timeoutIntervalForResource;
+    profile.HTTPShouldUsePipelining         = self.HTTPShouldUsePipelining;
+    profile.allowsCellularAccess            = self.allowsCellularAccess;
+    profile.URLCacheMemoryCapacity          = self.URLCacheMemoryCapacity;
+    profile.URLCacheDiskCapacity            = self.URLCacheDiskCapacity;
+    
+    // a single cache for each disk path
+    @synchronized (self) {
+        profile->_URLCache = _URLCache;
+    }
+    return profile;
+}
+
+@end
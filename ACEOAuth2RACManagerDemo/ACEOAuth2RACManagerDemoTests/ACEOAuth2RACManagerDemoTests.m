@@ -7,6 +7,737 @@
 //
 
 #import <XCTest/XCTest.h>
+#import <arpa/inet.h>
+#import <mach/mach.h>
+#import <malloc/malloc.h>
+#import <poll.h>
+#import <sys/socket.h>
+
+#import "ACEOAuth2RACChunkedUploader.h"
+#import "ACEOAuth2RACJSONResponseSerializer.h"
+#import "ACEOAuth2RACJSONStreamParser.h"
+#import "ACEOAuth2RACJSONStructuralIndex.h"
+#import "ACEOAuth2RACLazyJSON.h"
+#import "ACEOAuth2RACManager.h"
+#import "ACEOAuth2RACMessagePackSerializer.h"
+#import "ACEOAuth2RACOAuthManager.h"
+#import "ACEOAuth2RACOfflineQueue.h"
+#import "ACEOAuth2RACQueryEncoder.h"
+#import "ACEOAuth2RACQueryScanner.h"
+#import "ACEOAuth2RACRequestQueue.h"
+#import "ACEOAuth2RACResponseSerializer.h"
+
+// a byte by byte walk of the document, the reference of the vectorized index
+static ACEOAuth2RACJSONStructuralIndexStatus ACEOAuth2RACReferenceIndexBuild(const uint8_t *bytes, size_t length, uint32_t *positions, size_t *count, size_t *errorPosition)
+{
+    BOOL inString = NO, escaped = NO, inScalar = NO;
+    *count = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        uint8_t c = bytes[i];
+
+        if (inString) {
+            if (escaped) {
+                escaped = NO;
+
+            } else if (c == '\\') {
+                escaped = YES;
+
+            } else if (c == '"') {
+                positions[(*count)++] = (uint32_t)i;
+                inString = NO;
+
+            } else if (c < 0x20) {
+                *errorPosition = i;
+                return ACEOAuth2RACJSONStructuralIndexControlCharacter;
+            }
+            continue;
+        }
+
+        switch (c) {
+            case ' ': case '\t': case '\n': case '\r':
+                inScalar = NO;
+                break;
+
+            case '"':
+                positions[(*count)++] = (uint32_t)i;
+                inString = YES;
+                inScalar = NO;
+                break;
+
+            case '{': case '}': case '[': case ']': case ':': case ',':
+                positions[(*count)++] = (uint32_t)i;
+                inScalar = NO;
+                break;
+
+            default:
+                if (!inScalar) {
+                    positions[(*count)++] = (uint32_t)i;
+                }
+                inScalar = YES;
+                break;
+        }
+    }
+
+    if (inString) {
+        *errorPosition = length;
+        return ACEOAuth2RACJSONStructuralIndexUnterminatedString;
+    }
+    return ACEOAuth2RACJSONStructuralIndexSuccess;
+}
+
+typedef struct {
+    uint8_t *bytes;
+    size_t length;
+    size_t capacity;
+    uint64_t seed;
+} ACEOAuth2RACRandomDocument;
+
+static uint32_t ACEOAuth2RACRandom(ACEOAuth2RACRandomDocument *document, uint32_t bound)
+{
+    // xorshift, the same documents on every run
+    document->seed ^= document->seed << 13;
+    document->seed ^= document->seed >> 7;
+    document->seed ^= document->seed << 17;
+    return (uint32_t)(document->seed % bound);
+}
+
+static void ACEOAuth2RACAppend(ACEOAuth2RACRandomDocument *document, const char *string)
+{
+    size_t length = strlen(string);
+    if (document->length + length > document->capacity) {
+        document->capacity  = (document->length + length) * 2;
+        document->bytes     = realloc(document->bytes, document->capacity);
+    }
+    memcpy(document->bytes + document->length, string, length);
+    document->length += length;
+}
+
+static void ACEOAuth2RACAppendWhitespace(ACEOAuth2RACRandomDocument *document)
+{
+    static const char *whitespaces[] = { "", "", " ", "\n", "\t", "\r\n  " };
+    ACEOAuth2RACAppend(document, whitespaces[ACEOAuth2RACRandom(document, 6)]);
+}
+
+static void ACEOAuth2RACAppendValue(ACEOAuth2RACRandomDocument *document, unsigned depth)
+{
+    static const char *scalars[] = { "0", "-12", "3.25e-7", "1234567890123", "true", "false", "null" };
+    static const char *pieces[] = { "a", "key", " ", "\\\\", "\\\"", "\\\\\\\"", "\\n", "\\u00e9", "\\uD83D\\uDE00", "\xc3\xa9", "\xf0\x9f\x98\x80", "{[:,]}" };
+
+    uint32_t type = ACEOAuth2RACRandom(document, depth < 5 ? 4 : 2);
+    switch (type) {
+        case 0: {
+            ACEOAuth2RACAppend(document, "\"");
+            for (uint32_t i = ACEOAuth2RACRandom(document, 40); i > 0; i--) {
+                ACEOAuth2RACAppend(document, pieces[ACEOAuth2RACRandom(document, 12)]);
+            }
+            ACEOAuth2RACAppend(document, "\"");
+            break;
+        }
+
+        case 1:
+            ACEOAuth2RACAppend(document, scalars[ACEOAuth2RACRandom(document, 7)]);
+            break;
+
+        default: {
+            BOOL isObject = (type == 2);
+            ACEOAuth2RACAppend(document, isObject ? "{" : "[");
+            for (uint32_t i = ACEOAuth2RACRandom(document, 6); i > 0; i--) {
+                ACEOAuth2RACAppendWhitespace(document);
+                if (isObject) {
+                    ACEOAuth2RACAppend(document, "\"k\\\"\"");
+                    ACEOAuth2RACAppendWhitespace(document);
+                    ACEOAuth2RACAppend(document, ":");
+                    ACEOAuth2RACAppendWhitespace(document);
+                }
+                ACEOAuth2RACAppendValue(document, depth + 1);
+                ACEOAuth2RACAppendWhitespace(document);
+                if (i > 1) {
+                    ACEOAuth2RACAppend(document, ",");
+                }
+            }
+            ACEOAuth2RACAppend(document, isObject ? "}" : "]");
+            break;
+        }
+    }
+}
+
+// the memory of the process, with the pages its allocator keeps for reuse
+static uint64_t ACEOAuth2RACResidentSize(void)
+{
+    struct mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+
+// the reads of Secure Transport take only the bytes already received, so a record never waits for the next one
+static OSStatus ACEOAuth2RACTestServerRead(SSLConnectionRef connection, void *data, size_t *length)
+{
+    size_t requested = *length;
+    *length = 0;
+    while (*length < requested) {
+        ssize_t result = recv((int)(intptr_t)connection, (uint8_t *)data + *length, requested - *length, MSG_DONTWAIT);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return errSSLWouldBlock;
+        }
+        if (result <= 0) {
+            return result == 0 ? errSSLClosedGraceful : errSSLClosedAbort;
+        }
+        *length += result;
+    }
+    return noErr;
+}
+
+static OSStatus ACEOAuth2RACTestServerWrite(SSLConnectionRef connection, const void *data, size_t *length)
+{
+    size_t requested = *length;
+    *length = 0;
+    while (*length < requested) {
+        ssize_t result = write((int)(intptr_t)connection, (const uint8_t *)data + *length, requested - *length);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return errSSLClosedAbort;
+        }
+        *length += result;
+    }
+    return noErr;
+}
+
+#pragma clang diagnostic pop
+
+// until the socket can be read, or is closed
+static void ACEOAuth2RACTestServerWaitForBytes(int connectionSocket)
+{
+    struct pollfd descriptor = { .fd = connectionSocket, .events = POLLIN };
+    while (poll(&descriptor, 1, -1) < 0 && errno == EINTR) {
+    }
+}
+
+// the response to a request of the loopback server
+typedef NSData * _Nonnull (^ACEOAuth2RACTestServerHandler)(NSString *method, NSString *path, NSDictionary<NSString *, NSString *> *headers, NSData *body);
+
+// a keep-alive HTTP server on the loopback, counting the connections opened by the clients
+@interface ACEOAuth2RACTestServer : NSObject
+
+@property (nonatomic, strong, readonly) NSURL *baseURL;
+@property (atomic, assign, readonly) NSUInteger connectionCount;
+
+// the TLS handshakes completed by a server with an identity, one per connection without the session resumption
+@property (atomic, assign, readonly) NSUInteger handshakeCount;
+
+// the time each new connection waits before its first read, like the DNS, TCP and TLS setup of a real network
+@property (atomic, assign) NSTimeInterval connectionDelay;
+
++ (NSData *)responseWithStatusCode:(NSInteger)statusCode headers:(NSDictionary<NSString *, NSString *> *)headers body:(NSData *)body;
+
+- (instancetype)initWithResponseBody:(NSData *)responseBody;
+- (instancetype)initWithResponseBody:(NSData *)responseBody identity:(SecIdentityRef)identity;
+- (instancetype)initWithHandler:(ACEOAuth2RACTestServerHandler)handler;
+- (instancetype)initWithHandler:(ACEOAuth2RACTestServerHandler)handler identity:(SecIdentityRef)identity;
+- (void)closeConnections;
+- (void)stop;
+
+@end
+
+@interface ACEOAuth2RACTestServer ()
+
+@property (nonatomic, strong, readwrite) NSURL *baseURL;
+@property (atomic, assign, readwrite) NSUInteger connectionCount;
+@property (atomic, assign, readwrite) NSUInteger handshakeCount;
+@property (nonatomic, copy) ACEOAuth2RACTestServerHandler handler;
+@property (nonatomic, strong) id identity;
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, strong) dispatch_queue_t connectionQueue;
+@property (nonatomic, strong) dispatch_source_t listenSource;
+@property (nonatomic, strong) NSMutableSet<NSNumber *> *connectionSockets;
+
+@end
+
+@implementation ACEOAuth2RACTestServer
+
++ (NSData *)responseWithStatusCode:(NSInteger)statusCode headers:(NSDictionary<NSString *, NSString *> *)headers body:(NSData *)body {
+    NSMutableString *head = [NSMutableString stringWithFormat:@"HTTP/1.1 %ld %@\r\n", (long)statusCode, [NSHTTPURLResponse localizedStringForStatusCode:statusCode]];
+    [headers enumerateKeysAndObjectsUsingBlock:^(NSString *field, NSString *value, BOOL *stop) {
+        [head appendFormat:@"%@: %@\r\n", field, value];
+    }];
+    [head appendFormat:@"Content-Length: %lu\r\nConnection: keep-alive\r\n\r\n", (unsigned long)body.length];
+
+    NSMutableData *response = [NSMutableData dataWithData:[head dataUsingEncoding:NSUTF8StringEncoding]];
+    if (body != nil) {
+        [response appendData:body];
+    }
+    return response;
+}
+
+- (instancetype)initWithResponseBody:(NSData *)responseBody {
+    return [self initWithResponseBody:responseBody identity:NULL];
+}
+
+- (instancetype)initWithResponseBody:(NSData *)responseBody identity:(SecIdentityRef)identity {
+    NSData *response = [ACEOAuth2RACTestServer responseWithStatusCode:200 headers:@{ @"Content-Type": @"application/json" } body:responseBody];
+    return [self initWithHandler:^NSData *(NSString *method, NSString *path, NSDictionary<NSString *, NSString *> *headers, NSData *body) {
+        return response;
+    } identity:identity];
+}
+
+- (instancetype)initWithHandler:(ACEOAuth2RACTestServerHandler)handler {
+    return [self initWithHandler:handler identity:NULL];
+}
+
+- (instancetype)initWithHandler:(ACEOAuth2RACTestServerHandler)handler identity:(SecIdentityRef)identity {
+    self = [super init];
+    if (self) {
+        self.handler            = handler;
+        self.identity           = (__bridge id)identity;
+        self.queue              = dispatch_queue_create("com.onemob.network.tests.server", DISPATCH_QUEUE_SERIAL);
+        self.connectionQueue    = dispatch_queue_create("com.onemob.network.tests.server.connection", DISPATCH_QUEUE_CONCURRENT);
+        self.connectionSockets  = [NSMutableSet set];
+
+        int listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        struct sockaddr_in address = { 0 };
+        address.sin_len         = sizeof(address);
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = 0;
+
+        socklen_t length = sizeof(address);
+        if (bind(listenSocket, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listenSocket, 16) != 0 ||
+            getsockname(listenSocket, (struct sockaddr *)&address, &length) != 0) {
+            close(listenSocket);
+            return nil;
+        }
+
+        // App Transport Security doesn't apply to the IP addresses, plain HTTP is allowed
+        self.baseURL = [NSURL URLWithString:[NSString stringWithFormat:@"%@://127.0.0.1:%d/", identity ? @"https" : @"http", ntohs(address.sin_port)]];
+
+        __weak typeof(self) weakSelf = self;
+        self.listenSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, listenSocket, 0, self.queue);
+        dispatch_source_set_event_handler(self.listenSource, ^{
+            int connectionSocket = accept(listenSocket, NULL, NULL);
+            typeof(self) strongSelf = weakSelf;
+            if (connectionSocket < 0 || strongSelf == nil) {
+                return;
+            }
+
+            strongSelf.connectionCount++;
+            @synchronized (strongSelf.connectionSockets) {
+                [strongSelf.connectionSockets addObject:@(connectionSocket)];
+            }
+
+            // each connection blocks on its own thread, a slow response doesn't hold back the others
+            dispatch_async(strongSelf.connectionQueue, ^{
+                [strongSelf serveConnection:connectionSocket];
+            });
+        });
+        dispatch_source_set_cancel_handler(self.listenSource, ^{
+            close(listenSocket);
+        });
+        dispatch_resume(self.listenSource);
+    }
+    return self;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+
+// the server side of a TLS connection, NULL if the handshake failed
+- (SSLContextRef)handshakeConnection:(int)connectionSocket CF_RETURNS_RETAINED {
+    SSLContextRef context = SSLCreateContext(kCFAllocatorDefault, kSSLServerSide, kSSLStreamType);
+    SSLSetIOFuncs(context, ACEOAuth2RACTestServerRead, ACEOAuth2RACTestServerWrite);
+    SSLSetConnection(context, (SSLConnectionRef)(intptr_t)connectionSocket);
+    SSLSetCertificate(context, (__bridge CFArrayRef)@[ self.identity ]);
+
+    OSStatus status;
+    while ((status = SSLHandshake(context)) == errSSLWouldBlock) {
+        ACEOAuth2RACTestServerWaitForBytes(connectionSocket);
+    }
+
+    if (status != noErr) {
+        CFRelease(context);
+        return NULL;
+    }
+
+    @synchronized (self) {
+        self.handshakeCount++;
+    }
+    return context;
+}
+
+- (ssize_t)readConnection:(int)connectionSocket context:(SSLContextRef)context bytes:(uint8_t *)bytes length:(size_t)length {
+    while (context != NULL) {
+        size_t processed = 0;
+        OSStatus status = SSLRead(context, bytes, length, &processed);
+        if (processed > 0) {
+            return (ssize_t)processed;
+        }
+        if (status != noErr && status != errSSLWouldBlock) {
+            return -1;
+        }
+        ACEOAuth2RACTestServerWaitForBytes(connectionSocket);
+    }
+
+    ssize_t result;
+    do {
+        result = read(connectionSocket, bytes, length);
+    } while (result < 0 && errno == EINTR);
+    return result;
+}
+
+- (BOOL)writeConnection:(int)connectionSocket context:(SSLContextRef)context data:(NSData *)data {
+    if (context != NULL) {
+        size_t processed = 0;
+        return SSLWrite(context, data.bytes, data.length, &processed) == noErr && processed == data.length;
+    }
+
+    for (NSUInteger written = 0; written < data.length; ) {
+        ssize_t result = write(connectionSocket, (const uint8_t *)data.bytes + written, data.length - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return NO;
+        }
+        written += result;
+    }
+    return YES;
+}
+
+- (void)serveConnection:(int)connectionSocket {
+    int noSigPipe = 1;
+    setsockopt(connectionSocket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+
+    if (self.connectionDelay > 0.0) {
+        [NSThread sleepForTimeInterval:self.connectionDelay];
+    }
+
+    SSLContextRef context = self.identity ? [self handshakeConnection:connectionSocket] : NULL;
+    NSMutableData *buffer = [NSMutableData data];
+    NSData *headerEnd = [@"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding];
+    BOOL open = (self.identity == nil || context != NULL);
+
+    while (open) {
+        uint8_t bytes[16 * 1024];
+        ssize_t length = [self readConnection:connectionSocket context:context bytes:bytes length:sizeof(bytes)];
+        if (length <= 0) {
+            break;
+        }
+        [buffer appendBytes:bytes length:length];
+
+        // answer every complete request, with its body
+        while (open) {
+            NSRange range = [buffer rangeOfData:headerEnd options:0 range:NSMakeRange(0, buffer.length)];
+            if (range.location == NSNotFound) {
+                break;
+            }
+
+            NSString *head = [[NSString alloc] initWithData:[buffer subdataWithRange:NSMakeRange(0, range.location)] encoding:NSUTF8StringEncoding];
+            NSArray<NSString *> *lines = [head componentsSeparatedByString:@"\r\n"];
+            NSArray<NSString *> *requestLine = [lines.firstObject componentsSeparatedByString:@" "];
+
+            NSMutableDictionary<NSString *, NSString *> *headers = [NSMutableDictionary dictionary];
+            for (NSString *line in [lines subarrayWithRange:NSMakeRange(1, lines.count - 1)]) {
+                NSRange separator = [line rangeOfString:@":"];
+                if (separator.location != NSNotFound) {
+                    NSString *value = [[line substringFromIndex:NSMaxRange(separator)] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+                    headers[[line substringToIndex:separator.location].lowercaseString] = value;
+                }
+            }
+
+            NSUInteger contentLength = (NSUInteger)[headers[@"content-length"] integerValue];
+            NSUInteger requestLength = NSMaxRange(range) + contentLength;
+            if (buffer.length < requestLength || requestLine.count < 2) {
+                break;
+            }
+
+            NSData *body = [buffer subdataWithRange:NSMakeRange(NSMaxRange(range), contentLength)];
+            [buffer replaceBytesInRange:NSMakeRange(0, requestLength) withBytes:NULL length:0];
+
+            open = [self writeConnection:connectionSocket context:context data:self.handler(requestLine[0], requestLine[1], headers, body)];
+        }
+    }
+
+    if (context != NULL) {
+        SSLClose(context);
+        CFRelease(context);
+    }
+
+    @synchronized (self.connectionSockets) {
+        [self.connectionSockets removeObject:@(connectionSocket)];
+    }
+    close(connectionSocket);
+}
+
+#pragma clang diagnostic pop
+
+- (void)stop {
+    dispatch_sync(self.queue, ^{
+        dispatch_source_cancel(self.listenSource);
+    });
+    [self closeConnections];
+}
+
+- (void)closeConnections {
+    // the blocked reads return, and their threads close the sockets
+    @synchronized (self.connectionSockets) {
+        for (NSNumber *connectionSocket in self.connectionSockets) {
+            shutdown(connectionSocket.intValue, SHUT_RDWR);
+        }
+    }
+}
+
+@end
+
+// a tus server on the loopback, with the creation and the concatenation extensions
+@interface ACEOAuth2RACTusServer : NSObject
+
+@property (nonatomic, strong, readonly) ACEOAuth2RACTestServer *server;
+@property (nonatomic, copy, readonly) NSArray<NSString *> *requests;
+
+// the next PATCH at this offset is stored, and its response lost with a 500
+@property (atomic, strong) NSNumber *failingOffset;
+
+// the time the first PATCH of the first partial upload waits before answering
+@property (atomic, assign) NSTimeInterval firstPartialUploadDelay;
+
+- (NSData *)dataOfUploadWithURL:(NSURL *)URL;
+- (void)forgetUploads;
+- (void)stop;
+
+@end
+
+@interface ACEOAuth2RACTusServer ()
+
+@property (nonatomic, strong, readwrite) ACEOAuth2RACTestServer *server;
+@property (nonatomic, strong) NSMutableArray<NSString *> *log;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableData *> *uploads;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *lengths;
+@property (nonatomic, strong) NSMutableArray<NSString *> *partialUploads;
+@property (nonatomic, assign) NSUInteger nextNumber;
+
+@end
+
+@implementation ACEOAuth2RACTusServer
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        self.log            = [NSMutableArray array];
+        self.uploads        = [NSMutableDictionary dictionary];
+        self.lengths        = [NSMutableDictionary dictionary];
+        self.partialUploads = [NSMutableArray array];
+        self.nextNumber     = 1;
+
+        __weak typeof(self) weakSelf = self;
+        self.server = [[ACEOAuth2RACTestServer alloc] initWithHandler:^NSData *(NSString *method, NSString *path, NSDictionary<NSString *, NSString *> *headers, NSData *body) {
+            return [weakSelf responseToMethod:method path:path headers:headers body:body];
+        }];
+        if (self.server == nil) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (NSArray<NSString *> *)requests {
+    @synchronized (self) {
+        return [self.log copy];
+    }
+}
+
+- (NSData *)dataOfUploadWithURL:(NSURL *)URL {
+    @synchronized (self) {
+        NSData *data = self.uploads[URL.path];
+        return data.length == self.lengths[URL.path].unsignedIntegerValue ? [data copy] : nil;
+    }
+}
+
+- (void)forgetUploads {
+    @synchronized (self) {
+        [self.uploads removeAllObjects];
+        [self.lengths removeAllObjects];
+    }
+}
+
+- (void)stop {
+    [self.server stop];
+}
+
+- (NSData *)responseWithStatusCode:(NSInteger)statusCode headers:(NSDictionary<NSString *, NSString *> *)headers {
+    NSMutableDictionary *allHeaders = [NSMutableDictionary dictionaryWithDictionary:headers ?: @{}];
+    allHeaders[@"Tus-Resumable"] = @"1.0.0";
+    return [ACEOAuth2RACTestServer responseWithStatusCode:statusCode headers:allHeaders body:nil];
+}
+
+- (NSData *)responseToMethod:(NSString *)method path:(NSString *)path headers:(NSDictionary<NSString *, NSString *> *)headers body:(NSData *)body {
+    if (![headers[@"tus-resumable"] isEqualToString:@"1.0.0"]) {
+        return [self responseWithStatusCode:412 headers:nil];
+    }
+
+    NSTimeInterval delay = 0.0;
+    NSData *response;
+    @synchronized (self) {
+        if ([method isEqualToString:@"POST"]) {
+            response = [self responseToCreationWithHeaders:headers];
+
+        } else if (self.uploads[path] == nil) {
+            [self.log addObject:[NSString stringWithFormat:@"%@ %@", method, path]];
+            response = [self responseWithStatusCode:404 headers:nil];
+
+        } else if ([method isEqualToString:@"HEAD"]) {
+            [self.log addObject:[NSString stringWithFormat:@"HEAD %@", path]];
+            response = [self responseWithStatusCode:200 headers:@{
+                                                                  @"Upload-Offset": [NSString stringWithFormat:@"%lu", (unsigned long)self.uploads[path].length],
+                                                                  @"Upload-Length": self.lengths[path].stringValue,
+                                                                  @"Cache-Control": @"no-store",
+                                                                  }];
+
+        } else if ([method isEqualToString:@"PATCH"]) {
+            NSMutableData *upload = self.uploads[path];
+            NSUInteger offset = (NSUInteger)[headers[@"upload-offset"] integerValue];
+            [self.log addObject:[NSString stringWithFormat:@"PATCH %@ %lu", path, (unsigned long)offset]];
+
+            if (![headers[@"content-type"] isEqualToString:@"application/offset+octet-stream"]) {
+                response = [self responseWithStatusCode:415 headers:nil];
+
+            } else if (headers[@"upload-offset"] == nil || offset != upload.length) {
+                // the core protocol takes the chunks only at the current offset
+                response = [self responseWithStatusCode:409 headers:nil];
+
+            } else if (upload.length + body.length > self.lengths[path].unsignedIntegerValue) {
+                response = [self responseWithStatusCode:400 headers:nil];
+
+            } else {
+                [upload appendData:body];
+                response = [self responseWithStatusCode:204 headers:@{ @"Upload-Offset": [NSString stringWithFormat:@"%lu", (unsigned long)upload.length] }];
+
+                if ([self.failingOffset isEqual:@(offset)]) {
+                    self.failingOffset = nil;
+                    response = [self responseWithStatusCode:500 headers:nil];
+                }
+                if (offset == 0 && [path isEqualToString:self.partialUploads.firstObject]) {
+                    delay = self.firstPartialUploadDelay;
+                }
+            }
+
+        } else {
+            response = [self responseWithStatusCode:405 headers:nil];
+        }
+    }
+
+    if (delay > 0.0) {
+        [NSThread sleepForTimeInterval:delay];
+    }
+    return response;
+}
+
+- (NSData *)responseToCreationWithHeaders:(NSDictionary<NSString *, NSString *> *)headers {
+    NSString *concat = headers[@"upload-concat"];
+    NSMutableData *upload = [NSMutableData data];
+    NSUInteger length;
+
+    if ([concat hasPrefix:@"final;"]) {
+        // the partial uploads joined in the order of the header
+        NSMutableArray<NSString *> *paths = [NSMutableArray array];
+        for (NSString *partialURL in [[concat substringFromIndex:6] componentsSeparatedByString:@" "]) {
+            NSString *partialPath = [NSURL URLWithString:partialURL].path;
+            if (![self.partialUploads containsObject:partialPath] || self.uploads[partialPath].length != self.lengths[partialPath].unsignedIntegerValue) {
+                [self.log addObject:@"POST final"];
+                return [self responseWithStatusCode:400 headers:nil];
+            }
+            [upload appendData:self.uploads[partialPath]];
+            [paths addObject:partialPath];
+        }
+        [self.log addObject:[@"POST final " stringByAppendingString:[paths componentsJoinedByString:@" "]]];
+        length = upload.length;
+
+    } else if (headers[@"upload-length"] != nil) {
+        [self.log addObject:[concat isEqualToString:@"partial"] ? @"POST partial" : @"POST"];
+        length = (NSUInteger)[headers[@"upload-length"] integerValue];
+
+    } else {
+        [self.log addObject:@"POST"];
+        return [self responseWithStatusCode:400 headers:nil];
+    }
+
+    NSString *path = [NSString stringWithFormat:@"/files/%lu", (unsigned long)self.nextNumber++];
+    self.uploads[path] = upload;
+    self.lengths[path] = @(length);
+    if ([concat isEqualToString:@"partial"]) {
+        [self.partialUploads addObject:path];
+    }
+    return [self responseWithStatusCode:201 headers:@{ @"Location": path }];
+}
+
+@end
+
+// the signals of fake requests, recording when the queue starts them, and completed by the tests
+@interface ACEOAuth2RACTestRequests : NSObject
+
+@property (nonatomic, copy, readonly) NSArray<NSString *> *startedNames;
+
+- (RACSignal *)signalNamed:(NSString *)name;
+- (void)completeRequestNamed:(NSString *)name;
+
+@end
+
+@interface ACEOAuth2RACTestRequests ()
+
+@property (nonatomic, strong) NSMutableArray<NSString *> *names;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, id<RACSubscriber>> *subscribers;
+
+@end
+
+@implementation ACEOAuth2RACTestRequests
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        self.names          = [NSMutableArray array];
+        self.subscribers    = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (NSArray<NSString *> *)startedNames {
+    @synchronized (self) {
+        return [self.names copy];
+    }
+}
+
+- (RACSignal *)signalNamed:(NSString *)name {
+    return [RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+        @synchronized (self) {
+            [self.names addObject:name];
+            self.subscribers[name] = subscriber;
+        }
+        return nil;
+    }];
+}
+
+- (void)completeRequestNamed:(NSString *)name {
+    id<RACSubscriber> subscriber;
+    @synchronized (self) {
+        subscriber = self.subscribers[name];
+    }
+    [subscriber sendNext:name];
+    [subscriber sendCompleted];
+}
+
+@end
 
 @interface ACEOAuth2RACManagerDemoTests : XCTestCase
 
@@ -14,26 +745,2454 @@
 
 @implementation ACEOAuth2RACManagerDemoTests
 
-- (void)setUp {
-    [super setUp];
-    // Put setup code here. This method is called before the invocation of each test method in the class.
+#pragma mark - Helpers
+
+- (NSData *)dataWithString:(NSString *)string {
+    return [string dataUsingEncoding:NSUTF8StringEncoding];
 }
 
-- (void)tearDown {
-    // Put teardown code here. This method is called after the invocation of each test method in the class.
-    [super tearDown];
+- (NSHTTPURLResponse *)JSONResponse {
+    return [[NSHTTPURLResponse alloc] initWithURL:[NSURL URLWithString:@"https://example.com/items"]
+                                       statusCode:200
+                                      HTTPVersion:@"HTTP/1.1"
+                                     headerFields:@{ @"Content-Type": @"application/json" }];
 }
 
-- (void)testExample {
-    // This is an example of a functional test case.
-    // Use XCTAssert and related functions to verify your tests produce the correct results.
+// the reference: NSJSONSerialization followed by the null removal of AFNetworking
+- (id)AFObjectWithData:(NSData *)data error:(NSError **)error {
+    AFJSONResponseSerializer *serializer = [AFJSONResponseSerializer serializer];
+    serializer.removesKeysWithNullValues = YES;
+    return [serializer responseObjectForResponse:[self JSONResponse] data:data error:error];
 }
 
-- (void)testPerformanceExample {
-    // This is an example of a performance test case.
-    [self measureBlock:^{
-        // Put the code you want to measure the time of here.
-    }];
+- (NSData *)randomDocumentWithSeed:(uint64_t)seed {
+    ACEOAuth2RACRandomDocument document = { NULL, 0, 0, seed * 0x9E3779B97F4A7C15ULL };
+    ACEOAuth2RACAppendWhitespace(&document);
+    ACEOAuth2RACAppendValue(&document, 0);
+    ACEOAuth2RACAppendWhitespace(&document);
+    return [NSData dataWithBytesNoCopy:document.bytes length:document.length freeWhenDone:YES];
+}
+
+- (void)assertStructuralIndexOfBytes:(const uint8_t *)bytes length:(size_t)length matchesReference:(NSString *)message {
+    uint32_t *positions = malloc((length + 1) * sizeof(uint32_t));
+    size_t count = 0;
+    size_t expectedErrorPosition = 0;
+    ACEOAuth2RACJSONStructuralIndexStatus expectedStatus = ACEOAuth2RACReferenceIndexBuild(bytes, length, positions, &count, &expectedErrorPosition);
+
+    ACEOAuth2RACJSONStructuralIndex index = { 0 };
+    size_t errorPosition = 0;
+    ACEOAuth2RACJSONStructuralIndexStatus status = ACEOAuth2RACJSONStructuralIndexBuild(bytes, length, &index, &errorPosition);
+
+    XCTAssertEqual(status, expectedStatus, @"%@", message);
+    if (status == ACEOAuth2RACJSONStructuralIndexSuccess) {
+        XCTAssertEqual(index.count, count, @"%@", message);
+        XCTAssertTrue(index.count == count && memcmp(index.positions, positions, count * sizeof(uint32_t)) == 0, @"%@", message);
+
+    } else {
+        XCTAssertEqual(errorPosition, expectedErrorPosition, @"%@", message);
+    }
+
+    ACEOAuth2RACJSONStructuralIndexFree(&index);
+    free(positions);
+}
+
+- (NSData *)dataWithHexString:(NSString *)hex {
+    NSMutableData *data = [NSMutableData data];
+    NSString *digits = [hex stringByReplacingOccurrencesOfString:@" " withString:@""];
+    for (NSUInteger i = 0; i + 1 < digits.length; i += 2) {
+        uint8_t byte = (uint8_t)strtoul([[digits substringWithRange:NSMakeRange(i, 2)] UTF8String], NULL, 16);
+        [data appendBytes:&byte length:1];
+    }
+    return data;
+}
+
+- (void)appendMessagePackType:(uint8_t)type value:(uint64_t)value size:(NSUInteger)size toData:(NSMutableData *)data {
+    [data appendBytes:&type length:1];
+    for (NSUInteger i = size; i > 0; i--) {
+        uint8_t byte = (uint8_t)(value >> (8 * (i - 1)));
+        [data appendBytes:&byte length:1];
+    }
+}
+
+- (void)appendMessagePackHeaderWithLength:(NSUInteger)length fixType:(uint8_t)fixType fixLimit:(NSUInteger)fixLimit types:(const uint8_t *)types toData:(NSMutableData *)data {
+    if (length < fixLimit) {
+        [self appendMessagePackType:(uint8_t)(fixType | length) value:0 size:0 toData:data];
+    } else if (types[0] != 0 && length <= UINT8_MAX) {
+        [self appendMessagePackType:types[0] value:length size:1 toData:data];
+    } else if (length <= UINT16_MAX) {
+        [self appendMessagePackType:types[1] value:length size:2 toData:data];
+    } else {
+        [self appendMessagePackType:types[2] value:length size:4 toData:data];
+    }
+}
+
+// the smallest encoding of each value, to go through every format
+- (void)appendMessagePackOfObject:(id)object toData:(NSMutableData *)data {
+    if (object == [NSNull null]) {
+        [self appendMessagePackType:0xc0 value:0 size:0 toData:data];
+
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        NSNumber *number = object;
+        const char *type = number.objCType;
+
+        if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+            [self appendMessagePackType:number.boolValue ? 0xc3 : 0xc2 value:0 size:0 toData:data];
+
+        } else if (strcmp(type, @encode(float)) == 0) {
+            float value = number.floatValue;
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            [self appendMessagePackType:0xca value:bits size:4 toData:data];
+
+        } else if (strcmp(type, @encode(double)) == 0) {
+            double value = number.doubleValue;
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            [self appendMessagePackType:0xcb value:bits size:8 toData:data];
+
+        } else if (strcmp(type, @encode(unsigned long long)) == 0 || number.longLongValue >= 0) {
+            uint64_t value = number.unsignedLongLongValue;
+            if (value <= 0x7f) {
+                [self appendMessagePackType:(uint8_t)value value:0 size:0 toData:data];
+            } else if (value <= UINT8_MAX) {
+                [self appendMessagePackType:0xcc value:value size:1 toData:data];
+            } else if (value <= UINT16_MAX) {
+                [self appendMessagePackType:0xcd value:value size:2 toData:data];
+            } else if (value <= UINT32_MAX) {
+                [self appendMessagePackType:0xce value:value size:4 toData:data];
+            } else {
+                [self appendMessagePackType:0xcf value:value size:8 toData:data];
+            }
+
+        } else {
+            int64_t value = number.longLongValue;
+            if (value >= -32) {
+                [self appendMessagePackType:(uint8_t)value value:0 size:0 toData:data];
+            } else if (value >= INT8_MIN) {
+                [self appendMessagePackType:0xd0 value:(uint8_t)value size:1 toData:data];
+            } else if (value >= INT16_MIN) {
+                [self appendMessagePackType:0xd1 value:(uint16_t)value size:2 toData:data];
+            } else if (value >= INT32_MIN) {
+                [self appendMessagePackType:0xd2 value:(uint32_t)value size:4 toData:data];
+            } else {
+                [self appendMessagePackType:0xd3 value:(uint64_t)value size:8 toData:data];
+            }
+        }
+
+    } else if ([object isKindOfClass:[NSString class]]) {
+        NSData *string = [object dataUsingEncoding:NSUTF8StringEncoding];
+        static const uint8_t types[] = { 0xd9, 0xda, 0xdb };
+        [self appendMessagePackHeaderWithLength:string.length fixType:0xa0 fixLimit:32 types:types toData:data];
+        [data appendData:string];
+
+    } else if ([object isKindOfClass:[NSData class]]) {
+        static const uint8_t types[] = { 0xc4, 0xc5, 0xc6 };
+        [self appendMessagePackHeaderWithLength:[object length] fixType:0 fixLimit:0 types:types toData:data];
+        [data appendData:object];
+
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        static const uint8_t types[] = { 0, 0xdc, 0xdd };
+        [self appendMessagePackHeaderWithLength:[object count] fixType:0x90 fixLimit:16 types:types toData:data];
+        for (id element in object) {
+            [self appendMessagePackOfObject:element toData:data];
+        }
+
+    } else if ([object isKindOfClass:[NSDictionary class]]) {
+        static const uint8_t types[] = { 0, 0xde, 0xdf };
+        [self appendMessagePackHeaderWithLength:[object count] fixType:0x80 fixLimit:16 types:types toData:data];
+        [object enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+            [self appendMessagePackOfObject:key toData:data];
+            [self appendMessagePackOfObject:value toData:data];
+        }];
+    }
+}
+
+- (NSData *)messagePackOfObject:(id)object {
+    NSMutableData *data = [NSMutableData data];
+    [self appendMessagePackOfObject:object toData:data];
+    return data;
+}
+
+// the elements streamed from the chunks of the document, nil if the parsing failed
+- (NSArray *)streamedElementsOfData:(NSData *)data itemsKey:(NSString *)itemsKey chunkSize:(NSUInteger)chunkSize {
+    ACEOAuth2RACJSONStreamParser *parser = [[ACEOAuth2RACJSONStreamParser alloc] initWithItemsKey:itemsKey];
+    NSMutableArray *elements = [NSMutableArray array];
+
+    for (NSUInteger offset = 0; offset < data.length; offset += chunkSize) {
+        NSData *chunk = [data subdataWithRange:NSMakeRange(offset, MIN(chunkSize, data.length - offset))];
+        BOOL success = [parser parseData:chunk elementHandler:^(id element) {
+            [elements addObject:element];
+        } error:nil];
+
+        if (!success) {
+            return nil;
+        }
+    }
+    return [parser finishWithError:nil] ? elements : nil;
+}
+
+- (NSData *)randomArrayWithSeed:(uint64_t)seed {
+    NSMutableData *data = [NSMutableData dataWithData:[self dataWithString:@"[ "]];
+    for (uint64_t element = 0; element < 10; element++) {
+        if (element > 0) {
+            [data appendData:[self dataWithString:@",\n"]];
+        }
+        [data appendData:[self randomDocumentWithSeed:seed * 10 + element]];
+    }
+    [data appendData:[self dataWithString:@" ]"]];
+    return data;
+}
+
+- (NSArray *)queryParameters {
+    NSString *longString = [[@"" stringByPaddingToLength:49 withString:@"a" startingAtIndex:0] stringByAppendingString:@"\U0001F600 and more text after the emoji, past the batch of AFNetworking é"];
+
+    return @[
+             @{},
+             @{ @"a": @"b" },
+             @{ @"user": @{ @"name": @"Ann", @"tags": @[ @"x", @"y" ], @"address": @{ @"city": @"Köln", @"zip": @"50667" } } },
+             @{ @"items": @[ @{ @"id": @1 }, @{ @"id": @2, @"q": @"a b" } ] },
+             @{ @"matrix": @[ @[ @1, @2 ], @[], @[ @[ @3 ] ] ] },
+             @{ @"set": [NSSet setWithObjects:@"b", @"a", @3, nil], @"sets": @[ [NSSet setWithObject:@"z"] ] },
+             @{ @"null": [NSNull null], @"nested": @{ @"x": [NSNull null], @"y": @[ [NSNull null] ] } },
+             @{ @"q": @"café 中文 \U0001F600 &=?/#[]@!$'()*+,;:%\"<>\\^`{|}", @"ключ": @"значение" },
+             @{ @"long": longString, longString: @[ longString ] },
+             @{ @"int": @42, @"float": @1.5, @"true": @YES, @"false": @NO, @"negative": @-1, @"big": @(UINT64_MAX) },
+             @{ @1: @"one", @2: @[ @"two" ], @"3": @{ @4: @"four" } },
+             @{ @"empty": @"", @"emptyArray": @[], @"emptyDictionary": @{}, @"emptySet": [NSSet set] },
+             @[ @1, @"two", @{ @"three": @3 } ],
+             [NSSet setWithObjects:@"x", @{ @"a": @1 }, @[ @2 ], [NSNull null], nil],
+             @"scalar value",
+             @42,
+             [NSNull null],
+             ];
+}
+
+- (NSArray *)sortedPairsOfQuery:(NSString *)query {
+    return [[query componentsSeparatedByString:@"&"] sortedArrayUsingSelector:@selector(compare:)];
+}
+
+- (NSString *)nestedArraysWithDepth:(NSUInteger)depth {
+    return [[@"" stringByPaddingToLength:depth withString:@"[" startingAtIndex:0] stringByAppendingString:[@"" stringByPaddingToLength:depth withString:@"]" startingAtIndex:0]];
+}
+
+- (NSArray<NSString *> *)validDocuments {
+    return @[
+             @"{\"a\":1,\"b\":\"two\",\"c\":[1,2,3],\"d\":{\"e\":null,\"f\":false},\"g\":null}",
+             @" \n\t{ \"empty\" : { } , \"list\" : [ ] }\r\n",
+             @"[null,{\"a\":null},[null,{\"b\":null,\"c\":true}]]",
+             @"[\"\\\"\\\\\\/\\b\\f\\n\\r\\t\",\"caf\\u00e9 \\u00A0\\u4e2d\",\"\\uD83D\\uDE00\",\"\\u0000\"]",
+             @"{\"héllo\":\"中文 😀\",\"k\\u0065y\":\"v\"}",
+             @"[0,-0,1,-1,1.5,-2.25e-3,1E10,2e+2,0.1,123456789,-9223372036854775807,9223372036854775807]",
+             @"{\"a\":1,\"a\":2}",
+             @"{\"a\":1,\"a\":null}",
+             @"{\"a\":null,\"a\":1}",
+             @"{\"a\":{\"x\":1},\"b\":[{\"a\":null,\"a\":[null]}],\"a\":{\"y\":null}}",
+             ];
+}
+
+- (NSArray<NSString *> *)invalidDocuments {
+    return @[
+             @"",
+             @"{\"a\":1,}",
+             @"[1,]",
+             @"[1 2]",
+             @"{\"a\" 1}",
+             @"{a:1}",
+             @"[01]",
+             @"[1.]",
+             @"[.5]",
+             @"[1e]",
+             @"[-]",
+             @"[+1]",
+             @"[tru]",
+             @"[nul]",
+             @"[\"\\x\"]",
+             @"[\"\\u12\"]",
+             @"[\"a\tb\"]",
+             @"{} x",
+             @"[]]",
+             @"\"fragment\"",
+             ];
+}
+
+
+#pragma mark - JSON Parser
+
+- (void)testJSONParserMatchesAFNetworking {
+    for (NSString *document in [self validDocuments]) {
+        NSData *data = [self dataWithString:document];
+
+        NSError *error;
+        id expected = [self AFObjectWithData:data error:&error];
+        XCTAssertNotNil(expected, @"%@: %@", document, error);
+
+        id object = ACEOAuth2RACJSONObjectRemovingNullValues(data, 0, &error);
+        XCTAssertEqualObjects(object, expected, @"%@: %@", document, error);
+    }
+}
+
+- (void)testJSONParserMatchesNSJSONSerializationWithoutNulls {
+    NSString *document = @"{\"a\":[1,2.5,\"x\\ny\",true,false,{}],\"b\":{\"c\":\"\\uD834\\uDD1E\"},\"d\":-12}";
+    NSData *data = [self dataWithString:document];
+
+    id expected = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+    XCTAssertEqualObjects(ACEOAuth2RACJSONObjectRemovingNullValues(data, 0, NULL), expected);
+    XCTAssertEqualObjects(expected[@"b"][@"c"], @"\U0001D11E");
+}
+
+- (void)testJSONParserKeepsTheLastValueOfRepeatedKeys {
+    XCTAssertEqualObjects(ACEOAuth2RACJSONObjectRemovingNullValues([self dataWithString:@"{\"a\":1,\"a\":2}"], 0, NULL), @{ @"a": @2 });
+    XCTAssertEqualObjects(ACEOAuth2RACJSONObjectRemovingNullValues([self dataWithString:@"{\"a\":1,\"a\":null}"], 0, NULL), @{});
+    XCTAssertEqualObjects(ACEOAuth2RACJSONObjectRemovingNullValues([self dataWithString:@"{\"a\":null,\"a\":1}"], 0, NULL), @{ @"a": @1 });
+}
+
+- (void)testJSONParserRejectsInvalidDocuments {
+    for (NSString *document in [self invalidDocuments]) {
+        NSData *data = [self dataWithString:document];
+
+        NSError *error;
+        XCTAssertNil(ACEOAuth2RACJSONObjectRemovingNullValues(data, 0, &error), @"%@", document);
+        XCTAssertEqualObjects(error.domain, NSCocoaErrorDomain, @"%@", document);
+        XCTAssertEqual(error.code, NSPropertyListReadCorruptError, @"%@", document);
+
+        XCTAssertNil([NSJSONSerialization JSONObjectWithData:data options:0 error:nil], @"%@", document);
+    }
+}
+
+- (void)testJSONParserRejectsTruncatedDocuments {
+    NSData *data = [self dataWithString:@"{\"a\":[1,-2.5e3,\"x\\n\\u00e9\",true,null],\"b\":{\"c\":false}}"];
+
+    for (NSUInteger length = 0; length < data.length; length++) {
+        NSData *truncated = [data subdataWithRange:NSMakeRange(0, length)];
+        XCTAssertNil(ACEOAuth2RACJSONObjectRemovingNullValues(truncated, 0, NULL), @"%lu", (unsigned long)length);
+        XCTAssertNil([NSJSONSerialization JSONObjectWithData:truncated options:0 error:nil], @"%lu", (unsigned long)length);
+    }
+}
+
+- (void)testJSONParserRejectsInvalidSurrogates {
+    NSArray *documents = @[ @"[\"\\uD83D\"]", @"[\"\\uDE00\"]", @"[\"\\uD83D\\u0041\"]", @"[\"\\uD83Dx\"]", @"[\"\\uD83D\\uD83D\"]" ];
+    for (NSString *document in documents) {
+        XCTAssertNil(ACEOAuth2RACJSONObjectRemovingNullValues([self dataWithString:document], 0, NULL), @"%@", document);
+    }
+}
+
+- (void)testJSONParserReadsBigIntegers {
+    NSArray *numbers = ACEOAuth2RACJSONObjectRemovingNullValues([self dataWithString:@"[9223372036854775807,-9223372036854775808,18446744073709551615,123456789012345678901234567890,-18446744073709551616]"], 0, NULL);
+    XCTAssertEqual(numbers.count, 5);
+
+    XCTAssertEqual([numbers[0] longLongValue], INT64_MAX);
+    XCTAssertEqual([numbers[1] longLongValue], INT64_MIN);
+    XCTAssertEqual([numbers[2] unsignedLongLongValue], UINT64_MAX);
+    XCTAssertEqualWithAccuracy([numbers[3] doubleValue], 123456789012345678901234567890.0, 1e15);
+    XCTAssertEqualWithAccuracy([numbers[4] doubleValue], -18446744073709551616.0, 1e4);
+
+    NSArray *expected = [NSJSONSerialization JSONObjectWithData:[self dataWithString:@"[123456789012345678901234567890]"] options:0 error:nil];
+    XCTAssertEqualWithAccuracy([numbers[3] doubleValue], [expected[0] doubleValue], 1e15);
+
+    XCTAssertNil(ACEOAuth2RACJSONObjectRemovingNullValues([self dataWithString:@"[1e400]"], 0, NULL));
+}
+
+- (void)testJSONParserSkipsTheByteOrderMark {
+    NSMutableData *data = [NSMutableData dataWithBytes:"\xef\xbb\xbf" length:3];
+    [data appendData:[self dataWithString:@"{\"a\":[1,null]}"]];
+
+    XCTAssertEqualObjects(ACEOAuth2RACJSONObjectRemovingNullValues(data, 0, NULL), (@{ @"a": @[ @1, [NSNull null] ] }));
+    XCTAssertEqualObjects(ACEOAuth2RACJSONObjectRemovingNullValues(data, 0, NULL), [self AFObjectWithData:data error:nil]);
+}
+
+- (void)testJSONParserReadsFragments {
+    NSArray *fragments = @[ @"\"x\"", @" 12 ", @"-1.5", @"true", @"false", @"null" ];
+    for (NSString *fragment in fragments) {
+        NSData *data = [self dataWithString:fragment];
+
+        id expected = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:nil];
+        XCTAssertEqualObjects(ACEOAuth2RACJSONObjectRemovingNullValues(data, NSJSONReadingAllowFragments, NULL), expected, @"%@", fragment);
+        XCTAssertNil(ACEOAuth2RACJSONObjectRemovingNullValues(data, 0, NULL), @"%@", fragment);
+    }
+}
+
+- (void)testJSONParserLimitsTheDepth {
+    XCTAssertNotNil(ACEOAuth2RACJSONObjectRemovingNullValues([self dataWithString:[self nestedArraysWithDepth:512]], 0, NULL));
+
+    NSError *error;
+    XCTAssertNil(ACEOAuth2RACJSONObjectRemovingNullValues([self dataWithString:[self nestedArraysWithDepth:513]], 0, &error));
+    XCTAssertEqual(error.code, NSPropertyListReadCorruptError);
+
+    XCTAssertNil(ACEOAuth2RACJSONObjectRemovingNullValues([self dataWithString:[self nestedArraysWithDepth:100000]], 0, NULL));
+}
+
+- (void)testJSONParserHonorsTheMutableOptions {
+    NSData *data = [self dataWithString:@"{\"a\":[\"x\"],\"b\":{\"c\":null}}"];
+
+    NSDictionary *object = ACEOAuth2RACJSONObjectRemovingNullValues(data, NSJSONReadingMutableContainers | NSJSONReadingMutableLeaves, NULL);
+    XCTAssertTrue([object isKindOfClass:[NSMutableDictionary class]]);
+    XCTAssertTrue([object[@"a"] isKindOfClass:[NSMutableArray class]]);
+    XCTAssertTrue([object[@"a"][0] isKindOfClass:[NSMutableString class]]);
+    XCTAssertTrue([object[@"b"] isKindOfClass:[NSMutableDictionary class]]);
+
+    XCTAssertNoThrow([(NSMutableDictionary *)object[@"b"] setObject:@1 forKey:@"d"]);
+    XCTAssertNoThrow([(NSMutableString *)object[@"a"][0] appendString:@"y"]);
+    XCTAssertEqualObjects(object, (@{ @"a": @[ @"xy" ], @"b": @{ @"d": @1 } }));
+}
+
+- (void)testJSONResponseSerializerMatchesAFNetworking {
+    ACEOAuth2RACJSONResponseSerializer *serializer = [ACEOAuth2RACJSONResponseSerializer serializer];
+    serializer.removesKeysWithNullValues = YES;
+
+    for (NSString *document in [self validDocuments]) {
+        NSData *data = [self dataWithString:document];
+        XCTAssertEqualObjects([serializer responseObjectForResponse:[self JSONResponse] data:data error:nil], [self AFObjectWithData:data error:nil], @"%@", document);
+    }
+
+    for (NSString *document in [self invalidDocuments]) {
+        NSError *error;
+        NSError *expectedError;
+        NSData *data = [self dataWithString:document];
+
+        XCTAssertEqualObjects([serializer responseObjectForResponse:[self JSONResponse] data:data error:&error], [self AFObjectWithData:data error:&expectedError], @"%@", document);
+        XCTAssertEqual(error == nil, expectedError == nil, @"%@", document);
+    }
+}
+
+- (void)testJSONResponseSerializerMatchesAFNetworkingOnInvalidResponses {
+    ACEOAuth2RACJSONResponseSerializer *serializer = [ACEOAuth2RACJSONResponseSerializer serializer];
+    serializer.removesKeysWithNullValues = YES;
+    AFJSONResponseSerializer *expectedSerializer = [AFJSONResponseSerializer serializer];
+    expectedSerializer.removesKeysWithNullValues = YES;
+
+    // the wrong content type of an error status is found under the status code error
+    NSData *data = [self dataWithString:@"{\"error\":\"failed\",\"detail\":null}"];
+    for (NSNumber *statusCode in @[ @200, @500 ]) {
+        for (NSString *contentType in @[ @"application/json", @"text/html" ]) {
+            NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:[NSURL URLWithString:@"https://example.com/items"]
+                                                                       statusCode:statusCode.integerValue
+                                                                      HTTPVersion:@"HTTP/1.1"
+                                                                     headerFields:@{ @"Content-Type": contentType }];
+            NSError *error;
+            NSError *expectedError;
+            XCTAssertEqualObjects([serializer responseObjectForResponse:response data:data error:&error], [expectedSerializer responseObjectForResponse:response data:data error:&expectedError], @"%@ %@", statusCode, contentType);
+            XCTAssertEqualObjects(error.domain, expectedError.domain, @"%@ %@", statusCode, contentType);
+            XCTAssertEqual(error.code, expectedError.code, @"%@ %@", statusCode, contentType);
+
+            // without an error to fill, an invalid response gives no object
+            XCTAssertEqualObjects([serializer responseObjectForResponse:response data:data error:NULL], [expectedSerializer responseObjectForResponse:response data:data error:NULL], @"%@ %@", statusCode, contentType);
+        }
+    }
+}
+
+
+#pragma mark - Structural Index
+
+- (void)testStructuralIndexFindsTheStructuralCharacters {
+    NSData *data = [self dataWithString:@"{\"a\":[1,true,\"x\\\"y\"]}"];
+    uint32_t expected[] = { 0, 1, 3, 4, 5, 6, 7, 8, 12, 13, 18, 19, 20 };
+
+    ACEOAuth2RACJSONStructuralIndex index = { 0 };
+    size_t errorPosition;
+    XCTAssertEqual(ACEOAuth2RACJSONStructuralIndexBuild(data.bytes, data.length, &index, &errorPosition), ACEOAuth2RACJSONStructuralIndexSuccess);
+    XCTAssertEqual(index.count, sizeof(expected) / sizeof(expected[0]));
+    XCTAssertTrue(index.count == sizeof(expected) / sizeof(expected[0]) && memcmp(index.positions, expected, sizeof(expected)) == 0);
+
+    // the index is reused
+    XCTAssertEqual(ACEOAuth2RACJSONStructuralIndexBuild(data.bytes, data.length, &index, &errorPosition), ACEOAuth2RACJSONStructuralIndexSuccess);
+    XCTAssertEqual(index.count, sizeof(expected) / sizeof(expected[0]));
+
+    ACEOAuth2RACJSONStructuralIndexFree(&index);
+    XCTAssertTrue(index.positions == NULL);
+}
+
+- (void)testStructuralIndexMatchesAByteByByteWalk {
+    for (uint64_t seed = 1; seed <= 500; seed++) {
+        NSData *data = [self randomDocumentWithSeed:seed];
+
+        // the blocks are read from any alignment
+        for (NSUInteger offset = 0; offset < 4; offset++) {
+            NSMutableData *shifted = [NSMutableData dataWithLength:offset];
+            [shifted appendData:data];
+            [self assertStructuralIndexOfBytes:(const uint8_t *)shifted.bytes + offset length:data.length matchesReference:[NSString stringWithFormat:@"seed %llu offset %lu", seed, (unsigned long)offset]];
+        }
+    }
+}
+
+- (void)testStructuralIndexFollowsEscapesAcrossBlocks {
+    // runs of backslashes ending on each side of the 64 and 128 byte boundaries
+    for (NSUInteger padding = 50; padding < 140; padding++) {
+        for (NSUInteger backslashes = 1; backslashes <= 5; backslashes++) {
+            NSMutableString *document = [NSMutableString stringWithString:@"[\""];
+            [document appendString:[@"" stringByPaddingToLength:padding withString:@"a" startingAtIndex:0]];
+            [document appendString:[@"" stringByPaddingToLength:backslashes withString:@"\\" startingAtIndex:0]];
+            [document appendString:(backslashes % 2 == 1) ? @"\"\",1]" : @"\",1]"];
+
+            NSData *data = [self dataWithString:document];
+            [self assertStructuralIndexOfBytes:data.bytes length:data.length matchesReference:document];
+
+            ACEOAuth2RACJSONStructuralIndex index = { 0 };
+            size_t errorPosition;
+            XCTAssertEqual(ACEOAuth2RACJSONStructuralIndexBuild(data.bytes, data.length, &index, &errorPosition), ACEOAuth2RACJSONStructuralIndexSuccess, @"%@", document);
+            XCTAssertEqual(index.count, 6, @"%@", document);
+            ACEOAuth2RACJSONStructuralIndexFree(&index);
+        }
+    }
+}
+
+- (void)testStructuralIndexReportsInvalidStrings {
+    ACEOAuth2RACJSONStructuralIndex index = { 0 };
+    size_t errorPosition;
+
+    NSData *data = [self dataWithString:@"[\"abc"];
+    XCTAssertEqual(ACEOAuth2RACJSONStructuralIndexBuild(data.bytes, data.length, &index, &errorPosition), ACEOAuth2RACJSONStructuralIndexUnterminatedString);
+    XCTAssertEqual(errorPosition, data.length);
+
+    data = [self dataWithString:@"[\"ab\\\"]"];
+    XCTAssertEqual(ACEOAuth2RACJSONStructuralIndexBuild(data.bytes, data.length, &index, &errorPosition), ACEOAuth2RACJSONStructuralIndexUnterminatedString);
+
+    data = [self dataWithString:@"[\"ab\ncd\"]"];
+    XCTAssertEqual(ACEOAuth2RACJSONStructuralIndexBuild(data.bytes, data.length, &index, &errorPosition), ACEOAuth2RACJSONStructuralIndexControlCharacter);
+    XCTAssertEqual(errorPosition, 4);
+
+    // the whitespace is valid outside the strings
+    NSString *padding = [@"" stringByPaddingToLength:100 withString:@" " startingAtIndex:0];
+    data = [self dataWithString:[NSString stringWithFormat:@"[\n%@\"%@\t\"]", padding, padding]];
+    XCTAssertEqual(ACEOAuth2RACJSONStructuralIndexBuild(data.bytes, data.length, &index, &errorPosition), ACEOAuth2RACJSONStructuralIndexControlCharacter);
+    XCTAssertEqual(errorPosition, 203);
+
+    ACEOAuth2RACJSONStructuralIndexFree(&index);
+}
+
+- (void)testStructuralIndexParserMatchesAFNetworking {
+    ACEOAuth2RACJSONResponseSerializer *serializer = [ACEOAuth2RACJSONResponseSerializer serializer];
+    serializer.removesKeysWithNullValues = YES;
+    serializer.structuralIndexThreshold = 0;
+
+    NSMutableArray<NSData *> *documents = [NSMutableArray array];
+    for (NSString *document in [[self validDocuments] arrayByAddingObjectsFromArray:[self invalidDocuments]]) {
+        [documents addObject:[self dataWithString:document]];
+    }
+
+    NSData *truncated = [self dataWithString:@"{\"a\":[1,-2.5e3,\"x\\n\\u00e9\",true,null],\"b\":{\"c\":false}}"];
+    for (NSUInteger length = 1; length < truncated.length; length++) {
+        [documents addObject:[truncated subdataWithRange:NSMakeRange(0, length)]];
+    }
+
+    NSMutableData *byteOrderMark = [NSMutableData dataWithBytes:"\xef\xbb\xbf" length:3];
+    [byteOrderMark appendData:truncated];
+    [documents addObject:byteOrderMark];
+
+    [documents addObject:[self dataWithString:[self nestedArraysWithDepth:512]]];
+    for (uint64_t seed = 1; seed <= 200; seed++) {
+        [documents addObject:[self randomDocumentWithSeed:seed]];
+    }
+
+    for (NSData *data in documents) {
+        for (NSNumber *options in @[ @0, @(NSJSONReadingAllowFragments) ]) {
+            serializer.readingOptions = options.unsignedIntegerValue;
+
+            AFJSONResponseSerializer *expectedSerializer = [AFJSONResponseSerializer serializer];
+            expectedSerializer.removesKeysWithNullValues = YES;
+            expectedSerializer.readingOptions = options.unsignedIntegerValue;
+
+            NSError *error;
+            NSError *expectedError;
+            id object = [serializer responseObjectForResponse:[self JSONResponse] data:data error:&error];
+            id expected = [expectedSerializer responseObjectForResponse:[self JSONResponse] data:data error:&expectedError];
+
+            NSString *document = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+            XCTAssertEqualObjects(object, expected, @"%@", document);
+            XCTAssertEqual(error == nil, expectedError == nil, @"%@", document);
+        }
+    }
+
+    serializer.readingOptions = 0;
+    XCTAssertNil([serializer responseObjectForResponse:[self JSONResponse] data:[self dataWithString:[self nestedArraysWithDepth:513]] error:nil]);
+}
+
+- (void)testStructuralIndexParserKeepsNullValues {
+    ACEOAuth2RACJSONResponseSerializer *serializer = [ACEOAuth2RACJSONResponseSerializer serializer];
+    serializer.structuralIndexThreshold = 0;
+
+    for (NSString *document in [self validDocuments]) {
+        NSData *data = [self dataWithString:document];
+        XCTAssertEqualObjects([serializer responseObjectForResponse:[self JSONResponse] data:data error:nil], [NSJSONSerialization JSONObjectWithData:data options:0 error:nil], @"%@", document);
+    }
+}
+
+
+#pragma mark - Lazy JSON
+
+- (void)testLazyJSONMatchesAFNetworking {
+    NSMutableArray<NSData *> *documents = [NSMutableArray array];
+    for (NSString *document in [self validDocuments]) {
+        [documents addObject:[self dataWithString:document]];
+    }
+    for (uint64_t seed = 1; seed <= 200; seed++) {
+        [documents addObject:[self randomDocumentWithSeed:seed]];
+    }
+
+    for (NSData *data in documents) {
+        NSString *document = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        id expected = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:nil];
+        XCTAssertEqualObjects(ACEOAuth2RACLazyJSONObjectWithData(data, NSJSONReadingAllowFragments, NO, NULL), expected, @"%@", document);
+
+        AFJSONResponseSerializer *expectedSerializer = [AFJSONResponseSerializer serializer];
+        expectedSerializer.removesKeysWithNullValues = YES;
+        expectedSerializer.readingOptions = NSJSONReadingAllowFragments;
+        expected = [expectedSerializer responseObjectForResponse:[self JSONResponse] data:data error:nil];
+        XCTAssertEqualObjects(ACEOAuth2RACLazyJSONObjectWithData(data, NSJSONReadingAllowFragments, YES, NULL), expected, @"%@", document);
+    }
+}
+
+- (void)testLazyJSONResponseSerializerMatchesAFNetworking {
+    ACEOAuth2RACJSONResponseSerializer *serializer = [ACEOAuth2RACJSONResponseSerializer serializer];
+    serializer.removesKeysWithNullValues = YES;
+    serializer.decodesLazily = YES;
+
+    for (NSString *document in [self validDocuments]) {
+        NSData *data = [self dataWithString:document];
+        XCTAssertEqualObjects([serializer responseObjectForResponse:[self JSONResponse] data:data error:nil], [self AFObjectWithData:data error:nil], @"%@", document);
+    }
+
+    // the mutable containers are decoded right away
+    serializer.readingOptions = NSJSONReadingMutableContainers;
+    id object = [serializer responseObjectForResponse:[self JSONResponse] data:[self dataWithString:@"{\"a\":[1]}"] error:nil];
+    XCTAssertTrue([object isKindOfClass:[NSMutableDictionary class]]);
+    XCTAssertTrue([object[@"a"] isKindOfClass:[NSMutableArray class]]);
+}
+
+- (void)testLazyJSONKeepsTheLastValueOfRepeatedKeys {
+    NSDictionary *object = ACEOAuth2RACLazyJSONObjectWithData([self dataWithString:@"{\"a\":1,\"b\":2,\"a\":null,\"b\":3}"], 0, YES, NULL);
+    XCTAssertEqual(object.count, 1);
+    XCTAssertEqual(object.allKeys.count, 1);
+    XCTAssertNil(object[@"a"]);
+    XCTAssertEqualObjects(object[@"b"], @3);
+
+    object = ACEOAuth2RACLazyJSONObjectWithData([self dataWithString:@"{\"a\":1,\"b\":2,\"a\":null,\"b\":3}"], 0, NO, NULL);
+    XCTAssertEqual(object.count, 2);
+    XCTAssertEqualObjects(object[@"a"], [NSNull null]);
+    XCTAssertEqualObjects(object[@"b"], @3);
+
+    object = ACEOAuth2RACLazyJSONObjectWithData([self dataWithString:@"{\"a\":null,\"k\\u0065y\":1,\"key\":2,\"a\":{}}"], 0, YES, NULL);
+    XCTAssertEqualObjects(object, (@{ @"a": @{}, @"key": @2 }));
+    XCTAssertNil(object[@1]);
+}
+
+- (void)testLazyJSONRejectsInvalidDocuments {
+    // the escapes are checked only when the strings are read
+    NSMutableArray *documents = [[self invalidDocuments] mutableCopy];
+    [documents removeObjectsInArray:@[ @"[\"\\x\"]", @"[\"\\u12\"]" ]];
+
+    for (NSString *document in documents) {
+        NSError *error;
+        XCTAssertNil(ACEOAuth2RACLazyJSONObjectWithData([self dataWithString:document], 0, YES, &error), @"%@", document);
+        XCTAssertEqualObjects(error.domain, NSCocoaErrorDomain, @"%@", document);
+        XCTAssertEqual(error.code, NSPropertyListReadCorruptError, @"%@", document);
+    }
+
+    NSData *data = [self dataWithString:@"{\"a\":[1,-2.5e3,\"x\\n\\u00e9\",true,null],\"b\":{\"c\":false}}"];
+    for (NSUInteger length = 0; length < data.length; length++) {
+        XCTAssertNil(ACEOAuth2RACLazyJSONObjectWithData([data subdataWithRange:NSMakeRange(0, length)], 0, YES, NULL), @"%lu", (unsigned long)length);
+    }
+}
+
+- (void)testLazyJSONReadsInvalidStringsAsNull {
+    NSArray *object = ACEOAuth2RACLazyJSONObjectWithData([self dataWithString:@"[\"\\x\",\"\\uD83D\",\"\\uDE00\",\"\\uD83D\\uDE00\",\"ok\"]"], 0, YES, NULL);
+    XCTAssertEqualObjects(object, (@[ [NSNull null], [NSNull null], [NSNull null], @"\U0001F600", @"ok" ]));
+}
+
+- (void)testLazyJSONReadsNumbersAndTheByteOrderMark {
+    NSMutableData *data = [NSMutableData dataWithBytes:"\xef\xbb\xbf" length:3];
+    [data appendData:[self dataWithString:@"[9223372036854775807,-9223372036854775808,18446744073709551615,123456789012345678901234567890,-0,2.5e-3]"]];
+
+    NSArray *numbers = ACEOAuth2RACLazyJSONObjectWithData(data, 0, YES, NULL);
+    XCTAssertEqual(numbers.count, 6);
+    XCTAssertEqual([numbers[0] longLongValue], INT64_MAX);
+    XCTAssertEqual([numbers[1] longLongValue], INT64_MIN);
+    XCTAssertEqual([numbers[2] unsignedLongLongValue], UINT64_MAX);
+    XCTAssertEqualWithAccuracy([numbers[3] doubleValue], 123456789012345678901234567890.0, 1e15);
+    XCTAssertEqualObjects(numbers[4], @0);
+    XCTAssertEqualObjects(numbers[5], @0.0025);
+    XCTAssertThrowsSpecificNamed(numbers[6], NSException, NSRangeException);
+}
+
+- (void)testLazyJSONReadsFragments {
+    for (NSString *fragment in @[ @"\"x\"", @" 12 ", @"-1.5", @"true", @"false", @"null" ]) {
+        NSData *data = [self dataWithString:fragment];
+
+        id expected = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:nil];
+        XCTAssertEqualObjects(ACEOAuth2RACLazyJSONObjectWithData(data, NSJSONReadingAllowFragments, YES, NULL), expected, @"%@", fragment);
+        XCTAssertNil(ACEOAuth2RACLazyJSONObjectWithData(data, 0, YES, NULL), @"%@", fragment);
+    }
+}
+
+- (void)testLazyJSONLimitsTheDepth {
+    XCTAssertNotNil(ACEOAuth2RACLazyJSONObjectWithData([self dataWithString:[self nestedArraysWithDepth:512]], 0, YES, NULL));
+    XCTAssertNil(ACEOAuth2RACLazyJSONObjectWithData([self dataWithString:[self nestedArraysWithDepth:513]], 0, YES, NULL));
+    XCTAssertNil(ACEOAuth2RACLazyJSONObjectWithData([self dataWithString:[self nestedArraysWithDepth:100000]], 0, YES, NULL));
+}
+
+- (void)testLazyJSONProxiesAreImmutableAndThreadSafe {
+    NSData *data = [self benchmarkJSONData];
+    NSDictionary *object = ACEOAuth2RACLazyJSONObjectWithData(data, 0, YES, NULL);
+    XCTAssertTrue([object isKindOfClass:[NSDictionary class]]);
+    XCTAssertEqual([object copy], object);
+
+    NSArray *users = object[@"users"];
+    XCTAssertTrue([users isKindOfClass:[NSArray class]]);
+    XCTAssertEqual([users copy], users);
+
+    // the values are decoded once, whatever thread reads them first
+    NSArray *expected = [self AFObjectWithData:data error:nil][@"users"];
+    dispatch_apply(8, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t iteration) {
+        for (NSUInteger i = iteration; i < users.count; i += 8) {
+            XCTAssertEqualObjects(users[i], expected[i]);
+            XCTAssertEqual(users[i], users[i]);
+        }
+    });
+}
+
+
+#pragma mark - MessagePack
+
+- (void)testMessagePackDecodesEveryFormat {
+    NSDictionary *vectors = @{
+                              @"00": @0,
+                              @"7f": @127,
+                              @"e0": @-32,
+                              @"ff": @-1,
+                              @"cc ff": @255,
+                              @"cd ff ff": @65535,
+                              @"ce ff ff ff ff": @4294967295,
+                              @"cf ff ff ff ff ff ff ff ff": @(UINT64_MAX),
+                              @"d0 80": @-128,
+                              @"d1 80 00": @-32768,
+                              @"d2 80 00 00 00": @(INT32_MIN),
+                              @"d3 80 00 00 00 00 00 00 00": @(INT64_MIN),
+                              @"ca 3f c0 00 00": @1.5f,
+                              @"cb 40 09 21 fb 54 44 2d 18": @(M_PI),
+                              @"c0": [NSNull null],
+                              @"c2": @NO,
+                              @"c3": @YES,
+                              @"a0": @"",
+                              @"a3 61 62 63": @"abc",
+                              @"a2 c3 a9": @"é",
+                              @"a4 f0 9f 98 80": @"\U0001F600",
+                              @"d9 03 61 62 63": @"abc",
+                              @"da 00 03 61 62 63": @"abc",
+                              @"db 00 00 00 03 61 62 63": @"abc",
+                              @"c4 02 01 02": [self dataWithHexString:@"0102"],
+                              @"c5 00 02 01 02": [self dataWithHexString:@"0102"],
+                              @"c6 00 00 00 02 01 02": [self dataWithHexString:@"0102"],
+                              @"d4 05 aa": [self dataWithHexString:@"aa"],
+                              @"c7 02 05 aa bb": [self dataWithHexString:@"aabb"],
+                              @"d6 ff 00 00 00 01": [NSDate dateWithTimeIntervalSince1970:1],
+                              @"d7 ff 77 35 94 00 00 00 00 02": [NSDate dateWithTimeIntervalSince1970:2.5],
+                              @"c7 0c ff 00 00 00 00 ff ff ff ff ff ff ff ff": [NSDate dateWithTimeIntervalSince1970:-1],
+                              @"90": @[],
+                              @"92 01 a1 78": @[ @1, @"x" ],
+                              @"dc 00 02 01 02": @[ @1, @2 ],
+                              @"dd 00 00 00 02 01 02": @[ @1, @2 ],
+                              @"80": @{},
+                              @"82 a1 61 01 a1 62 c0": @{ @"a": @1, @"b": [NSNull null] },
+                              @"de 00 01 a1 61 01": @{ @"a": @1 },
+                              @"df 00 00 00 01 a1 61 01": @{ @"a": @1 },
+                              @"82 a1 61 01 a1 61 02": @{ @"a": @2 },
+                              @"81 01 91 c3": @{ @1: @[ @YES ] },
+                              };
+
+    [vectors enumerateKeysAndObjectsUsingBlock:^(NSString *hex, id expected, BOOL *stop) {
+        NSError *error;
+        id object = ACEOAuth2RACMessagePackObjectWithData([self dataWithHexString:hex], &error);
+        XCTAssertEqualObjects(object, expected, @"%@: %@", hex, error);
+    }];
+
+    NSNumber *number = ACEOAuth2RACMessagePackObjectWithData([self dataWithHexString:@"cf ff ff ff ff ff ff ff ff"], NULL);
+    XCTAssertEqual(number.unsignedLongLongValue, UINT64_MAX);
+}
+
+- (void)testMessagePackRejectsInvalidData {
+    NSArray *vectors = @[
+                         @"",
+                         @"c1",
+                         @"a3 61 62",
+                         @"91",
+                         @"82 a1 61 01",
+                         @"01 02",
+                         @"a1 ff",
+                         @"cd ff",
+                         @"cb 00 00 00",
+                         @"c7 03 ff 00 00 00",
+                         @"d4 ff 00",
+                         @"dd ff ff ff ff",
+                         @"df ff ff ff ff",
+                         @"db ff ff ff ff 61",
+                         ];
+
+    for (NSString *hex in vectors) {
+        NSError *error;
+        XCTAssertNil(ACEOAuth2RACMessagePackObjectWithData([self dataWithHexString:hex], &error), @"%@", hex);
+        XCTAssertEqualObjects(error.domain, ACEOAuth2RACErrorDomain, @"%@", hex);
+        XCTAssertEqual(error.code, ACEOAuth2RACErrorInvalidMessagePack, @"%@", hex);
+    }
+}
+
+- (void)testMessagePackMatchesJSON {
+    NSMutableArray<NSData *> *documents = [NSMutableArray array];
+    for (NSString *document in [self validDocuments]) {
+        [documents addObject:[self dataWithString:document]];
+    }
+    for (uint64_t seed = 1; seed <= 200; seed++) {
+        [documents addObject:[self randomDocumentWithSeed:seed]];
+    }
+    [documents addObject:[self benchmarkJSONData]];
+
+    for (NSData *data in documents) {
+        id expected = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:nil];
+        XCTAssertNotNil(expected);
+
+        NSError *error;
+        id object = ACEOAuth2RACMessagePackObjectWithData([self messagePackOfObject:expected], &error);
+        XCTAssertEqualObjects(object, expected, @"%@", error);
+    }
+}
+
+- (void)testMessagePackRejectsTruncatedData {
+    NSData *data = [self messagePackOfObject:@{
+                                               @"a": @[ @1, @-200, @70000, @(INT64_MIN), @(UINT64_MAX), @2.5, [NSNull null], @YES ],
+                                               @"b": @{ @"c": @"é \U0001F600", @"d": [self dataWithHexString:@"00ff"] },
+                                               @"e": [@"" stringByPaddingToLength:300 withString:@"x" startingAtIndex:0],
+                                               }];
+
+    XCTAssertNotNil(ACEOAuth2RACMessagePackObjectWithData(data, NULL));
+    for (NSUInteger length = 0; length < data.length; length++) {
+        XCTAssertNil(ACEOAuth2RACMessagePackObjectWithData([data subdataWithRange:NSMakeRange(0, length)], NULL), @"%lu", (unsigned long)length);
+    }
+}
+
+- (void)testMessagePackLimitsTheDepth {
+    NSMutableData *data = [NSMutableData data];
+    for (NSUInteger depth = 0; depth < 511; depth++) {
+        [self appendMessagePackType:0x91 value:0 size:0 toData:data];
+    }
+    [self appendMessagePackType:0x90 value:0 size:0 toData:data];
+    XCTAssertNotNil(ACEOAuth2RACMessagePackObjectWithData(data, NULL));
+
+    data = [NSMutableData data];
+    for (NSUInteger depth = 0; depth < 100000; depth++) {
+        [self appendMessagePackType:0x91 value:0 size:0 toData:data];
+    }
+    [self appendMessagePackType:0x90 value:0 size:0 toData:data];
+    XCTAssertNil(ACEOAuth2RACMessagePackObjectWithData(data, NULL));
+}
+
+- (void)testMessagePackResponseSerializer {
+    ACEOAuth2RACMessagePackResponseSerializer *serializer = [ACEOAuth2RACMessagePackResponseSerializer serializer];
+    NSData *data = [self messagePackOfObject:@{ @"a": @[ @1, @"x" ] }];
+
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:[NSURL URLWithString:@"https://example.com/items"]
+                                                              statusCode:200
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:@{ @"Content-Type": @"application/msgpack" }];
+    XCTAssertEqualObjects([serializer responseObjectForResponse:response data:data error:nil], (@{ @"a": @[ @1, @"x" ] }));
+
+    NSError *error;
+    XCTAssertNil([serializer responseObjectForResponse:[self JSONResponse] data:data error:&error]);
+    XCTAssertNotNil(error);
+}
+
+
+#pragma mark - JSON Stream Parser
+
+- (void)testStreamParserMatchesNSJSONSerialization {
+    NSMutableArray<NSData *> *documents = [NSMutableArray array];
+    [documents addObject:[self dataWithString:@"[]"]];
+    [documents addObject:[self dataWithString:@"[\"a\\\\\\\"b\",\"\\uD83D\\uDE00\",\"\\\\\",\"]\",\"[{\",\",\",{\"a\":[1,{\"b\":null}]},-0.5e-3,18446744073709551615,true,null]"]];
+    [documents addObject:[self dataWithString:[NSString stringWithFormat:@"[%@,%@]", [self nestedArraysWithDepth:100], [self nestedArraysWithDepth:1]]]];
+    for (uint64_t seed = 1; seed <= 50; seed++) {
+        [documents addObject:[self randomArrayWithSeed:seed]];
+    }
+
+    for (NSData *data in documents) {
+        NSString *document = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        NSArray *expected = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+        XCTAssertNotNil(expected, @"%@", document);
+
+        // the elements, the strings and their escapes split across the chunks
+        for (NSNumber *chunkSize in @[ @1, @2, @3, @7, @64, @(data.length) ]) {
+            XCTAssertEqualObjects([self streamedElementsOfData:data itemsKey:nil chunkSize:chunkSize.unsignedIntegerValue], expected, @"%@ %@", chunkSize, document);
+        }
+
+        // the array as the value of a key, after other keys and arrays
+        NSMutableData *wrapped = [NSMutableData dataWithData:[self dataWithString:@"{\"meta\":{\"items\":[0]},\"other\":[1,[2]],\"items\":"]];
+        [wrapped appendData:data];
+        [wrapped appendData:[self dataWithString:@",\"after\":[3]}"]];
+        for (NSNumber *chunkSize in @[ @1, @5, @(wrapped.length) ]) {
+            XCTAssertEqualObjects([self streamedElementsOfData:wrapped itemsKey:@"items" chunkSize:chunkSize.unsignedIntegerValue], expected, @"%@ %@", chunkSize, document);
+        }
+    }
+}
+
+- (void)testStreamParserMatchesEscapedKeys {
+    NSData *data = [self dataWithString:@"{\"\\u0069tems\":[1,2]}"];
+    XCTAssertEqualObjects([self streamedElementsOfData:data itemsKey:@"items" chunkSize:3], (@[ @1, @2 ]));
+
+    data = [self dataWithString:@"{\"it\\\"ems\":[1],\"items\":[2]}"];
+    XCTAssertEqualObjects([self streamedElementsOfData:data itemsKey:@"it\"ems" chunkSize:1], (@[ @1 ]));
+    XCTAssertEqualObjects([self streamedElementsOfData:data itemsKey:@"items" chunkSize:1], (@[ @2 ]));
+
+    data = [self dataWithString:@"{\"caf\u00e9\":[1],\"caf\\u00e9s\":[2]}"];
+    XCTAssertEqualObjects([self streamedElementsOfData:data itemsKey:@"caf\u00e9s" chunkSize:1], (@[ @2 ]));
+}
+
+- (void)testStreamParserReadsNonContiguousData {
+    dispatch_data_t first = dispatch_data_create("[1,\"a", 5, NULL, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+    dispatch_data_t second = dispatch_data_create("b\",2]", 5, NULL, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+    NSData *data = (NSData *)dispatch_data_create_concat(first, second);
+
+    XCTAssertEqualObjects([self streamedElementsOfData:data itemsKey:nil chunkSize:data.length], (@[ @1, @"ab", @2 ]));
+}
+
+- (void)testStreamParserSkipsTheByteOrderMark {
+    NSMutableData *data = [NSMutableData dataWithBytes:"\xef\xbb\xbf" length:3];
+    [data appendData:[self dataWithString:@"[1,2]"]];
+    XCTAssertEqualObjects([self streamedElementsOfData:data itemsKey:nil chunkSize:1], (@[ @1, @2 ]));
+}
+
+- (void)testStreamParserRejectsTruncatedDocuments {
+    NSData *data = [self dataWithString:@"{\"items\":[1,\"a\\\"b\",{\"c\":[null]},-2.5e3]}"];
+    NSUInteger end = [[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] rangeOfString:@"]" options:NSBackwardsSearch].location;
+
+    for (NSUInteger length = 0; length <= end; length++) {
+        XCTAssertNil([self streamedElementsOfData:[data subdataWithRange:NSMakeRange(0, length)] itemsKey:@"items" chunkSize:4], @"%lu", (unsigned long)length);
+    }
+
+    // the rest of the document is ignored once the array is complete
+    XCTAssertEqualObjects([self streamedElementsOfData:[data subdataWithRange:NSMakeRange(0, end + 1)] itemsKey:@"items" chunkSize:4], (@[ @1, @"a\"b", @{ @"c": @[ [NSNull null] ] }, @-2500 ]));
+}
+
+- (void)testStreamParserRejectsInvalidDocuments {
+    NSArray *documents = @[ @"[1,]", @"[,1]", @"[1,,2]", @"[1 2]", @"[tru]", @"[\"\\x\"]", @"[01]", @"]", @"{\"a\":1}" ];
+    for (NSString *document in documents) {
+        NSData *data = [self dataWithString:document];
+        XCTAssertNil([self streamedElementsOfData:data itemsKey:nil chunkSize:1], @"%@", document);
+        XCTAssertNil([self streamedElementsOfData:data itemsKey:nil chunkSize:data.length], @"%@", document);
+        XCTAssertNil([NSJSONSerialization JSONObjectWithData:data options:0 error:nil], @"%@", document);
+    }
+
+    ACEOAuth2RACJSONStreamParser *parser = [[ACEOAuth2RACJSONStreamParser alloc] initWithItemsKey:@"items"];
+    XCTAssertTrue([parser parseData:[self dataWithString:@"{\"other\":[1]}"] elementHandler:^(id element) {
+        XCTFail(@"%@", element);
+    } error:nil]);
+
+    NSError *error;
+    XCTAssertFalse([parser finishWithError:&error]);
+    XCTAssertEqualObjects(error.domain, ACEOAuth2RACErrorDomain);
+    XCTAssertEqual(error.code, ACEOAuth2RACErrorInvalidJSON);
+}
+
+
+#pragma mark - Query Encoder
+
+- (void)testQueryEncoderMatchesAFNetworking {
+    ACEOAuth2RACQueryEncoder *encoder = [ACEOAuth2RACQueryEncoder new];
+    for (id parameters in [self queryParameters]) {
+        XCTAssertEqualObjects([encoder queryStringFromParameters:parameters], AFQueryStringFromParameters(parameters), @"%@", parameters);
+    }
+}
+
+- (void)testQueryEncoderWithoutSortingKeepsThePairs {
+    ACEOAuth2RACQueryEncoder *encoder = [ACEOAuth2RACQueryEncoder new];
+    encoder.sortsKeys = NO;
+
+    for (id parameters in [self queryParameters]) {
+        NSString *query = [encoder queryStringFromParameters:parameters];
+        XCTAssertEqualObjects([self sortedPairsOfQuery:query], [self sortedPairsOfQuery:AFQueryStringFromParameters(parameters)], @"%@", parameters);
+    }
+}
+
+- (void)testQueryEncoderReusesTheConstantParameters {
+    ACEOAuth2RACQueryEncoder *encoder = [ACEOAuth2RACQueryEncoder new];
+    NSDictionary *filters = [encoder constantParameters:@{ @"status": @[ @"open", @"closed" ], @"owner": @{ @"name": @"Jürgen" }, @"archived": [NSNull null] }];
+    NSDictionary *empty = [encoder constantParameters:@{}];
+
+    NSArray *parameters = @[
+                            @{ @"filter": filters, @"page": @1 },
+                            @{ @"filter": filters, @"page": @2, @"a": @"first" },
+                            @{ @"other": filters },
+                            @{ @"list": @[ filters, filters ], @"z": @"last" },
+                            @{ @"nested": @{ @"filter": filters } },
+                            @{ @"a": @1, @"empty": empty, @"z": @2 },
+                            @[ filters ],
+                            [NSSet setWithObject:filters],
+                            filters,
+                            ];
+
+    // the encodings are made on the first pass and copied on the second one
+    for (NSUInteger pass = 0; pass < 2; pass++) {
+        for (id parameter in parameters) {
+            XCTAssertEqualObjects([encoder queryStringFromParameters:parameter], AFQueryStringFromParameters(parameter), @"%@", parameter);
+        }
+    }
+
+    // an encoding follows the order of the keys
+    encoder.sortsKeys = NO;
+    for (id parameter in parameters) {
+        XCTAssertEqualObjects([self sortedPairsOfQuery:[encoder queryStringFromParameters:parameter]], [self sortedPairsOfQuery:AFQueryStringFromParameters(parameter)], @"%@", parameter);
+    }
+
+    encoder.sortsKeys = YES;
+    [encoder removeConstantParameters:filters];
+    for (id parameter in parameters) {
+        XCTAssertEqualObjects([encoder queryStringFromParameters:parameter], AFQueryStringFromParameters(parameter), @"%@", parameter);
+    }
+}
+
+- (void)testQueryEncoderDoesNotRetainTheConstantParameters {
+    ACEOAuth2RACQueryEncoder *encoder = [ACEOAuth2RACQueryEncoder new];
+    __weak NSDictionary *weakFilters;
+
+    @autoreleasepool {
+        NSDictionary *filters = [encoder constantParameters:[NSMutableDictionary dictionaryWithObject:@"open" forKey:@"status"]];
+        XCTAssertEqualObjects([encoder queryStringFromParameters:@{ @"filter": filters }], @"filter%5Bstatus%5D=open");
+        weakFilters = filters;
+    }
+
+    XCTAssertNil(weakFilters);
+}
+
+
+#pragma mark - Query Scanner
+
+// the reference: the dictionary of NSURL+QueryDictionary, which the redirect handler used before the scanner
+- (NSDictionary<NSString *, id> *)queryDictionaryOfURL:(NSURL *)URL {
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+    for (NSString *pair in [URL.query componentsSeparatedByString:@"&"]) {
+        NSArray<NSString *> *components = [pair componentsSeparatedByString:@"="];
+        if (components.count > 2) {
+            continue;
+        }
+        NSString *key = [components[0] stringByRemovingPercentEncoding];
+        NSString *value = components.count == 2 ? [components[1] stringByRemovingPercentEncoding] : nil;
+        dictionary[key] = value.length ? value : [NSNull null];
+    }
+    return dictionary;
+}
+
+- (void)testQueryScannerDecodesThePlusAsASpace {
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey([NSURL URLWithString:@"app://callback?code=a+b%2Bc"], @"code"), @"a b+c");
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey([NSURL URLWithString:@"app://callback?the+key=value"], @"the key"), @"value");
+}
+
+- (void)testQueryScannerReadsTheFragment {
+    NSURL *URL = [NSURL URLWithString:@"app://callback#code=abc&state=xyz"];
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"code"), @"abc");
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"state"), @"xyz");
+    XCTAssertNil(ACEOAuth2RACQueryValueForKey(URL, @"error"));
+    XCTAssertEqual(ACEOAuth2RACQueryParameterCount(URL), 2);
+
+    // the query wins, the fragment gives only what it misses
+    URL = [NSURL URLWithString:@"app://callback?code=query&state=s#code=fragment&error=denied"];
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"code"), @"query");
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"error"), @"denied");
+    XCTAssertEqual(ACEOAuth2RACQueryParameterCount(URL), 4);
+}
+
+// the bytes as they are, +URLWithString: refuses the malformed escapes that a web view can still navigate to
+- (NSURL *)URLWithBytesOfString:(NSString *)string {
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    NSURL *URL = CFBridgingRelease(CFURLCreateWithBytes(kCFAllocatorDefault, data.bytes, data.length, kCFStringEncodingUTF8, NULL));
+    XCTAssertNotNil(URL, @"%@", string);
+    return URL;
+}
+
+- (void)testQueryScannerKeepsTheMalformedEscapes {
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey([self URLWithBytesOfString:@"app://callback?code=%zz"], @"code"), @"%zz");
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey([self URLWithBytesOfString:@"app://callback?code=100%25%4"], @"code"), @"100%%4");
+
+    NSURL *URL = [self URLWithBytesOfString:@"app://callback?code=%41%4G&state=%#error=%%"];
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"code"), @"A%4G");
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"state"), @"%");
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"error"), @"%%");
+}
+
+- (void)testQueryScannerReadsTheKeysWithoutValue {
+    NSURL *URL = [NSURL URLWithString:@"app://callback?flag&&code=&state=s&"];
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"flag"), @"");
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"code"), @"");
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"state"), @"s");
+    XCTAssertNil(ACEOAuth2RACQueryValueForKey(URL, @"fla"));
+    XCTAssertNil(ACEOAuth2RACQueryValueForKey(URL, @"flags"));
+    XCTAssertEqual(ACEOAuth2RACQueryParameterCount(URL), 3);
+}
+
+- (void)testQueryScannerReadsTheLongURLs {
+    // past the buffer on the stack for the URL, and for the value
+    NSString *padding = [@"" stringByPaddingToLength:2000 withString:@"x" startingAtIndex:0];
+    NSString *value = [@"" stringByPaddingToLength:600 withString:@"v%20" startingAtIndex:0];
+    NSURL *URL = [NSURL URLWithString:[NSString stringWithFormat:@"app://callback?padding=%@&code=%@#state=s", padding, value]];
+    XCTAssertGreaterThan(URL.absoluteString.length, 1024);
+
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"padding"), padding);
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"code"), [value stringByRemovingPercentEncoding]);
+    XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, @"state"), @"s");
+    XCTAssertEqual(ACEOAuth2RACQueryParameterCount(URL), 3);
+}
+
+- (void)testQueryScannerMatchesTheQueryDictionary {
+    NSArray<NSString *> *URLStrings = @[
+                                        @"app://callback?code=first&code=second",
+                                        @"app://callback?code=a&state=1&code=b&state=2&code=c",
+                                        @"app://callback?c%6Fde=encoded&code=plain",
+                                        @"app://callback?code=plain&c%6Fde=encoded",
+                                        @"app://callback?state=%E2%9C%93&code=%2F%3F%26&state=caf%C3%A9",
+                                        ];
+
+    for (NSString *URLString in URLStrings) {
+        NSURL *URL = [NSURL URLWithString:URLString];
+        [[self queryDictionaryOfURL:URL] enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+            XCTAssertEqualObjects(ACEOAuth2RACQueryValueForKey(URL, key), value, @"%@", URLString);
+        }];
+    }
+}
+
+
+#pragma mark - Shared Session
+
+- (AFHTTPSessionManager *)networkManagerWithBaseURL:(NSURL *)baseURL {
+    AFHTTPSessionManager *networkManager = [[AFHTTPSessionManager alloc] initWithBaseURL:baseURL];
+    networkManager.responseSerializer = [[ACEOAuth2RACResponseSerializer alloc] initWithDefaultSerializer:[AFJSONResponseSerializer serializer]];
+    return networkManager;
+}
+
+// a token call followed by an API call, one at a time so an idle connection can be reused
+- (void)runTokenAndAPICallsWithOAuthManager:(AFOAuth2Manager *)OAuthManager networkManager:(AFHTTPSessionManager *)networkManager count:(NSUInteger)count {
+    for (NSUInteger i = 0; i < count; i++) {
+        XCTestExpectation *tokenExpectation = [self expectationWithDescription:@"token"];
+        [OAuthManager authenticateUsingOAuthWithURLString:@"oauth/token" parameters:@{ @"grant_type": @"client_credentials" } success:^(AFOAuthCredential *credential) {
+            XCTAssertEqualObjects(credential.accessToken, @"token");
+            [tokenExpectation fulfill];
+        } failure:^(NSError *error) {
+            XCTFail(@"%@", error);
+            [tokenExpectation fulfill];
+        }];
+        [self waitForExpectationsWithTimeout:10 handler:nil];
+
+        XCTestExpectation *APIExpectation = [self expectationWithDescription:@"API"];
+        [networkManager GET:@"items" parameters:nil progress:nil success:^(NSURLSessionDataTask *task, id responseObject) {
+            XCTAssertEqualObjects(responseObject[@"token_type"], @"Bearer");
+            [APIExpectation fulfill];
+        } failure:^(NSURLSessionDataTask *task, NSError *error) {
+            XCTFail(@"%@", error);
+            [APIExpectation fulfill];
+        }];
+        [self waitForExpectationsWithTimeout:10 handler:nil];
+    }
+}
+
+- (ACEOAuth2RACTestServer *)tokenServer {
+    return [self tokenServerWithIdentity:nil];
+}
+
+- (ACEOAuth2RACTestServer *)tokenServerWithIdentity:(id)identity {
+    ACEOAuth2RACTestServer *server = [[ACEOAuth2RACTestServer alloc] initWithResponseBody:[self dataWithString:@"{\"access_token\":\"token\",\"token_type\":\"Bearer\",\"expires_in\":3600}"]
+                                                                                 identity:(__bridge SecIdentityRef)identity];
+    XCTAssertNotNil(server);
+    return server;
+}
+
+// a self-signed RSA certificate for 127.0.0.1 (serverAuth, subjectAltName IP:127.0.0.1) with its key,
+// in a PKCS #12 protected by "test"; the certificate expires in January 2029, regenerate it with:
+//   openssl req -x509 -newkey rsa:2048 -nodes -keyout key.pem -out cert.pem -days 825 -sha256 -config cert.cnf
+//   openssl pkcs12 -export -inkey key.pem -in cert.pem -out identity.p12 -passout pass:test \
+//     -certpbe PBE-SHA1-3DES -keypbe PBE-SHA1-3DES -macalg sha1
+- (id)TLSIdentity {
+    NSString *PKCS12String = [@[
+                                 @"MIIJpAIBAzCCCWoGCSqGSIb3DQEHAaCCCVsEgglXMIIJUzCCA+cGCSqGSIb3DQEHBqCCA9gwggPUAgEAMIIDzQYJKoZIhvcN",
+                                 @"AQcBMBwGCiqGSIb3DQEMAQMwDgQIWma6DRLdALYCAggAgIIDoIyDNAtc60hUbpt9w/sRPyStiz814TLSJHubS+iAESRNHcyu",
+                                 @"1Ty861c1RfyE1C/7b+VhkwLAKdYGlVD1Y3ShU83U8MpUPaHPuCdd11poIlXiirj/A333d3rWD/D7eyapno7bsy6vlIbjmDOw",
+                                 @"3w3CiD5cK0qL3H1EI/piVLily/qdJ1D0BMfhd9khv+k2q9mSZxugcpSARaE071WMCG8l41Rb6OeYFnbtcxCr/qZSBig17UKs",
+                                 @"p3dXhJxoiRq0X5n3/J5y2lF8nhpSbsCxAqrIFHiDyVjYsh/o9LYTZ225cuQNnuaid2XcNA431VAt8Wt0rt4K3/CmSf/X5IXa",
+                                 @"joEJ3nHA+Ko0G37J5NtXfM32tQnBrdpF7jqdu5cQ/Kdhe9E6pxELAOisjuiUqbRjbb82waD76NrMhbkgoUF7CgfVDy3XdNe7",
+                                 @"kVp9wpzozx5/yNA/z6ltRCBImHejmUVTZ6PSuFcAyERaGCTsNW7tkmcOW0Sj8dehJVNgOoY5vw1nYRCj676JfmMmPZnT/e5t",
+                                 @"mN8yXyeMjQm1H6Kd71NtCcc/4wJfj3r8y8BHOdm0BZh2YcNgmCC3rlaj4kERJI197/FWeSZWRLjCtpcEzX95tw82x1RivLyB",
+                                 @"zWGv5aN5CRScevQo08j3dYYJwVmGBIEaQtNsZhtmFcs5p73quoM9uIR3PyvAltpMhM0sJf7b1gvbIgTGCacu0epR+0xpeEGK",
+                                 @"A9TITYq4/KZiv5RLc4DuhOqcViK0XJ67YeYmpQMTKWEVSK7T5jpz/usjJPanCxx2NxTYAwT79HGdOKEGY5SvPAoNWM8f9A39",
+                                 @"SnYmFn/bZw4WSArb5ToW2SD/cmrRNF3lrQr0TjPxDH28jkTkJT8eK7nPte2WLfA4CUdOW8PouzJFN8fgmKXGwzCtfA/eIBWZ",
+                                 @"qi+sJXY6gLzud+wlLTZFHFHNbGIlFNUsez3iYaUm3/GTr6PzaD01pRnq2yTL0mNF2UxBnz4hVpb3v7lI1KFN3qQOCzP59+v4",
+                                 @"W43LQhY+80YGKWJQsmWAmszlJJjSBQGOffYMtxcKd8wTWqAz4pi2Q3EiyS7tdyveA77N7Gc2C8sNT0rgax7CxXvH2KWKqS+v",
+                                 @"+v+o2+qZpaxtuf09WxdiDoGKNkCuOqaipRrPhG48COBhGxiFz8XvT7HoIWTTaxk+/LEu+oIgEikDUeHKARsIHwGwdyNVlmgV",
+                                 @"vRCrZ1W/xmcVoF3DSqLFIaESn2HcPIBAhUntxb8wggVkBgkqhkiG9w0BBwGgggVVBIIFUTCCBU0wggVJBgsqhkiG9w0BDAoB",
+                                 @"AqCCBO4wggTqMBwGCiqGSIb3DQEMAQMwDgQI9pJYoFKXmsYCAggABIIEyMrD2yWcZ/h/AFixi1wqiaFKErHC/o9LlAlENk29",
+                                 @"8LnySgKcraFS++5hYKCxl5wjpRovsMhfPVLrG65K+h9EEqnGwZtVPt9VpCiAabl57j0r8BOrnUDNFwmU/61PkFyod70vtrIo",
+                                 @"oAIc19Lx8n9bPqyl8jqJZ6e1WtHk95v7Q7dU5OJKt95fG6AY/RyHmNXO0QYLolLrPo1kFDkcCNZ1kViPmTtzIlEaEiHLrfM2",
+                                 @"qKQpr4rEbIyDAr6dp+D56OKh58XkOcDkHF+AcWffbB+U9NQBkyyAr76w6kmIQTtT5vyflRpL55o31NoXxmGSgGMBIA8oXTTv",
+                                 @"41rNw8dmGMd2j/UIwSczsHOaFRtwTCp2lcq7rhrAmRFOHe5GBdLsCQuMXItrqPNr9n8Y+rbK8Mfhk52HwpYP68hVJ/gzT0l+",
+                                 @"L27BvnmAeJ5dNiyU54UFl8XNq1kz2JWK8wcxAkf3V7X5RaBXMaWoGppdVdiL6CRLmq/hKgE2yoJMmi2e1QXH9v081SBcorQm",
+                                 @"NxZE2CA9b7tJRCm03XxegQkzd6eL4Vt6ZXyGRu3dokrfrC528UfoXeqYBMIciVfTcR8ZRCCv5MHI5hawIdlLbhgqCcLUHdI1",
+                                 @"sDaD5ZZMLJkjOIV92bBxfjegfkjxcvTSUpAu0BuTJ7iw12xJFD0J4UUiuJtB9YoEPg0dizE/LEYyzuws1uuYsrrktUFbMHz8",
+                                 @"eURgSE0sX0Pfby4TMNTvmmkxosm+VQDPEHLWFaCUVdRuSAzovFhwPV626KeeDre8pcKjqPjejJof5w7HvkVYn3AJFmfEmomi",
+                                 @"fLCoh6sy6u7G0ux6i2et0tvDDHKv/KUlPsn6+cHpwXsOvFcErpKnQEV7PDOcknHguwVZ+d7muvqGouePjOjP3s486LD2+Gu2",
+                                 @"MP+bUgjRccGROW64LyOsEUi3sANUC3cq0B2LEzaOqb9oKH+NkY4hJpIze5Q+sfg7Fva25/BYne534tnWsOccxtCwtEkcJFwr",
+                                 @"hdIenurylS1h5qiA+X7anVUB5IQj+Axf553uAr6bysiX5leHtto10XciddQ+jgUUBoHcdnJwSq6ox93BxMarMwYWHX7qlIDG",
+                                 @"QbIs1YItiRbFyKcj7O/WTazbnfeGp8RgnEPYj3gN0D2GVURwTxmGV6eURWpRNGMHo8ZWxXBvsC/n3tL5AUbZL7Bu1HXzlHd4",
+                                 @"fRXYxuvqKt0FZFOVKFncg88OAHqRmzBLu9jdG8pb/D7uWVjTq8jM8oJHvRA307RT7jgAHPtQmzKL0R4qpf6g71cwrCDkIRPG",
+                                 @"335Ni/noCdY+V+BqVF4lZviY3Tb6outIKyzaWQHn8pBOfiZoToGUyuKB7uVc53cdqIAx/fwUmUCtdar1B2KIItQz9EPII5S6",
+                                 @"kAmNhZqCGCIksPej/pGCPGoiNMCsIayEEpFCt8EFn7Hiv0uivblRgWxGiQIna9oShNCNg90dc+jklAnVngLjRa4FZCd4zO5N",
+                                 @"AxqvvYdqWyaFGh36pleBqWFgQCZHTdOhdtWr2qzOvAw9O4fKowrmOOZsnIggGTLtiaxBIjXqp7rRWK5xweCtFKIHcZlNWXfo",
+                                 @"PUf6UmwhP2bjegcz4E5zxYZbl0xG6KGlhlivDphepyBFiyGS2gtAeC+G9jFIMCEGCSqGSIb3DQEJFDEUHhIAMQAyADcALgAw",
+                                 @"AC4AMAAuADEwIwYJKoZIhvcNAQkVMRYEFM7iDYYzdpiyACE4xR4K3s8V2x6pMDEwITAJBgUrDgMCGgUABBTltDGPmjyUpdCf",
+                                 @"T85tfkMW2hpz2QQIWvln24wKsfECAggA",
+                                 ] componentsJoinedByString:@""];
+
+    NSData *PKCS12Data = [[NSData alloc] initWithBase64EncodedString:PKCS12String options:0];
+    CFArrayRef itemsRef = NULL;
+    OSStatus status = SecPKCS12Import((__bridge CFDataRef)PKCS12Data, (__bridge CFDictionaryRef)@{ (__bridge id)kSecImportExportPassphrase: @"test" }, &itemsRef);
+    XCTAssertEqual(status, errSecSuccess);
+
+    NSArray<NSDictionary *> *items = CFBridgingRelease(itemsRef);
+    id identity = items.firstObject[(__bridge id)kSecImportItemIdentity];
+    XCTAssertNotNil(identity);
+    return identity;
+}
+
+// the key of the certificate is pinned, it has no chain to the system roots and its dates are never evaluated
+- (AFSecurityPolicy *)securityPolicyTrustingIdentity:(id)identity {
+    SecCertificateRef certificate = NULL;
+    XCTAssertEqual(SecIdentityCopyCertificate((__bridge SecIdentityRef)identity, &certificate), errSecSuccess);
+    NSData *certificateData = CFBridgingRelease(SecCertificateCopyData(certificate));
+    CFRelease(certificate);
+
+    AFSecurityPolicy *securityPolicy = [AFSecurityPolicy policyWithPinningMode:AFSSLPinningModePublicKey withPinnedCertificates:[NSSet setWithObject:certificateData]];
+    securityPolicy.allowInvalidCertificates = YES;
+    return securityPolicy;
+}
+
+- (void)testSharedSessionReusesTheConnection {
+    ACEOAuth2RACTestServer *server = [self tokenServer];
+    AFHTTPSessionManager *networkManager = [self networkManagerWithBaseURL:server.baseURL];
+
+    ACEOAuth2RACOAuthManager *OAuthManager = [[ACEOAuth2RACOAuthManager alloc] initWithBaseURL:server.baseURL clientID:@"client" secret:@"secret"];
+    OAuthManager.sharedSessionManager = networkManager;
+
+    [self runTokenAndAPICallsWithOAuthManager:OAuthManager networkManager:networkManager count:5];
+    XCTAssertEqual(server.connectionCount, 1);
+
+    [networkManager invalidateSessionCancelingTasks:YES];
+    [OAuthManager invalidateSessionCancelingTasks:YES];
+    [server stop];
+}
+
+- (void)testSeparateSessionsOpenTheirOwnConnections {
+    ACEOAuth2RACTestServer *server = [self tokenServer];
+    AFHTTPSessionManager *networkManager = [self networkManagerWithBaseURL:server.baseURL];
+    ACEOAuth2RACOAuthManager *OAuthManager = [[ACEOAuth2RACOAuthManager alloc] initWithBaseURL:server.baseURL clientID:@"client" secret:@"secret"];
+
+    [self runTokenAndAPICallsWithOAuthManager:OAuthManager networkManager:networkManager count:5];
+    XCTAssertEqual(server.connectionCount, 2);
+
+    [networkManager invalidateSessionCancelingTasks:YES];
+    [OAuthManager invalidateSessionCancelingTasks:YES];
+    [server stop];
+}
+
+- (void)testSharedSessionSharesTheTLSHandshake {
+    id identity = [self TLSIdentity];
+    ACEOAuth2RACTestServer *server = [self tokenServerWithIdentity:identity];
+    AFHTTPSessionManager *networkManager = [self networkManagerWithBaseURL:server.baseURL];
+    networkManager.securityPolicy = [self securityPolicyTrustingIdentity:identity];
+
+    ACEOAuth2RACOAuthManager *OAuthManager = [[ACEOAuth2RACOAuthManager alloc] initWithBaseURL:server.baseURL clientID:@"client" secret:@"secret"];
+    OAuthManager.securityPolicy = [self securityPolicyTrustingIdentity:identity];
+    OAuthManager.sharedSessionManager = networkManager;
+
+    [self runTokenAndAPICallsWithOAuthManager:OAuthManager networkManager:networkManager count:5];
+    XCTAssertEqual(server.handshakeCount, 1);
+
+    [networkManager invalidateSessionCancelingTasks:YES];
+    [OAuthManager invalidateSessionCancelingTasks:YES];
+    [server stop];
+}
+
+- (void)testSeparateSessionsMakeTheirOwnTLSHandshakes {
+    id identity = [self TLSIdentity];
+    ACEOAuth2RACTestServer *server = [self tokenServerWithIdentity:identity];
+    AFHTTPSessionManager *networkManager = [self networkManagerWithBaseURL:server.baseURL];
+    networkManager.securityPolicy = [self securityPolicyTrustingIdentity:identity];
+
+    ACEOAuth2RACOAuthManager *OAuthManager = [[ACEOAuth2RACOAuthManager alloc] initWithBaseURL:server.baseURL clientID:@"client" secret:@"secret"];
+    OAuthManager.securityPolicy = [self securityPolicyTrustingIdentity:identity];
+
+    [self runTokenAndAPICallsWithOAuthManager:OAuthManager networkManager:networkManager count:5];
+    XCTAssertEqual(server.handshakeCount, 2);
+
+    [networkManager invalidateSessionCancelingTasks:YES];
+    [OAuthManager invalidateSessionCancelingTasks:YES];
+    [server stop];
+}
+
+- (void)testSharedSessionFallsBackWhenTheSerializerIsReplaced {
+    ACEOAuth2RACTestServer *server = [self tokenServer];
+    AFHTTPSessionManager *networkManager = [self networkManagerWithBaseURL:server.baseURL];
+
+    ACEOAuth2RACOAuthManager *OAuthManager = [[ACEOAuth2RACOAuthManager alloc] initWithBaseURL:server.baseURL clientID:@"client" secret:@"secret"];
+    OAuthManager.sharedSessionManager = networkManager;
+    networkManager.responseSerializer = [AFJSONResponseSerializer serializer];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"refresh"];
+    [OAuthManager authenticateUsingOAuthWithURLString:@"oauth/token" refreshToken:@"refresh" success:^(AFOAuthCredential *credential) {
+        XCTAssertEqualObjects(credential.accessToken, @"token");
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"%@", error);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+
+    // the refresh ran on the session of the OAuth manager
+    [self runTokenAndAPICallsWithOAuthManager:OAuthManager networkManager:networkManager count:1];
+    XCTAssertEqual(server.connectionCount, 2);
+
+    [networkManager invalidateSessionCancelingTasks:YES];
+    [OAuthManager invalidateSessionCancelingTasks:YES];
+    [server stop];
+}
+
+
+#pragma mark - Pre-warm
+
+// a server answering every call with an empty object, recording the methods
+- (ACEOAuth2RACTestServer *)prewarmServerWithMethods:(NSMutableArray<NSString *> *)methods {
+    NSData *response = [ACEOAuth2RACTestServer responseWithStatusCode:200 headers:@{ @"Content-Type": @"application/json" } body:[self dataWithString:@"{}"]];
+    ACEOAuth2RACTestServer *server = [[ACEOAuth2RACTestServer alloc] initWithHandler:^NSData *(NSString *method, NSString *path, NSDictionary<NSString *, NSString *> *headers, NSData *body) {
+        @synchronized (methods) {
+            [methods addObject:method];
+        }
+        return response;
+    }];
+    XCTAssertNotNil(server);
+    [self addTeardownBlock:^{
+        [server stop];
+    }];
+    return server;
+}
+
+- (NSUInteger)countOfMethod:(NSString *)method inMethods:(NSMutableArray<NSString *> *)methods {
+    @synchronized (methods) {
+        return [methods indexesOfObjectsPassingTest:^BOOL(NSString *otherMethod, NSUInteger index, BOOL *stop) {
+            return [otherMethod isEqualToString:method];
+        }].count;
+    }
+}
+
+- (void)sendFirstRequestWithManager:(ACEOAuth2RACManager *)manager {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"first request"];
+    [manager.networkManager GET:@"items" parameters:nil progress:nil success:^(NSURLSessionDataTask *task, id responseObject) {
+        [expectation fulfill];
+    } failure:^(NSURLSessionDataTask *task, NSError *error) {
+        XCTFail(@"%@", error);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testPrewarmOpensTheConnectionOfTheFirstRequest {
+    NSMutableArray<NSString *> *methods = [NSMutableArray array];
+    ACEOAuth2RACTestServer *server = [self prewarmServerWithMethods:methods];
+    ACEOAuth2RACManager *manager = [[ACEOAuth2RACManager alloc] initWithBaseURL:server.baseURL clientID:@"client" secret:@"secret" redirectURL:nil];
+
+    manager.prewarmURLString = @"ping";
+    [self waitForCondition:^BOOL{
+        return [self countOfMethod:@"HEAD" inMethods:methods] == 1;
+    }];
+
+    // the API and token hosts are the same, a single connection is opened and then reused
+    [self sendFirstRequestWithManager:manager];
+    XCTAssertEqual(server.connectionCount, 1);
+
+    // nothing is sent again within the interval
+    [manager prewarmConnections];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertEqual([self countOfMethod:@"HEAD" inMethods:methods], 1);
+
+    [manager.networkManager invalidateSessionCancelingTasks:YES];
+}
+
+- (void)testPrewarmRunsWhenTheAppReturnsToTheForeground {
+    NSMutableArray<NSString *> *methods = [NSMutableArray array];
+    ACEOAuth2RACTestServer *server = [self prewarmServerWithMethods:methods];
+    ACEOAuth2RACManager *manager = [[ACEOAuth2RACManager alloc] initWithBaseURL:server.baseURL clientID:@"client" secret:@"secret" redirectURL:nil];
+    manager.prewarmURLString = @"ping";
+    [self waitForCondition:^BOOL{
+        return [self countOfMethod:@"HEAD" inMethods:methods] == 1;
+    }];
+
+    // the idle connections are closed in background
+    manager.prewarmInterval = 0.0;
+    [server closeConnections];
+    [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationWillEnterForegroundNotification object:nil];
+    [self waitForCondition:^BOOL{
+        return [self countOfMethod:@"HEAD" inMethods:methods] == 2;
+    }];
+
+    [self sendFirstRequestWithManager:manager];
+    XCTAssertEqual(server.connectionCount, 2);
+
+    [manager.networkManager invalidateSessionCancelingTasks:YES];
+}
+
+
+#pragma mark - Offline Queue
+
+- (NSURL *)offlineJournalURL {
+    NSURL *journalURL = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES] URLByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"journal"]];
+    [self addTeardownBlock:^{
+        [[NSFileManager defaultManager] removeItemAtURL:journalURL error:nil];
+    }];
+    return journalURL;
+}
+
+// a queue over the journal, recording the requests it sends, as a new process would load it
+- (ACEOAuth2RACOfflineQueue *)offlineQueueWithJournalURL:(NSURL *)journalURL sentRequests:(NSMutableArray<ACEOAuth2RACRequest *> *)sentRequests signals:(RACSignal *(^)(ACEOAuth2RACRequest *request))signals {
+    ACEOAuth2RACOfflineQueue *queue = [[ACEOAuth2RACOfflineQueue alloc] initWithIdentifier:@"https://example.com/" sendBlock:^RACSignal *(ACEOAuth2RACRequest *request) {
+        @synchronized (sentRequests) {
+            [sentRequests addObject:request];
+        }
+        return signals ? signals(request) : [RACSignal empty];
+    }];
+    queue.journalURL = journalURL;
+    return queue;
+}
+
+- (void)enqueueOfflineRequest:(ACEOAuth2RACRequest *)request inQueue:(ACEOAuth2RACOfflineQueue *)queue {
+    NSError *error;
+    XCTAssertTrue([[queue rac_enqueueRequest:request] asynchronouslyWaitUntilCompleted:&error], @"%@", error);
+}
+
+// the predicate expectations poll once a second, too slow for the tests running many replays
+- (void)waitForCondition:(BOOL (^)(void))condition {
+    NSDate *timeoutDate = [NSDate dateWithTimeIntervalSinceNow:10];
+    while (!condition() && timeoutDate.timeIntervalSinceNow > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    XCTAssertTrue(condition());
+}
+
+- (NSArray<NSString *> *)descriptionsOfOfflineRequests:(NSMutableArray<ACEOAuth2RACRequest *> *)requests {
+    NSMutableArray<NSString *> *descriptions = [NSMutableArray array];
+    @synchronized (requests) {
+        for (ACEOAuth2RACRequest *request in requests) {
+            // the keys sorted, like the merged parameters of the PATCH requests
+            NSString *query = request.parameters ? AFQueryStringFromParameters(request.parameters) : @"";
+            [descriptions addObject:[NSString stringWithFormat:@"%@ %@ %@", request.HTTPMethod, request.path, query]];
+        }
+    }
+    return descriptions;
+}
+
+// the offsets where the records of the journal end, from the length in their header
+- (NSArray<NSNumber *> *)recordEndsOfJournalData:(NSData *)data {
+    NSMutableArray<NSNumber *> *ends = [NSMutableArray array];
+    NSUInteger offset = 0;
+    while (offset + 8 <= data.length) {
+        uint32_t length;
+        [data getBytes:&length range:NSMakeRange(offset, 4)];
+        offset += 8 + CFSwapInt32LittleToHost(length);
+        [ends addObject:@(offset)];
+    }
+    XCTAssertEqual(offset, data.length);
+    return ends;
+}
+
+- (NSError *)serverErrorWithStatusCode:(NSInteger)statusCode {
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:[NSURL URLWithString:@"https://example.com/items"] statusCode:statusCode HTTPVersion:@"HTTP/1.1" headerFields:nil];
+    return [NSError errorWithDomain:AFURLResponseSerializationErrorDomain code:NSURLErrorBadServerResponse userInfo:@{ AFNetworkingOperationFailingURLResponseErrorKey: response }];
+}
+
+- (void)testOfflineQueueCollapsesSupersededRequests {
+    NSURL *journalURL = [self offlineJournalURL];
+    NSMutableArray<ACEOAuth2RACRequest *> *sentRequests = [NSMutableArray array];
+    ACEOAuth2RACOfflineQueue *queue = [self offlineQueueWithJournalURL:journalURL sentRequests:sentRequests signals:nil];
+    queue.maxConcurrentRequests = 1;
+
+    NSArray *requests = @[
+                          [ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"items" parameters:@{ @"a": @1 }],
+                          [ACEOAuth2RACRequest requestWithMethod:@"PUT" path:@"items/1" parameters:@{ @"a": @1 }],
+                          [ACEOAuth2RACRequest requestWithMethod:@"PATCH" path:@"items/1" parameters:@{ @"b": @2 }],
+                          [ACEOAuth2RACRequest requestWithMethod:@"PUT" path:@"items/1" parameters:@{ @"c": @3 }],
+                          [ACEOAuth2RACRequest requestWithMethod:@"PATCH" path:@"items/1" parameters:@{ @"d": @4, @"e": @4 }],
+                          [ACEOAuth2RACRequest requestWithMethod:@"PATCH" path:@"items/1" parameters:@{ @"e": @5 }],
+                          [ACEOAuth2RACRequest requestWithMethod:@"PATCH" path:@"items/2" parameters:@{ @"a": @1 }],
+                          [ACEOAuth2RACRequest requestWithMethod:@"DELETE" path:@"items/2" parameters:nil],
+                          [ACEOAuth2RACRequest requestWithMethod:@"PATCH" path:@"items/2" parameters:@{ @"b": @2 }],
+                          [ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"items" parameters:@{ @"b": @2 }],
+                          ];
+    for (ACEOAuth2RACRequest *request in requests) {
+        [self enqueueOfflineRequest:request inQueue:queue];
+    }
+    XCTAssertEqual(queue.pendingRequestCount, 7);
+
+    [queue replay];
+    [self waitForCondition:^BOOL{
+        return queue.pendingRequestCount == 0;
+    }];
+
+    // a PUT replaces the PUT and the PATCH before it, the PATCH requests are merged up to another method
+    NSArray *expected = @[
+                          @"POST items a=1",
+                          @"PUT items/1 c=3",
+                          @"PATCH items/1 d=4&e=5",
+                          @"PATCH items/2 a=1",
+                          @"DELETE items/2 ",
+                          @"PATCH items/2 b=2",
+                          @"POST items b=2",
+                          ];
+    XCTAssertEqualObjects([self descriptionsOfOfflineRequests:sentRequests], expected);
+}
+
+- (void)testOfflineQueueDoesNotSupersedeARunningRequest {
+    NSURL *journalURL = [self offlineJournalURL];
+    NSMutableArray<ACEOAuth2RACRequest *> *sentRequests = [NSMutableArray array];
+    RACSubject *firstResponse = [RACSubject subject];
+    ACEOAuth2RACOfflineQueue *queue = [self offlineQueueWithJournalURL:journalURL sentRequests:sentRequests signals:^RACSignal *(ACEOAuth2RACRequest *request) {
+        return [request.parameters[@"a"] isEqual:@1] ? firstResponse : [RACSignal empty];
+    }];
+
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"PATCH" path:@"items/1" parameters:@{ @"a": @1 }] inQueue:queue];
+    [queue replay];
+    [self waitForCondition:^BOOL{
+        return [self descriptionsOfOfflineRequests:sentRequests].count == 1;
+    }];
+
+    // the requests after the running one are collapsed among themselves only
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"PATCH" path:@"items/1" parameters:@{ @"b": @2 }] inQueue:queue];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"PUT" path:@"items/1" parameters:@{ @"c": @3 }] inQueue:queue];
+    XCTAssertEqual(queue.pendingRequestCount, 2);
+    XCTAssertEqual([self descriptionsOfOfflineRequests:sentRequests].count, 1);
+
+    [firstResponse sendCompleted];
+    [self waitForCondition:^BOOL{
+        return queue.pendingRequestCount == 0;
+    }];
+
+    NSArray *expected = @[ @"PATCH items/1 a=1", @"PUT items/1 c=3" ];
+    XCTAssertEqualObjects([self descriptionsOfOfflineRequests:sentRequests], expected);
+}
+
+- (void)testOfflineQueueSendsOneRequestPerResource {
+    NSURL *journalURL = [self offlineJournalURL];
+    NSMutableArray<ACEOAuth2RACRequest *> *sentRequests = [NSMutableArray array];
+    NSMutableDictionary<NSString *, RACSubject *> *responses = [NSMutableDictionary dictionary];
+    ACEOAuth2RACOfflineQueue *queue = [self offlineQueueWithJournalURL:journalURL sentRequests:sentRequests signals:^RACSignal *(ACEOAuth2RACRequest *request) {
+        RACSubject *response = [RACSubject subject];
+        @synchronized (responses) {
+            responses[request.HTTPHeaders[@"Idempotency-Key"]] = response;
+        }
+        return response;
+    }];
+    queue.maxConcurrentRequests = 0;
+
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"PUT" path:@"a" parameters:@{ @"a": @1 }] inQueue:queue];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"PATCH" path:@"a" parameters:@{ @"a": @2 }] inQueue:queue];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"b" parameters:@{ @"b": @1 }] inQueue:queue];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"b" parameters:@{ @"b": @2 }] inQueue:queue];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"DELETE" path:@"c" parameters:nil] inQueue:queue];
+
+    [queue replay];
+    [self waitForCondition:^BOOL{
+        return [self descriptionsOfOfflineRequests:sentRequests].count == 3;
+    }];
+
+    // the first request of each resource, the others wait even without a global limit
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    NSArray *expected = @[ @"PUT a a=1", @"POST b b=1", @"DELETE c " ];
+    XCTAssertEqualObjects([self descriptionsOfOfflineRequests:sentRequests], expected);
+
+    // each completion sends the next request of its resource
+    for (NSUInteger sent = 3; sent < 5; sent++) {
+        ACEOAuth2RACRequest *request;
+        @synchronized (sentRequests) {
+            request = sentRequests[sent - 3];
+        }
+        @synchronized (responses) {
+            [responses[request.HTTPHeaders[@"Idempotency-Key"]] sendCompleted];
+        }
+        [self waitForCondition:^BOOL{
+            return [self descriptionsOfOfflineRequests:sentRequests].count == sent + 1;
+        }];
+    }
+
+    expected = @[ @"PUT a a=1", @"POST b b=1", @"DELETE c ", @"PATCH a a=2", @"POST b b=2" ];
+    XCTAssertEqualObjects([self descriptionsOfOfflineRequests:sentRequests], expected);
+}
+
+- (void)testOfflineQueueTruncatesATornTail {
+    NSURL *journalURL = [self offlineJournalURL];
+    ACEOAuth2RACOfflineQueue *queue = [self offlineQueueWithJournalURL:journalURL sentRequests:[NSMutableArray array] signals:nil];
+    for (NSUInteger i = 0; i < 3; i++) {
+        [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"items" parameters:@{ @"i": @(i) }] inQueue:queue];
+    }
+
+    NSData *journal = [NSData dataWithContentsOfURL:journalURL];
+    NSMutableData *tornJournal = [journal mutableCopy];
+    uint32_t header[2] = { CFSwapInt32HostToLittle(100), 0 };
+    [tornJournal appendBytes:header length:sizeof(header)];
+    [tornJournal appendData:[self dataWithString:@"{\"op\":\"add\""]];
+    XCTAssertTrue([tornJournal writeToURL:journalURL atomically:NO]);
+
+    NSMutableArray<ACEOAuth2RACRequest *> *sentRequests = [NSMutableArray array];
+    ACEOAuth2RACOfflineQueue *restartedQueue = [self offlineQueueWithJournalURL:journalURL sentRequests:sentRequests signals:nil];
+    restartedQueue.maxConcurrentRequests = 1;
+    [restartedQueue replay];
+    [self waitForCondition:^BOOL{
+        return [self descriptionsOfOfflineRequests:sentRequests].count == 3 && restartedQueue.pendingRequestCount == 0;
+    }];
+
+    NSArray *expected = @[ @"POST items i=0", @"POST items i=1", @"POST items i=2" ];
+    XCTAssertEqualObjects([self descriptionsOfOfflineRequests:sentRequests], expected);
+
+    // the tail is gone before the records of the replay are appended
+    NSData *replayedJournal = [NSData dataWithContentsOfURL:journalURL];
+    XCTAssertEqualObjects([replayedJournal subdataWithRange:NSMakeRange(0, journal.length)], journal);
+    XCTAssertEqual([self recordEndsOfJournalData:replayedJournal].count, 6);
+}
+
+- (void)testOfflineQueueRejectsARecordWithAWrongChecksum {
+    NSURL *journalURL = [self offlineJournalURL];
+    ACEOAuth2RACOfflineQueue *queue = [self offlineQueueWithJournalURL:journalURL sentRequests:[NSMutableArray array] signals:nil];
+    for (NSUInteger i = 0; i < 3; i++) {
+        [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"items" parameters:@{ @"i": @(i) }] inQueue:queue];
+    }
+
+    // a flipped bit in the payload of the second record, still valid JSON
+    NSMutableData *journal = [[NSData dataWithContentsOfURL:journalURL] mutableCopy];
+    NSArray<NSNumber *> *ends = [self recordEndsOfJournalData:journal];
+    NSRange payload = NSMakeRange(ends[0].unsignedIntegerValue + 8, ends[1].unsignedIntegerValue - ends[0].unsignedIntegerValue - 8);
+    NSRange value = [journal rangeOfData:[self dataWithString:@"\"i\":1"] options:0 range:payload];
+    XCTAssertNotEqual(value.location, NSNotFound);
+    [journal replaceBytesInRange:NSMakeRange(NSMaxRange(value) - 1, 1) withBytes:"3"];
+    XCTAssertTrue([journal writeToURL:journalURL atomically:NO]);
+
+    NSMutableArray<ACEOAuth2RACRequest *> *sentRequests = [NSMutableArray array];
+    ACEOAuth2RACOfflineQueue *restartedQueue = [self offlineQueueWithJournalURL:journalURL sentRequests:sentRequests signals:^RACSignal *(ACEOAuth2RACRequest *request) {
+        return [RACSignal never];
+    }];
+    [restartedQueue replay];
+    [self waitForCondition:^BOOL{
+        return [self descriptionsOfOfflineRequests:sentRequests].count == 1;
+    }];
+
+    // the journal ends before the damaged record
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertEqualObjects([self descriptionsOfOfflineRequests:sentRequests], (@[ @"POST items i=0" ]));
+    XCTAssertEqual(restartedQueue.pendingRequestCount, 1);
+    XCTAssertEqual([NSData dataWithContentsOfURL:journalURL].length, ends[0].unsignedIntegerValue);
+}
+
+- (void)testOfflineQueueSurvivesACrashAtAnyByte {
+    NSURL *journalURL = [self offlineJournalURL];
+    ACEOAuth2RACOfflineQueue *queue = [self offlineQueueWithJournalURL:journalURL sentRequests:[NSMutableArray array] signals:nil];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"a" parameters:@{ @"a": @1 }] inQueue:queue];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"DELETE" path:@"b" parameters:nil] inQueue:queue];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"PUT" path:@"c" parameters:@{ @"c": @1 }] inQueue:queue];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"PUT" path:@"c" parameters:@{ @"c": @2 }] inQueue:queue];
+
+    // the last PUT writes its record, then the removal of the one it replaces
+    NSData *journal = [NSData dataWithContentsOfURL:journalURL];
+    NSArray<NSNumber *> *ends = [self recordEndsOfJournalData:journal];
+    XCTAssertEqual(ends.count, 5);
+    NSArray *expectedByRecordCount = @[
+                                       @[],
+                                       @[ @"POST a a=1" ],
+                                       @[ @"POST a a=1", @"DELETE b " ],
+                                       @[ @"POST a a=1", @"DELETE b ", @"PUT c c=1" ],
+                                       @[ @"POST a a=1", @"DELETE b ", @"PUT c c=1", @"PUT c c=2" ],
+                                       @[ @"POST a a=1", @"DELETE b ", @"PUT c c=2" ],
+                                       ];
+
+    // the process killed after any byte of the journal reached the disk
+    for (NSUInteger length = 0; length <= journal.length; length++) {
+        NSURL *crashURL = [self offlineJournalURL];
+        XCTAssertTrue([[journal subdataWithRange:NSMakeRange(0, length)] writeToURL:crashURL atomically:NO]);
+
+        NSUInteger recordCount = 0;
+        while (recordCount < ends.count && ends[recordCount].unsignedIntegerValue <= length) {
+            recordCount++;
+        }
+        NSArray *expected = expectedByRecordCount[recordCount];
+
+        NSMutableArray<ACEOAuth2RACRequest *> *sentRequests = [NSMutableArray array];
+        ACEOAuth2RACOfflineQueue *restartedQueue = [self offlineQueueWithJournalURL:crashURL sentRequests:sentRequests signals:nil];
+        restartedQueue.maxConcurrentRequests = 1;
+        [restartedQueue replay];
+        [self waitForCondition:^BOOL{
+            return [self descriptionsOfOfflineRequests:sentRequests].count == expected.count && restartedQueue.pendingRequestCount == 0;
+        }];
+        XCTAssertEqualObjects([self descriptionsOfOfflineRequests:sentRequests], expected, @"%lu", (unsigned long)length);
+    }
+}
+
+- (void)testOfflineQueueSendsARunningRequestAgainAfterACrash {
+    NSURL *journalURL = [self offlineJournalURL];
+    NSMutableArray<ACEOAuth2RACRequest *> *sentRequests = [NSMutableArray array];
+    ACEOAuth2RACOfflineQueue *queue = [self offlineQueueWithJournalURL:journalURL sentRequests:sentRequests signals:^RACSignal *(ACEOAuth2RACRequest *request) {
+        return [request.path isEqualToString:@"a"] ? [RACSignal never] : [RACSignal empty];
+    }];
+    queue.maxConcurrentRequests = 1;
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"a" parameters:@{ @"a": @1 }] inQueue:queue];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"b" parameters:@{ @"b": @1 }] inQueue:queue];
+
+    // killed while the first request is on its way to the server
+    [queue replay];
+    [self waitForCondition:^BOOL{
+        return [self descriptionsOfOfflineRequests:sentRequests].count == 1;
+    }];
+    NSString *idempotencyKey = sentRequests.firstObject.HTTPHeaders[@"Idempotency-Key"];
+    XCTAssertNotNil(idempotencyKey);
+
+    NSMutableArray<ACEOAuth2RACRequest *> *replayedRequests = [NSMutableArray array];
+    ACEOAuth2RACOfflineQueue *restartedQueue = [self offlineQueueWithJournalURL:journalURL sentRequests:replayedRequests signals:nil];
+    restartedQueue.maxConcurrentRequests = 1;
+    [restartedQueue replay];
+    [self waitForCondition:^BOOL{
+        return [self descriptionsOfOfflineRequests:replayedRequests].count == 2 && restartedQueue.pendingRequestCount == 0;
+    }];
+
+    // the server recognizes the request sent again by its key
+    XCTAssertEqualObjects([self descriptionsOfOfflineRequests:replayedRequests], (@[ @"POST a a=1", @"POST b b=1" ]));
+    XCTAssertEqualObjects(replayedRequests.firstObject.HTTPHeaders[@"Idempotency-Key"], idempotencyKey);
+}
+
+- (void)testOfflineQueueReplaysAgainAfterAServerError {
+    NSURL *journalURL = [self offlineJournalURL];
+    NSMutableArray<ACEOAuth2RACRequest *> *sentRequests = [NSMutableArray array];
+    ACEOAuth2RACOfflineQueue *queue = [self offlineQueueWithJournalURL:journalURL sentRequests:sentRequests signals:^RACSignal *(ACEOAuth2RACRequest *request) {
+        return [self descriptionsOfOfflineRequests:sentRequests].count < 3 ? [RACSignal error:[self serverErrorWithStatusCode:503]] : [RACSignal empty];
+    }];
+    queue.retryInterval = 0.05;
+
+    NSMutableArray *failures = [NSMutableArray array];
+    [queue.rac_failedRequests subscribeNext:^(RACTuple *failure) {
+        [failures addObject:failure];
+    }];
+
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"PUT" path:@"a" parameters:@{ @"a": @1 }] inQueue:queue];
+    [queue replay];
+
+    // the server comes back without any change of network
+    [self waitForCondition:^BOOL{
+        return queue.pendingRequestCount == 0;
+    }];
+    XCTAssertEqual([self descriptionsOfOfflineRequests:sentRequests].count, 3);
+    XCTAssertEqual(failures.count, 0);
+}
+
+- (void)testOfflineQueueReportsRejectedRequests {
+    NSURL *journalURL = [self offlineJournalURL];
+    NSMutableArray<ACEOAuth2RACRequest *> *sentRequests = [NSMutableArray array];
+    ACEOAuth2RACOfflineQueue *queue = [self offlineQueueWithJournalURL:journalURL sentRequests:sentRequests signals:^RACSignal *(ACEOAuth2RACRequest *request) {
+        return [request.path isEqualToString:@"a"] ? [RACSignal error:[self serverErrorWithStatusCode:422]] : [RACSignal empty];
+    }];
+    queue.maxConcurrentRequests = 1;
+
+    NSMutableArray<RACTuple *> *failures = [NSMutableArray array];
+    [queue.rac_failedRequests subscribeNext:^(RACTuple *failure) {
+        @synchronized (failures) {
+            [failures addObject:failure];
+        }
+    }];
+
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"a" parameters:@{ @"a": @1 }] inQueue:queue];
+    [self enqueueOfflineRequest:[ACEOAuth2RACRequest requestWithMethod:@"POST" path:@"b" parameters:@{ @"b": @1 }] inQueue:queue];
+    [queue replay];
+    [self waitForCondition:^BOOL{
+        return queue.pendingRequestCount == 0;
+    }];
+
+    // the rejected request is removed, the next one is sent
+    XCTAssertEqualObjects([self descriptionsOfOfflineRequests:sentRequests], (@[ @"POST a a=1", @"POST b b=1" ]));
+    @synchronized (failures) {
+        XCTAssertEqual(failures.count, 1);
+        XCTAssertEqualObjects([failures.firstObject.first path], @"a");
+    }
+}
+
+
+#pragma mark - Request Queue
+
+- (void)enqueueRequestNamed:(NSString *)name requests:(ACEOAuth2RACTestRequests *)requests queue:(ACEOAuth2RACRequestQueue *)queue priority:(ACEOAuth2RACRequestPriority)priority host:(NSString *)host caller:(NSString *)caller {
+    [[queue rac_enqueueSignal:[requests signalNamed:name] priority:priority host:host caller:caller] subscribeCompleted:^{
+    }];
+}
+
+// the requests started one at a time, each completed before the next one can start
+- (NSArray<NSString *> *)namesOfRequests:(ACEOAuth2RACTestRequests *)requests completingInTurn:(NSUInteger)count {
+    for (NSUInteger i = 0; i < count; i++) {
+        [self waitForCondition:^BOOL{
+            return requests.startedNames.count == i + 1;
+        }];
+        [requests completeRequestNamed:requests.startedNames.lastObject];
+    }
+    return requests.startedNames;
+}
+
+- (void)testRequestQueueLimitsTheRequestsPerHost {
+    ACEOAuth2RACRequestQueue *queue = [ACEOAuth2RACRequestQueue new];
+    queue.maxConcurrentRequests = 0;
+    queue.maxConcurrentRequestsPerHost = 2;
+    ACEOAuth2RACTestRequests *requests = [ACEOAuth2RACTestRequests new];
+
+    for (NSString *name in @[ @"a1", @"a2", @"a3", @"a4", @"b1", @"b2" ]) {
+        [self enqueueRequestNamed:name requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:[name substringToIndex:1] caller:nil];
+    }
+    [self enqueueRequestNamed:@"any" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:nil caller:nil];
+
+    // a busy host doesn't hold back the requests to the others
+    [self waitForCondition:^BOOL{
+        return requests.startedNames.count == 5;
+    }];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertEqualObjects([NSSet setWithArray:requests.startedNames], ([NSSet setWithObjects:@"a1", @"a2", @"b1", @"b2", @"any", nil]));
+    XCTAssertEqual([queue pendingRequestCountForHost:@"a"], 2);
+    XCTAssertEqual([queue pendingRequestCountForHost:@"b"], 0);
+    XCTAssertEqual(queue.runningRequestCount, 5);
+
+    [requests completeRequestNamed:@"b1"];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertEqual(requests.startedNames.count, 5);
+
+    [requests completeRequestNamed:@"a2"];
+    [self waitForCondition:^BOOL{
+        return requests.startedNames.count == 6;
+    }];
+    XCTAssertEqualObjects(requests.startedNames.lastObject, @"a3");
+    XCTAssertEqual([queue pendingRequestCountForHost:@"a"], 1);
+
+    // a higher limit starts the waiting requests right away
+    queue.maxConcurrentRequestsPerHost = 0;
+    [self waitForCondition:^BOOL{
+        return requests.startedNames.count == 7;
+    }];
+    XCTAssertEqualObjects(requests.startedNames.lastObject, @"a4");
+}
+
+- (void)testRequestQueueSharesTheSlotsByWeight {
+    ACEOAuth2RACRequestQueue *queue = [ACEOAuth2RACRequestQueue new];
+    queue.maxConcurrentRequests = 1;
+    queue.ordering = ACEOAuth2RACRequestQueueOrderingWeightedFair;
+    [queue setWeight:2 forCaller:@"A"];
+    ACEOAuth2RACTestRequests *requests = [ACEOAuth2RACTestRequests new];
+
+    // the other requests wait behind the first one, each caller sending its burst at once
+    [self enqueueRequestNamed:@"first" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:nil caller:nil];
+    for (NSUInteger i = 1; i <= 6; i++) {
+        [self enqueueRequestNamed:[NSString stringWithFormat:@"A%lu", (unsigned long)i] requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:nil caller:@"A"];
+    }
+    for (NSUInteger i = 1; i <= 3; i++) {
+        [self enqueueRequestNamed:[NSString stringWithFormat:@"B%lu", (unsigned long)i] requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:nil caller:@"B"];
+    }
+
+    NSArray *expected = @[ @"first", @"A1", @"A2", @"B1", @"A3", @"A4", @"B2", @"A5", @"A6", @"B3" ];
+    XCTAssertEqualObjects([self namesOfRequests:requests completingInTurn:10], expected);
+}
+
+- (void)testRequestQueueKeepsTheOrderOfArrival {
+    ACEOAuth2RACRequestQueue *queue = [ACEOAuth2RACRequestQueue new];
+    queue.maxConcurrentRequests = 1;
+    [queue setWeight:2 forCaller:@"A"];
+    ACEOAuth2RACTestRequests *requests = [ACEOAuth2RACTestRequests new];
+
+    [self enqueueRequestNamed:@"first" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:nil caller:nil];
+    for (NSString *name in @[ @"A1", @"A2", @"A3", @"B1", @"B2" ]) {
+        [self enqueueRequestNamed:name requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:nil caller:[name substringToIndex:1]];
+    }
+
+    NSArray *expected = @[ @"first", @"A1", @"A2", @"A3", @"B1", @"B2" ];
+    XCTAssertEqualObjects([self namesOfRequests:requests completingInTurn:6], expected);
+}
+
+- (void)testRequestQueueReportsTheDepthPerClassAndHost {
+    ACEOAuth2RACRequestQueue *queue = [ACEOAuth2RACRequestQueue new];
+    queue.maxConcurrentRequests = 1;
+    ACEOAuth2RACTestRequests *requests = [ACEOAuth2RACTestRequests new];
+
+    [self enqueueRequestNamed:@"first" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityBackground host:@"a" caller:nil];
+    [self enqueueRequestNamed:@"background1" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityBackground host:@"b" caller:nil];
+    [self enqueueRequestNamed:@"background2" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityBackground host:@"b" caller:nil];
+    [self enqueueRequestNamed:@"default" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:@"a" caller:nil];
+    [self enqueueRequestNamed:@"interactive1" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityInteractive host:@"a" caller:nil];
+    [self enqueueRequestNamed:@"interactive2" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityInteractive host:@"b" caller:nil];
+
+    [self waitForCondition:^BOOL{
+        return queue.pendingRequestCount == 5;
+    }];
+    XCTAssertEqual(queue.runningRequestCount, 1);
+    XCTAssertEqual([queue pendingRequestCountForPriority:ACEOAuth2RACRequestPriorityInteractive], 2);
+    XCTAssertEqual([queue pendingRequestCountForPriority:ACEOAuth2RACRequestPriorityDefault], 1);
+    XCTAssertEqual([queue pendingRequestCountForPriority:ACEOAuth2RACRequestPriorityBackground], 2);
+    XCTAssertEqual([queue pendingRequestCountForHost:@"a"], 2);
+    XCTAssertEqual([queue pendingRequestCountForHost:@"b"], 3);
+    XCTAssertEqual([queue pendingRequestCountForHost:@"c"], 0);
+
+    // the interactive requests go first, the background ones get the slots left
+    NSArray *expected = @[ @"first", @"interactive1", @"interactive2", @"default", @"background1", @"background2" ];
+    XCTAssertEqualObjects([self namesOfRequests:requests completingInTurn:6], expected);
+
+    [self waitForCondition:^BOOL{
+        return queue.runningRequestCount == 0;
+    }];
+    XCTAssertEqual(queue.pendingRequestCount, 0);
+    for (NSInteger priority = ACEOAuth2RACRequestPriorityInteractive; priority <= ACEOAuth2RACRequestPriorityBackground; priority++) {
+        XCTAssertEqual([queue pendingRequestCountForPriority:priority], 0);
+    }
+    XCTAssertEqual([queue pendingRequestCountForHost:@"a"], 0);
+    XCTAssertEqual([queue pendingRequestCountForHost:@"b"], 0);
+}
+
+- (void)testRequestQueueNeverStartsADisposedRequest {
+    ACEOAuth2RACRequestQueue *queue = [ACEOAuth2RACRequestQueue new];
+    queue.maxConcurrentRequests = 1;
+    ACEOAuth2RACTestRequests *requests = [ACEOAuth2RACTestRequests new];
+
+    [self enqueueRequestNamed:@"first" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:@"a" caller:nil];
+    RACDisposable *disposable = [[queue rac_enqueueSignal:[requests signalNamed:@"disposed"] priority:ACEOAuth2RACRequestPriorityDefault host:@"a" caller:nil] subscribeNext:^(id x) {
+        XCTFail(@"%@", x);
+    }];
+    [self waitForCondition:^BOOL{
+        return queue.pendingRequestCount == 1;
+    }];
+
+    [disposable dispose];
+    [self waitForCondition:^BOOL{
+        return queue.pendingRequestCount == 0;
+    }];
+    XCTAssertEqual([queue pendingRequestCountForHost:@"a"], 0);
+
+    // the slot goes to the next request, the disposed one is never subscribed
+    [self enqueueRequestNamed:@"next" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:@"a" caller:nil];
+    [requests completeRequestNamed:@"first"];
+    [self waitForCondition:^BOOL{
+        return requests.startedNames.count == 2;
+    }];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertEqualObjects(requests.startedNames, (@[ @"first", @"next" ]));
+}
+
+- (void)testRequestQueueReleasesTheSlotOfADisposedRequest {
+    ACEOAuth2RACRequestQueue *queue = [ACEOAuth2RACRequestQueue new];
+    queue.maxConcurrentRequests = 1;
+    ACEOAuth2RACTestRequests *requests = [ACEOAuth2RACTestRequests new];
+
+    RACDisposable *disposable = [[queue rac_enqueueSignal:[requests signalNamed:@"first"] priority:ACEOAuth2RACRequestPriorityDefault host:nil caller:nil] subscribeCompleted:^{
+    }];
+    [self enqueueRequestNamed:@"next" requests:requests queue:queue priority:ACEOAuth2RACRequestPriorityDefault host:nil caller:nil];
+    [self waitForCondition:^BOOL{
+        return requests.startedNames.count == 1;
+    }];
+
+    // a running request cancelled by its subscriber frees its slot
+    [disposable dispose];
+    [self waitForCondition:^BOOL{
+        return requests.startedNames.count == 2;
+    }];
+    XCTAssertEqualObjects(requests.startedNames, (@[ @"first", @"next" ]));
+}
+
+
+#pragma mark - Chunked Uploader
+
+- (ACEOAuth2RACTusServer *)tusServer {
+    ACEOAuth2RACTusServer *server = [ACEOAuth2RACTusServer new];
+    XCTAssertNotNil(server);
+    [self addTeardownBlock:^{
+        [server stop];
+    }];
+    return server;
+}
+
+// an uploader sending its calls to the server with a plain session, each call failing at its first error
+- (ACEOAuth2RACChunkedUploader *)chunkedUploaderForServer:(ACEOAuth2RACTusServer *)server journalDirectoryURL:(NSURL *)journalDirectoryURL {
+    AFHTTPSessionManager *sessionManager = [[AFHTTPSessionManager alloc] initWithBaseURL:server.server.baseURL];
+    sessionManager.responseSerializer = [AFHTTPResponseSerializer serializer];
+    [self addTeardownBlock:^{
+        [sessionManager invalidateSessionCancelingTasks:YES];
+    }];
+
+    ACEOAuth2RACChunkedUploader *uploader = [[ACEOAuth2RACChunkedUploader alloc] initWithSendBlock:^RACSignal *(ACEOAuth2RACRequest *request) {
+        return [RACSignal createSignal:^RACDisposable *(id<RACSubscriber> subscriber) {
+            NSURL *URL = [NSURL URLWithString:request.path relativeToURL:server.server.baseURL];
+            NSMutableURLRequest *URLRequest = [NSMutableURLRequest requestWithURL:URL.absoluteURL];
+            URLRequest.HTTPMethod = request.HTTPMethod;
+            URLRequest.HTTPBody = request.HTTPBody;
+            [request.HTTPHeaders enumerateKeysAndObjectsUsingBlock:^(NSString *field, NSString *value, BOOL *stop) {
+                [URLRequest setValue:value forHTTPHeaderField:field];
+            }];
+
+            NSURLSessionDataTask *task = [sessionManager dataTaskWithRequest:URLRequest completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+                if (error != nil) {
+                    [subscriber sendError:error];
+
+                } else {
+                    [subscriber sendNext:RACTuplePack(responseObject, response)];
+                    [subscriber sendCompleted];
+                }
+            }];
+            [task resume];
+
+            return [RACDisposable disposableWithBlock:^{
+                [task cancel];
+            }];
+        }];
+    }];
+
+    // chunks of a fixed size, whatever the throughput of the loopback
+    uploader.journalDirectoryURL = journalDirectoryURL;
+    uploader.initialChunkSize    = 16 * 1024;
+    uploader.minimumChunkSize    = 16 * 1024;
+    uploader.maximumChunkSize    = 16 * 1024;
+    return uploader;
+}
+
+- (NSURL *)uploadJournalDirectoryURL {
+    NSURL *directoryURL = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES] URLByAppendingPathComponent:[NSUUID UUID].UUIDString isDirectory:YES];
+    [self addTeardownBlock:^{
+        [[NSFileManager defaultManager] removeItemAtURL:directoryURL error:nil];
+    }];
+    return directoryURL;
+}
+
+// 100 KB of random bytes, so a chunk sent at the wrong offset can't match
+- (NSURL *)uploadFileURLWithData:(NSData **)data {
+    NSMutableData *fileData = [NSMutableData dataWithLength:100 * 1024];
+    arc4random_buf(fileData.mutableBytes, fileData.length);
+
+    NSURL *fileURL = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES] URLByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"bin"]];
+    XCTAssertTrue([fileData writeToURL:fileURL atomically:YES]);
+    [self addTeardownBlock:^{
+        [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+    }];
+
+    *data = fileData;
+    return fileURL;
+}
+
+- (NSURL *)uploadFileURL:(NSURL *)fileURL withUploader:(ACEOAuth2RACChunkedUploader *)uploader error:(NSError **)error {
+    BOOL success = NO;
+    return [[uploader rac_uploadFileURL:fileURL toPath:@"files" identifier:@"upload" progress:nil] asynchronousFirstOrDefault:nil success:&success error:error];
+}
+
+- (NSURL *)journalURLInDirectory:(NSURL *)journalDirectoryURL {
+    return [journalDirectoryURL URLByAppendingPathComponent:@"upload.json"];
+}
+
+- (void)testChunkedUploaderSendsTheChunksInOrder {
+    ACEOAuth2RACTusServer *server = [self tusServer];
+    NSURL *journalDirectoryURL = [self uploadJournalDirectoryURL];
+    NSData *data;
+    NSURL *fileURL = [self uploadFileURLWithData:&data];
+
+    NSError *error;
+    NSURL *uploadURL = [self uploadFileURL:fileURL withUploader:[self chunkedUploaderForServer:server journalDirectoryURL:journalDirectoryURL] error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(uploadURL.path, @"/files/1");
+    XCTAssertEqualObjects([server dataOfUploadWithURL:uploadURL], data);
+
+    NSArray *expected = @[
+                          @"POST",
+                          @"PATCH /files/1 0",
+                          @"PATCH /files/1 16384",
+                          @"PATCH /files/1 32768",
+                          @"PATCH /files/1 49152",
+                          @"PATCH /files/1 65536",
+                          @"PATCH /files/1 81920",
+                          @"PATCH /files/1 98304",
+                          ];
+    XCTAssertEqualObjects(server.requests, expected);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[self journalURLInDirectory:journalDirectoryURL].path]);
+}
+
+- (void)testChunkedUploaderResumesFromTheOffsetOfTheServer {
+    ACEOAuth2RACTusServer *server = [self tusServer];
+    NSURL *journalDirectoryURL = [self uploadJournalDirectoryURL];
+    NSData *data;
+    NSURL *fileURL = [self uploadFileURLWithData:&data];
+
+    // the server keeps the third chunk, but the client never learns it
+    server.failingOffset = @32768;
+    NSError *error;
+    XCTAssertNil([self uploadFileURL:fileURL withUploader:[self chunkedUploaderForServer:server journalDirectoryURL:journalDirectoryURL] error:&error]);
+    XCTAssertNotNil(error);
+
+    NSData *journalData = [NSData dataWithContentsOfURL:[self journalURLInDirectory:journalDirectoryURL]];
+    NSDictionary *journal = journalData ? [NSJSONSerialization JSONObjectWithData:journalData options:0 error:nil] : nil;
+    XCTAssertEqualObjects(journal[@"completedRanges"], (@[ @[ @0, @32768 ] ]));
+
+    // a new process, the journal gives the upload URL and the HEAD the offset
+    error = nil;
+    NSURL *uploadURL = [self uploadFileURL:fileURL withUploader:[self chunkedUploaderForServer:server journalDirectoryURL:journalDirectoryURL] error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(uploadURL.path, @"/files/1");
+    XCTAssertEqualObjects([server dataOfUploadWithURL:uploadURL], data);
+
+    NSArray *expected = @[
+                          @"POST",
+                          @"PATCH /files/1 0",
+                          @"PATCH /files/1 16384",
+                          @"PATCH /files/1 32768",
+                          @"HEAD /files/1",
+                          @"PATCH /files/1 49152",
+                          @"PATCH /files/1 65536",
+                          @"PATCH /files/1 81920",
+                          @"PATCH /files/1 98304",
+                          ];
+    XCTAssertEqualObjects(server.requests, expected);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[self journalURLInDirectory:journalDirectoryURL].path]);
+}
+
+- (void)testChunkedUploaderStartsAgainAnUploadForgottenByTheServer {
+    ACEOAuth2RACTusServer *server = [self tusServer];
+    NSURL *journalDirectoryURL = [self uploadJournalDirectoryURL];
+    NSData *data;
+    NSURL *fileURL = [self uploadFileURLWithData:&data];
+
+    server.failingOffset = @16384;
+    NSError *error;
+    XCTAssertNil([self uploadFileURL:fileURL withUploader:[self chunkedUploaderForServer:server journalDirectoryURL:journalDirectoryURL] error:&error]);
+
+    // the HEAD gets a 404, the upload is created again from the start
+    [server forgetUploads];
+    error = nil;
+    NSURL *uploadURL = [self uploadFileURL:fileURL withUploader:[self chunkedUploaderForServer:server journalDirectoryURL:journalDirectoryURL] error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(uploadURL.path, @"/files/2");
+    XCTAssertEqualObjects([server dataOfUploadWithURL:uploadURL], data);
+
+    NSArray<NSString *> *requests = server.requests;
+    NSArray *expected = @[ @"POST", @"PATCH /files/1 0", @"PATCH /files/1 16384", @"HEAD /files/1", @"POST", @"PATCH /files/2 0" ];
+    XCTAssertEqualObjects([requests subarrayWithRange:NSMakeRange(0, MIN(requests.count, expected.count))], expected);
+    XCTAssertEqualObjects(requests.lastObject, @"PATCH /files/2 98304");
+}
+
+- (void)testChunkedUploaderConcatenatesThePartialUploadsInTheOrderOfTheFile {
+    ACEOAuth2RACTusServer *server = [self tusServer];
+    NSData *data;
+    NSURL *fileURL = [self uploadFileURLWithData:&data];
+
+    // the first chunk completes after the others
+    server.firstPartialUploadDelay = 0.5;
+    ACEOAuth2RACChunkedUploader *uploader = [self chunkedUploaderForServer:server journalDirectoryURL:[self uploadJournalDirectoryURL]];
+    uploader.usesConcatenation   = YES;
+    uploader.maxConcurrentChunks = 4;
+
+    NSError *error;
+    NSURL *uploadURL = [self uploadFileURL:fileURL withUploader:uploader error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects([server dataOfUploadWithURL:uploadURL], data);
+
+    // the same data only if the final upload lists the partial ones in the order of their chunks
+    NSArray<NSString *> *requests = server.requests;
+    XCTAssertEqual([requests filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF == 'POST partial'"]].count, 7);
+    XCTAssertEqual([requests.lastObject componentsSeparatedByString:@" "].count, 2 + 7);
+    XCTAssertTrue([requests.lastObject hasPrefix:@"POST final "]);
+}
+
+
+#pragma mark - Benchmarks
+
+- (NSData *)benchmarkJSONData {
+    static NSData *data;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSMutableArray *users = [NSMutableArray array];
+        for (NSUInteger i = 0; i < 5000; i++) {
+            [users addObject:@{
+                               @"id": @(i),
+                               @"name": [NSString stringWithFormat:@"User %lu", (unsigned long)i],
+                               @"email": [NSString stringWithFormat:@"user%lu@example.com", (unsigned long)i],
+                               @"bio": @"Caf\u00e9 \"quoted\"\nline 😀",
+                               @"score": @(i * 1.25),
+                               @"active": @(i % 2 == 0),
+                               @"manager": (i % 3 == 0) ? [NSNull null] : @(i / 3),
+                               @"tags": @[ @"a", @"b", [NSNull null] ],
+                               @"address": @{ @"city": @"Rome", @"zip": [NSNull null] },
+                               }];
+        }
+        data = [NSJSONSerialization dataWithJSONObject:@{ @"users": users } options:0 error:nil];
+    });
+    return data;
+}
+
+- (void)testPerformanceJSONParser {
+    NSData *data = [self benchmarkJSONData];
+    [self measureBlock:^{
+        XCTAssertNotNil(ACEOAuth2RACJSONObjectRemovingNullValues(data, 0, NULL));
+    }];
+}
+
+- (void)testPerformanceNSJSONSerializationRemovingNullValues {
+    NSData *data = [self benchmarkJSONData];
+    [self measureBlock:^{
+        XCTAssertNotNil([self AFObjectWithData:data error:nil]);
+    }];
+}
+
+- (void)testPerformanceNSJSONSerialization {
+    NSData *data = [self benchmarkJSONData];
+    [self measureBlock:^{
+        XCTAssertNotNil([NSJSONSerialization JSONObjectWithData:data options:0 error:nil]);
+    }];
+}
+
+// about 11 MB of nodes with three children down to ten levels, under a chain of 256 objects
+- (NSData *)benchmarkNestedJSONData {
+    static NSData *data;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSMutableString *document = [NSMutableString string];
+        for (NSUInteger i = 0; i < 256; i++) {
+            [document appendString:@"{\"next\":"];
+        }
+
+        __block NSUInteger identifier = 0;
+        __block void (^__weak weakAppendNode)(NSUInteger);
+        void (^appendNode)(NSUInteger) = ^(NSUInteger depth) {
+            NSUInteger nodeIdentifier = identifier++;
+            [document appendFormat:@"{\"id\":%lu,\"name\":\"Node %lu\",\"note\":\"Caf\\u00e9 \\\"quoted\\\"\",\"score\":%.2f,\"parent\":null,\"tags\":[\"a\",null,\"b\"],\"children\":[", (unsigned long)nodeIdentifier, (unsigned long)nodeIdentifier, nodeIdentifier * 1.25];
+            for (NSUInteger child = 0; depth > 0 && child < 3; child++) {
+                if (child > 0) {
+                    [document appendString:@","];
+                }
+                weakAppendNode(depth - 1);
+            }
+            [document appendString:@"]}"];
+        };
+        weakAppendNode = appendNode;
+        appendNode(10);
+
+        for (NSUInteger i = 0; i < 256; i++) {
+            [document appendString:@"}"];
+        }
+        data = [document dataUsingEncoding:NSUTF8StringEncoding];
+    });
+    return data;
+}
+
+// the highest resident size reached while the block runs, above the one before it
+- (uint64_t)peakMemoryOfBlock:(void (^)(void))block {
+    // the pages freed by the previous runs go back to the system, they would hide the growth
+    malloc_zone_pressure_relief(NULL, 0);
+    uint64_t baseline = ACEOAuth2RACResidentSize();
+
+    __block uint64_t peak = baseline;
+    dispatch_queue_t queue = dispatch_queue_create("com.onemob.network.tests.memory", DISPATCH_QUEUE_SERIAL);
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+    dispatch_source_set_timer(timer, DISPATCH_TIME_NOW, NSEC_PER_MSEC, 0);
+    dispatch_source_set_event_handler(timer, ^{
+        peak = MAX(peak, ACEOAuth2RACResidentSize());
+    });
+    dispatch_resume(timer);
+
+    block();
+
+    dispatch_sync(queue, ^{
+        dispatch_source_cancel(timer);
+    });
+    return peak - baseline;
+}
+
+- (void)testPerformanceNestedDocument {
+    ACEOAuth2RACJSONResponseSerializer *serializer = [ACEOAuth2RACJSONResponseSerializer serializer];
+    serializer.removesKeysWithNullValues = YES;
+
+    NSData *data = [self benchmarkNestedJSONData];
+    XCTAssertGreaterThanOrEqual(data.length, 10 * 1024 * 1024);
+    [self measureBlock:^{
+        XCTAssertNotNil([serializer responseObjectForResponse:[self JSONResponse] data:data error:nil]);
+    }];
+}
+
+- (void)testPerformanceNestedDocumentWithAFNetworking {
+    AFJSONResponseSerializer *serializer = [AFJSONResponseSerializer serializer];
+    serializer.removesKeysWithNullValues = YES;
+
+    NSData *data = [self benchmarkNestedJSONData];
+    [self measureBlock:^{
+        XCTAssertNotNil([serializer responseObjectForResponse:[self JSONResponse] data:data error:nil]);
+    }];
+}
+
+- (void)testPerformanceNestedDocumentPeakMemory {
+    ACEOAuth2RACJSONResponseSerializer *serializer = [ACEOAuth2RACJSONResponseSerializer serializer];
+    serializer.removesKeysWithNullValues = YES;
+    AFJSONResponseSerializer *expectedSerializer = [AFJSONResponseSerializer serializer];
+    expectedSerializer.removesKeysWithNullValues = YES;
+
+    NSData *data = [self benchmarkNestedJSONData];
+    uint64_t peakMemory = [self peakMemoryOfBlock:^{
+        @autoreleasepool {
+            XCTAssertNotNil([serializer responseObjectForResponse:[self JSONResponse] data:data error:nil]);
+        }
+    }];
+    uint64_t expectedPeakMemory = [self peakMemoryOfBlock:^{
+        @autoreleasepool {
+            XCTAssertNotNil([expectedSerializer responseObjectForResponse:[self JSONResponse] data:data error:nil]);
+        }
+    }];
+
+    // the current path holds the parsed tree and its copy without the nulls at the same time
+    NSLog(@"Peak memory parsing %.1f MB: %.1f MB, %.1f MB with AFNetworking", data.length / 1048576.0, peakMemory / 1048576.0, expectedPeakMemory / 1048576.0);
+    XCTAssertLessThan(peakMemory, expectedPeakMemory);
+}
+
+- (void)testPerformanceStructuralIndex {
+    NSData *data = [self benchmarkJSONData];
+    [self measureBlock:^{
+        ACEOAuth2RACJSONStructuralIndex index = { 0 };
+        size_t errorPosition;
+        XCTAssertEqual(ACEOAuth2RACJSONStructuralIndexBuild(data.bytes, data.length, &index, &errorPosition), ACEOAuth2RACJSONStructuralIndexSuccess);
+        ACEOAuth2RACJSONStructuralIndexFree(&index);
+    }];
+}
+
+- (void)testPerformanceStructuralIndexParser {
+    ACEOAuth2RACJSONResponseSerializer *serializer = [ACEOAuth2RACJSONResponseSerializer serializer];
+    serializer.removesKeysWithNullValues = YES;
+    serializer.structuralIndexThreshold = 0;
+
+    NSData *data = [self benchmarkJSONData];
+    [self measureBlock:^{
+        XCTAssertNotNil([serializer responseObjectForResponse:[self JSONResponse] data:data error:nil]);
+    }];
+}
+
+- (void)testPerformanceMessagePack {
+    NSData *data = [self messagePackOfObject:[NSJSONSerialization JSONObjectWithData:[self benchmarkJSONData] options:0 error:nil]];
+    [self measureBlock:^{
+        XCTAssertNotNil(ACEOAuth2RACMessagePackObjectWithData(data, NULL));
+    }];
+}
+
+- (NSDictionary *)benchmarkQueryParameters {
+    NSMutableDictionary *parameters = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < 200; i++) {
+        parameters[[NSString stringWithFormat:@"key%lu", (unsigned long)i]] = @{
+                                                                                @"name": [NSString stringWithFormat:@"Café %lu & more", (unsigned long)i],
+                                                                                @"values": @[ @(i), @(i * 2), @"a b" ],
+                                                                                @"enabled": @(i % 2 == 0),
+                                                                                };
+    }
+    return parameters;
+}
+
+- (void)testPerformanceQueryEncoder {
+    ACEOAuth2RACQueryEncoder *encoder = [ACEOAuth2RACQueryEncoder new];
+    NSDictionary *parameters = [self benchmarkQueryParameters];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10; i++) {
+            XCTAssertNotNil([encoder queryStringFromParameters:parameters]);
+        }
+    }];
+}
+
+- (void)testPerformanceAFQueryStringFromParameters {
+    NSDictionary *parameters = [self benchmarkQueryParameters];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10; i++) {
+            XCTAssertNotNil(AFQueryStringFromParameters(parameters));
+        }
+    }];
+}
+
+- (void)testPerformanceQueryEncoderWithConstantParameters {
+    ACEOAuth2RACQueryEncoder *encoder = [ACEOAuth2RACQueryEncoder new];
+    NSDictionary *filters = [encoder constantParameters:[self benchmarkQueryParameters]];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10; i++) {
+            XCTAssertNotNil([encoder queryStringFromParameters:@{ @"filter": filters, @"page": @(i) }]);
+        }
+    }];
+}
+
+// a new client making its first token and API calls, over one connection or two
+- (NSURL *)benchmarkRedirectURL {
+    return [NSURL URLWithString:@"com.example.app://oauth/callback?state=af0ifjsldkj&session_state=c5f1b3a0-9f4e-4d9b-a7e1-5b7c1b2c3d4e&code=SplxlOBeZQQYbYS6WxSbIA%2Bk3mQ%3D&scope=openid+profile+email"];
+}
+
+- (void)testPerformanceQueryScanner {
+    NSURL *URL = [self benchmarkRedirectURL];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10000; i++) {
+            @autoreleasepool {
+                XCTAssertNotNil(ACEOAuth2RACQueryValueForKey(URL, @"code"));
+            }
+        }
+    }];
+}
+
+- (void)testPerformanceQueryDictionary {
+    NSURL *URL = [self benchmarkRedirectURL];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10000; i++) {
+            @autoreleasepool {
+                XCTAssertNotNil([self queryDictionaryOfURL:URL][@"code"]);
+            }
+        }
+    }];
+}
+
+- (void)measureFirstCallsSharingTheSession:(BOOL)sharesSession {
+    ACEOAuth2RACTestServer *server = [self tokenServer];
+
+    [self measureBlock:^{
+        AFHTTPSessionManager *networkManager = [self networkManagerWithBaseURL:server.baseURL];
+        ACEOAuth2RACOAuthManager *OAuthManager = [[ACEOAuth2RACOAuthManager alloc] initWithBaseURL:server.baseURL clientID:@"client" secret:@"secret"];
+        OAuthManager.sharedSessionManager = sharesSession ? networkManager : nil;
+
+        [self runTokenAndAPICallsWithOAuthManager:OAuthManager networkManager:networkManager count:3];
+
+        [networkManager invalidateSessionCancelingTasks:YES];
+        [OAuthManager invalidateSessionCancelingTasks:YES];
+    }];
+
+    [server stop];
+}
+
+- (void)testPerformanceSharedSession {
+    [self measureFirstCallsSharingTheSession:YES];
+}
+
+- (void)testPerformanceSeparateSessions {
+    [self measureFirstCallsSharingTheSession:NO];
+}
+
+// the first request after the app returns to the foreground, with the connection setup of a real network
+- (void)measureFirstRequestAfterForegroundPrewarming:(BOOL)prewarms {
+    NSMutableArray<NSString *> *methods = [NSMutableArray array];
+    ACEOAuth2RACTestServer *server = [self prewarmServerWithMethods:methods];
+    server.connectionDelay = 0.1;
+
+    ACEOAuth2RACManager *manager = [[ACEOAuth2RACManager alloc] initWithBaseURL:server.baseURL clientID:@"client" secret:@"secret" redirectURL:nil];
+    manager.prewarmInterval = 0.0;
+    manager.prewarmURLString = prewarms ? @"ping" : nil;
+
+    [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+        [server closeConnections];
+        [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationWillEnterForegroundNotification object:nil];
+
+        // the user needs a moment before the first request, in both cases
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+
+        [self startMeasuring];
+        [self sendFirstRequestWithManager:manager];
+        [self stopMeasuring];
+    }];
+
+    [manager.networkManager invalidateSessionCancelingTasks:YES];
+}
+
+- (void)testPerformanceFirstRequestWithPrewarm {
+    [self measureFirstRequestAfterForegroundPrewarming:YES];
+}
+
+- (void)testPerformanceFirstRequestWithoutPrewarm {
+    [self measureFirstRequestAfterForegroundPrewarming:NO];
 }
 
 @end
@@ -0,0 +1,365 @@
+// ACEOAuth2RACJSONStructuralIndexHarness.c
+//
+// Copyright (c) 2016 Stefano Acerbetti - https://github.com/acerbetti/ACEOAuth2RACManager
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+// A headless check and benchmark of the structural index, without Foundation, for Linux and macOS:
+//
+//     make -C ACEOAuth2RACManagerDemo/ACEOAuth2RACManagerDemoTests/StructuralIndex check
+//
+// Every corpus file, shifted by 0 to 63 spaces so its bytes fall at every offset of the 64 byte blocks, and a
+// set of random documents are indexed and compared with a byte by byte walk. Then both are timed on each file.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "ACEOAuth2RACJSONStructuralIndex.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    uint8_t *bytes;
+    size_t length;
+    size_t capacity;
+    uint64_t seed;
+} ACEOAuth2RACHarnessDocument;
+
+
+#pragma mark - Reference
+
+// a byte by byte walk of the document, the reference of the vectorized index
+static ACEOAuth2RACJSONStructuralIndexStatus ACEOAuth2RACHarnessReferenceBuild(const uint8_t *bytes, size_t length, uint32_t *positions, size_t *count, size_t *errorPosition)
+{
+    bool inString = false, escaped = false, inScalar = false;
+    *count = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        uint8_t c = bytes[i];
+
+        if (inString) {
+            if (escaped) {
+                escaped = false;
+
+            } else if (c == '\\') {
+                escaped = true;
+
+            } else if (c == '"') {
+                positions[(*count)++] = (uint32_t)i;
+                inString = false;
+
+            } else if (c < 0x20) {
+                *errorPosition = i;
+                return ACEOAuth2RACJSONStructuralIndexControlCharacter;
+            }
+            continue;
+        }
+
+        switch (c) {
+            case ' ': case '\t': case '\n': case '\r':
+                inScalar = false;
+                break;
+
+            case '"':
+                positions[(*count)++] = (uint32_t)i;
+                inString = true;
+                inScalar = false;
+                break;
+
+            case '{': case '}': case '[': case ']': case ':': case ',':
+                positions[(*count)++] = (uint32_t)i;
+                inScalar = false;
+                break;
+
+            default:
+                if (!inScalar) {
+                    positions[(*count)++] = (uint32_t)i;
+                }
+                inScalar = true;
+                break;
+        }
+    }
+
+    if (inString) {
+        *errorPosition = length;
+        return ACEOAuth2RACJSONStructuralIndexUnterminatedString;
+    }
+    return ACEOAuth2RACJSONStructuralIndexSuccess;
+}
+
+// the same status, positions and failure offset of the reference, a message on the first difference
+static bool ACEOAuth2RACHarnessCompare(const char *name, const uint8_t *bytes, size_t length)
+{
+    uint32_t *expected = malloc((length + 1) * sizeof(uint32_t));
+    size_t expectedCount, expectedErrorPosition = 0;
+    ACEOAuth2RACJSONStructuralIndexStatus expectedStatus = ACEOAuth2RACHarnessReferenceBuild(bytes, length, expected, &expectedCount, &expectedErrorPosition);
+
+    ACEOAuth2RACJSONStructuralIndex index = { 0 };
+    size_t errorPosition = 0;
+    ACEOAuth2RACJSONStructuralIndexStatus status = ACEOAuth2RACJSONStructuralIndexBuild(bytes, length, &index, &errorPosition);
+
+    bool matches = false;
+    if (status != expectedStatus) {
+        fprintf(stderr, "%s: status %d, expected %d\n", name, status, expectedStatus);
+
+    } else if (status != ACEOAuth2RACJSONStructuralIndexSuccess) {
+        matches = (errorPosition == expectedErrorPosition);
+        if (!matches) {
+            fprintf(stderr, "%s: failure at %zu, expected %zu\n", name, errorPosition, expectedErrorPosition);
+        }
+
+    } else if (index.count != expectedCount) {
+        fprintf(stderr, "%s: %zu structural characters, expected %zu\n", name, index.count, expectedCount);
+
+    } else {
+        matches = true;
+        for (size_t i = 0; i < expectedCount && matches; i++) {
+            if (index.positions[i] != expected[i]) {
+                fprintf(stderr, "%s: structural character %zu at %u, expected %u\n", name, i, index.positions[i], expected[i]);
+                matches = false;
+            }
+        }
+    }
+
+    ACEOAuth2RACJSONStructuralIndexFree(&index);
+    free(expected);
+    return matches;
+}
+
+
+#pragma mark - Documents
+
+static uint32_t ACEOAuth2RACHarnessRandom(ACEOAuth2RACHarnessDocument *document, uint32_t bound)
+{
+    // xorshift, the same documents on every run
+    document->seed ^= document->seed << 13;
+    document->seed ^= document->seed >> 7;
+    document->seed ^= document->seed << 17;
+    return (uint32_t)(document->seed % bound);
+}
+
+static void ACEOAuth2RACHarnessAppendBytes(ACEOAuth2RACHarnessDocument *document, const void *bytes, size_t length)
+{
+    if (document->length + length > document->capacity) {
+        document->capacity  = (document->length + length) * 2;
+        document->bytes     = realloc(document->bytes, document->capacity);
+        if (document->bytes == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+    }
+    memcpy(document->bytes + document->length, bytes, length);
+    document->length += length;
+}
+
+static void ACEOAuth2RACHarnessAppend(ACEOAuth2RACHarnessDocument *document, const char *string)
+{
+    ACEOAuth2RACHarnessAppendBytes(document, string, strlen(string));
+}
+
+static void ACEOAuth2RACHarnessAppendWhitespace(ACEOAuth2RACHarnessDocument *document)
+{
+    static const char *whitespaces[] = { "", "", " ", "\n", "\t", "\r\n  " };
+    ACEOAuth2RACHarnessAppend(document, whitespaces[ACEOAuth2RACHarnessRandom(document, 6)]);
+}
+
+static void ACEOAuth2RACHarnessAppendValue(ACEOAuth2RACHarnessDocument *document, unsigned depth)
+{
+    static const char *scalars[] = { "0", "-12", "3.25e-7", "1234567890123", "true", "false", "null" };
+    static const char *pieces[] = { "a", "key", " ", "\\\\", "\\\"", "\\\\\\\"", "\\n", "\\u00e9", "\\uD83D\\uDE00", "\xc3\xa9", "\xf0\x9f\x98\x80", "{[:,]}" };
+
+    uint32_t type = ACEOAuth2RACHarnessRandom(document, depth < 5 ? 4 : 2);
+    switch (type) {
+        case 0: {
+            ACEOAuth2RACHarnessAppend(document, "\"");
+            for (uint32_t i = ACEOAuth2RACHarnessRandom(document, 40); i > 0; i--) {
+                ACEOAuth2RACHarnessAppend(document, pieces[ACEOAuth2RACHarnessRandom(document, 12)]);
+            }
+            ACEOAuth2RACHarnessAppend(document, "\"");
+            break;
+        }
+
+        case 1:
+            ACEOAuth2RACHarnessAppend(document, scalars[ACEOAuth2RACHarnessRandom(document, 7)]);
+            break;
+
+        default: {
+            bool isObject = (type == 2);
+            ACEOAuth2RACHarnessAppend(document, isObject ? "{" : "[");
+            for (uint32_t i = ACEOAuth2RACHarnessRandom(document, 6); i > 0; i--) {
+                ACEOAuth2RACHarnessAppendWhitespace(document);
+                if (isObject) {
+                    ACEOAuth2RACHarnessAppend(document, "\"k\\\"\"");
+                    ACEOAuth2RACHarnessAppendWhitespace(document);
+                    ACEOAuth2RACHarnessAppend(document, ":");
+                    ACEOAuth2RACHarnessAppendWhitespace(document);
+                }
+                ACEOAuth2RACHarnessAppendValue(document, depth + 1);
+                ACEOAuth2RACHarnessAppendWhitespace(document);
+                if (i > 1) {
+                    ACEOAuth2RACHarnessAppend(document, ",");
+                }
+            }
+            ACEOAuth2RACHarnessAppend(document, isObject ? "}" : "]");
+            break;
+        }
+    }
+}
+
+static bool ACEOAuth2RACHarnessReadFile(const char *path, ACEOAuth2RACHarnessDocument *document)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+
+    uint8_t buffer[64 * 1024];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        ACEOAuth2RACHarnessAppendBytes(document, buffer, length);
+    }
+
+    bool failed = ferror(file);
+    fclose(file);
+    return !failed;
+}
+
+
+#pragma mark - Benchmark
+
+static double ACEOAuth2RACHarnessNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// the throughput in MB/s of the index and of the byte by byte walk, each run for at least 0.2 seconds
+static void ACEOAuth2RACHarnessMeasure(const char *name, const uint8_t *bytes, size_t length)
+{
+    ACEOAuth2RACJSONStructuralIndex index = { 0 };
+    uint32_t *positions = malloc((length + 1) * sizeof(uint32_t));
+    size_t count = 0, errorPosition;
+    double rates[2];
+
+    for (int pass = 0; pass < 2; pass++) {
+        unsigned long runs = 0;
+        double start = ACEOAuth2RACHarnessNow(), elapsed;
+        do {
+            if (pass == 0) {
+                ACEOAuth2RACJSONStructuralIndexBuild(bytes, length, &index, &errorPosition);
+
+            } else {
+                ACEOAuth2RACHarnessReferenceBuild(bytes, length, positions, &count, &errorPosition);
+            }
+            runs++;
+            elapsed = ACEOAuth2RACHarnessNow() - start;
+        } while (elapsed < 0.2);
+
+        rates[pass] = (double)length * runs / elapsed / (1024.0 * 1024.0);
+    }
+
+    printf("%-28s %10zu bytes %10zu structural %9.1f MB/s index %9.1f MB/s walk\n", name, length, index.count, rates[0], rates[1]);
+
+    ACEOAuth2RACJSONStructuralIndexFree(&index);
+    free(positions);
+}
+
+
+#pragma mark - Main
+
+int main(int argc, char *argv[])
+{
+    bool matches = true;
+
+    for (int i = 1; i < argc; i++) {
+        ACEOAuth2RACHarnessDocument document = { 0 };
+        if (!ACEOAuth2RACHarnessReadFile(argv[i], &document)) {
+            return 2;
+        }
+
+        // the same document starting at every offset of a block
+        ACEOAuth2RACHarnessDocument shifted = { 0 };
+        for (size_t shift = 0; shift < 64; shift++) {
+            shifted.length = 0;
+            for (size_t space = 0; space < shift; space++) {
+                ACEOAuth2RACHarnessAppend(&shifted, " ");
+            }
+            ACEOAuth2RACHarnessAppendBytes(&shifted, document.bytes, document.length);
+
+            char name[1024];
+            snprintf(name, sizeof(name), "%s shifted by %zu", argv[i], shift);
+            matches &= ACEOAuth2RACHarnessCompare(name, shifted.bytes, shifted.length);
+        }
+
+        // every prefix of the start, cut in the middle of the strings and of the escapes
+        for (size_t length = 0; length <= document.length && length <= 1024; length++) {
+            char name[1024];
+            snprintf(name, sizeof(name), "%s cut at %zu", argv[i], length);
+            matches &= ACEOAuth2RACHarnessCompare(name, document.bytes, length);
+        }
+
+        free(shifted.bytes);
+        free(document.bytes);
+    }
+
+    for (uint64_t seed = 1; seed <= 2000; seed++) {
+        ACEOAuth2RACHarnessDocument document = { .seed = seed * 0x9e3779b97f4a7c15ULL };
+        ACEOAuth2RACHarnessAppendValue(&document, 0);
+
+        char name[64];
+        snprintf(name, sizeof(name), "random document %llu", (unsigned long long)seed);
+        matches &= ACEOAuth2RACHarnessCompare(name, document.bytes, document.length);
+        free(document.bytes);
+    }
+
+    if (!matches) {
+        fprintf(stderr, "the index differs from the byte by byte walk\n");
+        return 1;
+    }
+    printf("the index matches the byte by byte walk\n\n");
+
+    for (int i = 1; i < argc; i++) {
+        ACEOAuth2RACHarnessDocument document = { 0 };
+        ACEOAuth2RACHarnessReadFile(argv[i], &document);
+
+        const char *name = strrchr(argv[i], '/');
+        ACEOAuth2RACHarnessMeasure(name ? name + 1 : argv[i], document.bytes, document.length);
+        free(document.bytes);
+    }
+
+    // a large document, past the caches
+    ACEOAuth2RACHarnessDocument document = { .seed = 0x2545f4914f6cdd1dULL };
+    ACEOAuth2RACHarnessAppend(&document, "[");
+    while (document.length < 16 * 1024 * 1024) {
+        ACEOAuth2RACHarnessAppendValue(&document, 1);
+        ACEOAuth2RACHarnessAppend(&document, ",");
+    }
+    ACEOAuth2RACHarnessAppend(&document, "0]");
+    ACEOAuth2RACHarnessMeasure("random (16 MB)", document.bytes, document.length);
+    free(document.bytes);
+
+    return 0;
+}
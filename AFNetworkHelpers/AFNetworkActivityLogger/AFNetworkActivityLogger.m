@@ -24,6 +24,7 @@
 #import "AFURLSessionManager.h"
 
 #import "ACEOAuth2RACManagerPrivate.h"
+#import "ACEOAuth2RACRoute.h"
 
 #import <objc/runtime.h>
 
@@ -151,23 +152,27 @@ static void * AFNetworkRequestStartDate = &AFNetworkRequestStartDate;
 
     NSTimeInterval elapsedTime = [[NSDate date] timeIntervalSinceDate:objc_getAssociatedObject(notification.object, AFNetworkRequestStartDate)];
 
+    // the timings of the requests of the same route are grouped by its identifier
+    NSString *routeIdentifier = [ACEOAuth2RACRoute identifierForURLRequest:request];
+    NSString *route = routeIdentifier ? [NSString stringWithFormat:@" <%@>", routeIdentifier] : @"";
+
     if (error) {
         switch (self.level) {
             case AFLoggerLevelDebug:
             case AFLoggerLevelInfo:
             case AFLoggerLevelWarn:
             case AFLoggerLevelError:
-                ACE_LOG_ERROR(@"[Error] %@ '%@' (%ld) [%.04f s]: %@", [request HTTPMethod], [[response URL] absoluteString], (long)responseStatusCode, elapsedTime, error);
+                ACE_LOG_ERROR(@"[Error] %@ '%@'%@ (%ld) [%.04f s]: %@", [request HTTPMethod], [[response URL] absoluteString], route, (long)responseStatusCode, elapsedTime, error);
             default:
                 break;
         }
     } else {
         switch (self.level) {
             case AFLoggerLevelDebug:
-                ACE_LOG_DEBUG(@"%ld '%@' [%.04f s]: %@ %@", (long)responseStatusCode, [[response URL] absoluteString], elapsedTime, responseHeaderFields, responseObject);
+                ACE_LOG_DEBUG(@"%ld '%@'%@ [%.04f s]: %@ %@", (long)responseStatusCode, [[response URL] absoluteString], route, elapsedTime, responseHeaderFields, responseObject);
                 break;
             case AFLoggerLevelInfo:
-                ACE_LOG_INFO(@"%ld '%@' [%.04f s]", (long)responseStatusCode, [[response URL] absoluteString], elapsedTime);
+                ACE_LOG_INFO(@"%ld '%@'%@ [%.04f s]", (long)responseStatusCode, [[response URL] absoluteString], route, elapsedTime);
                 break;
             default:
                 break;
@@ -42,6 +42,33 @@
 - (RACSignal *)rac_DELETE:(NSString *)path parameters:(id)parameters retries:(NSInteger)retries interval:(NSTimeInterval)interval;
 - (RACSignal *)rac_DELETE:(NSString *)path parameters:(id)parameters retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock;
 
+- (RACSignal *)rac_requestPath:(NSString *)path parameters:(id)parameters method:(NSString *)method retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock;
+
+- (RACSignal *)rac_sendRequest:(NSURLRequest *)request retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock;
+- (RACSignal *)rac_sendRequest:(NSURLRequest *)request retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock configure:(void (^)(RACURLSessionRetryDataTask *task))configureBlock;
+
+/*!
+ *  Uploads a streamed body, sends a tuple with the response object and the response
+ *
+ *  @param requestBuilder builds the request with its body stream, called again for every retry
+ *  @param progressBlock  optional, called with the progress of the upload
+ */
+- (RACSignal *)rac_uploadRequestWithBuilder:(NSURLRequest *(^)(void))requestBuilder progress:(void (^)(NSProgress *uploadProgress))progressBlock retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock configure:(void (^)(RACURLSessionRetryDataTask *task))configureBlock;
+
+/*!
+ *  Downloads the response body to a file, sends a tuple with the file URL and the response
+ *
+ *  @param request        to download
+ *  @param resumeData     optional, resume data of a previous download of the same request
+ *  @param destinationURL file the body is moved to, replaced if it exists
+ *  @param progressBlock  optional, called with the progress of the download
+ *
+ *  Each retry resumes from the bytes already received when the server allows it,
+ *  except for an attempt whose timeout is shortened by the deadline of the task, which starts over,
+ *  the final error contains NSURLSessionDownloadTaskResumeData when the download can be resumed later.
+ */
+- (RACSignal *)rac_downloadRequest:(NSURLRequest *)request resumeData:(NSData *)resumeData destination:(NSURL *)destinationURL progress:(void (^)(NSProgress *downloadProgress))progressBlock retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock configure:(void (^)(RACURLSessionRetryDataTask *task))configureBlock;
+
 @end
 
 #endif
@@ -78,17 +78,11 @@ NSTimeInterval const RACDefaultTimeInterval = 10.0;
 
 - (RACSignal *)rac_POST:(NSString *)path parameters:(id)parameters constructingBodyWithBlock:(void (^)(id <AFMultipartFormData> formData))block retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock
 {
-    return [[RACSignal createSignal:^(id<RACSubscriber> subscriber) {
-        NSMutableURLRequest *request = [self.requestSerializer multipartFormRequestWithMethod:@"POST" URLString:[[NSURL URLWithString:path relativeToURL:self.baseURL] absoluteString] parameters:parameters constructingBodyWithBlock:block error:nil];
-        
-        RACURLSessionRetryDataTask *task = [self URLSessionRetryDataTaskForRequest:request numberOfRetries:retries retryInterval:interval test:testBlock subscriber:subscriber];
-        
-        [task resume];
-        
-        return [RACDisposable disposableWithBlock:^{
-            [task cancel];
-        }];
-    }] setNameWithFormat:@"%@ -rac_POST: %@, parameters: %@, constructingBodyWithBlock:", self.class, path, parameters];
+    return [[self rac_uploadRequestWithBuilder:^NSURLRequest *
+    {
+        return [self.requestSerializer multipartFormRequestWithMethod:@"POST" URLString:[[NSURL URLWithString:path relativeToURL:self.baseURL] absoluteString] parameters:parameters constructingBodyWithBlock:block error:nil];
+    } progress:nil retries:retries interval:interval test:testBlock configure:nil]
+            setNameWithFormat:@"%@ -rac_POST: %@, parameters: %@, constructingBodyWithBlock:", self.class, path, parameters];
 }
 
 #pragma mark - PUT
@@ -147,15 +141,159 @@ NSTimeInterval const RACDefaultTimeInterval = 10.0;
 
 - (RACSignal *)rac_requestPath:(NSString *)path parameters:(id)parameters method:(NSString *)method retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock
 {
-    return [RACSignal createSignal:^(id<RACSubscriber> subscriber)
+    return [RACSignal defer:^RACSignal *
     {
         NSURLRequest *request = [self.requestSerializer requestWithMethod:method URLString:[[NSURL URLWithString:path relativeToURL:self.baseURL] absoluteString] parameters:parameters error:nil];
         
+        return [self rac_sendRequest:request retries:retries interval:interval test:testBlock];
+    }];
+}
+
+- (RACSignal *)rac_sendRequest:(NSURLRequest *)request retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock
+{
+    return [self rac_sendRequest:request retries:retries interval:interval test:testBlock configure:nil];
+}
+
+- (RACSignal *)rac_sendRequest:(NSURLRequest *)request retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock configure:(void (^)(RACURLSessionRetryDataTask *task))configureBlock
+{
+    return [RACSignal createSignal:^(id<RACSubscriber> subscriber)
+    {
         //
         // Retry data task will create tasks multiple times and keep executing them unless canceled
         //
         RACURLSessionRetryDataTask *task = [self URLSessionRetryDataTaskForRequest:request numberOfRetries:retries retryInterval:interval test:testBlock subscriber:subscriber];
         
+        if (configureBlock)
+        {
+            configureBlock(task);
+        }
+        
+        [task resume];
+        
+        return [RACDisposable disposableWithBlock:^{
+            [task cancel];
+        }];
+    }];
+}
+
+- (RACSignal *)rac_downloadRequest:(NSURLRequest *)request resumeData:(NSData *)resumeData destination:(NSURL *)destinationURL progress:(void (^)(NSProgress *downloadProgress))progressBlock retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock configure:(void (^)(RACURLSessionRetryDataTask *task))configureBlock
+{
+    return [[RACSignal createSignal:^(id<RACSubscriber> subscriber)
+    {
+        RACURLSessionRetryDataTask *task = [self URLSessionRetryDataTaskForRequest:request numberOfRetries:retries retryInterval:interval test:testBlock subscriber:subscriber];
+        
+        //
+        // Bytes received by the failed attempt, the next one continues from there instead of starting from zero
+        //
+        __block NSData *currentResumeData = resumeData;
+        
+        NSTimeInterval requestTimeoutInterval = request.timeoutInterval;
+        
+        task.taskCreator = ^NSURLSessionTask*(NSURLRequest *request, RACURLSessionRetryDataTaskBlock retryBlock)
+        {
+            NSURL *(^destination)(NSURL *, NSURLResponse *) = ^NSURL *(NSURL *targetPath, NSURLResponse *response)
+            {
+                [[NSFileManager defaultManager] removeItemAtURL:destinationURL error:nil];
+                return destinationURL;
+            };
+            
+            void (^completionHandler)(NSURLResponse *, NSURL *, NSError *) = ^(NSURLResponse *response, NSURL *filePath, NSError *error)
+            {
+                NSInteger statusCode = [(NSHTTPURLResponse *)response statusCode];
+                
+                if (error && filePath && statusCode >= 200 && statusCode < 300)
+                {
+                    //
+                    // The response serializer only knows how to validate the content type of in memory bodies
+                    //
+                    error = nil;
+                }
+                else if (error && filePath)
+                {
+                    //
+                    // The file contains the body of the error
+                    //
+                    [[NSFileManager defaultManager] removeItemAtURL:filePath error:nil];
+                }
+                
+                currentResumeData = error.userInfo[NSURLSessionDownloadTaskResumeData];
+                
+                retryBlock(response, filePath, error);
+            };
+            
+            //
+            // A task created from resume data takes its timeout from the session configuration,
+            // so an attempt shortened by the deadline starts over from the request to keep the cap
+            //
+            if (currentResumeData && request.timeoutInterval >= requestTimeoutInterval)
+            {
+                return [self downloadTaskWithResumeData:currentResumeData progress:progressBlock destination:destination completionHandler:completionHandler];
+            }
+            
+            return [self downloadTaskWithRequest:request progress:progressBlock destination:destination completionHandler:completionHandler];
+        };
+        
+        if (configureBlock)
+        {
+            configureBlock(task);
+        }
+        
+        [task resume];
+        
+        return [RACDisposable disposableWithBlock:^{
+            [task cancel];
+        }];
+    }] setNameWithFormat:@"%@ -rac_downloadRequest: %@, destination: %@", self.class, request.URL, destinationURL];
+}
+
+- (RACSignal *)rac_uploadRequestWithBuilder:(NSURLRequest *(^)(void))requestBuilder progress:(void (^)(NSProgress *uploadProgress))progressBlock retries:(NSInteger)retries interval:(NSTimeInterval)interval test:(RACURLSessionRetryTestBlock)testBlock configure:(void (^)(RACURLSessionRetryDataTask *task))configureBlock
+{
+    return [RACSignal createSignal:^(id<RACSubscriber> subscriber)
+    {
+        __block NSURLRequest *nextRequest = requestBuilder();
+        
+        if (!nextRequest)
+        {
+            [subscriber sendError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCannotOpenFile userInfo:nil]];
+            return (RACDisposable *)nil;
+        }
+        
+        RACURLSessionRetryDataTask *task = [self URLSessionRetryDataTaskForRequest:nextRequest numberOfRetries:retries retryInterval:interval test:testBlock subscriber:subscriber];
+        
+        task.taskCreator = ^NSURLSessionTask*(NSURLRequest *request, RACURLSessionRetryDataTaskBlock retryBlock)
+        {
+            //
+            // A body stream can only be read once, so every retry streams the parts again from their source
+            // instead of reusing the stream consumed by the failed attempt
+            //
+            NSMutableURLRequest *attemptRequest = [(nextRequest ?: requestBuilder()) mutableCopy];
+            nextRequest = nil;
+            
+            if (!attemptRequest)
+            {
+                NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCannotOpenFile userInfo:@{ NSURLErrorFailingURLErrorKey: request.URL }];
+                
+                dispatch_async(self.completionQueue ?: dispatch_get_main_queue(), ^(void)
+                {
+                    retryBlock(nil, nil, error);
+                });
+                
+                return nil;
+            }
+            
+            //
+            // Keep the timeout capped by the deadline
+            //
+            attemptRequest.timeoutInterval = request.timeoutInterval;
+            
+            return [self uploadTaskWithStreamedRequest:attemptRequest progress:progressBlock completionHandler:retryBlock];
+        };
+        
+        if (configureBlock)
+        {
+            configureBlock(task);
+        }
+        
         [task resume];
         
         return [RACDisposable disposableWithBlock:^{
@@ -196,7 +334,7 @@ NSTimeInterval const RACDefaultTimeInterval = 10.0;
     // we must execute it's retry block instead of completing based on our own criteria.
     //
     
-    task.taskCreator = ^NSURLSessionDataTask*(NSURLRequest *request, RACURLSessionRetryDataTaskBlock retryBlock)
+    task.taskCreator = ^NSURLSessionTask*(NSURLRequest *request, RACURLSessionRetryDataTaskBlock retryBlock)
     {
         return [self dataTaskWithRequest:request completionHandler:retryBlock];
     };
@@ -206,6 +344,14 @@ NSTimeInterval const RACDefaultTimeInterval = 10.0;
         task.testBlock = testBlock;
     }
     
+    //
+    // Retry on the same queue the completions are delivered on
+    //
+    if (self.completionQueue)
+    {
+        task.retryQueue = self.completionQueue;
+    }
+    
     return task;
 }
 
@@ -16,9 +16,9 @@ typedef BOOL (^RACURLSessionRetryTestBlock)(NSURLResponse *response, id response
  *  @param request    provides request
  *  @param retryBlock retry block to be executed when data task fails
  *
- *  @return new NSURLSessionDataTask
+ *  @return new NSURLSessionDataTask, or NSURLSessionDownloadTask for downloads
  */
-typedef NSURLSessionDataTask* (^RACURLSessionDataTaskCreator)(NSURLRequest *request, RACURLSessionRetryDataTaskBlock retryBlock);
+typedef NSURLSessionTask* (^RACURLSessionDataTaskCreator)(NSURLRequest *request, RACURLSessionRetryDataTaskBlock retryBlock);
 
 #pragma mark - RACURLSessionRetryDataTask
 
@@ -43,6 +43,27 @@ typedef NSURLSessionDataTask* (^RACURLSessionDataTaskCreator)(NSURLRequest *requ
  */
 @property (nonatomic, copy) RACURLSessionRetryTestBlock testBlock;
 
+/*!
+ *  Queue the retries are scheduled on, defaults to the main queue.
+ */
+@property (nonatomic, strong) dispatch_queue_t retryQueue;
+
+/*!
+ *  Priority given to each data task, defaults to NSURLSessionTaskPriorityDefault.
+ */
+@property (nonatomic, assign) float priority;
+
+/*!
+ *  Optional, if set no attempt nor retry cooldown goes past this date:
+ *  the timeout interval of each attempt is capped to the time left.
+ */
+@property (nonatomic, strong) NSDate *deadline;
+
+/*!
+ *  Error reported when the deadline is reached, defaults to NSURLErrorTimedOut.
+ */
+@property (nonatomic, strong) NSError *deadlineError;
+
 - (instancetype)initWithRequest:(NSURLRequest *)request numberOfRetries:(NSInteger)numberOfRetries retryInterval:(NSTimeInterval)retryInterval completionHandler:(void (^)(NSURLResponse *response, id responseObject, NSError *error))completionHandler;
 
 - (void)resume;
@@ -28,7 +28,12 @@
 
 @property (nonatomic, copy) void (^completionHandler)(NSURLResponse *, id, NSError *);
 
-@property (nonatomic, strong) NSURLSessionDataTask* currentTask;
+@property (nonatomic, strong) NSURLSessionTask* currentTask;
+
+/*!
+ *  YES when the timeout of the current task was shortened to meet the deadline
+ */
+@property (nonatomic, assign) BOOL currentTaskCappedByDeadline;
 
 @end
 
@@ -48,6 +53,10 @@
         self.retriesLeft = numberOfRetries - 1;
         
         self.completionHandler = completionHandler;
+        
+        self.priority = NSURLSessionTaskPriorityDefault;
+        
+        self.retryQueue = dispatch_get_main_queue();
     }
     
     return self;
@@ -60,9 +69,37 @@
 
 - (void)resume
 {
+    NSURLRequest *request = self.request;
+    
+    self.currentTaskCappedByDeadline = NO;
+    
+    if (self.deadline)
+    {
+        NSTimeInterval timeLeft = [self.deadline timeIntervalSinceNow];
+        
+        if (timeLeft <= 0.0)
+        {
+            [self completeWithDeadlineError];
+            return;
+        }
+        
+        //
+        // Each attempt can only use the time left before the deadline
+        //
+        if (timeLeft < request.timeoutInterval)
+        {
+            NSMutableURLRequest *mutableRequest = [request mutableCopy];
+            mutableRequest.timeoutInterval = timeLeft;
+            request = mutableRequest;
+            
+            self.currentTaskCappedByDeadline = YES;
+        }
+    }
+    
     if (self.taskCreator)
     {
-        self.currentTask = self.taskCreator(self.request, [self retryBlock]);
+        self.currentTask = self.taskCreator(request, [self retryBlock]);
+        self.currentTask.priority = self.priority;
     }
     
     //NSLog(@"Calling URL...");
@@ -80,6 +117,21 @@
     [self.currentTask cancel];
 }
 
+- (void)completeWithDeadlineError
+{
+    NSError *error = self.deadlineError;
+    
+    if (!error)
+    {
+        error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:@{ NSURLErrorFailingURLErrorKey: self.request.URL }];
+    }
+    
+    if (self.completionHandler)
+    {
+        self.completionHandler(nil, nil, error);
+    }
+}
+
 - (RACURLSessionRetryDataTaskBlock)retryBlock
 {
     RACURLSessionRetryDataTaskBlock retryBlock = ^(NSURLResponse *response, id responseObject, NSError *error)
@@ -88,6 +140,15 @@
         
         if (error)
         {
+            //
+            // The attempt ran out of the time left, there is no point in retrying
+            //
+            if (self.currentTaskCappedByDeadline && [error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorTimedOut)
+            {
+                [self completeWithDeadlineError];
+                return;
+            }
+            
             BOOL retryTest = YES;
             
             if (self.testBlock)
@@ -98,7 +159,14 @@
             //
             // This is the retry logic
             //
-            if ( (self.retriesLeft > 0) && retryTest)
+            if ( (self.retriesLeft > 0) && retryTest && self.deadline && [self.deadline timeIntervalSinceNow] <= self.retryInterval)
+            {
+                //
+                // Waiting for the cooldown would go past the deadline
+                //
+                [self completeWithDeadlineError];
+            }
+            else if ( (self.retriesLeft > 0) && retryTest)
             {
                 //NSLog(@"Retrying for: %ld", (long)self.retriesLeft);
                 
@@ -108,7 +176,7 @@
                 self.currentTask = nil;
                 
                 dispatch_time_t delay = dispatch_time(0, (int64_t)(self.retryInterval * NSEC_PER_SEC));
-                dispatch_after(delay, dispatch_get_main_queue(), ^(void)
+                dispatch_after(delay, self.retryQueue, ^(void)
                 {
                     [self resume];
                 });